@@ -7,6 +7,8 @@
 #include <iomanip>
 #include <sstream>
 #include <fstream>
+#include <chrono>
+#include <thread>
 
 #include "rbdl/rbdl.h"
 #include "model_generator.h"
@@ -42,7 +44,17 @@ bool benchmark_run_id_rnea = true;
 bool benchmark_run_crba = true;
 bool benchmark_run_nle = true;
 bool benchmark_run_calc_minv_times_tau = true;
+bool benchmark_run_gravity_torques = true;
+bool benchmark_run_coriolis_matrix = true;
+bool benchmark_run_operational_space = true;
 bool benchmark_run_contacts = true;
+bool benchmark_run_frictional_contacts = true;
+bool benchmark_run_multi_dof_joints = true;
+bool benchmark_run_simulator = true;
+bool benchmark_run_rollouts = true;
+bool benchmark_run_batch_dynamics = true;
+bool benchmark_run_precision = true;
+bool benchmark_run_constraint_threads = true;
 bool benchmark_run_ik = true;
 
 bool json_output = false;
@@ -53,7 +65,8 @@ enum ContactsMethod {
     ConstraintsMethodDirect = 0,
     ConstraintsMethodRangeSpaceSparse,
     ConstraintsMethodNullSpace,
-    ConstraintsMethodKokkevis
+    ConstraintsMethodKokkevis,
+    ConstraintsMethodDirectCompliant
 };
 
 struct BenchmarkRun {
@@ -280,6 +293,102 @@ double run_calc_minv_times_tau_benchmark (Model *model, int sample_count) {
   return sample_data.durations.sum();
 }
 
+double run_gravity_torques_id_benchmark (Model *model, int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  VectorNd qdot_zero = VectorNd::Zero (model->dof_count);
+  VectorNd qddot_zero = VectorNd::Zero (model->dof_count);
+
+  TimerInfo tinfo;
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    InverseDynamics (*model, sample_data.q[i], qdot_zero, qddot_zero,
+        sample_data.tau[i]);
+    sample_data.durations[i] = timer_stop (&tinfo);
+  }
+
+  report_run(*model, sample_data, "GravityTorques (InverseDynamics)");
+
+  return sample_data.durations.sum();
+}
+
+double run_gravity_torques_benchmark (Model *model, int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  TimerInfo tinfo;
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    CalcGravityTorques (*model, sample_data.q[i], sample_data.tau[i]);
+    sample_data.durations[i] = timer_stop (&tinfo);
+  }
+
+  report_run(*model, sample_data, "CalcGravityTorques");
+
+  return sample_data.durations.sum();
+}
+
+double run_coriolis_matrix_nle_benchmark (Model *model, int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  Math::MatrixNd C = Math::MatrixNd::Zero(model->dof_count, model->dof_count);
+  VectorNd qdot_unit = VectorNd::Zero (model->dof_count);
+  VectorNd nle = VectorNd::Zero (model->dof_count);
+
+  TimerInfo tinfo;
+
+  // the workaround: with gravity removed the nonlinear effects c(qdot) are
+  // quadratic in qdot and C(q, qdot) e_j = 1/2 (c(qdot + e_j) - c(qdot)
+  // - c(e_j))
+  Vector3d gravity = model->gravity;
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    model->gravity.setZero();
+    NonlinearEffects (*model, sample_data.q[i], sample_data.qdot[i],
+        sample_data.tau[i]);
+    for (unsigned int j = 0; j < model->dof_count; j++) {
+      qdot_unit = sample_data.qdot[i];
+      qdot_unit[j] += 1.;
+      NonlinearEffects (*model, sample_data.q[i], qdot_unit, nle);
+      qdot_unit.setZero();
+      qdot_unit[j] = 1.;
+      C.col(j) = nle - sample_data.tau[i];
+      NonlinearEffects (*model, sample_data.q[i], qdot_unit, nle);
+      C.col(j) = 0.5 * (C.col(j) - nle);
+    }
+    model->gravity = gravity;
+    sample_data.durations[i] = timer_stop (&tinfo);
+  }
+
+  report_run(*model, sample_data, "CoriolisMatrix (NonlinearEffects)");
+
+  return sample_data.durations.sum();
+}
+
+double run_coriolis_matrix_benchmark (Model *model, int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  Math::MatrixNd C = Math::MatrixNd::Zero(model->dof_count, model->dof_count);
+
+  TimerInfo tinfo;
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    CalcCoriolisMatrix (*model, sample_data.q[i], sample_data.qdot[i], C);
+    sample_data.durations[i] = timer_stop (&tinfo);
+  }
+
+  report_run(*model, sample_data, "CalcCoriolisMatrix");
+
+  return sample_data.durations.sum();
+}
+
 double run_inverse_dynamics_constraints_benchmark (Model *model, ConstraintSet *constraint_set, std::vector<bool> &dofActuated, int sample_count) {
   SampleData sample_data;
   sample_data.fillRandom(model->dof_count, sample_count);
@@ -349,6 +458,45 @@ double run_contacts_null_space (Model *model, ConstraintSet *constraint_set, int
   return sample_data.durations.sum();
 }
 
+double run_contacts_null_space_switching_benchmark (Model *model, ConstraintSet *constraint_set, bool incremental, int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  TimerInfo tinfo;
+  unsigned int group_count = constraint_set->getGroupIndexMax() + 1;
+  NullSpaceQRFactorization &nsf = constraint_set->null_space_factorization;
+
+  for (int i = 0; i < sample_count; i++) {
+    CalcConstrainedSystemVariables (*model, sample_data.q[i], sample_data.qdot[i], sample_data.tau[i], *constraint_set);
+    constraint_set->FactorizeNullSpace();
+
+    // opens and closes one contact
+    unsigned int group_index = i % group_count;
+
+    timer_start (&tinfo);
+    if (incremental) {
+      constraint_set->DeactivateConstraint (group_index);
+      SolveConstrainedSystemNullSpaceFactorized (*constraint_set, sample_data.tau[i], sample_data.qddot[i]);
+      constraint_set->ActivateConstraint (group_index);
+      SolveConstrainedSystemNullSpaceFactorized (*constraint_set, sample_data.tau[i], sample_data.qddot[i]);
+    } else {
+      nsf.factorized = false;
+      constraint_set->DeactivateConstraint (group_index);
+      constraint_set->FactorizeNullSpace();
+      SolveConstrainedSystemNullSpaceFactorized (*constraint_set, sample_data.tau[i], sample_data.qddot[i]);
+      nsf.factorized = false;
+      constraint_set->ActivateConstraint (group_index);
+      constraint_set->FactorizeNullSpace();
+      SolveConstrainedSystemNullSpaceFactorized (*constraint_set, sample_data.tau[i], sample_data.qddot[i]);
+    }
+    sample_data.durations[i] = timer_stop (&tinfo);
+  }
+
+  report_constraints_run(*model, sample_data, incremental ? "NullSpaceSwitching (Givens updates)" : "NullSpaceSwitching (QR recomputed)");
+
+  return sample_data.durations.sum();
+}
+
 double run_contacts_kokkevis_benchmark (Model *model, ConstraintSet *constraint_set, int sample_count) {
   SampleData sample_data;
   sample_data.fillRandom(model->dof_count, sample_count);
@@ -397,6 +545,9 @@ void contacts_benchmark (int sample_count, ContactsMethod contacts_method) {
   ConstraintSet four_bodies_four_constraints;
 
   LinearSolver linear_solver = LinearSolverPartialPivLU;
+  if (contacts_method == ConstraintsMethodDirectCompliant) {
+    linear_solver = LinearSolverLLT;
+  }
 
   one_body_one_constraint.linear_solver = linear_solver;
   two_bodies_one_constraint.linear_solver = linear_solver;
@@ -464,6 +615,24 @@ void contacts_benchmark (int sample_count, ContactsMethod contacts_method) {
 
   four_bodies_four_constraints.Bind (*model);
 
+  // a small compliance regularizes the constraints such that the Cholesky
+  // decompositions of the Schur complement can be used
+  if (contacts_method == ConstraintsMethodDirectCompliant) {
+    ConstraintSet *constraint_sets[6] = {
+      &one_body_one_constraint, &two_bodies_one_constraint,
+      &four_bodies_one_constraint, &one_body_four_constraints,
+      &two_bodies_four_constraints, &four_bodies_four_constraints
+    };
+
+    for (unsigned int i = 0; i < 6; i++) {
+      for (unsigned int j = 0; j <= constraint_sets[i]->getGroupIndexMax(); j++) {
+        constraint_sets[i]->setCompliance (j, 1.0e-8);
+      }
+    }
+
+    contacts_method = ConstraintsMethodDirect;
+  }
+
   model_name = "Human36";
   if (!json_output) {
     cout << "= #DOF: " << setw(3) << model->dof_count << endl;
@@ -681,6 +850,783 @@ double run_all_inverse_kinematics_benchmark (int sample_count){
   return duration;
 }
 
+double run_operational_space_inertia_crba_benchmark (Model *model, OperationalSpaceTaskSet &tasks, int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  unsigned int m = tasks.size();
+  MatrixNd H = MatrixNd::Zero(model->dof_count, model->dof_count);
+  MatrixNd J = MatrixNd::Zero(m, model->dof_count);
+  MatrixNd G = MatrixNd::Zero(6, model->dof_count);
+  MatrixNd Lambda = MatrixNd::Zero(m, m);
+
+  TimerInfo tinfo;
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    UpdateKinematicsCustom (*model, &sample_data.q[i], NULL, NULL);
+    for (unsigned int r = 0; r < m; r++) {
+      G.setZero();
+      CalcPointJacobian6D (*model, sample_data.q[i], tasks.body_ids[r],
+          tasks.body_points[r], G, false);
+      J.row(r) = tasks.axes[r].transpose() * G;
+    }
+    H.setZero();
+    CompositeRigidBodyAlgorithm (*model, sample_data.q[i], H, false);
+    MatrixNd Hinv = H.inverse();
+    Lambda = (J * Hinv * J.transpose()).inverse();
+    sample_data.durations[i] = timer_stop (&tinfo);
+  }
+
+  report_constraints_run(*model, sample_data, "OperationalSpaceInertia (CRBA)");
+
+  return sample_data.durations.sum();
+}
+
+double run_operational_space_inertia_benchmark (Model *model, OperationalSpaceTaskSet &tasks, int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  MatrixNd Lambda = MatrixNd::Zero(tasks.size(), tasks.size());
+
+  TimerInfo tinfo;
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    CalcOperationalSpaceInertia (*model, sample_data.q[i], tasks, Lambda);
+    sample_data.durations[i] = timer_stop (&tinfo);
+  }
+
+  report_constraints_run(*model, sample_data, "CalcOperationalSpaceInertia");
+
+  return sample_data.durations.sum();
+}
+
+double run_delassus_benchmark (Model *model, OperationalSpaceTaskSet &tasks, int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  MatrixNd Delassus = MatrixNd::Zero(tasks.size(), tasks.size());
+
+  TimerInfo tinfo;
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    CalcDelassus (*model, sample_data.q[i], tasks, Delassus);
+    sample_data.durations[i] = timer_stop (&tinfo);
+  }
+
+  report_constraints_run(*model, sample_data, "CalcDelassus");
+
+  return sample_data.durations.sum();
+}
+
+void operational_space_benchmark (int sample_count) {
+  Model *model = new Model();
+  generate_human36model(model);
+
+  unsigned int foot_r = model->GetBodyId ("foot_r");
+  unsigned int foot_l = model->GetBodyId ("foot_l");
+  unsigned int hand_r = model->GetBodyId ("hand_r");
+  unsigned int hand_l = model->GetBodyId ("hand_l");
+
+  OperationalSpaceTaskSet feet;
+  feet.AddPointTask (foot_r, Vector3d (0.1, 0., -0.05));
+  feet.AddPointTask (foot_l, Vector3d (0.1, 0., -0.05));
+
+  OperationalSpaceTaskSet limbs;
+  limbs.AddPointTask6D (foot_r, Vector3d (0.1, 0., -0.05));
+  limbs.AddPointTask6D (foot_l, Vector3d (0.1, 0., -0.05));
+  limbs.AddPointTask6D (hand_r, Vector3d (0.1, 0., -0.05));
+  limbs.AddPointTask6D (hand_l, Vector3d (0.1, 0., -0.05));
+
+  if (!json_output) {
+    cout << "= #DOF: " << setw(3) << model->dof_count << endl;
+    cout << "= #samples: " << sample_count << endl;
+  }
+
+  model_name = "Human36_2Points3D";
+  run_operational_space_inertia_crba_benchmark (model, feet, sample_count);
+  run_operational_space_inertia_benchmark (model, feet, sample_count);
+  run_delassus_benchmark (model, feet, sample_count);
+
+  model_name = "Human36_4Points6D";
+  run_operational_space_inertia_crba_benchmark (model, limbs, sample_count);
+  run_operational_space_inertia_benchmark (model, limbs, sample_count);
+  run_delassus_benchmark (model, limbs, sample_count);
+
+  delete model;
+}
+
+Model* generate_bouncing_body_model (const Body &body, unsigned int *body_id) {
+  Model *model = new Model();
+  model->gravity = Vector3d (0., 0., -9.81);
+
+  // translation and XYZ euler angles such that q can be integrated directly
+  Joint floating_joint (
+      SpatialVector (0., 0., 0., 1., 0., 0.),
+      SpatialVector (0., 0., 0., 0., 1., 0.),
+      SpatialVector (0., 0., 0., 0., 0., 1.),
+      SpatialVector (1., 0., 0., 0., 0., 0.),
+      SpatialVector (0., 1., 0., 0., 0., 0.),
+      SpatialVector (0., 0., 1., 0., 0., 0.)
+      );
+
+  *body_id = model->AddBody (0, Xtrans (Vector3d (0., 0., 0.)),
+      floating_joint, body);
+
+  return model;
+}
+
+/** Simulates a body that is dropped onto the ground plane z = 0 with
+ * semi-implicit Euler steps and SolveFrictionalContactImpulses(). Every
+ * sample is a time step. For a sphere (radius > 0) the single contact point
+ * is moved to the lowest point of the sphere in every step, otherwise the
+ * contact points are fixed on the body. Contacts are active when they are
+ * closer to the ground than a small margin. */
+double run_bouncing_body_benchmark (Model *model, unsigned int body_id,
+    FrictionalContactSet &contacts, double radius, const char *run_name,
+    int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  const double dt = 1.0e-3;
+  // fraction of the penetration that is removed in the next time step
+  const double penetration_correction = 0.2;
+  const double contact_margin = 0.01;
+
+  VectorNd q = VectorNd::Zero (model->q_size);
+  VectorNd qdot = VectorNd::Zero (model->qdot_size);
+  VectorNd qddot = VectorNd::Zero (model->qdot_size);
+  VectorNd qdot_free = VectorNd::Zero (model->qdot_size);
+  VectorNd tau = VectorNd::Zero (model->qdot_size);
+
+  q << 0., 0., 0.5, 0.1, 0.2, 0.3;
+  qdot << 1., 0.5, 0., 0.5, -1., 2.;
+
+  unsigned int contact_steps = 0;
+  unsigned int sweeps = 0;
+
+  TimerInfo tinfo;
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+
+    UpdateKinematicsCustom (*model, &q, NULL, NULL);
+
+    for (unsigned int c = 0; c < contacts.size(); c++) {
+      double depth;
+
+      if (radius > 0.) {
+        Vector3d center = CalcBodyToBaseCoordinates (*model, q, body_id,
+            Vector3d::Zero(), false);
+        Matrix3d E = CalcBodyWorldOrientation (*model, q, body_id, false);
+        contacts.body_points[c] = E * Vector3d (0., 0., -radius);
+        depth = radius - center[2];
+      } else {
+        depth = - CalcBodyToBaseCoordinates (*model, q, body_id,
+            contacts.body_points[c], false)[2];
+      }
+
+      // contacts within the margin are kept active and may only close the
+      // remaining gap in the next step (speculative contacts)
+      contacts.active[c] = depth >= -contact_margin;
+      if (depth >= 0.) {
+        contacts.normal_velocity_bias[c] = depth * penetration_correction / dt;
+      } else {
+        contacts.normal_velocity_bias[c] = depth / dt;
+      }
+    }
+
+    ForwardDynamics (*model, q, qdot, tau, qddot);
+    qdot_free = qdot + dt * qddot;
+    SolveFrictionalContactImpulses (*model, q, qdot_free, contacts, qdot);
+    q += dt * qdot;
+
+    sample_data.durations[i] = timer_stop (&tinfo);
+
+    if (contacts.num_iterations > 0) {
+      contact_steps++;
+      sweeps += contacts.num_iterations;
+    }
+  }
+
+  report_constraints_run(*model, sample_data, run_name);
+
+  if (!json_output && contact_steps > 0) {
+    cout << "  " << contact_steps << " steps with contacts, ~"
+      << static_cast<double>(sweeps) / contact_steps
+      << " sweeps per step" << endl;
+  }
+
+  return sample_data.durations.sum();
+}
+
+void null_space_switching_benchmark (int sample_count) {
+  Model *model = new Model();
+  generate_human36model(model);
+
+  const char *body_names[4] = { "foot_r", "foot_l", "hand_r", "hand_l" };
+
+  ConstraintSet constraint_set;
+  for (unsigned int i = 0; i < 4; i++) {
+    unsigned int body_id = model->GetBodyId (body_names[i]);
+    constraint_set.AddContactConstraint (body_id, Vector3d (0.1, 0., -0.05), Vector3d (1., 0., 0.));
+    constraint_set.AddContactConstraint (body_id, Vector3d (0.1, 0., -0.05), Vector3d (0., 1., 0.));
+    constraint_set.AddContactConstraint (body_id, Vector3d (0.1, 0., -0.05), Vector3d (0., 0., 1.));
+  }
+  constraint_set.Bind (*model);
+
+  if (!json_output) {
+    cout << "= #DOF: " << setw(3) << model->dof_count << endl;
+    cout << "= #samples (one contact opened and closed): " << sample_count << endl;
+  }
+
+  model_name = "Human36_4Bodies3Constraints";
+  run_contacts_null_space_switching_benchmark (model, &constraint_set, false, sample_count);
+  run_contacts_null_space_switching_benchmark (model, &constraint_set, true, sample_count);
+
+  delete model;
+}
+
+void frictional_contacts_benchmark (int sample_count) {
+  unsigned int body_id;
+  double radius = 0.1;
+  double mass = 1.;
+
+  Body ball (mass, Vector3d (0., 0., 0.),
+      Vector3d (0.4 * mass * radius * radius,
+        0.4 * mass * radius * radius,
+        0.4 * mass * radius * radius));
+  Model *ball_model = generate_bouncing_body_model (ball, &body_id);
+
+  FrictionalContactSet ball_contacts;
+  ball_contacts.AddContact (body_id, Vector3d (0., 0., -radius),
+      Vector3d (0., 0., 1.), 0.5, 0.5);
+  ball_contacts.Bind (*ball_model);
+
+  if (!json_output) {
+    cout << "= #samples (time steps of 1ms): " << sample_count << endl;
+  }
+
+  model_name = "BouncingBall";
+  run_bouncing_body_benchmark (ball_model, body_id, ball_contacts, radius,
+      "FrictionalContacts (cone)", sample_count);
+
+  delete ball_model;
+
+  Vector3d size (0.3, 0.2, 0.1);
+  Body box (mass, Vector3d (0., 0., 0.),
+      Vector3d (mass / 12. * (size[1] * size[1] + size[2] * size[2]),
+        mass / 12. * (size[0] * size[0] + size[2] * size[2]),
+        mass / 12. * (size[0] * size[0] + size[1] * size[1])));
+  Model *box_model = generate_bouncing_body_model (box, &body_id);
+
+  FrictionalContactSet box_contacts;
+  for (int i = -1; i <= 1; i += 2) {
+    for (int j = -1; j <= 1; j += 2) {
+      for (int k = -1; k <= 1; k += 2) {
+        box_contacts.AddContact (body_id,
+            0.5 * Vector3d (i * size[0], j * size[1], k * size[2]),
+            Vector3d (0., 0., 1.), 0.5, 0.2);
+      }
+    }
+  }
+  box_contacts.Bind (*box_model);
+
+  model_name = "BouncingBox";
+  box_contacts.friction_model = FrictionModelPyramid;
+  run_bouncing_body_benchmark (box_model, body_id, box_contacts, 0.,
+      "FrictionalContacts (pyramid)", sample_count);
+
+  box_contacts.friction_model = FrictionModelCone;
+  run_bouncing_body_benchmark (box_model, body_id, box_contacts, 0.,
+      "FrictionalContacts (cone)", sample_count);
+
+  box_contacts.warm_start = false;
+  run_bouncing_body_benchmark (box_model, body_id, box_contacts, 0.,
+      "FrictionalContacts (cone, no warm start)", sample_count);
+
+  delete box_model;
+}
+
+void multi_dof_joints_benchmark (int sample_count) {
+  const char *model_names[2] = { "Human36_emulated", "Human36_native" };
+
+  for (unsigned int i = 0; i < 2; i++) {
+    Model *model = new Model();
+    model->emulate_multi_dof_joints = (i == 0);
+    generate_human36model(model);
+
+    model_name = model_names[i];
+
+    if (!json_output) {
+      cout << "= " << model_name << " (#bodies: " << model->mBodies.size()
+        << ", #multi-dof joints: " << model->mMultiDofJoints.size()
+        << ")" << endl;
+    }
+
+    run_forward_dynamics_ABA_benchmark (model, sample_count);
+    run_inverse_dynamics_RNEA_benchmark (model, sample_count);
+    run_CRBA_benchmark (model, sample_count);
+    run_calc_minv_times_tau_benchmark (model, sample_count);
+
+    delete model;
+  }
+}
+
+/** Advances the simulator by one time step per sample. */
+double run_simulator_benchmark (Model *model, Simulator &simulator,
+    const char *run_name, int sample_count) {
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  simulator.q.setZero();
+  simulator.qdot = sample_data.qdot[0];
+  simulator.tau.setZero();
+
+  TimerInfo tinfo;
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    simulator.Step();
+    sample_data.durations[i] = timer_stop (&tinfo);
+  }
+
+  report_constraints_run(*model, sample_data, run_name);
+
+  return sample_data.durations.sum();
+}
+
+void simulator_benchmark (int sample_count) {
+  Model *model = new Model();
+  generate_human36model(model);
+
+  Simulator simulator;
+  simulator.Bind (*model);
+
+  if (!json_output) {
+    cout << "= #DOF: " << setw(3) << model->dof_count << endl;
+    cout << "= #samples (time steps of 1ms): " << sample_count << endl;
+  }
+
+  model_name = "Human36";
+
+  simulator.integrator = SimulatorIntegratorSymplecticEuler;
+  run_simulator_benchmark (model, simulator, "Simulator (symplectic Euler)",
+      sample_count);
+
+  simulator.integrator = SimulatorIntegratorSemiImplicit;
+  run_simulator_benchmark (model, simulator, "Simulator (semi-implicit)",
+      sample_count);
+
+  simulator.integrator = SimulatorIntegratorRungeKutta4;
+  run_simulator_benchmark (model, simulator, "Simulator (RK4)",
+      sample_count);
+
+  const char *body_names[2] = { "foot_r", "foot_l" };
+
+  ConstraintSet constraint_set;
+  for (unsigned int i = 0; i < 2; i++) {
+    unsigned int body_id = model->GetBodyId (body_names[i]);
+    constraint_set.AddContactConstraint (body_id, Vector3d (0.1, 0., -0.05), Vector3d (1., 0., 0.));
+    constraint_set.AddContactConstraint (body_id, Vector3d (0.1, 0., -0.05), Vector3d (0., 1., 0.));
+    constraint_set.AddContactConstraint (body_id, Vector3d (0.1, 0., -0.05), Vector3d (0., 0., 1.));
+  }
+  constraint_set.Bind (*model);
+
+  model_name = "Human36_2Bodies3Constraints";
+  simulator.integrator = SimulatorIntegratorSemiImplicit;
+
+  simulator.SetConstraintSet (&constraint_set, ConstraintSolverDirect);
+  run_simulator_benchmark (model, simulator,
+      "Simulator (semi-implicit, direct)", sample_count);
+
+  simulator.SetConstraintSet (&constraint_set,
+      ConstraintSolverRangeSpaceSparse);
+  run_simulator_benchmark (model, simulator,
+      "Simulator (semi-implicit, range space sparse)", sample_count);
+
+  simulator.SetConstraintSet (&constraint_set, ConstraintSolverNullSpace);
+  run_simulator_benchmark (model, simulator,
+      "Simulator (semi-implicit, null space)", sample_count);
+
+  delete model;
+}
+
+/** Runs a batch of rollouts with num_threads workers and reports the
+ * throughput. The wall clock time is measured as clock() sums up the time
+ * of all threads. */
+double run_rollout_benchmark (Model *model, unsigned int num_threads,
+    const MatrixNd &Q0, const MatrixNd &QDot0, const MatrixNd &controls,
+    RolloutBuffer &buffer) {
+  RolloutEngine engine;
+  engine.integrator = SimulatorIntegratorSemiImplicit;
+  engine.dt = 1.0e-3;
+  engine.Bind (*model, num_threads);
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  engine.Run (Q0, QDot0, &controls, buffer);
+  double duration = chrono::duration<double> (
+      chrono::steady_clock::now() - start).count();
+
+  ostringstream run_name;
+  run_name << "RolloutEngine (" << num_threads << " threads)";
+
+  BenchmarkRun run;
+  run.benchmark = run_name.str();
+  run.model_name = model_name;
+  run.model_dof = model->dof_count;
+  run.sample_count = buffer.num_rollouts;
+  run.duration = duration;
+  run.avg = duration / buffer.num_rollouts;
+  run.min = run.avg;
+  run.max = run.avg;
+  benchmark_runs.push_back (run);
+
+  if (!json_output) {
+    cout << model_name << ": " << setw(3) << num_threads << " threads"
+         << " duration = " << setw(10) << duration << "(s)"
+         << " rollouts/s = " << setw(10) << buffer.num_rollouts / duration
+         << " steps/s = " << setw(10)
+         << buffer.num_rollouts * buffer.num_steps / duration << endl;
+  }
+
+  return duration;
+}
+
+void rollout_benchmark (int sample_count) {
+  Model *model = new Model();
+  generate_human36model(model);
+
+  const unsigned int num_rollouts = sample_count;
+  const unsigned int num_steps = 100;
+
+  Simulator simulator;
+  simulator.Bind (*model);
+
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, num_rollouts);
+
+  MatrixNd Q0 (model->q_size, num_rollouts);
+  MatrixNd QDot0 (model->qdot_size, num_rollouts);
+  for (unsigned int r = 0; r < num_rollouts; r++) {
+    Q0.col (r) = simulator.q;
+    QDot0.col (r) = sample_data.qdot[r];
+  }
+  MatrixNd controls = MatrixNd::Zero (model->qdot_size,
+      num_rollouts * num_steps);
+
+  RolloutBuffer buffer;
+  buffer.Resize (*model, num_rollouts, num_steps);
+
+  unsigned int max_threads = std::max (1u, thread::hardware_concurrency());
+
+  if (!json_output) {
+    cout << "= #DOF: " << setw(3) << model->dof_count << endl;
+    cout << "= #rollouts: " << num_rollouts << " x " << num_steps
+      << " time steps of 1ms, up to " << max_threads << " threads" << endl;
+  }
+
+  model_name = "Human36";
+
+  for (unsigned int num_threads = 1; num_threads < max_threads;
+      num_threads *= 2) {
+    run_rollout_benchmark (model, num_threads, Q0, QDot0, controls, buffer);
+  }
+  run_rollout_benchmark (model, max_threads, Q0, QDot0, controls, buffer);
+
+  delete model;
+}
+
+/** Evaluates the dynamics of all samples at once, the duration of a
+ * sample is the average over all samples. */
+void report_batch_run (Model *model, SampleData &sample_data,
+    double duration, const char *run_name) {
+  sample_data.durations.setConstant (duration / sample_data.count);
+  register_run(*model, sample_data, run_name);
+
+  if (!json_output) {
+    cout << setw(36) << left << run_name << right << ": "
+         << " duration = " << setw(10) << duration << "(s)"
+         << " (~" << setw(10) << duration / sample_data.count
+         << "(s) per state)" << endl;
+  }
+}
+
+void batch_dynamics_benchmark (int sample_count) {
+  Model *model = new Model();
+  generate_human36model(model);
+
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  MatrixNd Q (model->q_size, sample_count);
+  MatrixNd QDot (model->qdot_size, sample_count);
+  MatrixNd QDDot (model->qdot_size, sample_count);
+  MatrixNd Tau (model->qdot_size, sample_count);
+  for (int i = 0; i < sample_count; i++) {
+    Q.col(i) = sample_data.q[i];
+    QDot.col(i) = sample_data.qdot[i];
+    Tau.col(i) = sample_data.tau[i];
+  }
+
+  BatchWorkspace workspace;
+  workspace.Bind (*model);
+
+  if (!json_output) {
+    cout << "= #DOF: " << setw(3) << model->dof_count << endl;
+    cout << "= #samples: " << sample_count << ", " << workspace.lanes
+      << " lanes" << (workspace.lane_parallel ? "" : " (scalar fallback)")
+      << endl;
+  }
+
+  model_name = "Human36";
+  TimerInfo tinfo;
+
+  timer_start (&tinfo);
+  for (int i = 0; i < sample_count; i++) {
+    ForwardDynamics (*model, sample_data.q[i], sample_data.qdot[i],
+        sample_data.tau[i], sample_data.qddot[i]);
+  }
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "ForwardDynamics (scalar)");
+
+  timer_start (&tinfo);
+  ForwardDynamicsBatch (*model, Q, QDot, Tau, workspace, QDDot);
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "ForwardDynamicsBatch");
+
+  timer_start (&tinfo);
+  for (int i = 0; i < sample_count; i++) {
+    InverseDynamics (*model, sample_data.q[i], sample_data.qdot[i],
+        sample_data.qddot[i], sample_data.tau[i]);
+  }
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "InverseDynamics (scalar)");
+
+  timer_start (&tinfo);
+  InverseDynamicsBatch (*model, Q, QDot, QDDot, workspace, Tau);
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "InverseDynamicsBatch");
+
+  unsigned int hand_id = model->GetBodyId ("hand_r");
+  MatrixNd points (3, sample_count);
+
+  timer_start (&tinfo);
+  for (int i = 0; i < sample_count; i++) {
+    points.col(i) = CalcBodyToBaseCoordinates (*model, sample_data.q[i],
+        hand_id, Vector3d (0., 0., -0.1));
+  }
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "CalcBodyToBaseCoordinates (scalar)");
+
+  timer_start (&tinfo);
+  CalcBodyToBaseCoordinatesBatch (*model, Q, hand_id, Vector3d (0., 0., -0.1),
+      workspace, points);
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "CalcBodyToBaseCoordinatesBatch");
+
+  delete model;
+}
+
+/** Maximum deviation of the entries of M from the reference, relative to
+ * the largest entry of the reference. */
+double max_relative_error (const MatrixNd &reference, const MatrixNd &M) {
+  return (M - reference).cwiseAbs().maxCoeff()
+    / reference.cwiseAbs().maxCoeff();
+}
+
+void precision_benchmark (int sample_count) {
+  Model *model = new Model();
+  generate_human36model(model);
+
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  MatrixNd Q (model->q_size, sample_count);
+  MatrixNd QDot (model->qdot_size, sample_count);
+  MatrixNd QDDot (model->qdot_size, sample_count);
+  MatrixNd QDDot_random (model->qdot_size, sample_count);
+  MatrixNd Tau (model->qdot_size, sample_count);
+  for (int i = 0; i < sample_count; i++) {
+    Q.col(i) = sample_data.q[i];
+    QDot.col(i) = sample_data.qdot[i];
+    QDDot_random.col(i) = sample_data.qddot[i];
+    Tau.col(i) = sample_data.tau[i];
+  }
+
+  MatrixNf Qf = Q.cast<float>();
+  MatrixNf QDotf = QDot.cast<float>();
+  MatrixNf Tauf = Tau.cast<float>();
+  MatrixNf QDDotf (model->qdot_size, sample_count);
+  MatrixNf Tau_float (model->qdot_size, sample_count);
+  MatrixNd Tau_double (model->qdot_size, sample_count);
+
+  BatchWorkspace workspace;
+  workspace.Bind (*model);
+
+  if (!json_output) {
+    cout << "= #DOF: " << setw(3) << model->dof_count << endl;
+    cout << "= #samples: " << sample_count << ", " << workspace.lanes
+      << " lanes (double), " << workspace.lanes_float << " lanes (float)"
+      << endl;
+  }
+
+  model_name = "Human36";
+  TimerInfo tinfo;
+
+  timer_start (&tinfo);
+  ForwardDynamicsBatch (*model, Q, QDot, Tau, workspace, QDDot);
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "ForwardDynamicsBatch (double)");
+
+  timer_start (&tinfo);
+  ForwardDynamicsBatch (*model, Qf, QDotf, Tauf, workspace, QDDotf);
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "ForwardDynamicsBatch (float)");
+
+  MatrixNf QDDot_float = QDDot_random.cast<float>();
+
+  timer_start (&tinfo);
+  InverseDynamicsBatch (*model, Q, QDot, QDDot_random, workspace,
+      Tau_double);
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "InverseDynamicsBatch (double)");
+
+  timer_start (&tinfo);
+  InverseDynamicsBatch (*model, Qf, QDotf, QDDot_float, workspace, Tau_float);
+  report_batch_run (model, sample_data, timer_stop (&tinfo),
+      "InverseDynamicsBatch (float)");
+
+  if (!json_output) {
+    cout << "= max. relative error (float): qddot = "
+      << max_relative_error (QDDot, QDDotf.cast<double>()) << ", tau = "
+      << max_relative_error (Tau_double, Tau_float.cast<double>()) << endl;
+  }
+
+  // four bodies with three contact constraints each
+  const char *body_names[4] = { "foot_r", "foot_l", "hand_r", "hand_l" };
+  ConstraintSet cs;
+  for (unsigned int i = 0; i < 4; i++) {
+    cs.AddContactConstraint (model->GetBodyId (body_names[i]),
+        Vector3d (0.1, 0., -0.05), Vector3d (1., 0., 0.));
+    cs.AddContactConstraint (model->GetBodyId (body_names[i]),
+        Vector3d (0.1, 0., -0.05), Vector3d (0., 1., 0.));
+    cs.AddContactConstraint (model->GetBodyId (body_names[i]),
+        Vector3d (0.1, 0., -0.05), Vector3d (0., 0., 1.));
+  }
+  ConstraintSet cs_mixed = cs.Copy();
+  cs.linear_solver = LinearSolverPartialPivLU;
+  cs_mixed.linear_solver = LinearSolverMixedPrecisionLU;
+  cs.Bind (*model);
+  cs_mixed.Bind (*model);
+
+  MatrixNd QDDot_mixed (model->qdot_size, sample_count);
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    ForwardDynamicsConstraintsDirect (*model, sample_data.q[i],
+        sample_data.qdot[i], sample_data.tau[i], cs, sample_data.qddot[i]);
+    sample_data.durations[i] = timer_stop (&tinfo);
+    QDDot.col(i) = sample_data.qddot[i];
+  }
+  if (!json_output) {
+    cout << "= ForwardDynamicsConstraintsDirect (PartialPivLU):" << endl;
+  }
+  report_constraints_run(*model, sample_data,
+      "ForwardDynamicsConstraintsDirect (PartialPivLU)");
+
+  for (int i = 0; i < sample_count; i++) {
+    timer_start (&tinfo);
+    ForwardDynamicsConstraintsDirect (*model, sample_data.q[i],
+        sample_data.qdot[i], sample_data.tau[i], cs_mixed,
+        sample_data.qddot[i]);
+    sample_data.durations[i] = timer_stop (&tinfo);
+    QDDot_mixed.col(i) = sample_data.qddot[i];
+  }
+  if (!json_output) {
+    cout << "= ForwardDynamicsConstraintsDirect (MixedPrecisionLU):" << endl;
+  }
+  report_constraints_run(*model, sample_data,
+      "ForwardDynamicsConstraintsDirect (MixedPrecisionLU)");
+
+  if (!json_output) {
+    cout << "= max. relative error (mixed precision): qddot = "
+      << max_relative_error (QDDot, QDDot_mixed) << endl;
+  }
+
+  delete model;
+}
+
+/** Evaluates the constraints of the Human36 model with contacts at both
+ * feet and hands and loop constraints between the hands and the feet using
+ * num_threads threads of the ConstraintSet. The wall clock time is measured
+ * as clock() sums up the time of all threads. */
+void run_constraint_threads_benchmark (Model *model, SampleData &sample_data,
+    unsigned int num_threads) {
+  unsigned int foot_r = model->GetBodyId ("foot_r");
+  unsigned int foot_l = model->GetBodyId ("foot_l");
+  unsigned int hand_r = model->GetBodyId ("hand_r");
+  unsigned int hand_l = model->GetBodyId ("hand_l");
+  unsigned int contact_bodies[4] = { foot_r, foot_l, hand_r, hand_l };
+
+  ConstraintSet constraint_set;
+  for (unsigned int i = 0; i < 4; i++) {
+    constraint_set.AddContactConstraint (contact_bodies[i],
+        Vector3d (0.1, 0., -0.05), Vector3d (1., 0., 0.));
+    constraint_set.AddContactConstraint (contact_bodies[i],
+        Vector3d (0.1, 0., -0.05), Vector3d (0., 1., 0.));
+    constraint_set.AddContactConstraint (contact_bodies[i],
+        Vector3d (0.1, 0., -0.05), Vector3d (0., 0., 1.));
+  }
+
+  SpatialTransform X_hand (Matrix3d::Identity(), Vector3d (0., 0., -0.1));
+  SpatialTransform X_foot (Matrix3d::Identity(), Vector3d (0.1, 0., -0.05));
+  for (unsigned int i = 0; i < 3; i++) {
+    SpatialVector axis (SpatialVector::Zero());
+    axis[3 + i] = 1.;
+    constraint_set.AddLoopConstraint (hand_r, foot_r, X_hand, X_foot, axis);
+    constraint_set.AddLoopConstraint (hand_l, foot_l, X_hand, X_foot, axis);
+  }
+
+  constraint_set.SetNumThreads (num_threads);
+  constraint_set.Bind (*model);
+
+  ostringstream run_name;
+  run_name << "CalcConstrainedSystemVariables (" << num_threads << " threads)";
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (unsigned int i = 0; i < sample_data.count; i++) {
+    CalcConstrainedSystemVariables (*model, sample_data.q[i],
+        sample_data.qdot[i], sample_data.tau[i], constraint_set);
+  }
+  double duration = chrono::duration<double> (
+      chrono::steady_clock::now() - start).count();
+  report_batch_run (model, sample_data, duration, run_name.str().c_str());
+}
+
+void constraint_threads_benchmark (int sample_count) {
+  Model *model = new Model();
+  generate_human36model(model);
+
+  SampleData sample_data;
+  sample_data.fillRandom(model->dof_count, sample_count);
+
+  if (!json_output) {
+    cout << "= #DOF: " << setw(3) << model->dof_count << endl;
+    cout << "= #samples: " << sample_count << endl;
+  }
+
+  model_name = "Human36";
+
+  run_constraint_threads_benchmark (model, sample_data, 1);
+  run_constraint_threads_benchmark (model, sample_data, 2);
+  run_constraint_threads_benchmark (model, sample_data, 4);
+
+  delete model;
+}
+
 void print_usage () {
 #if defined (RBDL_BUILD_ADDON_LUAMODEL) || defined (RBDL_BUILD_ADDON_URDFREADER)
   cout << "Usage: benchmark [--count|-c <sample_count>] [--depth|-d <depth>] <model.lua>" << endl;
@@ -708,6 +1654,24 @@ void print_usage () {
   cout << "                                body algorithm." << endl;
   cout << "  --no-nle                    : disables benchmark for the nonlinear effects." << endl;
   cout << "  --no-calc-minv              : disables benchmark M^-1 * tau benchmark." << endl;
+  cout << "  --no-gravity                : disables benchmark for the gravity torques." << endl;
+  cout << "  --no-coriolis               : disables benchmark for the coriolis matrix." << endl;
+  cout << "  --no-osim                   : disables benchmark for the operational space" << endl;
+  cout << "                                inertia matrix." << endl;
+  cout << "  --no-frictional-contacts    : disables benchmark for the frictional contact" << endl;
+  cout << "                                solver." << endl;
+  cout << "  --no-multi-dof              : disables benchmark for emulated and native" << endl;
+  cout << "                                multi-dof joints." << endl;
+  cout << "  --no-simulator              : disables benchmark for the integrators of the" << endl;
+  cout << "                                simulator." << endl;
+  cout << "  --no-rollouts               : disables benchmark for the throughput of the" << endl;
+  cout << "                                parallel rollout engine." << endl;
+  cout << "  --no-batch                  : disables benchmark for the lane-parallel batch" << endl;
+  cout << "                                dynamics." << endl;
+  cout << "  --no-precision              : disables benchmark for the single and mixed" << endl;
+  cout << "                                precision batch dynamics and solvers." << endl;
+  cout << "  --no-constraint-threads     : disables benchmark for the evaluation of" << endl;
+  cout << "                                constraints on multiple threads." << endl;
   cout << "  --only-contacts | -C        : only runs contact model benchmarks." << endl;
   cout << "  --only-ik                   : only runs inverse kinematics benchmarks." << endl;
   cout << "  --help | -h                 : prints this help." << endl;
@@ -720,7 +1684,17 @@ void disable_all_benchmarks () {
   benchmark_run_crba = false;
   benchmark_run_nle = false;
   benchmark_run_calc_minv_times_tau = false;
+  benchmark_run_gravity_torques = false;
+  benchmark_run_coriolis_matrix = false;
+  benchmark_run_operational_space = false;
   benchmark_run_contacts = false;
+  benchmark_run_frictional_contacts = false;
+  benchmark_run_multi_dof_joints = false;
+  benchmark_run_simulator = false;
+  benchmark_run_rollouts = false;
+  benchmark_run_batch_dynamics = false;
+  benchmark_run_precision = false;
+  benchmark_run_constraint_threads = false;
 }
 
 void parse_args (int argc, char* argv[]) {
@@ -777,9 +1751,30 @@ void parse_args (int argc, char* argv[]) {
       benchmark_run_nle = false;
     } else if (arg == "--no-calc-minv" ) {
       benchmark_run_calc_minv_times_tau = false;
+    } else if (arg == "--no-gravity" ) {
+      benchmark_run_gravity_torques = false;
+    } else if (arg == "--no-coriolis" ) {
+      benchmark_run_coriolis_matrix = false;
+    } else if (arg == "--no-osim" ) {
+      benchmark_run_operational_space = false;
+    } else if (arg == "--no-frictional-contacts" ) {
+      benchmark_run_frictional_contacts = false;
+    } else if (arg == "--no-multi-dof" ) {
+      benchmark_run_multi_dof_joints = false;
+    } else if (arg == "--no-simulator" ) {
+      benchmark_run_simulator = false;
+    } else if (arg == "--no-rollouts" ) {
+      benchmark_run_rollouts = false;
+    } else if (arg == "--no-batch" ) {
+      benchmark_run_batch_dynamics = false;
+    } else if (arg == "--no-precision" ) {
+      benchmark_run_precision = false;
+    } else if (arg == "--no-constraint-threads" ) {
+      benchmark_run_constraint_threads = false;
     } else if (arg == "--only-contacts" || arg == "-C") {
       disable_all_benchmarks();
       benchmark_run_contacts = true;
+      benchmark_run_frictional_contacts = true;
     } else if (arg == "--only-ik") {
       disable_all_benchmarks();
       benchmark_run_ik = true;
@@ -846,6 +1841,18 @@ int main (int argc, char *argv[]) {
       run_nle_benchmark (model, benchmark_sample_count);
     }
 
+    if (benchmark_run_gravity_torques) {
+      report_section("Gravity Torques");
+      run_gravity_torques_id_benchmark (model, benchmark_sample_count);
+      run_gravity_torques_benchmark (model, benchmark_sample_count);
+    }
+
+    if (benchmark_run_coriolis_matrix) {
+      report_section("Coriolis Matrix");
+      run_coriolis_matrix_nle_benchmark (model, benchmark_sample_count);
+      run_coriolis_matrix_benchmark (model, benchmark_sample_count);
+    }
+
     delete model;
 
     return 0;
@@ -944,10 +1951,48 @@ int main (int argc, char *argv[]) {
     }
   }
 
+  if (benchmark_run_gravity_torques) {
+    report_section("Gravity Torques");
+    for (int depth = 1; depth <= benchmark_model_max_depth; depth++) {
+      model = new Model();
+      model->gravity = Vector3d (0., -9.81, 0.);
+
+      generate_planar_tree (model, depth);
+
+      run_gravity_torques_id_benchmark (model, benchmark_sample_count);
+      run_gravity_torques_benchmark (model, benchmark_sample_count);
+
+      delete model;
+    }
+  }
+
+  if (benchmark_run_coriolis_matrix) {
+    report_section("Coriolis Matrix");
+    for (int depth = 1; depth <= benchmark_model_max_depth; depth++) {
+      model = new Model();
+      model->gravity = Vector3d (0., -9.81, 0.);
+
+      generate_planar_tree (model, depth);
+
+      run_coriolis_matrix_nle_benchmark (model, benchmark_sample_count);
+      run_coriolis_matrix_benchmark (model, benchmark_sample_count);
+
+      delete model;
+    }
+  }
+
+  if (benchmark_run_operational_space) {
+    report_section("Operational Space Inertia");
+    operational_space_benchmark (benchmark_sample_count);
+  }
+
   if (benchmark_run_contacts) {
     report_section("Contacts: ForwardDynamicsConstraintsDirect");
     contacts_benchmark (benchmark_sample_count, ConstraintsMethodDirect);
 
+    report_section("Contacts: ForwardDynamicsConstraintsDirect (LLT, compliant)");
+    contacts_benchmark (benchmark_sample_count, ConstraintsMethodDirectCompliant);
+
     report_section("Contacts: ForwardDynamicsConstraintsRangeSpaceSparse");
     contacts_benchmark (benchmark_sample_count, ConstraintsMethodRangeSpaceSparse);
 
@@ -956,6 +2001,44 @@ int main (int argc, char *argv[]) {
 
     report_section("Contacts: ForwardDynamicsContactsKokkevis");
     contacts_benchmark (benchmark_sample_count, ConstraintsMethodKokkevis);
+
+    report_section("Contacts: null-space method with contact switching");
+    null_space_switching_benchmark (benchmark_sample_count);
+  }
+
+  if (benchmark_run_frictional_contacts) {
+    report_section("Frictional Contacts: SolveFrictionalContactImpulses");
+    frictional_contacts_benchmark (benchmark_sample_count);
+  }
+
+  if (benchmark_run_multi_dof_joints) {
+    report_section("Multi-DoF Joints: emulated vs. native (FD, ID, CRBA, M^-1 tau)");
+    multi_dof_joints_benchmark (benchmark_sample_count);
+  }
+
+  if (benchmark_run_simulator) {
+    report_section("Simulator: Simulator::Step()");
+    simulator_benchmark (benchmark_sample_count);
+  }
+
+  if (benchmark_run_rollouts) {
+    report_section("Rollouts: RolloutEngine::Run()");
+    rollout_benchmark (benchmark_sample_count);
+  }
+
+  if (benchmark_run_batch_dynamics) {
+    report_section("Batch Dynamics: scalar vs. lane-parallel");
+    batch_dynamics_benchmark (benchmark_sample_count);
+  }
+
+  if (benchmark_run_precision) {
+    report_section("Precision: single vs. double and mixed precision solves");
+    precision_benchmark (benchmark_sample_count);
+  }
+
+  if (benchmark_run_constraint_threads) {
+    report_section("Constraint Threads: CalcConstrainedSystemVariables");
+    constraint_threads_benchmark (benchmark_sample_count);
   }
 
   if (benchmark_run_ik) {
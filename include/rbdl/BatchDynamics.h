@@ -0,0 +1,217 @@
+/*
+ * RBDL - Rigid Body Dynamics Library
+ * Copyright (c) 2011-2018 Martin Felis <martin@fysx.org>
+ *
+ * Licensed under the zlib license. See LICENSE for more details.
+ */
+
+#ifndef RBDL_BATCH_DYNAMICS_H
+#define RBDL_BATCH_DYNAMICS_H
+
+#include <memory>
+
+#include <rbdl/rbdl_math.h>
+#include <rbdl/Model.h>
+
+#ifndef RBDL_USE_CASADI_MATH
+
+namespace RigidBodyDynamics {
+
+/** \page batch_dynamics_page Batch Dynamics
+ *
+ * The batch functions evaluate the dynamics of the same model for many
+ * states at once, e.g. for sampling based planning or the evaluation of
+ * finite differences. Each state is one column of the input and output
+ * matrices.
+ *
+ * Instead of vectorizing the 3 and 6 dimensional spatial operations of a
+ * single state, the states are processed in groups of
+ * BatchWorkspace::lanes states that occupy the lanes of the SIMD
+ * registers: every scalar of the articulated body algorithm, the
+ * recursive Newton-Euler algorithm and the forward kinematics becomes a
+ * packet of one value per state and all states of a group take the same
+ * control flow. A last group that is not full is padded with the last
+ * state.
+ *
+ * The lane-parallel evaluation supports joints of type JointTypeRevolute,
+ * JointTypeRevoluteX, JointTypeRevoluteY, JointTypeRevoluteZ,
+ * JointTypePrismatic, JointTypeSpherical and JointTypeTranslationXYZ,
+ * i.e. also floating bases and emulated multi degree of freedom joints.
+ * Models that contain other joints (e.g. custom joints or Euler joints)
+ * are evaluated state by state with the scalar functions instead, see
+ * BatchWorkspace::lane_parallel. External forces are not supported.
+ *
+ * \code
+ * BatchWorkspace workspace;
+ * workspace.Bind (model);
+ *
+ * MatrixNd QDDot (model.qdot_size, num_states);
+ * ForwardDynamicsBatch (model, Q, QDot, Tau, workspace, QDDot);
+ * \endcode
+ *
+ * All batch functions are also available in single precision (MatrixNf
+ * inputs and outputs). The single precision evaluation processes
+ * BatchWorkspace::lanes_float = 2 * BatchWorkspace::lanes states at once
+ * and is meant for applications that tolerate relative errors of about
+ * 1.0e-5, e.g. sampling based planning or learning. The constant
+ * quantities of the model are rounded once when binding the workspace.
+ * Models that are not evaluated lane-parallel are still evaluated in
+ * double precision.
+ *
+ * \code
+ * MatrixNf QDDotf (model.qdot_size, num_states);
+ * ForwardDynamicsBatch (model, MatrixNf (Q.cast<float>()),
+ *     MatrixNf (QDot.cast<float>()), MatrixNf (Tau.cast<float>()),
+ *     workspace, QDDotf);
+ * \endcode
+ *
+ * \note The number of lanes is 8 if the library is compiled with AVX-512
+ * and 4 otherwise. It can be set with the compile definition
+ * RBDL_BATCH_LANES when building the library.
+ *
+ * \note Not available with CasADi.
+ *
+ * \defgroup batch_dynamics_group Batch Dynamics
+ * @{
+ */
+
+struct BatchLaneData;
+
+/** \brief Per-body workspace of the batch functions.
+ *
+ * The lane-parallel quantities are kept in a private structure, as their
+ * size depends on the SIMD width the library was compiled with.
+ */
+struct RBDL_DLLAPI BatchWorkspace {
+  BatchWorkspace();
+
+  /** \brief Allocates the workspace for the model and determines whether
+   * all joints of the model support the lane-parallel evaluation.
+   *
+   * Has to be called again if the model changes.
+   */
+  bool Bind (const Model &model);
+
+  /// Number of states that are evaluated at once.
+  unsigned int lanes;
+  /// Number of states that are evaluated at once in single precision.
+  unsigned int lanes_float;
+  /** \brief Whether the model is evaluated lane-parallel (otherwise state
+   * by state with the scalar functions). */
+  bool lane_parallel;
+  bool bound;
+
+  // Workspace of the scalar evaluation
+  Math::VectorNd q;
+  Math::VectorNd qdot;
+  Math::VectorNd qddot;
+  Math::VectorNd tau;
+
+  std::shared_ptr<BatchLaneData> lane_data;
+};
+
+/** \brief Computes the forward dynamics with the Articulated Body
+ * Algorithm for every column of Q, QDot and Tau.
+ *
+ * \param model rigid body model
+ * \param Q     state vectors of the internal joints (q_size x num_states)
+ * \param QDot  velocity vectors of the internal joints (qdot_size x
+ * num_states)
+ * \param Tau   actuations of the internal joints (qdot_size x num_states)
+ * \param workspace workspace bound to the model
+ * \param QDDot accelerations of the internal joints (output, has to be of
+ * size qdot_size x num_states)
+ *
+ * \note Unlike ForwardDynamics() the lane-parallel evaluation leaves the
+ * kinematic quantities stored in the model untouched.
+ */
+RBDL_DLLAPI void ForwardDynamicsBatch (
+    Model &model,
+    const Math::MatrixNd &Q,
+    const Math::MatrixNd &QDot,
+    const Math::MatrixNd &Tau,
+    BatchWorkspace &workspace,
+    Math::MatrixNd &QDDot
+    );
+
+/** \brief Single precision version of ForwardDynamicsBatch(). */
+RBDL_DLLAPI void ForwardDynamicsBatch (
+    Model &model,
+    const Math::MatrixNf &Q,
+    const Math::MatrixNf &QDot,
+    const Math::MatrixNf &Tau,
+    BatchWorkspace &workspace,
+    Math::MatrixNf &QDDot
+    );
+
+/** \brief Computes the inverse dynamics with the Newton-Euler Algorithm
+ * for every column of Q, QDot and QDDot.
+ *
+ * \param model rigid body model
+ * \param Q     state vectors of the internal joints (q_size x num_states)
+ * \param QDot  velocity vectors of the internal joints (qdot_size x
+ * num_states)
+ * \param QDDot accelerations of the internal joints (qdot_size x
+ * num_states)
+ * \param workspace workspace bound to the model
+ * \param Tau   actuations of the internal joints (output, has to be of
+ * size qdot_size x num_states)
+ */
+RBDL_DLLAPI void InverseDynamicsBatch (
+    Model &model,
+    const Math::MatrixNd &Q,
+    const Math::MatrixNd &QDot,
+    const Math::MatrixNd &QDDot,
+    BatchWorkspace &workspace,
+    Math::MatrixNd &Tau
+    );
+
+/** \brief Single precision version of InverseDynamicsBatch(). */
+RBDL_DLLAPI void InverseDynamicsBatch (
+    Model &model,
+    const Math::MatrixNf &Q,
+    const Math::MatrixNf &QDot,
+    const Math::MatrixNf &QDDot,
+    BatchWorkspace &workspace,
+    Math::MatrixNf &Tau
+    );
+
+/** \brief Computes the base coordinates of a point on a body for every
+ * column of Q.
+ *
+ * \param model rigid body model
+ * \param Q     state vectors of the internal joints (q_size x num_states)
+ * \param body_id id of the body (may be a fixed body)
+ * \param point_body_coordinates coordinates of the point in body
+ * coordinates
+ * \param workspace workspace bound to the model
+ * \param points base coordinates of the point (output, has to be of size
+ * 3 x num_states)
+ */
+RBDL_DLLAPI void CalcBodyToBaseCoordinatesBatch (
+    Model &model,
+    const Math::MatrixNd &Q,
+    unsigned int body_id,
+    const Math::Vector3d &point_body_coordinates,
+    BatchWorkspace &workspace,
+    Math::MatrixNd &points
+    );
+
+/** \brief Single precision version of CalcBodyToBaseCoordinatesBatch(). */
+RBDL_DLLAPI void CalcBodyToBaseCoordinatesBatch (
+    Model &model,
+    const Math::MatrixNf &Q,
+    unsigned int body_id,
+    const Math::Vector3d &point_body_coordinates,
+    BatchWorkspace &workspace,
+    Math::MatrixNf &points
+    );
+
+/** @} */
+
+}
+
+#endif
+
+/* RBDL_BATCH_DYNAMICS_H */
+#endif
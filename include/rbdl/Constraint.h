@@ -391,7 +391,8 @@ class RBDL_DLLAPI Constraint {
                id(userDefinedIdNumber),
                sizeOfConstraint(sizeOfConstraint),
                baumgarteParameters(1./0.1,1./0.1),
-               baumgarteEnabled(false)
+               baumgarteEnabled(false),
+               compliance(0.)
     {
       name = "";
       if(nameOfConstraint){
@@ -574,6 +575,45 @@ class RBDL_DLLAPI Constraint {
       return baumgarteEnabled;
     }
 
+    /**
+      @brief Sets the compliance of this constraint. A compliant constraint
+              only has to satisfy
+              \f$ G \ddot{q} = \gamma - c \lambda \f$
+              where \f$\lambda\f$ is the constraint force (the constraint
+              force mixing of ODE). Together with Baumgarte stabilization,
+              which damps the position and velocity errors, this gives a
+              soft constraint.
+
+              A compliance greater than zero regularizes the constrained
+              system: \f$ G H^{-1} G^T + \textrm{diag}(c) \f$ stays positive
+              definite even for redundant constraints so that it can be
+              factorized with LinearSolverLLT or LinearSolverLDLT.
+
+      @param complianceOfConstraint : the compliance \f$c \geq 0\f$ of all
+              equations of this constraint (default: 0, i.e. rigid).
+    */
+    void setCompliance(double complianceOfConstraint){
+      assert(complianceOfConstraint >= 0.);
+      compliance = complianceOfConstraint;
+    }
+
+    /**
+      @return the compliance of this constraint.
+    */
+    double getCompliance(){
+      return compliance;
+    }
+
+    /**
+      @param complianceSysOutput: the compliance vector of the system in
+              which the entries of this constraint are set.
+    */
+    void setComplianceInSystem(Math::VectorNd &complianceSysOutput){
+      for(unsigned int i=0; i<sizeOfConstraint;++i){
+        complianceSysOutput[rowInSystem+i] = compliance;
+      }
+    }
+
 
     /**
       @brief: Will set the vectors positionConstraint and velocityConstraint
@@ -704,6 +744,27 @@ class RBDL_DLLAPI Constraint {
       return bodyFrames;
     }
 
+    /**
+      @return the columns of G in which the rows of this constraint can be
+              non-zero, sorted in ascending order. An empty vector means
+              that the rows of this constraint are treated as dense.
+    */
+    const std::vector< unsigned int >& getJacobianColumns(){
+      return jacobianColumns;
+    }
+
+    /**
+      @brief This function is called by ConstraintSet::Bind when the sparse
+              constraint Jacobian is enabled. DO NOT TOUCH THIS.
+      @param columns: the columns of G in which the rows of this constraint
+              can be non-zero, sorted in ascending order. Implementations
+              that honor this list only write (and read) these columns of
+              their rows in G.
+    */
+    void setJacobianColumns(const std::vector< unsigned int > &columns){
+      jacobianColumns = columns;
+    }
+
   protected:
     ///A user defined name which is unique to this constraint set
     std::string name;
@@ -732,6 +793,9 @@ class RBDL_DLLAPI Constraint {
     ///A flag which enables or disables Baumgarte stabilization
     bool baumgarteEnabled;
 
+    ///The compliance (constraint force mixing) of the constraint equations
+    double compliance;
+
     ///A mask that is used to selectively enable/disable the calculation of
     /// position-level and velocity-level errors. These errors are used to
     /// functions that assemble the system at the position and velocity levels,
@@ -739,6 +803,10 @@ class RBDL_DLLAPI Constraint {
     /// position and velocity level.
     std::vector< bool > positionConstraint;
     std::vector< bool > velocityConstraint;
+
+    ///The columns of G in which the rows of this constraint can be non-zero.
+    ///Empty if the rows of this constraint are treated as dense.
+    std::vector< unsigned int > jacobianColumns;
 };
 
 
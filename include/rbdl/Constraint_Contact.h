@@ -15,6 +15,58 @@
 
 namespace RigidBodyDynamics {
 
+/**
+  @brief Kinematic quantities of a body that are shared by all
+          ContactConstraint objects acting on points of this body.
+
+  ConstraintSet::Bind groups the contact constraints by their (movable) body.
+  These quantities are then evaluated once per body and every
+  ContactConstraint of the group only projects them onto its point and its
+  normal directions.
+*/
+struct RBDL_DLLAPI ContactBodyKinematics {
+  ContactBodyKinematics() :
+    referenceBodyId (0) {}
+
+  /**
+    @brief Allocates the Jacobian and collects the degrees of freedom of
+            the ancestors of the body.
+    @param model the multibody model
+    @param bodyId the movable body (fixed bodies are resolved to their
+            movable parent)
+  */
+  void bind(const Model &model, unsigned int bodyId);
+
+  /**
+    @brief Copies the orientation, position, velocity and (bias)
+            acceleration of the body from the model, whose kinematics
+            have to be up to date.
+  */
+  void update(const Model &model);
+
+  /**
+    @brief Evaluates the columns of J that belong to the ancestors of the
+            body, the remaining columns are not touched.
+  */
+  void updateJacobian(const Model &model);
+
+  ///The movable body
+  unsigned int referenceBodyId;
+  ///Orientation of the body (transforms base to body coordinates)
+  Math::Matrix3d E;
+  ///Position of the origin of the body in base coordinates
+  Math::Vector3d r;
+  ///Spatial velocity of the body in body coordinates
+  Math::SpatialVector v;
+  ///Spatial acceleration of the body in body coordinates
+  Math::SpatialVector a;
+  ///6 x N motion subspaces of the ancestor joints in base coordinates, i.e.
+  ///the spatial Jacobian of the body at the origin of the base frame
+  Math::MatrixNd J;
+  ///Degrees of freedom of the ancestor joints of the body
+  std::vector< unsigned int > columns;
+};
+
 /**
   @brief Implements a rigid kinematic body-point--to--ground constraint along a 
           normal direction as described in Ch. 11 of Featherstone's Rigid Body 
@@ -263,6 +315,53 @@ public:
           std::vector<Math::SpatialVector> &fExtSysUpd,
           bool updateKinematics=false);
 
+  /**
+    @brief Evaluates the rows of this constraint in the constraint Jacobian
+            from the Jacobian of its body, which is shared by all
+            contact constraints on this body.
+    @param body the kinematics of the body of this constraint
+            (ContactBodyKinematics::update and
+             ContactBodyKinematics::updateJacobian have been called)
+    @param GSysUpd the constraint Jacobian of the system
+  */
+  void calcConstraintJacobian(const ContactBodyKinematics &body,
+                              Math::MatrixNd &GSysUpd);
+
+  /**
+    @brief Evaluates the entries of this constraint in gamma from the
+            shared kinematics of its body.
+    @param body the kinematics of the body of this constraint (updated after
+            the accelerations of the model were evaluated with zero
+            generalized accelerations)
+    @param gammaSysUpd the right hand side of the acceleration equation of
+            the system
+  */
+  void calcGamma(const ContactBodyKinematics &body,
+                 Math::VectorNd &gammaSysUpd);
+
+  /**
+    @brief Evaluates the position errors of this constraint from the shared
+            kinematics of its body.
+  */
+  void calcPositionError(const ContactBodyKinematics &body,
+                         Math::VectorNd &errSysUpd);
+
+  /**
+    @brief Evaluates the velocity errors of this constraint from the shared
+            kinematics of its body.
+  */
+  void calcVelocityError(const ContactBodyKinematics &body,
+                         Math::VectorNd &derrSysUpd);
+
+  /**
+    @return the contact point in the coordinates of the movable body
+            that carries it (differs from getBodyFrames()[0].r only if
+            the constraint is attached to a fixed body). Set in bind().
+  */
+  const Math::Vector3d& getReferencePoint(){
+    return referencePoint;
+  }
+
 private:
   ///A vector of the ground normal vectors used in this constraint.
   std::vector< Math::Vector3d > T;
@@ -270,6 +369,8 @@ private:
   Math::Vector3d groundPoint;
   ///A working double 
   double dblA;
+  ///The contact point in the coordinates of the movable body
+  Math::Vector3d referencePoint;
 
 };
 
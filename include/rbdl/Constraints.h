@@ -12,6 +12,7 @@
 
 #include <rbdl/rbdl_math.h>
 #include <rbdl/rbdl_mathutils.h>
+#include <rbdl/rbdl_errors.h>
 #include <rbdl/Kinematics.h>
 #include <rbdl/Constraint.h>
 #include <rbdl/Constraint_Contact.h>
@@ -269,6 +270,264 @@ struct Model;
 //class RBDL_DLLAPI Constraint;
 
 
+/** \brief Structural non-zero pattern of a constraint Jacobian.
+ *
+ * The rows of a contact constraint can only be non-zero in the columns of
+ * the joints that lie between the constrained body and the root, and the
+ * rows of a loop constraint in the columns of the two chains of its
+ * bodies. The pattern stores, in a compressed row format, the columns in
+ * which every row of G can be non-zero. The values themselves stay in the
+ * dense ConstraintSet::G, however all operations that use the pattern only
+ * touch the listed entries.
+ *
+ * The columns of row i are
+ * columns[rowStart[i]] ... columns[rowStart[i+1]-1] (sorted ascending).
+ * The set of columns of every row is closed under Model::lambda_q, i.e. it
+ * contains all ancestor degrees of freedom of each of its columns.
+ */
+struct RBDL_DLLAPI ConstraintJacobianPattern {
+  /** \brief Computes \f$ y = G x \f$ using only the listed entries of G. */
+  void multiply (
+    const Math::MatrixNd &G,
+    const Math::VectorNd &x,
+    Math::VectorNd &y) const;
+
+  /** \brief Computes \f$ y = G^T x \f$ using only the listed entries of G.
+   */
+  void multiplyTranspose (
+    const Math::MatrixNd &G,
+    const Math::VectorNd &x,
+    Math::VectorNd &y) const;
+
+  /** \brief Returns the number of rows described by the pattern. */
+  size_t rows() const {
+    return rowStart.empty() ? 0 : rowStart.size() - 1;
+  }
+
+  /// Index into columns of the first entry of each row (size rows()+1).
+  std::vector<unsigned int> rowStart;
+  /// Column indices of the structural non-zeros of all rows.
+  std::vector<unsigned int> columns;
+};
+
+/** \brief Contact constraints of a ConstraintSet that act on the same
+ * movable body.
+ *
+ * ConstraintSet::Bind() groups contact constraints on the same body (fixed
+ * bodies are resolved to their movable parent). The transformation, the
+ * Jacobian and the bias acceleration of the body are then evaluated once
+ * per group instead of once per constraint.
+ */
+struct RBDL_DLLAPI ContactConstraintGroup {
+  /// Kinematic quantities of the body shared by the constraints
+  ContactBodyKinematics body;
+  /// Indices of the constraints of the group in
+  /// ConstraintSet::contactConstraints
+  std::vector<unsigned int> contactConstraintIndices;
+};
+
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Factorizations of InverseDynamicsConstraintsRelaxed that are kept
+ * between consecutive calls.
+ *
+ * Consecutive frames of a trajectory have nearly identical mass matrices and
+ * constraint Jacobians. When reuse is enabled (see
+ * ConstraintSet::SetRelaxedFactorizationReuse()) the LU decomposition of the
+ * relaxed KKT system
+ * \f[ K = \left( \begin{array}{cc} F & G^T_{SP} \\ G_{SP} & 0
+ *   \end{array} \right) \f]
+ * and the Cholesky decomposition of the weighting matrix \f$W\f$ are
+ * computed once and used for the following frames, where the solution is
+ * obtained by iterative refinement against the current matrices. A new
+ * factorization is computed when refinement does not reach the residual
+ * tolerance or after a fixed number of frames.
+ */
+struct RBDL_DLLAPI RelaxedKKTFactorization {
+  RelaxedKKTFactorization() :
+    enabled (false),
+    factorized (false),
+    refactorization_interval (0),
+    residual_tolerance (1.0e-10),
+    max_refinement_steps (4),
+    frames_since_factorization (0),
+    factorization_count (0),
+    refinement_steps (0),
+    residual (0.) {}
+
+  /// Whether the factorizations are reused across calls.
+  bool enabled;
+  /// Whether kkt_lu and W_llt hold a valid factorization.
+  bool factorized;
+  /// Number of frames after which a new factorization is forced
+  /// (0: refactorize only when the residual tolerance is not met).
+  unsigned int refactorization_interval;
+  /// Bound on the relative residual \f$\|b - Kx\| / \|b\|\f$.
+  double residual_tolerance;
+  /// Maximum number of refinement steps before a new factorization is
+  /// computed.
+  unsigned int max_refinement_steps;
+
+  /// Number of frames solved since the last factorization.
+  unsigned int frames_since_factorization;
+  /// Total number of factorizations of the KKT system.
+  unsigned int factorization_count;
+  /// Refinement steps used for the KKT system in the last call.
+  unsigned int refinement_steps;
+  /// Relative residual of the KKT system in the last call.
+  double residual;
+
+  Eigen::PartialPivLU<Math::MatrixNd> kkt_lu;
+  Eigen::LLT<Math::MatrixNd> W_llt;
+
+  /// Workspace of the relaxed KKT matrix and its right-hand-side.
+  Math::MatrixNd K;
+  Math::VectorNd rhs;
+  /// Workspace of the solution, the residual and the refinement step.
+  Math::VectorNd sol;
+  Math::VectorNd res;
+  Math::VectorNd delta;
+  /// Workspace of the residual and the refinement step for \f$W\f$.
+  Math::VectorNd res_w;
+  Math::VectorNd delta_w;
+};
+#endif
+
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief QR factorization of the active constraints of the null-space
+ * method that is updated when constraints are activated or deactivated.
+ *
+ * For the active rows \f$G_a\f$ of the constraint Jacobian the
+ * factorization
+ * \f[ G_a^T = Q \left( \begin{array}{c} R \\ 0 \end{array} \right),
+ *   \quad Q = \left[ \ Y \ | Z \ \right] \f]
+ * gives the range-space basis \f$Y\f$ and the null-space basis \f$Z\f$
+ * of SolveConstrainedSystemNullSpace(). Since \f$G_a Y = R^T\f$ the
+ * range-space parts of the accelerations and the constraint forces are
+ * obtained by triangular solves.
+ *
+ * Adding a row of G to (or removing it from) the factorization only changes
+ * a single column of \f$R\f$, which is restored to triangular form by
+ * Givens rotations in \f$O(n_\textit{dof}^2)\f$ instead of the
+ * \f$O(n_\textit{dof}^2 n_c)\f$ of a new Householder QR (see
+ * ConstraintSet::ActivateConstraint() and
+ * ConstraintSet::DeactivateConstraint()). This is useful for active-set
+ * iterations, e.g. contact switching, in which the constrained system is
+ * solved repeatedly for the same state while single contacts are opened or
+ * closed.
+ */
+struct RBDL_DLLAPI NullSpaceQRFactorization {
+  NullSpaceQRFactorization() :
+    factorized (false),
+    update_count (0) {}
+
+  /// Whether Q and R hold the factorization of the active rows of
+  /// ConstraintSet::G.
+  bool factorized;
+  /// Number of Givens updates and downdates since the last full
+  /// factorization.
+  unsigned int update_count;
+
+  /// Whether a row of ConstraintSet::G is active.
+  std::vector<bool> active;
+  /// The active rows of ConstraintSet::G in the order of the columns of R.
+  std::vector<unsigned int> rows;
+
+  /// Orthogonal factor \f$Q = [ Y | Z ]\f$.
+  Math::MatrixNd Q;
+  /// Upper triangular factor in the first rows.size() columns.
+  Math::MatrixNd R;
+
+  Eigen::HouseholderQR<Math::MatrixNd> qr;
+  /// Workspace of the transposed active rows of G.
+  Math::MatrixNd GaT;
+  /// Workspace of the reduced mass matrix \f$Z^T H Z\f$.
+  Math::MatrixNd HZ;
+  Math::MatrixNd ZHZ;
+  /// Workspace of the right hand sides of the triangular systems.
+  Math::VectorNd rhs;
+  Math::VectorNd w;
+};
+#endif
+
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Workspace of SolveConstrainedSystemDirect() for
+ * LinearSolverLLT and LinearSolverLDLT.
+ *
+ * The symmetric solvers factorize the joint space inertia matrix \f$H\f$
+ * and the Schur complement \f$K = G H^{-1} G^T + \textrm{diag}(c)\f$
+ * instead of the whole constrained system. ConstraintSet::Bind() sizes the
+ * decompositions and matrices such that repeated solves do not allocate.
+ */
+struct RBDL_DLLAPI SchurComplementWorkspace {
+  /// Resizes the workspace for n degrees of freedom and m constraint rows.
+  void resize (unsigned int n, unsigned int m);
+
+  Eigen::LLT<Math::MatrixNd> H_llt;
+  Eigen::LLT<Math::MatrixNd> K_llt;
+  Eigen::LDLT<Math::MatrixNd> H_ldlt;
+  Eigen::LDLT<Math::MatrixNd> K_ldlt;
+
+  /// Workspace of \f$H^{-1} G^T\f$ and \f$H^{-1} c\f$.
+  Math::MatrixNd HinvGT;
+  Math::VectorNd Hinvc;
+  /// Workspace of the Schur complement and its right hand side.
+  Math::MatrixNd K;
+  Math::VectorNd rhs;
+  /// Workspace of the constraint multipliers.
+  Math::VectorNd mu;
+};
+#else
+struct SchurComplementWorkspace;
+#endif
+
+struct ConstraintWorkerPoolData;
+
+/** \brief Persistent worker threads that evaluate the constraints of a
+ * ConstraintSet (see ConstraintSet::SetNumThreads()).
+ *
+ * The threads are started once and wait for work between the evaluations,
+ * so an evaluation only costs a wake-up instead of the creation of
+ * threads. Copies of a pool do not share its threads: a copied
+ * ConstraintSet starts its own threads when it is evaluated the first
+ * time.
+ */
+class RBDL_DLLAPI ConstraintWorkerPool {
+public:
+  ConstraintWorkerPool();
+  ConstraintWorkerPool (const ConstraintWorkerPool &other);
+  ConstraintWorkerPool &operator= (const ConstraintWorkerPool &other);
+  ~ConstraintWorkerPool();
+
+  /// Stops the current threads (if any) and starts num_workers threads.
+  void Resize (unsigned int num_workers);
+
+  /// Number of worker threads.
+  unsigned int size() const;
+
+  /** \brief Calls task (t) for t = 0 .. num_threads - 1, where task 0 runs
+   * on the calling thread and task t on worker t - 1.
+   *
+   * Returns once all tasks are done. The first exception thrown by a task
+   * is rethrown on the calling thread. num_threads - 1 must not exceed
+   * size().
+   */
+  template <typename Task>
+  void Run (unsigned int num_threads, Task &task) {
+    RunTasks (num_threads, &InvokeTask<Task>, &task);
+  }
+
+private:
+  template <typename Task>
+  static void InvokeTask (void *task, unsigned int t) {
+    (*static_cast<Task*>(task)) (t);
+  }
+
+  void RunTasks (unsigned int num_threads,
+                 void (*invoke)(void*, unsigned int), void *task);
+
+  std::unique_ptr<ConstraintWorkerPoolData> data;
+};
+
 /** \brief Structure that contains both constraint information and workspace memory.
  *
  * This structure is used to reduce the amount of memory allocations that
@@ -281,7 +540,9 @@ struct Model;
 struct RBDL_DLLAPI ConstraintSet {
   ConstraintSet() :
     linear_solver (Math::LinearSolverColPivHouseholderQR),
-    bound (false) {}
+    bound (false),
+    sparse_jacobian (false),
+    num_threads (1) {}
 
 
 
@@ -691,6 +952,34 @@ struct RBDL_DLLAPI ConstraintSet {
                                 baumgartePositionVelocityCoefficientsOutput);
   }
 
+  /**
+     @brief Sets the compliance of a constraint group, see
+            Constraint::setCompliance(). The compliance is used by
+            ForwardDynamicsConstraintsDirect(),
+            ForwardDynamicsConstraintsRangeSpaceSparse(),
+            ForwardDynamicsContactsKokkevis() and the corresponding impulse
+            functions. The null-space method eliminates the constraints
+            exactly and ignores it.
+
+     @param groupIndex: the index number of this constraint (see getGroupIndex
+            index functions)
+     @param complianceOfConstraint: the compliance (>= 0) of all equations
+            of the constraint group
+  */
+  void setCompliance(
+      unsigned int groupIndex,
+      double complianceOfConstraint);
+
+  /**
+     @param groupIndex: the index number of this constraint (see getGroupIndex
+            index functions)
+     @return the compliance of the constraint group
+  */
+  double getCompliance(
+      unsigned int groupIndex){
+    return constraints[groupIndex]->getCompliance();
+  }
+
   /** @brief Adds a single contact constraint (point-ground) to the
       constraint set.
 
@@ -808,6 +1097,58 @@ struct RBDL_DLLAPI ConstraintSet {
     linear_solver = solver;
   }
 
+  /** \brief Enables or disables the block-sparse constraint Jacobian.
+   *
+   * When enabled, ConstraintSet::Bind() computes the structural non-zero
+   * pattern of G (see ConstraintJacobianPattern) and the contact and loop
+   * constraints only evaluate and write the columns of their rows that can
+   * be non-zero. The remaining entries of G are left untouched (they are
+   * zero in ConstraintSet::G after binding) and all products with G in the
+   * constraint solvers (\f$ G \dot{q} \f$, \f$ G^T \lambda \f$,
+   * \f$ G H^{-1} G^T \f$) skip them. Custom constraints are treated as
+   * dense rows.
+   *
+   * \note This has to be called before ConstraintSet::Bind(). A matrix G
+   * that is passed to CalcConstraintsJacobian() instead of ConstraintSet::G
+   * has to be zero-initialized by the caller.
+   */
+  void SetSparseJacobian (bool enable) {
+    if (bound) {
+      throw Errors::RBDLError("Error: SetSparseJacobian must be called "
+                              "before binding the constraint set!\n");
+    }
+    sparse_jacobian = enable;
+  }
+
+  /** \brief Sets the number of threads that evaluate the constraints.
+   *
+   * CalcConstraintsJacobian(), CalcConstraintsPositionError(),
+   * CalcConstraintsVelocityError() and the computation of gamma in
+   * CalcConstrainedSystemVariables() split the constraints into
+   * numThreads contiguous chunks that are evaluated concurrently by the
+   * calling thread and numThreads - 1 persistent worker threads (see
+   * ConstraintSet::workers). Every thread uses its own ConstraintCache and
+   * the constraints write disjoint rows of the results, so no locking is
+   * needed. The kinematics of the model are updated once before the
+   * constraints are evaluated. Exceptions thrown by a constraint are
+   * rethrown on the calling thread.
+   *
+   * Waking up the workers costs a few microseconds per evaluation, so this
+   * only pays off for sets with many (or expensive custom) constraints.
+   * Custom constraints must only modify the passed cache and their rows of
+   * the outputs.
+   *
+   * \param numThreads number of threads including the calling thread (1
+   *        evaluates all constraints serially, which is the default)
+   */
+  void SetNumThreads (unsigned int numThreads) {
+    num_threads = numThreads > 0 ? numThreads : 1;
+    workers.Resize (num_threads - 1);
+    if (bound) {
+      thread_caches.assign (num_threads - 1, cache);
+    }
+  }
+
   /** \brief Initializes and allocates memory for the constraint set.
    *
    * This function allocates memory for temporary values and matrices that
@@ -845,6 +1186,69 @@ struct RBDL_DLLAPI ConstraintSet {
   void SetActuationMap(const Model &model,
                           const std::vector<bool> &actuatedDof);
 
+#ifndef RBDL_USE_CASADI_MATH
+  /** \brief Enables the reuse of factorizations in
+   * InverseDynamicsConstraintsRelaxed (see RelaxedKKTFactorization).
+   *
+   * \param enable whether factorizations are kept between calls
+   * \param refactorizationInterval number of frames after which a new
+   *        factorization is forced. With 0 a new factorization is only
+   *        computed when the residual tolerance is not met.
+   * \param residualTolerance bound on the relative residual of the KKT
+   *        system after iterative refinement
+   * \param maxRefinementSteps number of refinement steps that are tried
+   *        before a new factorization is computed
+   *
+   * \note This has to be called after ConstraintSet::SetActuationMap().
+   */
+  void SetRelaxedFactorizationReuse (bool enable,
+                                     unsigned int refactorizationInterval = 0,
+                                     double residualTolerance = 1.0e-10,
+                                     unsigned int maxRefinementSteps = 4);
+
+  /** \brief Computes the QR factorization of the active constraints for
+   * SolveConstrainedSystemNullSpaceFactorized() (see
+   * NullSpaceQRFactorization).
+   *
+   * The factorization is computed from the current constraint Jacobian
+   * ConstraintSet::G, i.e. it has to be called after
+   * CalcConstrainedSystemVariables() whenever the state changes.
+   */
+  void FactorizeNullSpace ();
+
+  /** \brief Activates a constraint group for
+   * SolveConstrainedSystemNullSpaceFactorized().
+   *
+   * If the null-space factorization is valid the rows of the group are
+   * added to it with Givens rotations. The rows of G of the group have to
+   * be linearly independent of the other active rows.
+   *
+   * \param groupIndex the index of the constraint group (see getGroupIndex
+   * functions)
+   */
+  void ActivateConstraint (unsigned int groupIndex);
+
+  /** \brief Deactivates a constraint group for
+   * SolveConstrainedSystemNullSpaceFactorized().
+   *
+   * If the null-space factorization is valid the rows of the group are
+   * removed from it with Givens rotations. All constraints are active after
+   * ConstraintSet::Bind().
+   *
+   * \param groupIndex the index of the constraint group (see getGroupIndex
+   * functions)
+   */
+  void DeactivateConstraint (unsigned int groupIndex);
+
+  /** \brief Returns whether a constraint group is active (see
+   * ConstraintSet::ActivateConstraint()).
+   */
+  bool IsConstraintActive (unsigned int groupIndex) {
+    return null_space_factorization.active[
+      constraints[groupIndex]->getConstraintIndex()];
+  }
+#endif
+
   /** \brief Returns the number of constraints. */
   size_t size() const {
     return constraintType.size();
@@ -857,6 +1261,12 @@ struct RBDL_DLLAPI ConstraintSet {
   Math::LinearSolver linear_solver;
   /// Whether the constraint set was bound to a model (mandatory!).
   bool bound;
+  /// Whether the block-sparse structure of G is exploited (see
+  /// ConstraintSet::SetSparseJacobian()).
+  bool sparse_jacobian;
+  /// Number of threads that evaluate the constraints (see
+  /// ConstraintSet::SetNumThreads()).
+  unsigned int num_threads;
 
   // Common constraints variables.
   std::vector<ConstraintType> constraintType;
@@ -886,6 +1296,13 @@ struct RBDL_DLLAPI ConstraintSet {
 
   std::vector< std::shared_ptr<LoopConstraint> > loopConstraints;
 
+  /// Contact constraints that share a body and are evaluated together
+  /// (see ContactConstraintGroup).
+  std::vector<ContactConstraintGroup> contact_groups;
+  /// Indices into ConstraintSet::constraints of the constraints that are
+  /// not part of a ContactConstraintGroup.
+  std::vector<unsigned int> ungrouped_constraints;
+
   
   /** Position error for the Baumgarte stabilization */
   Math::VectorNd err;
@@ -908,8 +1325,12 @@ struct RBDL_DLLAPI ConstraintSet {
   Math::VectorNd C;
   /// Workspace of the right hand side of the acceleration equation.
   Math::VectorNd gamma;
+  /// Compliance of every constraint row (see ConstraintSet::setCompliance()).
+  Math::VectorNd compliance;
   /// Workspace for the constraint Jacobian
   Math::MatrixNd G;
+  /// Structural non-zero pattern of G, only filled if sparse_jacobian is set
+  ConstraintJacobianPattern G_pattern;
 
   /// Workspace for the Lagrangian left-hand-side matrix.
   Math::MatrixNd A;
@@ -923,6 +1344,12 @@ struct RBDL_DLLAPI ConstraintSet {
   Math::MatrixNd S;
   /// Selection matrix for the non-actuated parts of the model
   Math::MatrixNd P;
+  /// Indices of the actuated degrees of freedom, i.e. row i of S selects
+  /// the degree of freedom actuated_dof_index[i]
+  std::vector<unsigned int> actuated_dof_index;
+  /// Indices of the non-actuated degrees of freedom, i.e. row i of P selects
+  /// the degree of freedom unactuated_dof_index[i]
+  std::vector<unsigned int> unactuated_dof_index;
   /// Matrix that holds the relative cost of deviating from the desired
   /// accelerations
   Math::MatrixNd W;
@@ -937,6 +1364,7 @@ struct RBDL_DLLAPI ConstraintSet {
 
   Math::MatrixNd GT;
   Math::MatrixNd GTu, GTl;//blocks of GT for SimpleMath
+  Math::VectorNd Cu, Cl;//actuated (SC) and non-actuated (PC) parts of C
   Math::VectorNd g;
   Math::MatrixNd Ru;
   Math::VectorNd py;
@@ -946,6 +1374,14 @@ struct RBDL_DLLAPI ConstraintSet {
   /// Workspace for the QR decomposition of the null-space method
   Eigen::HouseholderQR<Math::MatrixNd> GT_qr;
   Eigen::FullPivHouseholderQR<Math::MatrixNd> GPT_full_qr;
+  /// Factorizations kept by InverseDynamicsConstraintsRelaxed (see
+  /// ConstraintSet::SetRelaxedFactorizationReuse())
+  RelaxedKKTFactorization relaxed_factorization;
+  /// Factorization of the active constraints of
+  /// SolveConstrainedSystemNullSpaceFactorized()
+  NullSpaceQRFactorization null_space_factorization;
+  /// Workspace of SolveConstrainedSystemDirect() for the symmetric solvers
+  SchurComplementWorkspace schur_complement;
 #endif
 
   Math::MatrixNd GT_qr_Q;
@@ -988,6 +1424,11 @@ struct RBDL_DLLAPI ConstraintSet {
   std::vector<Math::Vector3d> d_multdof3_u;
 
   ConstraintCache cache;
+  /// Caches of the additional threads (see ConstraintSet::SetNumThreads()),
+  /// the calling thread uses ConstraintSet::cache.
+  std::vector<ConstraintCache> thread_caches;
+  /// Persistent worker threads (see ConstraintSet::SetNumThreads()).
+  ConstraintWorkerPool workers;
 
 
 
@@ -1139,6 +1580,123 @@ void CalcAssemblyQDot(
   const Math::VectorNd &weights
 );
 
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Workspace of the Schur-reduced assembly functions.
+ *
+ * The weight block \f$W\f$ of the assembly systems is diagonal and is
+ * eliminated analytically: with \f$G = \phi_q\f$ every iteration only
+ * solves the \f$m \times m\f$ system
+ * \f[ G W^{-1} G^T \lambda = e, \qquad d = -W^{-1} G^T \lambda \f]
+ * where \f$m\f$ is the number of constraints. The workspace is sized on
+ * first use (or when the model or constraint set change) so that later
+ * calls do not allocate memory.
+ *
+ * If warm_start is set, CalcAssemblyQ() starts from the result of the
+ * previous successful assembly, which is close to the constraint manifold
+ * when consecutive calls solve similar problems (e.g. in an optimizer or
+ * along a trajectory). The initial guess is used instead if its constraint
+ * error is smaller.
+ */
+struct RBDL_DLLAPI AssemblyWorkspace {
+  AssemblyWorkspace() :
+    warm_start (false),
+    has_previous_solution (false),
+    iterations (0) {}
+
+  /** \brief Sizes the workspace, only allocates if the sizes changed. */
+  void resize (const Model &model, const ConstraintSet &CS);
+
+  /// Whether CalcAssemblyQ() starts from the previous assembly result.
+  bool warm_start;
+  /// Whether q_previous holds the result of a successful assembly.
+  bool has_previous_solution;
+  /// Number of iterations of the last call of CalcAssemblyQ().
+  unsigned int iterations;
+
+  /// Constraint Jacobian (m x n).
+  Math::MatrixNd G;
+  /// \f$W^{-1} G^T\f$ (n x m).
+  Math::MatrixNd WinvGT;
+  /// Reduced system \f$G W^{-1} G^T\f$ (m x m).
+  Math::MatrixNd K;
+  Eigen::LDLT<Math::MatrixNd> K_ldlt;
+
+  /// Constraint errors and multipliers (m).
+  Math::VectorNd e;
+  Math::VectorNd lambda;
+  /// Step of the current iteration (n).
+  Math::VectorNd d;
+  /// Result of the previous successful assembly (q_size).
+  Math::VectorNd q_previous;
+};
+
+/** \brief Computes a feasible initial value of the generalized joint
+ * positions using a reusable workspace (see AssemblyWorkspace).
+ *
+ * Solves the same problem as
+ * CalcAssemblyQ(Model&, Math::VectorNd, ConstraintSet&, Math::VectorNd&,
+ * const Math::VectorNd&, double, unsigned int) but eliminates the diagonal
+ * weight block so that every iteration solves an \f$m \times m\f$ system,
+ * and does not allocate memory once the workspace is sized.
+ *
+ * \param model the model
+ * \param QInit initial guess for the generalized positions of the joints
+ * \param CS the constraint set for which the error should be computed
+ * \param QOutput vector of the generalized joint positions.
+ * \param weights weighting coefficients for the different joint positions,
+ *        which have to be positive.
+ * \param workspace workspace (and warm start information) of the assembly
+ * \param tolerance the function will return successfully if the constraint
+ * position error norm is lower than this value.
+ * \param max_iter the funciton will return unsuccessfully after performing
+ * this number of iterations.
+ *
+ * \return true if the generalized joint positions were computed
+ * successfully, false otherwise.
+ */
+RBDL_DLLAPI
+bool CalcAssemblyQ(
+  Model &model,
+  const Math::VectorNd &QInit,
+  ConstraintSet &CS,
+  Math::VectorNd &QOutput,
+  const Math::VectorNd &weights,
+  AssemblyWorkspace &workspace,
+  double tolerance = 1e-12,
+  unsigned int max_iter = 100
+);
+
+/** \brief Computes a feasible initial value of the generalized joint
+ * velocities using a reusable workspace (see AssemblyWorkspace).
+ *
+ * Solves the same problem as CalcAssemblyQDot(Model&, const Math::VectorNd&,
+ * const Math::VectorNd&, ConstraintSet&, Math::VectorNd&,
+ * const Math::VectorNd&) using the \f$m \times m\f$ reduced system
+ * \f$G W^{-1} G^T \lambda = G \dot{q}_0\f$,
+ * \f$\dot{q} = \dot{q}_0 - W^{-1} G^T \lambda\f$.
+ *
+ * \param model the model
+ * \param Q the generalized joint position of the joints. It is assumed that
+ * this vector satisfies the position level assemblt constraints.
+ * \param QDotInit initial guess for the generalized velocities of the joints
+ * \param CS the constraint set for which the error should be computed
+ * \param QDotOutput vector of the generalized joint velocities.
+ * \param weights weighting coefficients for the different joint
+ *        velocities, which have to be positive.
+ * \param workspace workspace of the assembly
+ */
+RBDL_DLLAPI
+void CalcAssemblyQDot(
+  Model &model,
+  const Math::VectorNd &Q,
+  const Math::VectorNd &QDotInit,
+  ConstraintSet &CS,
+  Math::VectorNd &QDotOutput,
+  const Math::VectorNd &weights,
+  AssemblyWorkspace &workspace
+);
+#endif
+
 /** \brief Computes forward dynamics with contact by constructing and solving 
  *  the full lagrangian equation
  *
@@ -1563,6 +2121,41 @@ void InverseDynamicsConstraintsRelaxed(
     Math::VectorNd &TauOutput,
     bool update_kinematics=true,
     std::vector<Math::SpatialVector> *f_ext  = NULL);
+
+/**
+ @brief Applies RigidBodyDynamics::InverseDynamicsConstraintsRelaxed to every
+        frame of a trajectory.
+
+ The frames are processed in order with the same constraint set. If
+ factorization reuse is enabled using
+ RigidBodyDynamics::ConstraintSet::SetRelaxedFactorizationReuse the first
+ frame is factorized and the following frames reuse this factorization
+ according to the update policy of the constraint set, which amortizes the
+ cost of the factorization over the trajectory.
+
+ \param model: rigid body model
+ \param Q: generalized positions of each frame
+ \param QDot: generalized velocities of each frame
+ \param QDDotControls: generalized acceleration controls of each frame
+ \param CS: constraint set, SetActuationMap must have been called
+ \param QDDotOutput: generalized accelerations of each frame (resized to
+        the number of frames)
+ \param TauOutput: generalized forces of each frame (resized to the number of
+        frames)
+ \param ForceOutput (optional) constraint forces of each frame
+ \param f_ext (optional) external forces of each frame in base coordinates
+ */
+RBDL_DLLAPI
+void InverseDynamicsConstraintsRelaxedSequence(
+    Model &model,
+    const std::vector<Math::VectorNd> &Q,
+    const std::vector<Math::VectorNd> &QDot,
+    const std::vector<Math::VectorNd> &QDDotControls,
+    ConstraintSet &CS,
+    std::vector<Math::VectorNd> &QDDotOutput,
+    std::vector<Math::VectorNd> &TauOutput,
+    std::vector<Math::VectorNd> *ForceOutput = NULL,
+    std::vector< std::vector<Math::SpatialVector> > *f_ext = NULL);
 #endif
 /**
  @brief An inverse-dynamics operator that can be applied to fully-actuated
@@ -1872,6 +2465,23 @@ void ComputeConstraintImpulsesNullSpace (
  * \param b work-space for the right-hand-side of the linear system
  * \param x work-space for the solution of the linear system
  * \param linear_solver type of solver that should be used to solve the system
+ * \param G_pattern (optional) structural non-zero pattern of G. If given only
+ * the listed entries of G are copied into A, the other entries of the G
+ * blocks of A have to be zero (as they are in ConstraintSet::A after binding).
+ * \param compliance (optional) compliance \f$c\f$ of every constraint row,
+ * the lower right block of the system is then \f$-\textrm{diag}(c)\f$.
+ *
+ * \param schur_workspace (optional) workspace of the symmetric solvers,
+ * e.g. ConstraintSet::schur_complement. A temporary one is used if it is
+ * not given.
+ *
+ * With LinearSolverLLT or LinearSolverLDLT the system is not factorized as a
+ * whole but through its Schur complement
+ * \f$ G H^{-1} G^T + \textrm{diag}(c) \f$, which is symmetric positive
+ * definite if G has full row rank or all compliances are positive. A and b
+ * are not used in this case. If H or the Schur complement is numerically
+ * singular, e.g. for redundant constraints without compliance, the whole
+ * system is solved with LinearSolverColPivHouseholderQR instead.
  */
 RBDL_DLLAPI
 void SolveConstrainedSystemDirect (
@@ -1883,7 +2493,10 @@ void SolveConstrainedSystemDirect (
   Math::MatrixNd &A, 
   Math::VectorNd &b,
   Math::VectorNd &x,
-  Math::LinearSolver &linear_solver
+  Math::LinearSolver &linear_solver,
+  const ConstraintJacobianPattern *G_pattern = NULL,
+  const Math::VectorNd *compliance = NULL,
+  SchurComplementWorkspace *schur_workspace = NULL
 );
 
 /** \brief Solves the contact system by first solving for the the joint 
@@ -1907,6 +2520,11 @@ void SolveConstrainedSystemDirect (
  * system
  * \param linear_solver type of solver that should be used to solve the 
  * constraint force system
+ * \param G_pattern (optional) structural non-zero pattern of G. If given
+ * \f$ G H^{-1} G^T \f$ and \f$ G^T \lambda \f$ are only evaluated over the
+ * listed entries of G.
+ * \param compliance (optional) compliance of every constraint row that is
+ * added to the diagonal of \f$ G H^{-1} G^T \f$.
  */
 RBDL_DLLAPI
 void SolveConstrainedSystemRangeSpaceSparse (
@@ -1919,7 +2537,9 @@ void SolveConstrainedSystemRangeSpaceSparse (
   Math::VectorNd &lambda, 
   Math::MatrixNd &K, 
   Math::VectorNd &a,
-  Math::LinearSolver linear_solver
+  Math::LinearSolver linear_solver,
+  const ConstraintJacobianPattern *G_pattern = NULL,
+  const Math::VectorNd *compliance = NULL
 );
 
 /** \brief Solves the contact system by first solving for the joint 
@@ -1942,7 +2562,11 @@ void SolveConstrainedSystemRangeSpaceSparse (
  * \param Z basis for the null-space of the constraints
  * \param qddot_y work-space of size \f$\mathbb{R}^{n_\textit{dof}}\f$
  * \param qddot_z work-space of size \f$\mathbb{R}^{n_\textit{dof}}\f$
- * \param linear_solver type of solver that should be used to solve the system
+ * \param linear_solver type of solver that should be used to solve the system.
+ * \f$ G Y \f$ is not symmetric, LinearSolverLLT and LinearSolverLDLT use
+ * LinearSolverPartialPivLU.
+ * \param G_pattern (optional) structural non-zero pattern of G. If given
+ * \f$ G Y \f$ is only evaluated over the listed entries of G.
  */
 RBDL_DLLAPI
 void SolveConstrainedSystemNullSpace (
@@ -1956,10 +2580,46 @@ void SolveConstrainedSystemNullSpace (
   Math::MatrixNd &Z,
   Math::VectorNd &qddot_y,
   Math::VectorNd &qddot_z,
-  Math::LinearSolver &linear_solver
+  Math::LinearSolver &linear_solver,
+  const ConstraintJacobianPattern *G_pattern = NULL
 );
 
-
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Solves the constrained system for the active constraints with
+ * the updated null-space factorization of the constraint set.
+ *
+ * Uses ConstraintSet::H, ConstraintSet::C, ConstraintSet::G and
+ * ConstraintSet::gamma of the last call of CalcConstrainedSystemVariables()
+ * and the factorization of ConstraintSet::FactorizeNullSpace(), which may
+ * have been updated by ConstraintSet::ActivateConstraint() and
+ * ConstraintSet::DeactivateConstraint() since. The forces of the inactive
+ * constraints are zero. A typical active-set iteration is
+ * \code
+ * CalcConstrainedSystemVariables (model, Q, QDot, Tau, CS);
+ * CS.FactorizeNullSpace ();
+ * SolveConstrainedSystemNullSpaceFactorized (CS, Tau, QDDot);
+ *
+ * while (... a contact force pulls ...) {
+ *   CS.DeactivateConstraint (group_index);
+ *   SolveConstrainedSystemNullSpaceFactorized (CS, Tau, QDDot);
+ * }
+ * \endcode
+ *
+ * \param CS    the constraint set with a valid null-space factorization
+ * \param Tau   actuations of the internal joints
+ * \param QDDot accelerations of the internal joints (output)
+ *
+ * \note The result equals the one of ForwardDynamicsConstraintsNullSpace()
+ * for the active constraints. The compliance of the constraints is
+ * ignored.
+ */
+RBDL_DLLAPI
+void SolveConstrainedSystemNullSpaceFactorized (
+  ConstraintSet &CS,
+  const Math::VectorNd &Tau,
+  Math::VectorNd &QDDot
+);
+#endif
 
 } 
 
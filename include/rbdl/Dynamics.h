@@ -71,6 +71,55 @@ RBDL_DLLAPI void NonlinearEffects (
     std::vector<Math::SpatialVector> *f_ext = NULL
     );
 
+/** \brief Computes the generalized gravity forces
+ *
+ * This function computes the generalized forces that compensate gravity
+ * for given generalized positions:
+ *   \f$ \tau = G(q) \f$
+ * which is the same as InverseDynamics() with zero velocities and
+ * accelerations. Instead of propagating accelerations it only accumulates
+ * the mass and the Center of Mass of each subtree and projects the
+ * resulting gravity wrench onto the joint motion subspaces.
+ *
+ * \param model rigid body model
+ * \param Q     state vector of the internal joints
+ * \param Tau   generalized gravity forces (output)
+ * \param update_kinematics whether the kinematics should be updated (safer, but at a higher computational cost!)
+ */
+RBDL_DLLAPI void CalcGravityTorques (
+    Model &model,
+    const Math::VectorNd &Q,
+    Math::VectorNd &Tau,
+    bool update_kinematics = true
+    );
+
+/** \brief Computes the Coriolis matrix
+ *
+ * This function computes the Coriolis matrix \f$ C(q, \dot{q}) \f$ for
+ * which the velocity dependent generalized forces are
+ *   \f$ C(q, \dot{q}) \dot{q} = N(q, \dot{q}) - G(q) \f$
+ * and \f$ \dot{M} - 2 C \f$ is skew-symmetric. It runs in
+ * \f$O(n_{dof} d)\f$ time with \f$d\f$ being the depth of the kinematic
+ * tree by accumulating the composite inertias and composite Coriolis
+ * factors of all subtrees (Echeandia and Wensing, 2021).
+ *
+ * \param model rigid body model
+ * \param Q     state vector of the internal joints
+ * \param QDot  velocity vector of the internal joints
+ * \param C     a dof_count x dof_count matrix where the result will be stored in
+ * \param update_kinematics whether the kinematics should be updated (safer, but at a higher computational cost!)
+ *
+ * \note Custom joints are not supported as the time derivative of their
+ * motion subspace is not known.
+ */
+RBDL_DLLAPI void CalcCoriolisMatrix (
+    Model &model,
+    const Math::VectorNd &Q,
+    const Math::VectorNd &QDot,
+    Math::MatrixNd &C,
+    bool update_kinematics = true
+    );
+
 /** \brief Computes the joint space inertia matrix by using the Composite Rigid Body Algorithm
  *
  * This function computes the joint space inertia matrix from a given model and
@@ -100,6 +149,9 @@ RBDL_DLLAPI void CompositeRigidBodyAlgorithm (
  *   \f$ \ddot{q} = M(q)^{-1} ( -N(q, \dot{q}) + \tau)\f$
  * It does this by using the recursive Articulated Body Algorithm that runs
  * in \f$O(n_{dof})\f$ with \f$n_{dof}\f$ being the number of joints.
+ * The articulated body inertia of a free-flyer root (see \ref
+ * joint_free_flyer_root) is not projected, its \f$6 \times 6\f$ system is
+ * solved directly.
  *
  * \param model rigid body model
  * \param Q     state vector of the internal joints
@@ -176,6 +228,125 @@ RBDL_DLLAPI void CalcMInvTimesTau (
     bool update_kinematics=true
     );
 
+/** \brief Rows of a task space Jacobian used by CalcDelassus() and
+ * CalcOperationalSpaceInertia().
+ *
+ * Each row \f$r\f$ is described by a body, a point on that body and a
+ * spatial axis \f$a_r\f$ (angular part first) in base coordinates. The
+ * task velocity of the row is
+ *   \f$ \dot{x}_r = a_r^T \begin{bmatrix} \omega \\ v_p \end{bmatrix} =
+ *   J_r \dot{q} \f$
+ * where \f$\omega\f$ is the angular velocity of the body and \f$v_p\f$
+ * the linear velocity of the point, both in base coordinates. The rows of
+ * CalcPointJacobian() and CalcPointJacobian6D() can therefore be added
+ * with AddPointTask() and AddPointTask6D().
+ */
+struct RBDL_DLLAPI OperationalSpaceTaskSet {
+  OperationalSpaceTaskSet();
+
+  /// \brief Adds a single row and returns its index.
+  unsigned int AddRow (
+      unsigned int body_id,
+      const Math::Vector3d &body_point,
+      const Math::SpatialVector &axis
+      );
+  /// \brief Adds the 3 rows of CalcPointJacobian() and returns the index
+  /// of the first one.
+  unsigned int AddPointTask (
+      unsigned int body_id,
+      const Math::Vector3d &body_point
+      );
+  /// \brief Adds the 6 rows of CalcPointJacobian6D() and returns the index
+  /// of the first one.
+  unsigned int AddPointTask6D (
+      unsigned int body_id,
+      const Math::Vector3d &body_point
+      );
+  /// \brief Removes all rows.
+  void clear ();
+  /// \brief Returns the number of rows.
+  size_t size () const {
+    return body_ids.size();
+  }
+
+  std::vector<unsigned int> body_ids;
+  std::vector<Math::Vector3d> body_points;
+  std::vector<Math::SpatialVector> axes;
+
+  // Workspace of CalcDelassus(). It is sized on the first call (or when
+  // the number of rows changes).
+
+  /// \brief Movable body of each row
+  std::vector<unsigned int> movable_body_ids;
+  /// \brief Projections \f$ S_i^T \phi_r(i) \f$ of the test force of row
+  /// \f$r\f$ propagated to every supporting joint \f$i\f$ (dof_count x
+  /// size()). Only the entries of the supporting joints are valid. The
+  /// rows of a free-flyer root contain the linear and angular components
+  /// of \f$ L^{-1} \phi_r \f$ with \f$ L \f$ the Cholesky factor of its
+  /// articulated body inertia.
+  Math::MatrixNd Y;
+#ifndef RBDL_USE_CASADI_MATH
+  /// \brief Factorization of the Delassus matrix
+  Eigen::LLT<Math::MatrixNd> delassus_llt;
+#endif
+};
+
+/** \brief Computes the Delassus matrix (inverse operational space inertia)
+ * \f$ J M^{-1} J^T \f$ of a set of task rows.
+ *
+ * Instead of forming and inverting the joint space inertia matrix this
+ * function uses the articulated body inertias of the Articulated Body
+ * Algorithm: the unit test force of each row is propagated from its body
+ * to the root (as the bias forces in CalcMInvTimesTau()) which gives the
+ * factor \f$Y\f$ with \f$ J M^{-1} J^T = Y^T D^{-1} Y \f$ where \f$D\f$
+ * is the block diagonal matrix of the joint space articulated inertias.
+ * For \f$m\f$ rows and a tree of depth \f$d\f$ this costs
+ * \f$O(n_{dof} + m d + m^2 d)\f$ instead of \f$O(n_{dof}^3)\f$.
+ *
+ * \param model rigid body model
+ * \param Q     state vector of the internal joints
+ * \param tasks the task rows
+ * \param Delassus the Delassus matrix (output, resized to size() x size()
+ * if needed)
+ * \param update_kinematics whether the kinematics and the articulated body
+ * inertias should be updated. When false they must be up to date for Q, e.g.
+ * from a previous call of this function or from UpdateKinematicsCustom()
+ * followed by CalcMInvTimesTau(). Afterwards CalcMInvTimesTau() may be
+ * called with update_kinematics=false for the same Q.
+ */
+RBDL_DLLAPI void CalcDelassus (
+    Model &model,
+    const Math::VectorNd &Q,
+    OperationalSpaceTaskSet &tasks,
+    Math::MatrixNd &Delassus,
+    bool update_kinematics=true
+    );
+
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Computes the operational space inertia matrix
+ * \f$ \Lambda = (J M^{-1} J^T)^{-1} \f$ of a set of task rows.
+ *
+ * The Delassus matrix is computed with CalcDelassus() and inverted with a
+ * Cholesky factorization, which requires the task rows to be linearly
+ * independent.
+ *
+ * \param model rigid body model
+ * \param Q     state vector of the internal joints
+ * \param tasks the task rows
+ * \param Lambda the operational space inertia matrix (output, resized to
+ * size() x size() if needed)
+ * \param update_kinematics whether the kinematics and the articulated body
+ * inertias should be updated (see CalcDelassus())
+ */
+RBDL_DLLAPI void CalcOperationalSpaceInertia (
+    Model &model,
+    const Math::VectorNd &Q,
+    OperationalSpaceTaskSet &tasks,
+    Math::MatrixNd &Lambda,
+    bool update_kinematics=true
+    );
+#endif
+
 /** @} */
 
 }
@@ -0,0 +1,212 @@
+/*
+ * RBDL - Rigid Body Dynamics Library
+ * Copyright (c) 2011-2018 Martin Felis <martin@fysx.org>
+ *
+ * Licensed under the zlib license. See LICENSE for more details.
+ */
+
+#ifndef RBDL_FRICTIONAL_CONTACTS_H
+#define RBDL_FRICTIONAL_CONTACTS_H
+
+#include <vector>
+
+#include <rbdl/rbdl_math.h>
+#include <rbdl/rbdl_mathutils.h>
+#include <rbdl/Dynamics.h>
+
+#ifndef RBDL_USE_CASADI_MATH
+
+namespace RigidBodyDynamics {
+
+/** \page frictional_contacts_page Frictional Contacts
+ *
+ * The ContactConstraint of a ConstraintSet is a bilateral equality
+ * constraint. Unilateral contacts with Coulomb friction are handled by the
+ * FrictionalContactSet, which computes the contact impulses of a time step
+ * at the velocity level: given the velocities \f$\dot{q}^-\f$ of the
+ * unconstrained time step the impulses \f$\lambda\f$ are the solution of
+ * the nonlinear complementarity problem (NCP)
+ * \f[ v = W \lambda + J \dot{q}^-, \quad
+ *   0 \leq \lambda_n \perp v_n - b_n \geq 0, \quad
+ *   \lambda_t \in \mu \lambda_n \mathcal{F} \f]
+ * where \f$W = J M^{-1} J^T\f$ is the Delassus matrix of the contact frames
+ * (normal and two tangents), \f$b_n\f$ a normal velocity bias (restitution
+ * and penetration correction) and \f$\mathcal{F}\f$ the friction cone or
+ * its pyramid approximation. The tangential impulses maximize the
+ * dissipation, i.e. they oppose the sliding velocity.
+ *
+ * \note Not available with CasADi as the solver branches on the values of
+ * the impulses.
+ *
+ * \defgroup frictional_contacts_group Frictional Contacts
+ * @{
+ */
+
+struct Model;
+
+/** \brief Approximation of the Coulomb friction cone. */
+enum FrictionModel {
+  /// Each tangential impulse is bounded by \f$\mu \lambda_n\f$.
+  FrictionModelPyramid = 0,
+  /// The norm of the tangential impulse is bounded by \f$\mu \lambda_n\f$.
+  FrictionModelCone,
+  FrictionModelLast
+};
+
+/** \brief Unilateral frictional point contacts and the workspace of
+ * SolveFrictionalContactImpulses().
+ *
+ * Every contact adds three rows (normal, first and second tangent) to the
+ * OperationalSpaceTaskSet of the set, whose Delassus matrix is computed
+ * recursively by CalcDelassus(). The contact set has to be bound to a model
+ * with FrictionalContactSet::Bind() before it can be used, afterwards
+ * SolveFrictionalContactImpulses() does not allocate memory.
+ *
+ * The contact data (points, normals, friction coefficients, active flags
+ * and velocity biases) may be modified between the time steps, e.g. to
+ * move the contact point of a rolling ball or to deactivate separated
+ * contacts.
+ */
+struct RBDL_DLLAPI FrictionalContactSet {
+  FrictionalContactSet();
+
+  /** \brief Adds a contact and returns its index.
+   *
+   * \param body_id the body of the contact (fixed bodies are supported)
+   * \param body_point the contact point in body coordinates
+   * \param normal the contact normal in base coordinates, pointing away
+   * from the environment towards the body
+   * \param friction_coefficient the Coulomb friction coefficient \f$\mu\f$
+   * \param restitution_coefficient the coefficient of restitution \f$e\f$
+   */
+  unsigned int AddContact (
+      unsigned int body_id,
+      const Math::Vector3d &body_point,
+      const Math::Vector3d &normal,
+      double friction_coefficient,
+      double restitution_coefficient = 0.
+      );
+
+  /** \brief Sets the normal of a contact and updates its tangents. */
+  void SetContactNormal (unsigned int contact_index,
+      const Math::Vector3d &normal);
+
+  /** \brief Initializes and allocates the workspace for the model. */
+  bool Bind (const Model &model);
+
+  /** \brief Returns the number of contacts. */
+  size_t size() const {
+    return body_ids.size();
+  }
+
+  /** \brief Removes all contacts (the set has to be bound again). */
+  void clear ();
+
+  // Settings of the solver
+
+  /// Approximation of the friction cone (default: FrictionModelCone).
+  FrictionModel friction_model;
+  /// Maximum number of projected Gauss-Seidel sweeps (default: 100).
+  unsigned int max_iterations;
+  /// The iteration stops when no impulse changes by more than this value
+  /// in a sweep (default: 1.0e-10).
+  double tolerance;
+  /// Whether the iteration starts from the impulses of the previous call
+  /// (default: true).
+  bool warm_start;
+
+  // Contact data
+
+  std::vector<unsigned int> body_ids;
+  std::vector<Math::Vector3d> body_points;
+  /// Contact normals in base coordinates.
+  std::vector<Math::Vector3d> normals;
+  /// First tangent of each contact frame (see SetContactNormal()).
+  std::vector<Math::Vector3d> tangents1;
+  /// Second tangent of each contact frame (see SetContactNormal()).
+  std::vector<Math::Vector3d> tangents2;
+  std::vector<double> friction_coefficients;
+  std::vector<double> restitution_coefficients;
+  /// Whether the contact is closed. Inactive contacts get zero impulses.
+  std::vector<bool> active;
+  /// Minimal normal velocity after the impulse in addition to the
+  /// restitution, e.g. to correct the penetration of the contact.
+  std::vector<double> normal_velocity_bias;
+
+  // Results of the last call of SolveFrictionalContactImpulses()
+
+  /// Contact impulses (normal, tangent 1, tangent 2) of all contacts.
+  Math::VectorNd impulses;
+  /// Number of sweeps of the last solve.
+  unsigned int num_iterations;
+  /// Largest change of an impulse in the last sweep.
+  double residual;
+
+  // Workspace
+
+  bool bound;
+  /// Rows of the contact frames for CalcDelassus().
+  OperationalSpaceTaskSet tasks;
+  /// Delassus matrix of the contact frames.
+  Math::MatrixNd W;
+  /// Jacobian of the contact frames.
+  Math::MatrixNd J;
+  /// Workspace of the point Jacobian of a single contact.
+  Math::MatrixNd G;
+  /// Contact frame velocities of the unconstrained velocities.
+  Math::VectorNd velocity;
+  /// Normal velocity each contact has to reach.
+  Math::VectorNd target_velocity;
+  /// Generalized impulse \f$J^T \lambda\f$.
+  Math::VectorNd generalized_impulse;
+  /// Change of the generalized velocities \f$M^{-1} J^T \lambda\f$.
+  Math::VectorNd qdot_delta;
+};
+
+/** \brief Computes the frictional contact impulses of a time step with a
+ * projected Gauss-Seidel (PGS) iteration.
+ *
+ * The Delassus matrix of the contact frames is computed with CalcDelassus()
+ * and the NCP described in \ref frictional_contacts_page is solved by
+ * sweeping over the contacts: the normal impulse is projected onto
+ * \f$\lambda_n \geq 0\f$ and the tangential impulses onto the friction
+ * pyramid or cone of the updated normal impulse. Contacts that are not
+ * active are skipped. The resulting impulses are stored in
+ * FrictionalContactSet::impulses and are used as initial guess of the next
+ * call when FrictionalContactSet::warm_start is enabled.
+ *
+ * A semi-implicit Euler step with contacts is then
+ * \code
+ * ForwardDynamics (model, q, qdot, tau, qddot);
+ * qdot_free = qdot + dt * qddot;
+ * SolveFrictionalContactImpulses (model, q, qdot_free, contacts, qdot);
+ * q += dt * qdot; // (or model.CalcQ... for quaternion joints)
+ * \endcode
+ *
+ * \param model rigid body model
+ * \param Q     state vector of the internal joints
+ * \param QDotMinus velocities before the contact impulses
+ * \param CS    the contacts and the solver workspace
+ * \param QDotPlus velocities after the contact impulses (output)
+ * \param update_kinematics whether the kinematics and the articulated body
+ * inertias should be updated for Q (see CalcDelassus())
+ *
+ * \note The function does not allocate memory.
+ */
+RBDL_DLLAPI void SolveFrictionalContactImpulses (
+    Model &model,
+    const Math::VectorNd &Q,
+    const Math::VectorNd &QDotMinus,
+    FrictionalContactSet &CS,
+    Math::VectorNd &QDotPlus,
+    bool update_kinematics = true
+    );
+
+/** @} */
+
+}
+
+#endif
+
+/* RBDL_FRICTIONAL_CONTACTS_H */
+#endif
@@ -11,6 +11,7 @@
 #include "rbdl/rbdl_math.h"
 #include <assert.h>
 #include <iostream>
+#include <vector>
 #include "rbdl/Logging.h"
 #include "rbdl/rbdl_errors.h"
 
@@ -104,6 +105,34 @@ struct Model;
  * counterparts as they are considerably faster and describe the same
  * kinematics and dynamics.
 
+ * \section joint_native_multi_dof Native Multi-DoF Joints
+ *
+ * The emulation of a joint with \f$k\f$ degrees of freedom (JointType2DoF
+ * to JointType6DoF) adds \f$k - 1\f$ massless virtual bodies to the model,
+ * each of which is processed by all recursive algorithms. When
+ * Model::emulate_multi_dof_joints is set to false before the bodies are
+ * added, such joints are instead modeled by a single body with a
+ * MultiDofJoint whose \f$6 \times k\f$ motion subspace is computed
+ * directly from the joint axes. The values of \f$\mathbf{q}\f$,
+ * \f$\mathbf{\dot{q}}\f$ and \f$\mathbf{\tau}\f$ are the same in both
+ * cases, only the virtual bodies are missing:
+ *
+ * \code
+ * Model model;
+ * model.emulate_multi_dof_joints = false;
+ * unsigned int body_id = model.AddBody (0, Xtrans (Vector3d (0., 0., 0.)),
+ *   Joint (
+ *     SpatialVector (0., 0., 0., 1., 0., 0.),
+ *     SpatialVector (0., 0., 0., 0., 1., 0.),
+ *     SpatialVector (0., 0., 1., 0., 0., 0.)
+ *   ), body);
+ * // body_id == 1
+ * \endcode
+ *
+ * Native multi-DoF joints are handled as custom joints by the algorithms
+ * and therefore share their limitations (e.g. CalcCoriolisMatrix() does not
+ * support them).
+
  * \section joint_floatingbase Floating-Base Joint (a.k.a. Freeflyer Joint)
  *
  * RBDL has a special joint type for floating-base systems that uses the
@@ -118,6 +147,25 @@ struct Model;
  * Model::SetQuaternion () / Model::GetQuaternion() with the body id
  * returned when adding the floating base (i.e. the call to
  * Model::AddBody() or Model::AppendBody()).
+ *
+ * \subsection joint_free_flyer_root Free-Flyer Root
+ *
+ * If the floating base is the first body that is added to the ROOT, its id
+ * is stored in Model::free_flyer_root_id. The positional variables of the
+ * joint then describe an element of SE(3) (the position of the body and
+ * its orientation as a unit quaternion) and ForwardDynamics(),
+ * CalcMInvTimesTau(), InverseDynamics() and CompositeRigidBodyAlgorithm()
+ * treat the two internal joints as a single 6-DoF joint. As the root has
+ * no parent that could take up a part of its articulated body inertia, its
+ * \f$6 \times 6\f$ system is solved directly instead of projecting the
+ * inertia onto each of the two 3-DoF joints. The values in
+ * \f$\mathbf{q}, \mathbf{\dot{q}}, \mathbf{\ddot{q}}\f$ and
+ * \f$\mathbf{\tau}\f$ are the same as for the generic algorithms.
+ *
+ * The functions IntegrateConfiguration() and CalcConfigurationDifference()
+ * perform the numerical integration of \f$\mathbf{q}\f$ on the
+ * configuration manifold, i.e. on SE(3) for the free-flyer root and on
+ * SO(3) for all other spherical joints.
 
  * \section joint_singularities Joint Singularities
 
@@ -194,11 +242,11 @@ enum JointType {
   JointTypeFixed, ///< Fixed joint which causes the inertial properties to be merged with the parent body.
   JointTypeHelical, //1 DoF joint with both rotational and translational motion
   JointType1DoF,
-  JointType2DoF, ///< Emulated 2 DoF joint.
-  JointType3DoF, ///< Emulated 3 DoF joint.
-  JointType4DoF, ///< Emulated 4 DoF joint.
-  JointType5DoF, ///< Emulated 5 DoF joint.
-  JointType6DoF, ///< Emulated 6 DoF joint.
+  JointType2DoF, ///< Emulated 2 DoF joint (see \ref joint_native_multi_dof).
+  JointType3DoF, ///< Emulated 3 DoF joint (see \ref joint_native_multi_dof).
+  JointType4DoF, ///< Emulated 4 DoF joint (see \ref joint_native_multi_dof).
+  JointType5DoF, ///< Emulated 5 DoF joint (see \ref joint_native_multi_dof).
+  JointType6DoF, ///< Emulated 6 DoF joint (see \ref joint_native_multi_dof).
   JointTypeCustom, ///< User defined joints of varying size
 };
 
@@ -753,6 +801,35 @@ void jcalc_X_lambda_S (
   const Math::VectorNd &q
 );
 
+/** \brief Returns column dof of the motion subspace of a joint in body
+ * coordinates.
+ *
+ * \note The motion subspace has to be up to date, i.e. jcalc() or
+ * jcalc_X_lambda_S() must have been called for the current state.
+ */
+RBDL_DLLAPI
+Math::SpatialVector jcalc_S_column (
+  const Model &model,
+  unsigned int joint_id,
+  unsigned int dof
+);
+
+/** \brief Returns column dof of the apparent time derivative of the
+ * motion subspace of a joint in body coordinates (see the c_J terms
+ * computed in jcalc()).
+ *
+ * \note Custom joints do not provide the derivative of their motion
+ * subspace and are treated as having a constant motion subspace.
+ */
+RBDL_DLLAPI
+Math::SpatialVector jcalc_S_dot_column (
+  const Model &model,
+  unsigned int joint_id,
+  unsigned int dof,
+  const Math::VectorNd &q,
+  const Math::VectorNd &qdot
+);
+
 struct RBDL_DLLAPI CustomJoint {
   CustomJoint()
   { }
@@ -768,6 +845,16 @@ struct RBDL_DLLAPI CustomJoint {
                                  const Math::VectorNd &q
                                 ) = 0;
 
+  /** \brief Returns a copy of the joint that is allocated with new.
+   *
+   * Required by Model::CloneForThread() to give each copy of a model its
+   * own joint instances. The default implementation returns NULL, i.e.
+   * models containing the joint cannot be cloned.
+   */
+  virtual CustomJoint* Clone () const {
+    return NULL;
+  }
+
   unsigned int mDoFCount;
   Math::SpatialTransform XJ;
   Math::MatrixNd S;
@@ -777,6 +864,93 @@ struct RBDL_DLLAPI CustomJoint {
   Math::VectorNd d_u;
 };
 
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Custom joint with a number of degrees of freedom that is known
+ * at compile time.
+ *
+ * The constructor sizes S, U, Dinv, u and d_u once. For custom joints with
+ * 1 to 6 degrees of freedom the dynamics algorithms operate on this
+ * storage through fixed-size Eigen::Map views instead of dynamically sized
+ * temporaries. Derived joints implement jcalc() and jcalc_X_lambda_S() as
+ * for CustomJoint and can use MotionSubspace() to fill S with fixed-size
+ * expressions, e.g.:
+ *
+ * \code
+ * struct KneeJoint : public CustomJointN<2> {
+ *   virtual void jcalc (Model &model, unsigned int joint_id,
+ *       const Math::VectorNd &q, const Math::VectorNd &qdot) {
+ *     MotionSubspace() = ...;
+ *     model.v_J[joint_id] = MotionSubspace()
+ *       * qdot.segment<2>(model.mJoints[joint_id].q_index);
+ *     ...
+ *   }
+ * };
+ * \endcode
+ */
+template <int DoF>
+struct CustomJointN : public CustomJoint {
+  static_assert (DoF >= 1 && DoF <= 6,
+      "CustomJointN requires between 1 and 6 degrees of freedom");
+
+  typedef Eigen::Matrix<double, 6, DoF> MotionSubspaceMatrix;
+
+  CustomJointN() {
+    mDoFCount = DoF;
+    S = Math::MatrixNd::Zero (6, DoF);
+    U = Math::MatrixNd::Zero (6, DoF);
+    Dinv = Math::MatrixNd::Zero (DoF, DoF);
+    u = Math::VectorNd::Zero (DoF);
+    d_u = Math::VectorNd::Zero (DoF);
+  }
+
+  /// \brief Fixed-size view of the motion subspace S
+  Eigen::Map<MotionSubspaceMatrix> MotionSubspace() {
+    return Eigen::Map<MotionSubspaceMatrix> (S.data());
+  }
+};
+#endif
+
+/** \brief Native joint with 2 to 6 degrees of freedom.
+ *
+ * The joint is the composition of the rotations around and translations
+ * along its axes in the order of the axes, i.e. the same as the chain of
+ * single degree of freedom joints of the emulation (see \ref
+ * joint_native_multi_dof). The motion subspace, the joint velocity and
+ * the bias acceleration of the whole chain are expressed in the frame of
+ * the body.
+ *
+ * Instances are created by Model::AddBody() when
+ * Model::emulate_multi_dof_joints is false and are owned by the model.
+ */
+struct RBDL_DLLAPI MultiDofJoint : public CustomJoint {
+  /** \brief Creates the joint from a joint of type JointType2DoF to
+   * JointType6DoF whose axes are either pure rotations or pure
+   * translations.
+   */
+  MultiDofJoint (const Joint &joint);
+
+  virtual void jcalc (Model &model,
+                      unsigned int joint_id,
+                      const Math::VectorNd &q,
+                      const Math::VectorNd &qdot
+                     );
+  virtual void jcalc_X_lambda_S (Model &model,
+                                 unsigned int joint_id,
+                                 const Math::VectorNd &q
+                                );
+  virtual MultiDofJoint* Clone () const;
+
+  /// \brief The spatial axes of the joint
+  std::vector<Math::SpatialVector> mAxes;
+  /// \brief Whether an axis is a rotation (otherwise a translation)
+  std::vector<bool> mAxisIsRotation;
+
+private:
+  /// Computes XJ and S for the joint positions starting at q_index.
+  void calcTransformAndMotionSubspace (const Math::VectorNd &q,
+                                       unsigned int q_index);
+};
+
 }
 
 /* RBDL_JOINT_H */
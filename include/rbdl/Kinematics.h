@@ -375,6 +375,13 @@ struct RBDL_DLLAPI InverseKinematicsConstraintSet {
   Math::MatrixNd G; /// temporary storage of a single body Jacobian
   Math::VectorNd e; /// Vector with all the constraint residuals.
 
+  // Workspace of InverseKinematics(). It is sized on the first call (or
+  // when the problem size changes) so that the iterations do not allocate.
+  Math::MatrixNd A; /// damped normal matrix J^T J + Wn
+  Eigen::LDLT<Math::MatrixNd> A_ldlt; /// factorization of A
+  Math::VectorNd ek; /// J^T e
+  Math::VectorNd delta_theta; /// step of the current iteration
+
   unsigned int num_constraints; //size of all constraints
   double lambda; /// Damping factor, the default value of 1.0e-6 is reasonable for most problems
   unsigned int num_steps; // The number of iterations performed
@@ -417,6 +424,91 @@ RBDL_DLLAPI bool InverseKinematics (
     InverseKinematicsConstraintSet &CS,
     Math::VectorNd &Qres
     );
+
+/** \brief Computes the inverse kinematics of a sequence of frames, e.g. of
+ * a marker based motion capture trial.
+ *
+ * \param model rigid body model
+ * \param Qinit initial guess for the first frame of every chunk
+ * \param CS constraint set that defines the constraints (types, bodies,
+ * body points, weights) and the solver settings. It is not modified.
+ * \param target_positions target positions of every frame. Entry [f][k]
+ * replaces CS.target_positions[k] in frame f.
+ * \param Qres output of the computed inverse kinematics of every frame
+ * \param num_steps output of the number of iterations of every frame
+ * \param error_norms output of the constraint residual norm of every frame
+ * \param num_threads number of chunks the trial is split into that are
+ * solved concurrently (0 uses all available cores).
+ * \param target_orientations (optional) target orientations of every frame.
+ * Entry [f][k] replaces CS.target_orientations[k] in frame f.
+ * \returns true if the inverse kinematics of all frames succeeded, false
+ * otherwise.
+ *
+ * Every frame is warm-started from the solution of the previous frame. The
+ * trial is split into num_threads contiguous chunks; the first frame of
+ * each chunk starts from Qinit. Each thread works on its own copy of the
+ * model (see Model::CloneForThread()) and of the constraint set, whose
+ * buffers are reused for all frames of the chunk. With more than one thread
+ * all custom joints of the model therefore have to implement
+ * CustomJoint::Clone(). The output vectors are only reallocated if their
+ * sizes do not match.
+ */
+RBDL_DLLAPI bool InverseKinematicsTrajectory (
+    Model &model,
+    const Math::VectorNd &Qinit,
+    const InverseKinematicsConstraintSet &CS,
+    const std::vector<std::vector<Math::Vector3d> > &target_positions,
+    std::vector<Math::VectorNd> &Qres,
+    std::vector<unsigned int> &num_steps,
+    std::vector<double> &error_norms,
+    unsigned int num_threads = 1,
+    const std::vector<std::vector<Math::Matrix3d> > *target_orientations = NULL
+    );
+
+/** \brief Integrates the generalized positions for a constant velocity
+ * over a time step on the configuration manifold.
+ *
+ * \param model rigid body model
+ * \param Q generalized positions at the start of the time step
+ * \param QDot generalized velocities
+ * \param dt time step
+ * \param QNext output of the generalized positions at the end of the time
+ * step (may be the same vector as Q)
+ *
+ * The quaternions of spherical joints are updated with the exponential
+ * map of SO(3) of the angular velocity \f$\omega\f$ (in body coordinates)
+ * and are normalized afterwards. The pose of a free-flyer root (see \ref
+ * joint_free_flyer_root) is updated with the exponential map of SE(3) of
+ * its body twist, i.e. the root moves on a screw with constant velocities
+ * in body coordinates. All other positions are integrated linearly.
+ */
+RBDL_DLLAPI void IntegrateConfiguration (
+    const Model &model,
+    const Math::VectorNd &Q,
+    const Math::VectorNd &QDot,
+    double dt,
+    Math::VectorNd &QNext
+    );
+
+/** \brief Computes the generalized velocities that move the generalized
+ * positions Q0 to Q1 in unit time.
+ *
+ * \param model rigid body model
+ * \param Q0 generalized positions at the start
+ * \param Q1 generalized positions at the end
+ * \param QDot output of the generalized velocities
+ *
+ * This is the inverse of IntegrateConfiguration(), i.e.
+ * IntegrateConfiguration (model, Q0, QDot, 1., Q1) yields Q1 (up to the
+ * sign of the quaternions) and uses the logarithmic maps of SO(3) and
+ * SE(3).
+ */
+RBDL_DLLAPI void CalcConfigurationDifference (
+    const Model &model,
+    const Math::VectorNd &Q0,
+    const Math::VectorNd &Q1,
+    Math::VectorNd &QDot
+    );
 #endif
 
 /** @} */
@@ -15,6 +15,7 @@
 #include <iostream>
 #include <limits>
 #include <cstring>
+#include <memory>
 
 #include "rbdl/Logging.h"
 #include "rbdl/Joint.h"
@@ -103,6 +104,51 @@ namespace RigidBodyDynamics
  * RigidBodyDynamics::Addons::URDFReadFromFile \endlink.
  */
 
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Quantities of a body that the articulated body algorithm reads
+ * and writes in every iteration, packed into one cache line aligned
+ * record (see Model::use_body_arena).
+ */
+struct alignas(64) ArticulatedBodyRecord {
+  /// \brief Articulated body inertia
+  Math::SpatialMatrix IA;
+  /// \brief Transformation from the parent body to the body
+  Math::SpatialTransform X_lambda;
+  /// \brief Spatial velocity
+  Math::SpatialVector v;
+  /// \brief Velocity dependent spatial acceleration
+  Math::SpatialVector c;
+  /// \brief Spatial bias force
+  Math::SpatialVector pA;
+  /// \brief Spatial acceleration
+  Math::SpatialVector a;
+  /// \brief U_i of a 1-DoF joint (RBDA p. 130)
+  Math::SpatialVector U;
+  /// \brief D_i of a 1-DoF joint (RBDA p. 130)
+  double d;
+  /// \brief u_i of a 1-DoF joint (RBDA p. 130)
+  double u;
+};
+#endif
+
+/** \brief Maps ids and indices of a model to their values after
+ * Model::OptimizeOrdering().
+ *
+ * Entry i of each map contains the new value of the old id or index i,
+ * e.g. the value of q[i] before the reordering is found at
+ * q_new[q[i]] afterwards.
+ */
+struct RBDL_DLLAPI ModelOrderingMap {
+  /// \brief New ids of the movable bodies (ids of fixed bodies do not
+  /// change)
+  std::vector<unsigned int> body;
+  /// \brief New indices of the entries of the generalized positions
+  std::vector<unsigned int> q;
+  /// \brief New indices of the entries of the generalized velocities,
+  /// accelerations and forces
+  std::vector<unsigned int> qdot;
+};
+
 /** \brief Contains all information about the rigid body model
  *
  * This class contains all information required to perform the forward
@@ -163,6 +209,30 @@ struct RBDL_DLLAPI Model {
   /// \brief the cartesian vector of the gravity
   Math::Vector3d gravity;
 
+  /** \brief Whether joints of type JointType2DoF to JointType6DoF are
+   * emulated by chains of virtual bodies (default: true).
+   *
+   * If false, such joints are added as a single body with a native
+   * MultiDofJoint (see \ref joint_native_multi_dof). The value only
+   * affects bodies that are added after it was changed.
+   */
+  bool emulate_multi_dof_joints;
+
+#ifndef RBDL_USE_CASADI_MATH
+  /** \brief Whether ForwardDynamics() keeps the per-body quantities of
+   * the articulated body algorithm in Model::body_arena (default: false).
+   *
+   * The hot quantities of each body are then stored in one record instead
+   * of being spread over separate arrays. Afterwards Model::v, Model::c,
+   * Model::a, Model::U, Model::d, Model::u and Model::X_base hold the same
+   * values as without the arena, Model::IA and Model::pA are not updated.
+   */
+  bool use_body_arena;
+  /// \brief Per-body records of ForwardDynamics() (see
+  /// Model::use_body_arena), allocated together with the bodies
+  std::vector<ArticulatedBodyRecord> body_arena;
+#endif
+
   // State information
   /// \brief The spatial velocity of the bodies
   std::vector<Math::SpatialVector> v;
@@ -201,7 +271,27 @@ struct RBDL_DLLAPI Model {
   std::vector<Math::Vector3d> multdof3_u;
   std::vector<unsigned int> multdof3_w_index;
 
+  ////////////////////////////////////
+  // Special variables for a free-flyer root
+
+  /** \brief Id of the body that is attached to the ROOT by a
+   * JointTypeFloatingBase joint (0 if there is none).
+   *
+   * The dynamics algorithms treat this body and its virtual parent as a
+   * single 6-DoF root (see \ref joint_free_flyer_root).
+   */
+  unsigned int free_flyer_root_id;
+  /// \brief Cholesky factor L (IA = L L^T) of the articulated body inertia
+  /// of the free-flyer root, only the lower triangle is valid
+  Math::SpatialMatrix free_flyer_IA_L;
+
   std::vector<CustomJoint*> mCustomJoints;
+  /// \brief Native multi-DoF joints created by the model (see
+  ///  Model::emulate_multi_dof_joints), they are also in mCustomJoints.
+  std::vector<std::shared_ptr<MultiDofJoint> > mMultiDofJoints;
+  /// \brief Copies of the custom joints owned by a model that was created
+  ///  by Model::CloneForThread(), they are also in mCustomJoints.
+  std::vector<std::shared_ptr<CustomJoint> > mClonedCustomJoints;
 
   ////////////////////////////////////
   // Dynamics variables
@@ -226,6 +316,12 @@ struct RBDL_DLLAPI Model {
   std::vector<Math::SpatialRigidBodyInertia> Ic;
   std::vector<Math::SpatialVector> hc;
   std::vector<Math::SpatialVector> hdotc;
+  /// \brief Rate of change of the composite inertia of the subtree of
+  ///  body i (used only in Utils::CalcCentroidalMomentumMatrixDot())
+  std::vector<Math::SpatialMatrix> Icdot;
+  /// \brief Composite Coriolis factor of the subtree of body i (used
+  ///  only in CalcCoriolisMatrix())
+  std::vector<Math::SpatialMatrix> Bc;
 
   ////////////////////////////////////
   // Bodies
@@ -334,6 +430,38 @@ struct RBDL_DLLAPI Model {
     std::string body_name = ""
   );
 
+  /** \brief Renumbers the movable bodies in depth-first order.
+   *
+   * The ids of bodies, and therefore the order of the entries of q and
+   * qdot, follow the order in which the bodies were added. After this
+   * call every subtree occupies a contiguous range of ids with the
+   * children of a body in the order they were added, such that the
+   * sweeps of the algorithms traverse the per-body arrays from one end to
+   * the other.
+   *
+   * The body name map is updated, the state variables of the model are
+   * reset. Body ids stored elsewhere, e.g. in constraint sets, and
+   * vectors of generalized coordinates have to be converted using the
+   * returned maps.
+   *
+   * \returns the mapping of old to new body ids and q and qdot indices
+   */
+  ModelOrderingMap OptimizeOrdering ();
+
+  /** \brief Returns a copy of the model for use in another thread.
+   *
+   * The copy constructor of Model only copies the pointers in
+   * Model::mCustomJoints such that all copies would write into the
+   * same joint instances when running the algorithms. This function
+   * instead creates a copy of every custom joint using
+   * CustomJoint::Clone() which is owned by the returned model. The
+   * returned model can therefore be used concurrently with the original.
+   *
+   * \note Throws an Errors::RBDLError if a custom joint does not
+   * implement CustomJoint::Clone().
+   */
+  Model CloneForThread () const;
+
   /** \brief Returns the id of a body that was passed to AddBody()
    *
    * Bodies can be given a human readable name. This function allows to
@@ -0,0 +1,163 @@
+/*
+ * RBDL - Rigid Body Dynamics Library
+ * Copyright (c) 2011-2018 Martin Felis <martin@fysx.org>
+ *
+ * Licensed under the zlib license. See LICENSE for more details.
+ */
+
+#ifndef RBDL_ROLLOUT_H
+#define RBDL_ROLLOUT_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <rbdl/rbdl_math.h>
+#include <rbdl/Model.h>
+#include <rbdl/Simulator.h>
+
+#ifndef RBDL_USE_CASADI_MATH
+
+namespace RigidBodyDynamics {
+
+/** \page rollout_page Rollouts
+ *
+ * The RolloutEngine simulates many independent rollouts of the same model,
+ * e.g. for reinforcement learning or sampling based model predictive
+ * control. Every worker thread owns a copy of the model created with
+ * Model::CloneForThread() and a Simulator, the rollouts are claimed by the
+ * workers one after another from a shared counter such that workers that
+ * finish early take over the remaining rollouts. The trajectories are
+ * written into the contiguous matrices of a RolloutBuffer which is
+ * allocated once before the rollouts.
+ *
+ * \code
+ * RolloutEngine engine;
+ * engine.integrator = SimulatorIntegratorSemiImplicit;
+ * engine.dt = 1.0e-3;
+ * engine.Bind (model, 8);
+ *
+ * RolloutBuffer buffer;
+ * buffer.Resize (model, num_rollouts, num_steps);
+ * engine.Run (Q0, QDot0, &controls, buffer);
+ * \endcode
+ *
+ * \note Not available with CasADi, as the Simulator is not.
+ *
+ * \defgroup rollout_group Rollouts
+ * @{
+ */
+
+/** \brief Preallocated trajectories of a batch of rollouts.
+ *
+ * The states of rollout r after k steps are stored in column
+ * r * (num_steps + 1) + k of RolloutBuffer::q and RolloutBuffer::qdot and
+ * the torques of step k in column r * num_steps + k of
+ * RolloutBuffer::tau, i.e. each trajectory is a contiguous block of
+ * memory.
+ */
+struct RBDL_DLLAPI RolloutBuffer {
+  RolloutBuffer() :
+    num_rollouts (0),
+    num_steps (0) {
+  }
+
+  /** \brief Allocates the trajectories of num_rollouts rollouts with
+   * num_steps steps each. */
+  void Resize (const Model &model, unsigned int num_rollouts,
+      unsigned int num_steps);
+
+  unsigned int num_rollouts;
+  unsigned int num_steps;
+
+  /// Generalized positions, num_steps + 1 columns per rollout.
+  Math::MatrixNd q;
+  /// Generalized velocities, num_steps + 1 columns per rollout.
+  Math::MatrixNd qdot;
+  /// Applied torques, num_steps columns per rollout.
+  Math::MatrixNd tau;
+};
+
+/** \brief State of a worker thread of the RolloutEngine. */
+struct RBDL_DLLAPI RolloutWorker {
+  RolloutWorker (const Model &model);
+
+  /// Copy of the model that is only used by this worker.
+  Model model;
+  /// Simulator of the worker, bound to RolloutWorker::model.
+  Simulator simulator;
+};
+
+/** \brief Simulates batches of independent rollouts of a model in
+ * parallel (see \ref rollout_page). */
+struct RBDL_DLLAPI RolloutEngine {
+  RolloutEngine();
+
+  /** \brief Creates num_threads workers for the model.
+   *
+   * The workers are created on their threads (pinned if
+   * RolloutEngine::cpu_affinity is set), such that their memory is
+   * allocated close to the cores that use it on NUMA systems.
+   * RolloutEngine::setup_worker is called for every worker afterwards.
+   *
+   * \note Throws an Errors::RBDLError if the model cannot be cloned (see
+   * Model::CloneForThread()).
+   */
+  bool Bind (const Model &model, unsigned int num_threads);
+
+  /** \brief Simulates one rollout per column of Q0 and QDot0 for
+   * buffer.num_steps steps.
+   *
+   * The torques of step k of rollout r are taken from column
+   * r * num_steps + k of Controls or, if Controls is NULL, from
+   * RolloutEngine::control_callback. Without both the torques are zero.
+   *
+   * \param Q0 initial positions (model.q_size x num_rollouts)
+   * \param QDot0 initial velocities (model.qdot_size x num_rollouts)
+   * \param Controls torques of all steps (model.qdot_size x num_rollouts *
+   * num_steps) or NULL
+   * \param buffer trajectories of the rollouts, has to be allocated with
+   * RolloutBuffer::Resize() for num_rollouts rollouts
+   *
+   * \note Throws an Errors::RBDLError if the sizes do not match. Errors of
+   * the workers are rethrown in the calling thread.
+   */
+  void Run (const Math::MatrixNd &Q0,
+      const Math::MatrixNd &QDot0,
+      const Math::MatrixNd *Controls,
+      RolloutBuffer &buffer);
+
+  // Settings (applied to the simulators of the workers in Run())
+
+  /// Time stepping scheme of the rollouts (default:
+  /// SimulatorIntegratorSemiImplicit).
+  SimulatorIntegrator integrator;
+  /// Length of a time step (default: 1.0e-3).
+  double dt;
+  /** \brief CPUs the worker threads are pinned to (default: empty, i.e.
+   * no pinning). Worker t runs on cpu_affinity[t % cpu_affinity.size()].
+   *
+   * \note Only supported on Linux, ignored otherwise.
+   */
+  std::vector<int> cpu_affinity;
+  /** \brief Computes the torques of a step from the state of the
+   * simulator (optional). Called concurrently by the workers. */
+  std::function<void (unsigned int rollout, unsigned int step,
+      const Simulator &simulator, Math::VectorNd &tau)> control_callback;
+  /** \brief Called once for every worker in Bind() (optional), e.g. to
+   * attach a ConstraintSet or a FrictionalContactSet that is bound to the
+   * model of the worker. */
+  std::function<void (unsigned int thread, RolloutWorker &worker)>
+    setup_worker;
+
+  std::vector<std::shared_ptr<RolloutWorker> > workers;
+};
+
+/** @} */
+
+}
+
+#endif
+
+/* RBDL_ROLLOUT_H */
+#endif
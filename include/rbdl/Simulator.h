@@ -0,0 +1,185 @@
+/*
+ * RBDL - Rigid Body Dynamics Library
+ * Copyright (c) 2011-2018 Martin Felis <martin@fysx.org>
+ *
+ * Licensed under the zlib license. See LICENSE for more details.
+ */
+
+#ifndef RBDL_SIMULATOR_H
+#define RBDL_SIMULATOR_H
+
+#include <functional>
+#include <vector>
+
+#include <rbdl/rbdl_math.h>
+#include <rbdl/rbdl_mathutils.h>
+
+#ifndef RBDL_USE_CASADI_MATH
+
+namespace RigidBodyDynamics {
+
+/** \page simulator_page Simulator
+ *
+ * The Simulator advances the state \f$(q, \dot{q})\f$ of a model with a
+ * fixed time step \f$h\f$. The generalized positions are updated with
+ * IntegrateConfiguration(), i.e. the quaternions of spherical joints and
+ * the pose of a free-flyer root move on their Lie groups and stay
+ * normalized, while the generalized velocities are integrated linearly.
+ *
+ * The following integrators are available:
+ *
+ * - SimulatorIntegratorSymplecticEuler:
+ *   \f$\dot{q}_{n+1} = \dot{q}_n + h \ddot{q}(q_n, \dot{q}_n)\f$,
+ *   \f$q_{n+1} = q_n \oplus h \dot{q}_{n+1}\f$.
+ * - SimulatorIntegratorSemiImplicit: a symplectic Euler step whose new
+ *   velocities are made consistent with the constraints by impulses at
+ *   \f$q_n\f$, i.e. the velocity error of the bilateral constraints is
+ *   removed in every step (ComputeConstraintImpulsesDirect() and its
+ *   variants) and unilateral frictional contacts are resolved with
+ *   SolveFrictionalContactImpulses(). This is the only integrator that
+ *   supports a FrictionalContactSet.
+ * - SimulatorIntegratorRungeKutta4: the classical fourth order
+ *   Runge-Kutta method in the chart \f$q(\theta) = q_n \oplus \theta\f$
+ *   of IntegrateConfiguration() (Runge-Kutta-Munthe-Kaas method). The
+ *   velocities of spherical joints and of a free-flyer root are mapped to
+ *   the chart with the inverse of the differential of the exponential map
+ *   truncated after the second order term, which retains the fourth order
+ *   of the method.
+ *
+ * The accelerations come from ForwardDynamics() or, if a ConstraintSet is
+ * attached, from the forward dynamics method selected by
+ * Simulator::constraint_solver.
+ *
+ * \note Not available with CasADi, as IntegrateConfiguration() is not.
+ *
+ * \defgroup simulator_group Simulator
+ * @{
+ */
+
+struct Model;
+struct ConstraintSet;
+struct FrictionalContactSet;
+
+/** \brief Time stepping scheme of the Simulator
+ * (see \ref simulator_page). */
+enum SimulatorIntegrator {
+  SimulatorIntegratorSymplecticEuler = 0,
+  SimulatorIntegratorSemiImplicit,
+  SimulatorIntegratorRungeKutta4,
+  SimulatorIntegratorLast
+};
+
+/** \brief Method that solves for the accelerations (and impulses) of a
+ * ConstraintSet. */
+enum ConstraintSolver {
+  /// ForwardDynamicsConstraintsDirect() and
+  /// ComputeConstraintImpulsesDirect()
+  ConstraintSolverDirect = 0,
+  /// ForwardDynamicsConstraintsRangeSpaceSparse() and
+  /// ComputeConstraintImpulsesRangeSpaceSparse()
+  ConstraintSolverRangeSpaceSparse,
+  /// ForwardDynamicsConstraintsNullSpace() and
+  /// ComputeConstraintImpulsesNullSpace()
+  ConstraintSolverNullSpace,
+  ConstraintSolverLast
+};
+
+/** \brief Fixed-step simulation of a model and the workspace of its
+ * integrators.
+ *
+ * The simulator has to be bound to a model with Simulator::Bind(), which
+ * allocates the state and the workspace. Afterwards the integrators do not
+ * allocate memory themselves, so that Simulator::Step() is free of
+ * allocations if the dynamics functions that are used are, e.g.
+ * ForwardDynamics() and SolveFrictionalContactImpulses().
+ *
+ * \code
+ * Simulator simulator;
+ * simulator.Bind (model);
+ * simulator.integrator = SimulatorIntegratorRungeKutta4;
+ * simulator.dt = 1.0e-3;
+ * simulator.q = q_init;
+ * simulator.Advance (1000);
+ * \endcode
+ *
+ * The torques Simulator::tau, the external forces Simulator::f_ext and
+ * the data of the constraint and contact sets may be changed between the
+ * steps, either by the caller or in Simulator::pre_step.
+ */
+struct RBDL_DLLAPI Simulator {
+  Simulator();
+
+  /** \brief Allocates the state and the workspace for the model.
+   *
+   * The state is reset to zero positions (identity quaternions), zero
+   * velocities and zero torques and the time to 0.
+   */
+  bool Bind (Model &model);
+
+  /** \brief Attaches a constraint set (NULL to detach it) and selects
+   * the method that solves it. The set has to be bound to the model. */
+  void SetConstraintSet (ConstraintSet *constraint_set,
+      ConstraintSolver solver = ConstraintSolverDirect);
+
+  /** \brief Advances the state by one time step of length
+   * Simulator::dt. */
+  void Step ();
+
+  /** \brief Advances the state by num_steps time steps. */
+  void Advance (unsigned int num_steps);
+
+  // Settings
+
+  /// Time stepping scheme (default: SimulatorIntegratorSemiImplicit).
+  SimulatorIntegrator integrator;
+  /// Length of a time step (default: 1.0e-3).
+  double dt;
+  /// Constraints of the model (default: NULL), see SetConstraintSet().
+  ConstraintSet *constraint_set;
+  /// Solver for Simulator::constraint_set.
+  ConstraintSolver constraint_solver;
+  /// Unilateral frictional contacts (default: NULL), only supported by
+  /// SimulatorIntegratorSemiImplicit. The set has to be bound to the
+  /// model.
+  FrictionalContactSet *contacts;
+  /// External forces on the bodies in base coordinates (default: NULL).
+  std::vector<Math::SpatialVector> *f_ext;
+  /// Called at the beginning of every step, e.g. to update the torques or
+  /// the contact points (optional).
+  std::function<void (Simulator &simulator)> pre_step;
+
+  // State
+
+  /// Simulated time.
+  double time;
+  Math::VectorNd q;
+  Math::VectorNd qdot;
+  /// Accelerations at the beginning of the last step.
+  Math::VectorNd qddot;
+  Math::VectorNd tau;
+
+  // Workspace
+
+  Model *model;
+  bool bound;
+  /// Positions at the end of the step (and of the Runge-Kutta stages).
+  Math::VectorNd q_next;
+  /// Velocities before the impulses of the semi-implicit step and of the
+  /// Runge-Kutta stages.
+  Math::VectorNd qdot_next;
+  /// Chart coordinates of the Runge-Kutta stages.
+  Math::VectorNd theta;
+  /// Chart velocities of the Runge-Kutta stages.
+  std::vector<Math::VectorNd> theta_dot;
+  /// Accelerations of the Runge-Kutta stages.
+  std::vector<Math::VectorNd> qddot_stage;
+};
+
+/** @} */
+
+}
+
+#endif
+
+/* RBDL_SIMULATOR_H */
+#endif
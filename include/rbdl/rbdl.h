@@ -19,6 +19,10 @@
 #include "rbdl/Joint.h"
 #include "rbdl/Kinematics.h"
 #include "rbdl/Constraints.h"
+#include "rbdl/FrictionalContacts.h"
+#include "rbdl/Simulator.h"
+#include "rbdl/Rollout.h"
+#include "rbdl/BatchDynamics.h"
 
 #include "rbdl/rbdl_utils.h"
 
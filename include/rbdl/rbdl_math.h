@@ -46,6 +46,9 @@ typedef Eigen::Matrix<double, 4, 3> Matrix43_t;
 
 typedef Eigen::VectorXd VectorN_t;
 typedef Eigen::MatrixXd MatrixN_t;
+
+typedef Eigen::VectorXf VectorNf_t;
+typedef Eigen::MatrixXf MatrixNf_t;
 #endif
 
 namespace RigidBodyDynamics {
@@ -66,6 +69,12 @@ typedef Matrix4_t Matrix4d;
 typedef VectorN_t VectorNd;
 typedef MatrixN_t MatrixNd;
 
+#ifndef RBDL_USE_CASADI_MATH
+/// Single precision types, e.g. for the single precision batch functions
+typedef VectorNf_t VectorNf;
+typedef MatrixNf_t MatrixNf;
+#endif
+
 } /* Math */
 
 } /* RigidBodyDynamics */
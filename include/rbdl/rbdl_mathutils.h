@@ -30,6 +30,10 @@ enum RBDL_DLLAPI LinearSolver {
   LinearSolverColPivHouseholderQR,
   LinearSolverHouseholderQR,
   LinearSolverLLT,
+  LinearSolverLDLT,
+  /** LU decomposition in single precision with iterative refinement in
+   * double precision (see SolveLinearSystemMixedPrecision()). */
+  LinearSolverMixedPrecisionLU,
   LinearSolverLast,
 };
 
@@ -71,6 +75,34 @@ RBDL_DLLAPI inline MatrixNd MatrixFromPtr (unsigned int rows, unsigned int cols,
 #ifndef RBDL_USE_CASADI_MATH
 /// \brief Solves a linear system using gaussian elimination with pivoting
 RBDL_DLLAPI bool LinSolveGaussElimPivot (MatrixNd A, VectorNd b, VectorNd &x);
+
+/** \brief Solves A x = b with an LU decomposition of A in single precision
+ * and iterative refinement of the residual in double precision.
+ *
+ * The refinement \f$ x \leftarrow x + \tilde{A}^{-1} (b - A x) \f$ with
+ * the single precision decomposition \f$ \tilde{A} \f$ converges to the
+ * double precision solution as long as the condition number of A is well
+ * below the inverse of the single precision epsilon (about \f$10^7\f$).
+ * If the normwise backward error \f$ \|b - A x\|_\infty / (\|A\|_\infty
+ * \|x\|_\infty + \|b\|_\infty) \f$ does not reach the tolerance within
+ * max_steps steps, the system is solved with an LU decomposition in double
+ * precision instead. The default tolerance \f$ \sqrt{n} \epsilon \f$
+ * (as used by LAPACK's dsgesv) yields the accuracy of a double precision
+ * decomposition.
+ *
+ * \param A square system matrix
+ * \param b right-hand-side
+ * \param x solution (output)
+ * \param tolerance bound on the backward error (0 selects the default)
+ * \param max_steps maximum number of refinement steps
+ * \param steps (optional output) number of refinement steps used
+ *
+ * \returns true if the refinement reached the tolerance, false if the
+ * double precision decomposition was used.
+ */
+RBDL_DLLAPI bool SolveLinearSystemMixedPrecision (const MatrixNd &A,
+    const VectorNd &b, VectorNd &x, double tolerance = 0.,
+    unsigned int max_steps = 10, unsigned int *steps = NULL);
 #endif
 
 // \todo write test 
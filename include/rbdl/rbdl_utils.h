@@ -9,6 +9,7 @@
 #define RBDL_UTILS_H
 
 #include <string>
+#include <vector>
 #include <rbdl/rbdl_config.h>
 #include <rbdl/rbdl_math.h>
 
@@ -64,6 +65,60 @@ RBDL_DLLAPI void CalcCenterOfMass (
   bool update_kinematics = true
 );
 
+/** \brief Computes the centroidal momentum matrix \f$A_G(q)\f$.
+ *
+ * The centroidal momentum matrix maps the generalized velocities to the
+ * spatial momentum of the model at its Center of Mass (COM):
+ * \f[ h_G = A_G(q) \dot{q} \f]
+ * where the first three rows of \f$h_G\f$ are the angular momentum at the
+ * COM and the last three rows are the linear momentum, both expressed in
+ * base coordinates.
+ *
+ * The matrix is computed in O(n) from the composite rigid body inertias
+ * (model.Ic) of the Composite Rigid Body Algorithm: each column of joint
+ * \f$i\f$ is the momentum \f$I^c_i S_i\f$ of the subtree of body \f$i\f$
+ * transformed to the COM.
+ *
+ * \param model The model for which we want to compute the matrix
+ * \param q The current joint positions
+ * \param A_G (output) 6 x \#qdot_size centroidal momentum matrix
+ * \param update_kinematics (optional input) whether the kinematics should be updated (defaults to true)
+ */
+RBDL_DLLAPI void CalcCentroidalMomentumMatrix (
+  Model &model,
+  const Math::VectorNd &q,
+  Math::MatrixNd &A_G,
+  bool update_kinematics = true
+);
+
+/** \brief Computes the time derivative of the centroidal momentum matrix
+ * \f$\dot{A}_G(q, \dot{q})\f$.
+ *
+ * Together with CalcCentroidalMomentumMatrix() this gives the rate of
+ * change of the centroidal momentum
+ * \f[ \dot{h}_G = A_G \ddot{q} + \dot{A}_G \dot{q}. \f]
+ *
+ * The matrix is computed in O(n) alongside the composite rigid body
+ * inertias by also accumulating their rates of change (model.Icdot).
+ *
+ * \param model The model for which we want to compute the matrix
+ * \param q The current joint positions
+ * \param qdot The current joint velocities
+ * \param A_G_dot (output) 6 x \#qdot_size time derivative of the centroidal
+ * momentum matrix
+ * \param update_kinematics (optional input) whether the kinematics should be updated (defaults to true)
+ *
+ * \note Custom joints are not supported as the time derivative of their
+ * motion subspace is not known.
+ */
+RBDL_DLLAPI void CalcCentroidalMomentumMatrixDot (
+  Model &model,
+  const Math::VectorNd &q,
+  const Math::VectorNd &qdot,
+  Math::MatrixNd &A_G_dot,
+  bool update_kinematics = true
+);
+
 /** \brief Computes the Zero-Moment-Point (ZMP) on a given contact surface.
  *
  * \param model The model for which we want to compute the ZMP
@@ -84,6 +139,78 @@ RBDL_DLLAPI void CalcZeroMomentPoint (
   bool update_kinematics = true
 );
 
+/** \brief Whole body quantities of a model state, see
+ * CalcWholeBodyQuantities(). All vectors are expressed in base coordinates.
+ */
+struct RBDL_DLLAPI WholeBodyQuantities {
+  WholeBodyQuantities();
+
+  /// total mass of the model
+  Math::Scalar mass;
+  /// location of the Center of Mass (COM)
+  Math::Vector3d com;
+  /// linear velocity of the COM
+  Math::Vector3d com_velocity;
+  /// linear acceleration of the COM
+  Math::Vector3d com_acceleration;
+  /// angular momentum of the model at the COM
+  Math::Vector3d angular_momentum;
+  /// change of angular momentum of the model at the COM
+  Math::Vector3d change_of_angular_momentum;
+  /// kinetic energy of the model
+  Math::Scalar kinetic_energy;
+  /// potential energy of the model
+  Math::Scalar potential_energy;
+  /// Zero-Moment-Point (ZMP) on the contact surface
+  Math::Vector3d zmp;
+};
+
+/** \brief Computes the COM quantities, energies and the ZMP of the model
+ * in a single pass over the bodies.
+ *
+ * Gives the same results as CalcCenterOfMass(), CalcKineticEnergy(),
+ * CalcPotentialEnergy() and CalcZeroMomentPoint() but only updates the
+ * kinematics once and accumulates all subtree quantities in one backward
+ * pass. The function does not allocate memory.
+ *
+ * \param model The model for which we want to compute the quantities
+ * \param q The current joint positions
+ * \param qdot The current joint velocities
+ * \param qddot The current joint accelerations
+ * \param quantities (output) the whole body quantities
+ * \param normal The normal of the contact surface of the ZMP
+ * \param update_kinematics (optional input) whether the kinematics should be updated (defaults to true)
+ */
+RBDL_DLLAPI void CalcWholeBodyQuantities (
+  Model &model,
+  const Math::VectorNd &q,
+  const Math::VectorNd &qdot,
+  const Math::VectorNd &qddot,
+  WholeBodyQuantities &quantities,
+  const Math::Vector3d &normal = Math::Vector3d (0., 0., 1.),
+  bool update_kinematics = true
+);
+
+/** \brief Computes the whole body quantities for a sequence of states,
+ * e.g. of a recorded trajectory.
+ *
+ * \param model The model for which we want to compute the quantities
+ * \param Q The joint positions of all states
+ * \param QDot The joint velocities of all states
+ * \param QDDot The joint accelerations of all states
+ * \param quantities (output) the whole body quantities of all states. The
+ * vector is only resized if its size does not match.
+ * \param normal The normal of the contact surface of the ZMP
+ */
+RBDL_DLLAPI void CalcWholeBodyQuantities (
+  Model &model,
+  const std::vector<Math::VectorNd> &Q,
+  const std::vector<Math::VectorNd> &QDot,
+  const std::vector<Math::VectorNd> &QDDot,
+  std::vector<WholeBodyQuantities> &quantities,
+  const Math::Vector3d &normal = Math::Vector3d (0., 0., 1.)
+);
+
 /** \brief Computes the potential energy of the full model. */
 RBDL_DLLAPI Math::Scalar CalcPotentialEnergy (Model &model, const Math::VectorNd &q, bool update_kinematics = true);
 
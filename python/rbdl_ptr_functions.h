@@ -511,6 +511,15 @@ void SolveLinearSystem (
         case RigidBodyDynamics::Math::LinearSolverHouseholderQR :
             x = A.householderQr().solve(b);
             break;
+        case RigidBodyDynamics::Math::LinearSolverLLT :
+            x = A.llt().solve(b);
+            break;
+        case RigidBodyDynamics::Math::LinearSolverLDLT :
+            x = A.ldlt().solve(b);
+            break;
+        case RigidBodyDynamics::Math::LinearSolverMixedPrecisionLU :
+            RigidBodyDynamics::Math::SolveLinearSystemMixedPrecision (A, b, x);
+            break;
         default:
             std::ostringstream errormsg;
             errormsg << "Error: Invalid linear solver: " << ls << std::endl;
@@ -0,0 +1,1052 @@
+/*
+ * RBDL - Rigid Body Dynamics Library
+ * Copyright (c) 2011-2018 Martin Felis <martin@fysx.org>
+ *
+ * Licensed under the zlib license. See LICENSE for more details.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "rbdl/rbdl_mathutils.h"
+#include "rbdl/Logging.h"
+
+#include "rbdl/Model.h"
+#include "rbdl/Dynamics.h"
+#include "rbdl/Kinematics.h"
+#include "rbdl/BatchDynamics.h"
+#include "rbdl/rbdl_errors.h"
+
+#ifndef RBDL_USE_CASADI_MATH
+
+#ifndef RBDL_BATCH_LANES
+#if defined(__AVX512F__)
+#define RBDL_BATCH_LANES 8
+#else
+#define RBDL_BATCH_LANES 4
+#endif
+#endif
+
+namespace RigidBodyDynamics {
+
+using namespace Math;
+
+static const int BatchLanes = RBDL_BATCH_LANES;
+
+/* The same registers hold twice as many single precision values. */
+template <typename Real>
+struct BatchLaneCount {
+  static const int value = BatchLanes * int (sizeof (double) / sizeof (Real));
+};
+
+template <typename Real>
+using BatchMatrix = Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic>;
+
+/* Every column holds one value per lane (i.e. per state) such that all
+ * operations below are packet operations. Matrices are stored row-major,
+ * e.g. entry (i, j) of a LaneMatrix3 is column 3 * i + j. */
+template <typename Real, int Cols>
+using LaneArray = Eigen::Array<Real, BatchLaneCount<Real>::value, Cols>;
+
+template <typename Real> using Lane = LaneArray<Real, 1>;
+template <typename Real> using LaneVector3 = LaneArray<Real, 3>;
+template <typename Real> using LaneSpatialVector = LaneArray<Real, 6>;
+template <typename Real> using LaneMatrix3 = LaneArray<Real, 9>;
+template <typename Real> using LaneMatrix63 = LaneArray<Real, 18>;
+template <typename Real> using LaneSpatialMatrix = LaneArray<Real, 36>;
+
+template <typename Real>
+struct LaneTransform {
+  LaneMatrix3<Real> E;
+  LaneVector3<Real> r;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+enum BatchJointKind {
+  BatchJointRevolute = 0,
+  BatchJointPrismatic,
+  BatchJointSpherical,
+  BatchJointTranslationXYZ
+};
+
+/* Constant quantities of a joint and its body. */
+template <typename Real>
+struct BatchJoint {
+  BatchJointKind kind;
+  unsigned int lambda;
+  unsigned int q_index;
+  unsigned int w_index;
+  unsigned int dof;
+  bool is_virtual;
+  Eigen::Matrix<Real, 3, 1> axis;
+  Eigen::Matrix<Real, 6, 3> S;
+  Eigen::Matrix<Real, 3, 3> E_T;
+  Eigen::Matrix<Real, 3, 1> r_T;
+  Eigen::Matrix<Real, 6, 6> I;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/* Lane-parallel quantities of a body. The column of U for degree of
+ * freedom k starts at column 6 * k. */
+template <typename Real>
+struct BatchBodyLanes {
+  LaneTransform<Real> X_lambda;
+  LaneTransform<Real> X_base;
+  LaneSpatialVector<Real> v;
+  LaneSpatialVector<Real> c;
+  LaneSpatialVector<Real> a;
+  LaneSpatialVector<Real> pA;
+  LaneSpatialMatrix<Real> IA;
+  LaneMatrix63<Real> U;
+  LaneMatrix3<Real> Dinv;
+  LaneVector3<Real> u;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+template <typename Real>
+struct BatchLaneSet {
+  std::vector<BatchJoint<Real>, Eigen::aligned_allocator<BatchJoint<Real> > >
+    joints;
+  std::vector<BatchBodyLanes<Real>,
+    Eigen::aligned_allocator<BatchBodyLanes<Real> > > bodies;
+};
+
+struct BatchLaneData {
+  BatchLaneSet<double> double_lanes;
+  BatchLaneSet<float> float_lanes;
+};
+
+template <typename Real>
+static BatchLaneSet<Real> &GetLaneSet (BatchLaneData &data);
+
+template <>
+BatchLaneSet<double> &GetLaneSet<double> (BatchLaneData &data) {
+  return data.double_lanes;
+}
+
+template <>
+BatchLaneSet<float> &GetLaneSet<float> (BatchLaneData &data) {
+  return data.float_lanes;
+}
+
+/* Stores the constant quantities of the joints with scalar type Real and
+ * returns whether all joints support the lane-parallel evaluation. */
+template <typename Real>
+static bool InitLaneSet (const Model &model, BatchLaneSet<Real> &data) {
+  data.joints.resize (model.mBodies.size());
+  data.bodies.resize (model.mBodies.size());
+
+  bool lane_parallel = true;
+
+  for (unsigned int i = 1; i < model.mBodies.size(); i++) {
+    const Joint &joint = model.mJoints[i];
+    BatchJoint<Real> &batch_joint = data.joints[i];
+
+    batch_joint.lambda = model.lambda[i];
+    batch_joint.q_index = joint.q_index;
+    batch_joint.w_index = 0;
+    batch_joint.dof = joint.mDoFCount;
+    batch_joint.is_virtual = model.mBodies[i].mIsVirtual;
+    batch_joint.axis.setZero();
+    batch_joint.S.setZero();
+    batch_joint.E_T = model.X_T[i].E.template cast<Real>();
+    batch_joint.r_T = model.X_T[i].r.template cast<Real>();
+    batch_joint.I = model.I[i].toMatrix().template cast<Real>();
+
+    switch (joint.mJointType) {
+      case JointTypeRevolute:
+      case JointTypeRevoluteX:
+      case JointTypeRevoluteY:
+      case JointTypeRevoluteZ:
+        batch_joint.kind = BatchJointRevolute;
+        batch_joint.axis = joint.mJointAxes[0].block<3,1>(0,0)
+          .template cast<Real>();
+        batch_joint.S.col(0) = joint.mJointAxes[0].template cast<Real>();
+        break;
+      case JointTypePrismatic:
+        batch_joint.kind = BatchJointPrismatic;
+        batch_joint.axis = joint.mJointAxes[0].block<3,1>(3,0)
+          .template cast<Real>();
+        batch_joint.S.col(0) = joint.mJointAxes[0].template cast<Real>();
+        break;
+      case JointTypeSpherical:
+        batch_joint.kind = BatchJointSpherical;
+        batch_joint.w_index = model.multdof3_w_index[i];
+        batch_joint.S.template block<3,3>(0,0).setIdentity();
+        break;
+      case JointTypeTranslationXYZ:
+        batch_joint.kind = BatchJointTranslationXYZ;
+        batch_joint.S.template block<3,3>(3,0).setIdentity();
+        break;
+      default:
+        lane_parallel = false;
+    }
+  }
+
+  return lane_parallel;
+}
+
+BatchWorkspace::BatchWorkspace() :
+  lanes (BatchLaneCount<double>::value),
+  lanes_float (BatchLaneCount<float>::value),
+  lane_parallel (false),
+  bound (false) {
+}
+
+bool BatchWorkspace::Bind (const Model &model) {
+  lane_data = std::make_shared<BatchLaneData>();
+
+  lanes = BatchLaneCount<double>::value;
+  lanes_float = BatchLaneCount<float>::value;
+  lane_parallel = InitLaneSet (model, lane_data->double_lanes);
+  InitLaneSet (model, lane_data->float_lanes);
+
+  q = VectorNd::Zero (model.q_size);
+  qdot = VectorNd::Zero (model.qdot_size);
+  qddot = VectorNd::Zero (model.qdot_size);
+  tau = VectorNd::Zero (model.qdot_size);
+
+  bound = true;
+
+  return bound;
+}
+
+/* Loads the values of row row of the states col to col + lanes - 1. Lanes
+ * beyond the last state repeat the last state. */
+template <typename Real>
+static inline void GatherLane (
+    const BatchMatrix<Real> &M,
+    unsigned int row,
+    unsigned int col,
+    Lane<Real> &lane) {
+  const unsigned int last_col = M.cols() - 1;
+  for (int w = 0; w < BatchLaneCount<Real>::value; w++) {
+    lane[w] = M(row, std::min (col + w, last_col));
+  }
+}
+
+template <typename Real, int Cols>
+static inline void GatherLanes (
+    const BatchMatrix<Real> &M,
+    unsigned int row,
+    unsigned int count,
+    unsigned int col,
+    LaneArray<Real, Cols> &lanes) {
+  const unsigned int last_col = M.cols() - 1;
+  for (unsigned int k = 0; k < count; k++) {
+    for (int w = 0; w < BatchLaneCount<Real>::value; w++) {
+      lanes(w, k) = M(row + k, std::min (col + w, last_col));
+    }
+  }
+}
+
+/* Stores the lanes that correspond to states into rows row to row + count
+ * - 1 of M. */
+template <typename Real, int Cols>
+static inline void ScatterLanes (
+    const LaneArray<Real, Cols> &lanes,
+    unsigned int row,
+    unsigned int count,
+    unsigned int col,
+    BatchMatrix<Real> &M) {
+  const unsigned int num_lanes = std::min<unsigned int> (
+      BatchLaneCount<Real>::value, M.cols() - col);
+  for (unsigned int k = 0; k < count; k++) {
+    for (unsigned int w = 0; w < num_lanes; w++) {
+      M(row + k, col + w) = lanes(w, k);
+    }
+  }
+}
+
+/* out[io..io+2] += a[ia..ia+2] x b[ib..ib+2] */
+template <typename A, typename B, typename Out>
+static inline void AddCrossProduct (
+    const A &a, int ia,
+    const B &b, int ib,
+    Out &out, int io) {
+  out.col(io) += a.col(ia + 1) * b.col(ib + 2) - a.col(ia + 2) * b.col(ib + 1);
+  out.col(io + 1) += a.col(ia + 2) * b.col(ib) - a.col(ia) * b.col(ib + 2);
+  out.col(io + 2) += a.col(ia) * b.col(ib + 1) - a.col(ia + 1) * b.col(ib);
+}
+
+/* out = crossm (v, w) */
+template <typename Real>
+static inline void CrossMotion (
+    const LaneSpatialVector<Real> &v,
+    const LaneSpatialVector<Real> &w,
+    LaneSpatialVector<Real> &out) {
+  out.setZero();
+  AddCrossProduct (v, 0, w, 0, out, 0);
+  AddCrossProduct (v, 0, w, 3, out, 3);
+  AddCrossProduct (v, 3, w, 0, out, 3);
+}
+
+/* out = crossf (v, f) */
+template <typename Real>
+static inline void CrossForce (
+    const LaneSpatialVector<Real> &v,
+    const LaneSpatialVector<Real> &f,
+    LaneSpatialVector<Real> &out) {
+  out.setZero();
+  AddCrossProduct (v, 0, f, 0, out, 0);
+  AddCrossProduct (v, 3, f, 3, out, 0);
+  AddCrossProduct (v, 0, f, 3, out, 3);
+}
+
+/* out = X.apply (v) */
+template <typename Real>
+static inline void ApplyTransform (
+    const LaneTransform<Real> &X,
+    const LaneSpatialVector<Real> &v,
+    LaneSpatialVector<Real> &out) {
+  const LaneMatrix3<Real> &E = X.E;
+  const LaneVector3<Real> &r = X.r;
+
+  LaneVector3<Real> v_rxw;
+  v_rxw.col(0) = v.col(3) - r.col(1) * v.col(2) + r.col(2) * v.col(1);
+  v_rxw.col(1) = v.col(4) - r.col(2) * v.col(0) + r.col(0) * v.col(2);
+  v_rxw.col(2) = v.col(5) - r.col(0) * v.col(1) + r.col(1) * v.col(0);
+
+  for (int k = 0; k < 3; k++) {
+    out.col(k) = E.col(3 * k) * v.col(0) + E.col(3 * k + 1) * v.col(1)
+      + E.col(3 * k + 2) * v.col(2);
+    out.col(k + 3) = E.col(3 * k) * v_rxw.col(0)
+      + E.col(3 * k + 1) * v_rxw.col(1) + E.col(3 * k + 2) * v_rxw.col(2);
+  }
+}
+
+/* out += X.applyTranspose (f) */
+template <typename Real>
+static inline void AddTransformTranspose (
+    const LaneTransform<Real> &X,
+    const LaneSpatialVector<Real> &f,
+    LaneSpatialVector<Real> &out) {
+  const LaneMatrix3<Real> &E = X.E;
+
+  LaneVector3<Real> E_T_f;
+  for (int k = 0; k < 3; k++) {
+    E_T_f.col(k) = E.col(k) * f.col(3) + E.col(3 + k) * f.col(4)
+      + E.col(6 + k) * f.col(5);
+    out.col(k) += E.col(k) * f.col(0) + E.col(3 + k) * f.col(1)
+      + E.col(6 + k) * f.col(2);
+  }
+  AddCrossProduct (X.r, 0, E_T_f, 0, out, 0);
+  out.template rightCols<3>() += E_T_f;
+}
+
+/* IA += X^T Ia X with X = [E, 0; -E rx, E] */
+template <typename Real>
+static inline void AddTransformedInertia (
+    const LaneTransform<Real> &X,
+    const LaneSpatialMatrix<Real> &Ia,
+    LaneSpatialMatrix<Real> &IA) {
+  const LaneMatrix3<Real> &E = X.E;
+  const LaneVector3<Real> &r = X.r;
+
+  LaneMatrix3<Real> B;
+  for (int i = 0; i < 3; i++) {
+    B.col(3 * i) = E.col(3 * i + 2) * r.col(1) - E.col(3 * i + 1) * r.col(2);
+    B.col(3 * i + 1) = E.col(3 * i) * r.col(2) - E.col(3 * i + 2) * r.col(0);
+    B.col(3 * i + 2) = E.col(3 * i + 1) * r.col(0) - E.col(3 * i) * r.col(1);
+  }
+
+  // M = Ia X
+  LaneSpatialMatrix<Real> M;
+  for (int i = 0; i < 6; i++) {
+    for (int j = 0; j < 3; j++) {
+      M.col(6 * i + j) = Ia.col(6 * i) * E.col(j)
+        + Ia.col(6 * i + 1) * E.col(3 + j)
+        + Ia.col(6 * i + 2) * E.col(6 + j)
+        + Ia.col(6 * i + 3) * B.col(j)
+        + Ia.col(6 * i + 4) * B.col(3 + j)
+        + Ia.col(6 * i + 5) * B.col(6 + j);
+      M.col(6 * i + 3 + j) = Ia.col(6 * i + 3) * E.col(j)
+        + Ia.col(6 * i + 4) * E.col(3 + j)
+        + Ia.col(6 * i + 5) * E.col(6 + j);
+    }
+  }
+
+  // IA += X^T M
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 6; j++) {
+      IA.col(6 * i + j) += E.col(i) * M.col(j)
+        + E.col(3 + i) * M.col(6 + j)
+        + E.col(6 + i) * M.col(12 + j)
+        + B.col(i) * M.col(18 + j)
+        + B.col(3 + i) * M.col(24 + j)
+        + B.col(6 + i) * M.col(30 + j);
+      IA.col(6 * (3 + i) + j) += E.col(i) * M.col(18 + j)
+        + E.col(3 + i) * M.col(24 + j)
+        + E.col(6 + i) * M.col(30 + j);
+    }
+  }
+}
+
+/* out = I v for the constant inertia I */
+template <typename Real>
+static inline void ApplyInertia (
+    const Eigen::Matrix<Real, 6, 6> &I,
+    const LaneSpatialVector<Real> &v,
+    LaneSpatialVector<Real> &out) {
+  out.setZero();
+  for (int i = 0; i < 6; i++) {
+    for (int j = 0; j < 6; j++) {
+      if (I(i, j) != 0.) {
+        out.col(i) += I(i, j) * v.col(j);
+      }
+    }
+  }
+}
+
+/* out = S x */
+template <typename Real>
+static inline void ApplyMotionSubspace (
+    const BatchJoint<Real> &joint,
+    const LaneVector3<Real> &x,
+    LaneSpatialVector<Real> &out) {
+  out.setZero();
+  for (int i = 0; i < 6; i++) {
+    for (unsigned int k = 0; k < joint.dof; k++) {
+      if (joint.S(i, k) != 0.) {
+        out.col(i) += joint.S(i, k) * x.col(k);
+      }
+    }
+  }
+}
+
+/* Computes X_lambda = X_J * X_T of the joint for the states col to col +
+ * lanes - 1. */
+template <typename Real>
+static void CalcLaneJointTransform (
+    const BatchJoint<Real> &joint,
+    const BatchMatrix<Real> &Q,
+    unsigned int col,
+    LaneTransform<Real> &X_lambda) {
+  const Eigen::Matrix<Real, 3, 3> &E_T = joint.E_T;
+  const Eigen::Matrix<Real, 3, 1> &r_T = joint.r_T;
+
+  if (joint.kind == BatchJointRevolute
+      || joint.kind == BatchJointSpherical) {
+    LaneMatrix3<Real> E_J;
+
+    if (joint.kind == BatchJointRevolute) {
+      Lane<Real> q;
+      GatherLane (Q, joint.q_index, col, q);
+      Lane<Real> s = q.sin();
+      Lane<Real> c = q.cos();
+      Lane<Real> one_minus_c = Real (1) - c;
+      const Eigen::Matrix<Real, 3, 1> &axis = joint.axis;
+
+      E_J.col(0) = axis[0] * axis[0] * one_minus_c + c;
+      E_J.col(1) = axis[1] * axis[0] * one_minus_c + axis[2] * s;
+      E_J.col(2) = axis[0] * axis[2] * one_minus_c - axis[1] * s;
+      E_J.col(3) = axis[0] * axis[1] * one_minus_c - axis[2] * s;
+      E_J.col(4) = axis[1] * axis[1] * one_minus_c + c;
+      E_J.col(5) = axis[1] * axis[2] * one_minus_c + axis[0] * s;
+      E_J.col(6) = axis[0] * axis[2] * one_minus_c + axis[1] * s;
+      E_J.col(7) = axis[1] * axis[2] * one_minus_c - axis[0] * s;
+      E_J.col(8) = axis[2] * axis[2] * one_minus_c + c;
+    } else {
+      Lane<Real> x, y, z, w;
+      GatherLane (Q, joint.q_index, col, x);
+      GatherLane (Q, joint.q_index + 1, col, y);
+      GatherLane (Q, joint.q_index + 2, col, z);
+      GatherLane (Q, joint.w_index, col, w);
+
+      E_J.col(0) = Real (1) - Real (2) * y * y - Real (2) * z * z;
+      E_J.col(1) = Real (2) * x * y + Real (2) * w * z;
+      E_J.col(2) = Real (2) * x * z - Real (2) * w * y;
+      E_J.col(3) = Real (2) * x * y - Real (2) * w * z;
+      E_J.col(4) = Real (1) - Real (2) * x * x - Real (2) * z * z;
+      E_J.col(5) = Real (2) * y * z + Real (2) * w * x;
+      E_J.col(6) = Real (2) * x * z + Real (2) * w * y;
+      E_J.col(7) = Real (2) * y * z - Real (2) * w * x;
+      E_J.col(8) = Real (1) - Real (2) * x * x - Real (2) * y * y;
+    }
+
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        X_lambda.E.col(3 * i + j) = E_J.col(3 * i) * E_T(0, j)
+          + E_J.col(3 * i + 1) * E_T(1, j) + E_J.col(3 * i + 2) * E_T(2, j);
+      }
+      X_lambda.r.col(i).setConstant (r_T[i]);
+    }
+  } else {
+    LaneVector3<Real> r_J;
+
+    if (joint.kind == BatchJointPrismatic) {
+      Lane<Real> q;
+      GatherLane (Q, joint.q_index, col, q);
+      for (int i = 0; i < 3; i++) {
+        r_J.col(i) = joint.axis[i] * q;
+      }
+    } else {
+      GatherLanes (Q, joint.q_index, 3, col, r_J);
+    }
+
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        X_lambda.E.col(3 * i + j).setConstant (E_T(i, j));
+      }
+      X_lambda.r.col(i) = r_T[i] + E_T(0, i) * r_J.col(0)
+        + E_T(1, i) * r_J.col(1) + E_T(2, i) * r_J.col(2);
+    }
+  }
+}
+
+/* X_base = X_lambda * X_base_lambda */
+template <typename Real>
+static inline void ComposeTransforms (
+    const LaneTransform<Real> &X_lambda,
+    const LaneTransform<Real> &X_base_lambda,
+    LaneTransform<Real> &X_base) {
+  const LaneMatrix3<Real> &E_a = X_lambda.E;
+  const LaneMatrix3<Real> &E_b = X_base_lambda.E;
+
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      X_base.E.col(3 * i + j) = E_a.col(3 * i) * E_b.col(j)
+        + E_a.col(3 * i + 1) * E_b.col(3 + j)
+        + E_a.col(3 * i + 2) * E_b.col(6 + j);
+    }
+    X_base.r.col(i) = X_base_lambda.r.col(i)
+      + E_b.col(i) * X_lambda.r.col(0) + E_b.col(3 + i) * X_lambda.r.col(1)
+      + E_b.col(6 + i) * X_lambda.r.col(2);
+  }
+}
+
+template <typename Real>
+static void ForwardDynamicsLanes (
+    const Model &model,
+    BatchLaneSet<Real> &data,
+    const BatchMatrix<Real> &Q,
+    const BatchMatrix<Real> &QDot,
+    const BatchMatrix<Real> &Tau,
+    unsigned int col,
+    BatchMatrix<Real> &QDDot) {
+  const unsigned int num_bodies = data.joints.size();
+
+  LaneSpatialVector<Real> a_0 = LaneSpatialVector<Real>::Zero();
+  for (int k = 0; k < 3; k++) {
+    a_0.col(3 + k).setConstant (Real (-model.gravity[k]));
+  }
+
+  LaneVector3<Real> qdot_J;
+  LaneSpatialVector<Real> v_J;
+  LaneSpatialVector<Real> temp;
+
+  for (unsigned int i = 1; i < num_bodies; i++) {
+    const BatchJoint<Real> &joint = data.joints[i];
+    BatchBodyLanes<Real> &body = data.bodies[i];
+
+    CalcLaneJointTransform (joint, Q, col, body.X_lambda);
+
+    GatherLanes (QDot, joint.q_index, joint.dof, col, qdot_J);
+    ApplyMotionSubspace (joint, qdot_J, v_J);
+
+    if (joint.lambda != 0) {
+      ApplyTransform (body.X_lambda, data.bodies[joint.lambda].v, body.v);
+      body.v += v_J;
+    } else {
+      body.v = v_J;
+    }
+
+    CrossMotion (body.v, v_J, body.c);
+
+    for (int k = 0; k < 36; k++) {
+      body.IA.col(k).setConstant (joint.I(k / 6, k % 6));
+    }
+
+    ApplyInertia (joint.I, body.v, temp);
+    CrossForce (body.v, temp, body.pA);
+  }
+
+  LaneVector3<Real> tau_J;
+  LaneMatrix3<Real> D;
+  LaneMatrix63<Real> UDinv;
+  LaneSpatialMatrix<Real> Ia;
+  LaneSpatialVector<Real> pa;
+
+  for (unsigned int i = num_bodies - 1; i > 0; i--) {
+    const BatchJoint<Real> &joint = data.joints[i];
+    BatchBodyLanes<Real> &body = data.bodies[i];
+    const unsigned int dof = joint.dof;
+
+    // U = IA S, D = S^T U, u = tau - S^T pA
+    GatherLanes (Tau, joint.q_index, dof, col, tau_J);
+    for (unsigned int k = 0; k < dof; k++) {
+      for (int r = 0; r < 6; r++) {
+        body.U.col(6 * k + r).setZero();
+        for (int m = 0; m < 6; m++) {
+          if (joint.S(m, k) != 0.) {
+            body.U.col(6 * k + r) += joint.S(m, k) * body.IA.col(6 * r + m);
+          }
+        }
+      }
+
+      body.u.col(k) = tau_J.col(k);
+      for (int r = 0; r < 6; r++) {
+        if (joint.S(r, k) != 0.) {
+          body.u.col(k) -= joint.S(r, k) * body.pA.col(r);
+        }
+      }
+
+      for (unsigned int j = 0; j < dof; j++) {
+        D.col(3 * j + k).setZero();
+        for (int r = 0; r < 6; r++) {
+          if (joint.S(r, j) != 0.) {
+            D.col(3 * j + k) += joint.S(r, j) * body.U.col(6 * k + r);
+          }
+        }
+      }
+    }
+
+    if (dof == 1) {
+      body.Dinv.col(0) = Real (1) / D.col(0);
+    } else {
+      LaneVector3<Real> cofactor;
+      cofactor.col(0) = D.col(4) * D.col(8) - D.col(5) * D.col(7);
+      cofactor.col(1) = D.col(5) * D.col(6) - D.col(3) * D.col(8);
+      cofactor.col(2) = D.col(3) * D.col(7) - D.col(4) * D.col(6);
+      Lane<Real> det_inv = Real (1) / (D.col(0) * cofactor.col(0)
+          + D.col(1) * cofactor.col(1) + D.col(2) * cofactor.col(2));
+
+      body.Dinv.col(0) = cofactor.col(0) * det_inv;
+      body.Dinv.col(1) = (D.col(2) * D.col(7) - D.col(1) * D.col(8))
+        * det_inv;
+      body.Dinv.col(2) = (D.col(1) * D.col(5) - D.col(2) * D.col(4))
+        * det_inv;
+      body.Dinv.col(3) = cofactor.col(1) * det_inv;
+      body.Dinv.col(4) = (D.col(0) * D.col(8) - D.col(2) * D.col(6))
+        * det_inv;
+      body.Dinv.col(5) = (D.col(2) * D.col(3) - D.col(0) * D.col(5))
+        * det_inv;
+      body.Dinv.col(6) = cofactor.col(2) * det_inv;
+      body.Dinv.col(7) = (D.col(1) * D.col(6) - D.col(0) * D.col(7))
+        * det_inv;
+      body.Dinv.col(8) = (D.col(0) * D.col(4) - D.col(1) * D.col(3))
+        * det_inv;
+    }
+
+    if (joint.lambda == 0) {
+      continue;
+    }
+
+    // Ia = IA - U Dinv U^T, pa = pA + Ia c + U Dinv u
+    for (unsigned int k = 0; k < dof; k++) {
+      for (int r = 0; r < 6; r++) {
+        UDinv.col(6 * k + r) = body.U.col(r) * body.Dinv.col(k);
+        for (unsigned int j = 1; j < dof; j++) {
+          UDinv.col(6 * k + r) += body.U.col(6 * j + r)
+            * body.Dinv.col(3 * j + k);
+        }
+      }
+    }
+
+    Ia = body.IA;
+    pa = body.pA;
+    for (unsigned int k = 0; k < dof; k++) {
+      for (int r = 0; r < 6; r++) {
+        for (int c = 0; c < 6; c++) {
+          Ia.col(6 * r + c) -= UDinv.col(6 * k + r) * body.U.col(6 * k + c);
+        }
+        pa.col(r) += UDinv.col(6 * k + r) * body.u.col(k);
+      }
+    }
+
+    for (int r = 0; r < 6; r++) {
+      for (int c = 0; c < 6; c++) {
+        pa.col(r) += Ia.col(6 * r + c) * body.c.col(c);
+      }
+    }
+
+    BatchBodyLanes<Real> &parent = data.bodies[joint.lambda];
+    AddTransformedInertia (body.X_lambda, Ia, parent.IA);
+    AddTransformTranspose (body.X_lambda, pa, parent.pA);
+  }
+
+  LaneVector3<Real> qddot_J;
+  LaneVector3<Real> u_minus_Ua;
+
+  for (unsigned int i = 1; i < num_bodies; i++) {
+    const BatchJoint<Real> &joint = data.joints[i];
+    BatchBodyLanes<Real> &body = data.bodies[i];
+    const unsigned int dof = joint.dof;
+
+    if (joint.lambda != 0) {
+      ApplyTransform (body.X_lambda, data.bodies[joint.lambda].a, body.a);
+    } else {
+      ApplyTransform (body.X_lambda, a_0, body.a);
+    }
+    body.a += body.c;
+
+    // qddot = Dinv (u - U^T a)
+    for (unsigned int k = 0; k < dof; k++) {
+      u_minus_Ua.col(k) = body.u.col(k);
+      for (int r = 0; r < 6; r++) {
+        u_minus_Ua.col(k) -= body.U.col(6 * k + r) * body.a.col(r);
+      }
+    }
+    for (unsigned int j = 0; j < dof; j++) {
+      qddot_J.col(j) = body.Dinv.col(3 * j) * u_minus_Ua.col(0);
+      for (unsigned int k = 1; k < dof; k++) {
+        qddot_J.col(j) += body.Dinv.col(3 * j + k) * u_minus_Ua.col(k);
+      }
+    }
+
+    ApplyMotionSubspace (joint, qddot_J, temp);
+    body.a += temp;
+
+    ScatterLanes (qddot_J, joint.q_index, dof, col, QDDot);
+  }
+}
+
+template <typename Real>
+static void InverseDynamicsLanes (
+    const Model &model,
+    BatchLaneSet<Real> &data,
+    const BatchMatrix<Real> &Q,
+    const BatchMatrix<Real> &QDot,
+    const BatchMatrix<Real> &QDDot,
+    unsigned int col,
+    BatchMatrix<Real> &Tau) {
+  const unsigned int num_bodies = data.joints.size();
+
+  LaneSpatialVector<Real> a_0 = LaneSpatialVector<Real>::Zero();
+  for (int k = 0; k < 3; k++) {
+    a_0.col(3 + k).setConstant (Real (-model.gravity[k]));
+  }
+
+  LaneVector3<Real> qdot_J;
+  LaneVector3<Real> qddot_J;
+  LaneSpatialVector<Real> v_J;
+  LaneSpatialVector<Real> temp;
+
+  for (unsigned int i = 1; i < num_bodies; i++) {
+    const BatchJoint<Real> &joint = data.joints[i];
+    BatchBodyLanes<Real> &body = data.bodies[i];
+
+    CalcLaneJointTransform (joint, Q, col, body.X_lambda);
+
+    GatherLanes (QDot, joint.q_index, joint.dof, col, qdot_J);
+    ApplyMotionSubspace (joint, qdot_J, v_J);
+
+    if (joint.lambda != 0) {
+      const BatchBodyLanes<Real> &parent = data.bodies[joint.lambda];
+      ApplyTransform (body.X_lambda, parent.v, body.v);
+      body.v += v_J;
+      ApplyTransform (body.X_lambda, parent.a, body.a);
+    } else {
+      body.v = v_J;
+      ApplyTransform (body.X_lambda, a_0, body.a);
+    }
+
+    CrossMotion (body.v, v_J, body.c);
+    body.a += body.c;
+
+    GatherLanes (QDDot, joint.q_index, joint.dof, col, qddot_J);
+    ApplyMotionSubspace (joint, qddot_J, temp);
+    body.a += temp;
+
+    // the forces of the bodies are accumulated in pA
+    if (!joint.is_virtual) {
+      ApplyInertia (joint.I, body.v, temp);
+      CrossForce (body.v, temp, body.pA);
+      ApplyInertia (joint.I, body.a, temp);
+      body.pA += temp;
+    } else {
+      body.pA.setZero();
+    }
+  }
+
+  LaneVector3<Real> tau_J;
+
+  for (unsigned int i = num_bodies - 1; i > 0; i--) {
+    const BatchJoint<Real> &joint = data.joints[i];
+    BatchBodyLanes<Real> &body = data.bodies[i];
+
+    for (unsigned int k = 0; k < joint.dof; k++) {
+      tau_J.col(k).setZero();
+      for (int r = 0; r < 6; r++) {
+        if (joint.S(r, k) != 0.) {
+          tau_J.col(k) += joint.S(r, k) * body.pA.col(r);
+        }
+      }
+    }
+    ScatterLanes (tau_J, joint.q_index, joint.dof, col, Tau);
+
+    if (joint.lambda != 0) {
+      AddTransformTranspose (body.X_lambda, body.pA,
+          data.bodies[joint.lambda].pA);
+    }
+  }
+}
+
+template <typename Real>
+static void CalcBodyToBaseCoordinatesLanes (
+    const Model &model,
+    BatchLaneSet<Real> &data,
+    const BatchMatrix<Real> &Q,
+    unsigned int body_id,
+    const Vector3d &point_body_coordinates,
+    unsigned int col,
+    BatchMatrix<Real> &points) {
+  Vector3d point = point_body_coordinates;
+
+  if (body_id >= model.fixed_body_discriminator) {
+    const FixedBody &fixed_body =
+      model.mFixedBodies[body_id - model.fixed_body_discriminator];
+    point = fixed_body.mParentTransform.r
+      + fixed_body.mParentTransform.E.transpose() * point;
+    body_id = fixed_body.mMovableParent;
+  }
+
+  // only bodies with smaller ids can be on the path to the body
+  for (unsigned int i = 1; i <= body_id; i++) {
+    const BatchJoint<Real> &joint = data.joints[i];
+    BatchBodyLanes<Real> &body = data.bodies[i];
+
+    if (joint.lambda != 0) {
+      CalcLaneJointTransform (joint, Q, col, body.X_lambda);
+      ComposeTransforms (body.X_lambda, data.bodies[joint.lambda].X_base,
+          body.X_base);
+    } else {
+      CalcLaneJointTransform (joint, Q, col, body.X_base);
+    }
+  }
+
+  // r + E^T point
+  const Eigen::Matrix<Real, 3, 1> point_lanes = point.template cast<Real>();
+  const LaneTransform<Real> &X_base = data.bodies[body_id].X_base;
+  LaneVector3<Real> position;
+  for (int k = 0; k < 3; k++) {
+    position.col(k) = X_base.r.col(k) + X_base.E.col(k) * point_lanes[0]
+      + X_base.E.col(3 + k) * point_lanes[1]
+      + X_base.E.col(6 + k) * point_lanes[2];
+  }
+
+  ScatterLanes (position, 0, 3, col, points);
+}
+
+static void CheckBatchWorkspace (
+    const Model &model,
+    const BatchWorkspace &workspace,
+    const char *function_name) {
+  if (!workspace.bound
+      || workspace.lane_data->double_lanes.joints.size()
+        != model.mBodies.size()
+      || workspace.q.size() != model.q_size) {
+    std::ostringstream errormsg;
+    errormsg << "Error: the BatchWorkspace passed to " << function_name
+             << " has not been bound to the model. Call "
+             << "BatchWorkspace::Bind() first." << std::endl;
+    throw Errors::RBDLError (errormsg.str());
+  }
+}
+
+template <typename Real>
+static void CheckBatchMatrixSize (
+    const BatchMatrix<Real> &M,
+    unsigned int rows,
+    unsigned int cols,
+    const char *matrix_name,
+    const char *function_name) {
+  if (M.rows() != rows || M.cols() != cols) {
+    std::ostringstream errormsg;
+    errormsg << "Error: invalid size of " << matrix_name << " in "
+             << function_name << ": expected " << rows << " x " << cols
+             << " but got " << M.rows() << " x " << M.cols() << "."
+             << std::endl;
+    throw Errors::RBDLError (errormsg.str());
+  }
+}
+
+/* Models that are not evaluated lane-parallel are evaluated state by state
+ * with the (double precision) scalar functions. */
+template <typename Real>
+static void ForwardDynamicsBatchImpl (
+    Model &model,
+    const BatchMatrix<Real> &Q,
+    const BatchMatrix<Real> &QDot,
+    const BatchMatrix<Real> &Tau,
+    BatchWorkspace &workspace,
+    BatchMatrix<Real> &QDDot,
+    const char *function_name) {
+  const unsigned int num_states = Q.cols();
+
+  CheckBatchWorkspace (model, workspace, function_name);
+  CheckBatchMatrixSize (Q, model.q_size, num_states, "Q", function_name);
+  CheckBatchMatrixSize (QDot, model.qdot_size, num_states, "QDot",
+      function_name);
+  CheckBatchMatrixSize (Tau, model.qdot_size, num_states, "Tau",
+      function_name);
+  CheckBatchMatrixSize (QDDot, model.qdot_size, num_states, "QDDot",
+      function_name);
+
+  if (!workspace.lane_parallel) {
+    for (unsigned int s = 0; s < num_states; s++) {
+      workspace.q = Q.col(s).template cast<double>();
+      workspace.qdot = QDot.col(s).template cast<double>();
+      workspace.tau = Tau.col(s).template cast<double>();
+      ForwardDynamics (model, workspace.q, workspace.qdot, workspace.tau,
+          workspace.qddot);
+      QDDot.col(s) = workspace.qddot.template cast<Real>();
+    }
+    return;
+  }
+
+  BatchLaneSet<Real> &data = GetLaneSet<Real> (*workspace.lane_data);
+  for (unsigned int col = 0; col < num_states;
+      col += BatchLaneCount<Real>::value) {
+    ForwardDynamicsLanes (model, data, Q, QDot, Tau, col, QDDot);
+  }
+}
+
+template <typename Real>
+static void InverseDynamicsBatchImpl (
+    Model &model,
+    const BatchMatrix<Real> &Q,
+    const BatchMatrix<Real> &QDot,
+    const BatchMatrix<Real> &QDDot,
+    BatchWorkspace &workspace,
+    BatchMatrix<Real> &Tau,
+    const char *function_name) {
+  const unsigned int num_states = Q.cols();
+
+  CheckBatchWorkspace (model, workspace, function_name);
+  CheckBatchMatrixSize (Q, model.q_size, num_states, "Q", function_name);
+  CheckBatchMatrixSize (QDot, model.qdot_size, num_states, "QDot",
+      function_name);
+  CheckBatchMatrixSize (QDDot, model.qdot_size, num_states, "QDDot",
+      function_name);
+  CheckBatchMatrixSize (Tau, model.qdot_size, num_states, "Tau",
+      function_name);
+
+  if (!workspace.lane_parallel) {
+    for (unsigned int s = 0; s < num_states; s++) {
+      workspace.q = Q.col(s).template cast<double>();
+      workspace.qdot = QDot.col(s).template cast<double>();
+      workspace.qddot = QDDot.col(s).template cast<double>();
+      InverseDynamics (model, workspace.q, workspace.qdot, workspace.qddot,
+          workspace.tau);
+      Tau.col(s) = workspace.tau.template cast<Real>();
+    }
+    return;
+  }
+
+  BatchLaneSet<Real> &data = GetLaneSet<Real> (*workspace.lane_data);
+  for (unsigned int col = 0; col < num_states;
+      col += BatchLaneCount<Real>::value) {
+    InverseDynamicsLanes (model, data, Q, QDot, QDDot, col, Tau);
+  }
+}
+
+template <typename Real>
+static void CalcBodyToBaseCoordinatesBatchImpl (
+    Model &model,
+    const BatchMatrix<Real> &Q,
+    unsigned int body_id,
+    const Vector3d &point_body_coordinates,
+    BatchWorkspace &workspace,
+    BatchMatrix<Real> &points,
+    const char *function_name) {
+  const unsigned int num_states = Q.cols();
+
+  CheckBatchWorkspace (model, workspace, function_name);
+  CheckBatchMatrixSize (Q, model.q_size, num_states, "Q", function_name);
+  CheckBatchMatrixSize (points, 3, num_states, "points", function_name);
+
+  if (!workspace.lane_parallel) {
+    for (unsigned int s = 0; s < num_states; s++) {
+      workspace.q = Q.col(s).template cast<double>();
+      points.col(s) = CalcBodyToBaseCoordinates (model, workspace.q, body_id,
+          point_body_coordinates, true).template cast<Real>();
+    }
+    return;
+  }
+
+  BatchLaneSet<Real> &data = GetLaneSet<Real> (*workspace.lane_data);
+  for (unsigned int col = 0; col < num_states;
+      col += BatchLaneCount<Real>::value) {
+    CalcBodyToBaseCoordinatesLanes (model, data, Q, body_id,
+        point_body_coordinates, col, points);
+  }
+}
+
+RBDL_DLLAPI void ForwardDynamicsBatch (
+    Model &model,
+    const MatrixNd &Q,
+    const MatrixNd &QDot,
+    const MatrixNd &Tau,
+    BatchWorkspace &workspace,
+    MatrixNd &QDDot) {
+  LOG << "-------- " << __func__ << " --------" << std::endl;
+
+  ForwardDynamicsBatchImpl (model, Q, QDot, Tau, workspace, QDDot, __func__);
+}
+
+RBDL_DLLAPI void ForwardDynamicsBatch (
+    Model &model,
+    const MatrixNf &Q,
+    const MatrixNf &QDot,
+    const MatrixNf &Tau,
+    BatchWorkspace &workspace,
+    MatrixNf &QDDot) {
+  LOG << "-------- " << __func__ << " (float) --------" << std::endl;
+
+  ForwardDynamicsBatchImpl (model, Q, QDot, Tau, workspace, QDDot, __func__);
+}
+
+RBDL_DLLAPI void InverseDynamicsBatch (
+    Model &model,
+    const MatrixNd &Q,
+    const MatrixNd &QDot,
+    const MatrixNd &QDDot,
+    BatchWorkspace &workspace,
+    MatrixNd &Tau) {
+  LOG << "-------- " << __func__ << " --------" << std::endl;
+
+  InverseDynamicsBatchImpl (model, Q, QDot, QDDot, workspace, Tau, __func__);
+}
+
+RBDL_DLLAPI void InverseDynamicsBatch (
+    Model &model,
+    const MatrixNf &Q,
+    const MatrixNf &QDot,
+    const MatrixNf &QDDot,
+    BatchWorkspace &workspace,
+    MatrixNf &Tau) {
+  LOG << "-------- " << __func__ << " (float) --------" << std::endl;
+
+  InverseDynamicsBatchImpl (model, Q, QDot, QDDot, workspace, Tau, __func__);
+}
+
+RBDL_DLLAPI void CalcBodyToBaseCoordinatesBatch (
+    Model &model,
+    const MatrixNd &Q,
+    unsigned int body_id,
+    const Vector3d &point_body_coordinates,
+    BatchWorkspace &workspace,
+    MatrixNd &points) {
+  CalcBodyToBaseCoordinatesBatchImpl (model, Q, body_id,
+      point_body_coordinates, workspace, points, __func__);
+}
+
+RBDL_DLLAPI void CalcBodyToBaseCoordinatesBatch (
+    Model &model,
+    const MatrixNf &Q,
+    unsigned int body_id,
+    const Vector3d &point_body_coordinates,
+    BatchWorkspace &workspace,
+    MatrixNf &points) {
+  CalcBodyToBaseCoordinatesBatchImpl (model, Q, body_id,
+      point_body_coordinates, workspace, points, __func__);
+}
+
+}
+
+#endif
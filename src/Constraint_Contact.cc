@@ -9,6 +9,7 @@
 #include <sstream>
 #include <limits>
 #include <assert.h>
+#include <algorithm>
 
 #include "rbdl/rbdl_mathutils.h"
 #include "rbdl/Logging.h"
@@ -81,6 +82,16 @@ void ContactConstraint::bind(const Model &model)
   //There are no dynamically-sized local matrices or vectors that
   //need to be adjusted for this constraint
 
+  //The point in the frame of the movable body that carries it: used when
+  //the constraint is evaluated together with the other contact constraints
+  //of this body
+  referencePoint = bodyFrames[0].r;
+  if(bodyIds[0] >= model.fixed_body_discriminator){
+    const FixedBody &fbody =
+        model.mFixedBodies[bodyIds[0] - model.fixed_body_discriminator];
+    referencePoint = fbody.mParentTransform.r
+                    + fbody.mParentTransform.E.transpose()*bodyFrames[0].r;
+  }
 }
 
 
@@ -94,13 +105,29 @@ void ContactConstraint::calcConstraintJacobian( Model &model,
                               ConstraintCache &cache,
                               bool updateKinematics)
 {
-  cache.mat3NA.setZero();
+  if(jacobianColumns.empty()){
+    cache.mat3NA.setZero();
+  }
   CalcPointJacobian(model, Q,bodyIds[0],bodyFrames[0].r,cache.mat3NA,
                     updateKinematics);
 
-  for(unsigned int i=0; i < sizeOfConstraint; ++i){
-    GSysUpd.block(rowInSystem+i,0,1,GSysUpd.cols()) =
-        T[i].transpose()*cache.mat3NA;
+  if(jacobianColumns.empty()){
+    for(unsigned int i=0; i < sizeOfConstraint; ++i){
+      GSysUpd.block(rowInSystem+i,0,1,GSysUpd.cols()) =
+          T[i].transpose()*cache.mat3NA;
+    }
+  }else{
+    //CalcPointJacobian writes every column of the ancestor chain of the
+    //body, which are exactly the columns listed here: the remaining
+    //columns of mat3NA are neither needed nor read.
+    for(unsigned int i=0; i < sizeOfConstraint; ++i){
+      for(unsigned int j=0; j < jacobianColumns.size(); ++j){
+        unsigned int k = jacobianColumns[j];
+        GSysUpd(rowInSystem+i,k) = T[i][0]*cache.mat3NA(0,k)
+                                  +T[i][1]*cache.mat3NA(1,k)
+                                  +T[i][2]*cache.mat3NA(2,k);
+      }
+    }
   }
 }
 
@@ -225,6 +252,89 @@ void ContactConstraint::calcConstraintForces(
   //Update the forces applied to the ground in the frame of the ground
   constraintForcesUpd[1].block(3,0,3,1) = -cache.vec3A;
 }
+//==============================================================================
+
+void ContactConstraint::calcConstraintJacobian(
+                              const ContactBodyKinematics &body,
+                              Math::MatrixNd &GSysUpd)
+{
+  //The velocity of the point is v_O + w x p, where (w, v_O) are the columns
+  //of the spatial Jacobian of the body at the base origin. Projected onto
+  //the normal T[i] this gives T[i]'v_O + (p x T[i])'w.
+  Math::Vector3d p = body.r + body.E.transpose()*referencePoint;
+
+  for(unsigned int i=0; i < sizeOfConstraint; ++i){
+    Math::Vector3d pxT = p.cross(T[i]);
+    if(jacobianColumns.empty()){
+      GSysUpd.block(rowInSystem+i,0,1,GSysUpd.cols()).setZero();
+    }
+    for(unsigned int j=0; j < body.columns.size(); ++j){
+      unsigned int k = body.columns[j];
+      GSysUpd(rowInSystem+i,k) = pxT[0]*body.J(0,k)
+                                +pxT[1]*body.J(1,k)
+                                +pxT[2]*body.J(2,k)
+                                +T[i][0]*body.J(3,k)
+                                +T[i][1]*body.J(4,k)
+                                +T[i][2]*body.J(5,k);
+    }
+  }
+}
+
+//==============================================================================
+
+void ContactConstraint::calcGamma(const ContactBodyKinematics &body,
+                                  Math::VectorNd &gammaSysUpd)
+{
+  //Acceleration of the point in body coordinates (cf. CalcPointAcceleration)
+  //  a_p = a_O + dw x r + w x (v_O + w x r)
+  Math::Vector3d w (body.v[0], body.v[1], body.v[2]);
+  Math::Vector3d dw(body.a[0], body.a[1], body.a[2]);
+
+  Math::Vector3d vp = Math::Vector3d(body.v[3], body.v[4], body.v[5])
+                      + w.cross(referencePoint);
+  Math::Vector3d ap = Math::Vector3d(body.a[3], body.a[4], body.a[5])
+                      + dw.cross(referencePoint) + w.cross(vp);
+  ap = body.E.transpose()*ap;
+
+  for(unsigned int i=0; i < sizeOfConstraint; ++i){
+    gammaSysUpd[rowInSystem+i] = -T[i].dot(ap);
+  }
+}
+
+//==============================================================================
+
+void ContactConstraint::calcPositionError(const ContactBodyKinematics &body,
+                                          Math::VectorNd &errSysUpd)
+{
+  Math::Vector3d p = body.r + body.E.transpose()*referencePoint
+                     - groundPoint;
+  for(unsigned int i = 0; i < sizeOfConstraint; ++i){
+    if(positionConstraint[i]){
+      errSysUpd[rowInSystem+i] = p.dot( T[i] );
+    }else{
+      errSysUpd[rowInSystem+i] = 0.;
+    }
+  }
+}
+
+//==============================================================================
+
+void ContactConstraint::calcVelocityError(const ContactBodyKinematics &body,
+                                          Math::VectorNd &derrSysUpd)
+{
+  Math::Vector3d w (body.v[0], body.v[1], body.v[2]);
+  Math::Vector3d vp = body.E.transpose()
+                      * (Math::Vector3d(body.v[3], body.v[4], body.v[5])
+                         + w.cross(referencePoint));
+  for(unsigned int i = 0; i < sizeOfConstraint; ++i){
+    if(velocityConstraint[i]){
+      derrSysUpd[rowInSystem+i] = vp.dot( T[i] );
+    }else{
+      derrSysUpd[rowInSystem+i] = 0.;
+    }
+  }
+}
+
 //==============================================================================
 void ContactConstraint::
         appendNormalVector(const Math::Vector3d& normal,
@@ -321,3 +431,68 @@ void ContactConstraint::
 
 
 
+
+//==============================================================================
+
+void ContactBodyKinematics::bind(const Model &model, unsigned int bodyId)
+{
+  referenceBodyId = bodyId;
+  if(bodyId >= model.fixed_body_discriminator){
+    referenceBodyId = model.mFixedBodies[
+        bodyId - model.fixed_body_discriminator].mMovableParent;
+  }
+
+  E = Math::Matrix3dIdentity;
+  r.setZero();
+  v.setZero();
+  a.setZero();
+  J = Math::MatrixNd::Zero(6, model.qdot_size);
+
+  columns.clear();
+  unsigned int j = referenceBodyId;
+  while(j != 0){
+    for(unsigned int k=0; k < model.mJoints[j].mDoFCount; ++k){
+      columns.push_back(model.mJoints[j].q_index + k);
+    }
+    j = model.lambda[j];
+  }
+  std::sort(columns.begin(), columns.end());
+}
+
+//==============================================================================
+
+void ContactBodyKinematics::update(const Model &model)
+{
+  E = model.X_base[referenceBodyId].E;
+  r = model.X_base[referenceBodyId].r;
+  v = model.v[referenceBodyId];
+  a = model.a[referenceBodyId];
+}
+
+//==============================================================================
+
+void ContactBodyKinematics::updateJacobian(const Model &model)
+{
+  //Same columns as in CalcPointJacobian, but at the base origin so that
+  //they can be shared by all points of the body
+  unsigned int j = referenceBodyId;
+  while(j != 0){
+    unsigned int q_index = model.mJoints[j].q_index;
+
+    if(model.mJoints[j].mJointType != JointTypeCustom){
+      if(model.mJoints[j].mDoFCount == 1){
+        J.block(0,q_index,6,1) =
+            model.X_base[j].inverse().apply(model.S[j]);
+      }else if(model.mJoints[j].mDoFCount == 3){
+        J.block(0,q_index,6,3) =
+            model.X_base[j].inverse().toMatrix() * model.multdof3_S[j];
+      }
+    }else{
+      unsigned int k = model.mJoints[j].custom_joint_index;
+      J.block(0,q_index,6,model.mCustomJoints[k]->mDoFCount) =
+          model.X_base[j].inverse().toMatrix() * model.mCustomJoints[k]->S;
+    }
+
+    j = model.lambda[j];
+  }
+}
@@ -111,8 +111,18 @@ void LoopConstraint::calcConstraintJacobian( Model &model,
       //Resolve each constraint axis into the global frame
       cache.svecA =cache.stA.apply(T[i]);
       //Take the dot product of the constraint axis with Gs-Gp
-      GSysUpd.block(rowInSystem+i,0,1,GSysUpd.cols())
-          = cache.svecA.transpose()*cache.mat6NA;
+      if(jacobianColumns.empty()){
+        GSysUpd.block(rowInSystem+i,0,1,GSysUpd.cols())
+            = cache.svecA.transpose()*cache.mat6NA;
+      }else{
+        for(unsigned int j=0; j<jacobianColumns.size();++j){
+          unsigned int k = jacobianColumns[j];
+          GSysUpd(rowInSystem+i,k) = 0.;
+          for(unsigned int l=0; l<6;++l){
+            GSysUpd(rowInSystem+i,k) += cache.svecA[l]*cache.mat6NA(l,k);
+          }
+        }
+      }
     }
 
 }
@@ -255,9 +265,16 @@ void LoopConstraint::calcVelocityError(  Model &model,
   for(unsigned int i=0; i<sizeOfConstraint;++i){
     derrSysUpd[rowInSystem+i] = 0;
     if(velocityConstraint[i]){
-      for(unsigned int j=0; j<GSys.cols();++j){
-        derrSysUpd[rowInSystem+i] +=
-             GSys(rowInSystem+i,j)*QDot[j];
+      if(jacobianColumns.empty()){
+        for(unsigned int j=0; j<GSys.cols();++j){
+          derrSysUpd[rowInSystem+i] +=
+               GSys(rowInSystem+i,j)*QDot[j];
+        }
+      }else{
+        for(unsigned int j=0; j<jacobianColumns.size();++j){
+          derrSysUpd[rowInSystem+i] +=
+               GSys(rowInSystem+i,jacobianColumns[j])*QDot[jacobianColumns[j]];
+        }
       }
     }
   }
@@ -25,6 +25,12 @@
 #include "rbdl/Dynamics.h"
 #include "rbdl/Kinematics.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 namespace RigidBodyDynamics
 {
 
@@ -39,6 +45,52 @@ void SolveLinearSystem (
 
 unsigned int GetMovableBodyId (Model& model, unsigned int id);
 
+SchurComplementWorkspace* GetSchurComplementWorkspace (ConstraintSet& CS);
+
+#ifndef RBDL_USE_CASADI_MATH
+void ApplyAssemblyStep (
+  const Model& model,
+  const VectorNd& d,
+  VectorNd& Q
+);
+#endif
+
+void SelectBlock (
+  const MatrixNd& M,
+  const std::vector<unsigned int>& rows,
+  const std::vector<unsigned int>& cols,
+  MatrixNd& block
+);
+
+void SelectTransposedColumns (
+  const MatrixNd& M,
+  const std::vector<unsigned int>& cols,
+  MatrixNd& block
+);
+
+template <typename GroupFunction, typename Function>
+void ForEachConstraint (
+  ConstraintSet& CS,
+  GroupFunction group_fn,
+  Function fn
+);
+
+#ifndef RBDL_USE_CASADI_MATH
+template <typename Decomposition>
+bool SolveWithRefinement (
+  const Decomposition& dec,
+  const MatrixNd& A,
+  const VectorNd& b,
+  VectorNd& x,
+  VectorNd& r,
+  VectorNd& dx,
+  double tol,
+  unsigned int max_steps,
+  double& residual,
+  unsigned int& steps
+);
+#endif
+
 //==============================================================================
 
 
@@ -417,6 +469,10 @@ bool ConstraintSet::Bind (const Model &model)
   cache.mat6NC.resize(6, model.qdot_size);
   cache.mat6ND.resize(6, model.qdot_size);
 
+  thread_caches.assign(num_threads - 1, cache);
+  if (workers.size() != num_threads - 1) {
+    workers.Resize(num_threads - 1);
+  }
 
   unsigned int n_constr = size();
 
@@ -426,6 +482,10 @@ bool ConstraintSet::Bind (const Model &model)
   C.setZero();
   gamma.conservativeResize (n_constr);
   gamma.setZero();
+  compliance = VectorNd::Zero (n_constr);
+  for (unsigned int i = 0; i < constraints.size(); i++) {
+    constraints[i]->setComplianceInSystem(compliance);
+  }
   G.conservativeResize (n_constr, model.dof_count);
   G.setZero();
   A.conservativeResize (model.dof_count + n_constr, model.dof_count + n_constr);
@@ -451,6 +511,28 @@ bool ConstraintSet::Bind (const Model &model)
   qddot_y = VectorNd::Zero (model.dof_count);
   qddot_z = VectorNd::Zero (model.dof_count);
 
+#ifndef RBDL_USE_CASADI_MATH
+  // all constraints are active for the factorized null-space method
+  NullSpaceQRFactorization &nsf = null_space_factorization;
+  nsf.factorized = false;
+  nsf.update_count = 0;
+  nsf.active.assign (n_constr, true);
+  nsf.rows.clear();
+  nsf.rows.reserve (n_constr);
+  for (unsigned int i = 0; i < n_constr; i++) {
+    nsf.rows.push_back (i);
+  }
+  nsf.Q = MatrixNd::Identity (model.dof_count, model.dof_count);
+  nsf.R = MatrixNd::Zero (model.dof_count, n_constr);
+  nsf.GaT = MatrixNd::Zero (model.dof_count, n_constr);
+  nsf.HZ = MatrixNd::Zero (model.dof_count, model.dof_count);
+  nsf.ZHZ = MatrixNd::Zero (model.dof_count, model.dof_count);
+  nsf.rhs = VectorNd::Zero (model.dof_count);
+  nsf.w = VectorNd::Zero (model.dof_count);
+
+  schur_complement.resize (model.dof_count, n_constr);
+#endif
+
   K.conservativeResize (n_constr, n_constr);
   K.setZero();
   a.conservativeResize (n_constr);
@@ -479,6 +561,110 @@ bool ConstraintSet::Bind (const Model &model)
   d_multdof3_u = std::vector<Math::Vector3d> (model.mBodies.size()
                  , Math::Vector3d::Zero());
 
+  // Structural non-zero pattern of G
+  G_pattern.rowStart.clear();
+  G_pattern.columns.clear();
+
+  if (sparse_jacobian) {
+    std::vector<bool> in_support (model.qdot_size);
+    std::vector< std::vector<unsigned int> > row_columns (n_constr);
+
+    for (unsigned int i = 0; i < constraints.size(); i++) {
+      std::vector<unsigned int> columns;
+
+      if (constraints[i]->getConstraintType() == ConstraintTypeCustom) {
+        // No assumptions on custom constraints: their rows are dense.
+        for (unsigned int j = 0; j < model.qdot_size; j++) {
+          columns.push_back(j);
+        }
+      } else {
+        std::fill (in_support.begin(), in_support.end(), false);
+
+        const std::vector<unsigned int> &body_ids =
+          constraints[i]->getBodyIds();
+
+        for (unsigned int k = 0; k < body_ids.size(); k++) {
+          unsigned int j = body_ids[k];
+          if (j >= model.fixed_body_discriminator) {
+            j = model.mFixedBodies[j - model.fixed_body_discriminator]
+                .mMovableParent;
+          }
+
+          while (j != 0) {
+            for (unsigned int l = 0; l < model.mJoints[j].mDoFCount; l++) {
+              in_support[model.mJoints[j].q_index + l] = true;
+            }
+            j = model.lambda[j];
+          }
+        }
+
+        for (unsigned int j = 0; j < model.qdot_size; j++) {
+          if (in_support[j]) {
+            columns.push_back(j);
+          }
+        }
+
+        constraints[i]->setJacobianColumns(columns);
+      }
+
+      for (unsigned int k = 0; k < constraints[i]->getConstraintSize(); k++) {
+        row_columns[constraints[i]->getConstraintIndex() + k] = columns;
+      }
+    }
+
+    G_pattern.rowStart.push_back(0);
+    for (unsigned int i = 0; i < n_constr; i++) {
+      G_pattern.columns.insert(G_pattern.columns.end(),
+                               row_columns[i].begin(), row_columns[i].end());
+      G_pattern.rowStart.push_back(G_pattern.columns.size());
+    }
+  } else {
+    std::vector<unsigned int> no_columns;
+    for (unsigned int i = 0; i < constraints.size(); i++) {
+      constraints[i]->setJacobianColumns(no_columns);
+    }
+  }
+
+  // Contact constraints on the same movable body share its kinematics.
+  std::map<unsigned int, std::vector<unsigned int> > body_contacts;
+  for (unsigned int i = 0; i < contactConstraints.size(); i++) {
+    unsigned int j = contactConstraints[i]->getBodyIds()[0];
+    if (j >= model.fixed_body_discriminator) {
+      j = model.mFixedBodies[j - model.fixed_body_discriminator]
+          .mMovableParent;
+    }
+    body_contacts[j].push_back(i);
+  }
+
+  contact_groups.clear();
+  std::vector<bool> grouped (constraints.size(), false);
+  std::map<unsigned int, std::vector<unsigned int> >::iterator it;
+  for (it = body_contacts.begin(); it != body_contacts.end(); ++it) {
+    if (it->second.size() < 2) {
+      continue;
+    }
+    contact_groups.push_back(ContactConstraintGroup());
+    ContactConstraintGroup &group = contact_groups.back();
+    group.body.bind(model, it->first);
+    group.contactConstraintIndices = it->second;
+
+    for (unsigned int k = 0; k < it->second.size(); k++) {
+      const Constraint *contact = contactConstraints[it->second[k]].get();
+      for (unsigned int i = 0; i < constraints.size(); i++) {
+        if (constraints[i].get() == contact) {
+          grouped[i] = true;
+        }
+      }
+    }
+  }
+
+  ungrouped_constraints.clear();
+  for (unsigned int i = 0; i < constraints.size(); i++) {
+    if (!grouped[i]) {
+      ungrouped_constraints.push_back(i);
+    }
+  }
+
   bound = true;
 
   return bound;
@@ -517,14 +703,19 @@ void ConstraintSet::SetActuationMap(const Model &model,
   u.resize(na);
   v.resize(nu);
 
+  actuated_dof_index.resize(na);
+  unactuated_dof_index.resize(nu);
+
   unsigned int j=0;
   unsigned int k=0;
   for(unsigned int i=0; i<model.dof_count; ++i) {
     if(actuatedDofUpd[i]) {
       S(j,i) = 1.;
+      actuated_dof_index[j] = i;
       ++j;
     } else {
       P(k,i) = 1.;
+      unactuated_dof_index[k] = i;
       ++k;
     }
   }
@@ -555,10 +746,193 @@ void ConstraintSet::SetActuationMap(const Model &model,
   GTu.conservativeResize(na,nc);
   GTl.conservativeResize(nu,nc);
 
+  Cu.conservativeResize(na);
+  Cl.conservativeResize(nu);
+
   GPT.conservativeResize(nc,nu);
 
 }
 
+#ifndef RBDL_USE_CASADI_MATH
+//==============================================================================
+void ConstraintSet::SetRelaxedFactorizationReuse(
+  bool enable,
+  unsigned int refactorizationInterval,
+  double residualTolerance,
+  unsigned int maxRefinementSteps)
+{
+  unsigned int n  = unsigned( F.rows() );
+  unsigned int nc = unsigned( name.size() );
+  unsigned int na = unsigned( W.rows() );
+
+  RelaxedKKTFactorization &fac = relaxed_factorization;
+  fac.enabled                     = enable;
+  fac.factorized                  = false;
+  fac.refactorization_interval    = refactorizationInterval;
+  fac.residual_tolerance          = residualTolerance;
+  fac.max_refinement_steps        = maxRefinementSteps;
+  fac.frames_since_factorization  = 0;
+  fac.factorization_count         = 0;
+  fac.refinement_steps            = 0;
+  fac.residual                    = 0.;
+
+  if (!enable) {
+    return;
+  }
+
+  fac.K     = MatrixNd::Zero(n+nc, n+nc);
+  fac.rhs   = VectorNd::Zero(n+nc);
+  fac.sol   = VectorNd::Zero(n+nc);
+  fac.res   = VectorNd::Zero(n+nc);
+  fac.delta = VectorNd::Zero(n+nc);
+  fac.res_w   = VectorNd::Zero(na);
+  fac.delta_w = VectorNd::Zero(na);
+  fac.kkt_lu = Eigen::PartialPivLU<MatrixNd>(n+nc);
+  fac.W_llt  = Eigen::LLT<MatrixNd>(na);
+}
+
+//==============================================================================
+/* Appends the row of G to the factorization of the active rows: the new
+ * column of R is Q^T g, whose entries below the diagonal are eliminated
+ * with Givens rotations that are accumulated in Q. */
+static void NullSpaceQRAppendRow (
+  NullSpaceQRFactorization &nsf,
+  const MatrixNd &G,
+  unsigned int row)
+{
+  unsigned int n = unsigned(nsf.Q.rows());
+  unsigned int k = unsigned(nsf.rows.size());
+
+  if (k >= n) {
+    throw Errors::RBDLError(
+      "Error: the null-space method requires at most as many active "
+      "constraints as degrees of freedom!\n");
+  }
+
+  nsf.w.noalias() = nsf.Q.transpose() * G.row(row).transpose();
+
+  Eigen::JacobiRotation<double> givens;
+  for (unsigned int i = n - 1; i > k; i--) {
+    givens.makeGivens (nsf.w[i-1], nsf.w[i], &nsf.w[i-1]);
+    nsf.w[i] = 0.;
+    nsf.Q.applyOnTheRight (i-1, i, givens);
+  }
+
+  nsf.R.col(k) = nsf.w;
+}
+
+/* Removes the column at position j from R. The columns right of it are
+ * shifted to the left, which leaves R upper Hessenberg, and the
+ * subdiagonal is eliminated with Givens rotations that are accumulated in
+ * Q. */
+static void NullSpaceQRRemoveColumn (
+  NullSpaceQRFactorization &nsf,
+  unsigned int j)
+{
+  unsigned int k = unsigned(nsf.rows.size());
+
+  for (unsigned int c = j; c + 1 < k; c++) {
+    nsf.R.col(c) = nsf.R.col(c+1);
+  }
+  nsf.R.col(k-1).setZero();
+
+  Eigen::JacobiRotation<double> givens;
+  for (unsigned int c = j; c + 1 < k; c++) {
+    givens.makeGivens (nsf.R(c,c), nsf.R(c+1,c));
+    nsf.R.applyOnTheLeft (c, c+1, givens.adjoint());
+    nsf.R(c+1,c) = 0.;
+    nsf.Q.applyOnTheRight (c, c+1, givens);
+  }
+}
+
+//==============================================================================
+void ConstraintSet::FactorizeNullSpace ()
+{
+  assert (bound);
+
+  NullSpaceQRFactorization &nsf = null_space_factorization;
+  unsigned int n = unsigned(G.cols());
+  unsigned int m = unsigned(nsf.rows.size());
+
+  if (m > n) {
+    throw Errors::RBDLError(
+      "Error: the null-space method requires at most as many active "
+      "constraints as degrees of freedom!\n");
+  }
+
+  for (unsigned int k = 0; k < m; k++) {
+    nsf.GaT.col(k) = G.row(nsf.rows[k]).transpose();
+  }
+
+  nsf.R.setZero();
+  if (m == 0) {
+    nsf.Q.setIdentity();
+  } else {
+    nsf.qr.compute (nsf.GaT.leftCols(m));
+    nsf.qr.householderQ().evalTo (nsf.Q);
+    nsf.R.leftCols(m) = nsf.qr.matrixQR().triangularView<Eigen::Upper>();
+  }
+
+  nsf.factorized = true;
+  nsf.update_count = 0;
+}
+
+//==============================================================================
+void ConstraintSet::ActivateConstraint (unsigned int groupIndex)
+{
+  assert (bound);
+  assert (groupIndex < constraints.size());
+
+  NullSpaceQRFactorization &nsf = null_space_factorization;
+  unsigned int row_start = constraints[groupIndex]->getConstraintIndex();
+  unsigned int row_end = row_start
+                         + constraints[groupIndex]->getConstraintSize();
+
+  for (unsigned int i = row_start; i < row_end; i++) {
+    if (nsf.active[i]) {
+      continue;
+    }
+
+    if (nsf.factorized) {
+      NullSpaceQRAppendRow (nsf, G, i);
+      nsf.update_count++;
+    }
+
+    nsf.active[i] = true;
+    nsf.rows.push_back (i);
+  }
+}
+
+//==============================================================================
+void ConstraintSet::DeactivateConstraint (unsigned int groupIndex)
+{
+  assert (bound);
+  assert (groupIndex < constraints.size());
+
+  NullSpaceQRFactorization &nsf = null_space_factorization;
+  unsigned int row_start = constraints[groupIndex]->getConstraintIndex();
+  unsigned int row_end = row_start
+                         + constraints[groupIndex]->getConstraintSize();
+
+  for (unsigned int i = row_start; i < row_end; i++) {
+    if (!nsf.active[i]) {
+      continue;
+    }
+
+    unsigned int j = unsigned(std::find (nsf.rows.begin(), nsf.rows.end(), i)
+                              - nsf.rows.begin());
+
+    if (nsf.factorized) {
+      NullSpaceQRRemoveColumn (nsf, j);
+      nsf.update_count++;
+    }
+
+    nsf.active[i] = false;
+    nsf.rows.erase (nsf.rows.begin() + j);
+  }
+}
+#endif
+
 void ConstraintSet::clear()
 {
   force.setZero();
@@ -655,6 +1029,169 @@ void ConstraintSet::clear()
 }
 
 
+//==============================================================================
+void ConstraintJacobianPattern::multiply (
+  const Math::MatrixNd &G,
+  const Math::VectorNd &x,
+  Math::VectorNd &y) const
+{
+  for (unsigned int i = 0; i < rows(); i++) {
+    y[i] = 0.;
+    for (unsigned int k = rowStart[i]; k < rowStart[i+1]; k++) {
+      y[i] += G(i, columns[k]) * x[columns[k]];
+    }
+  }
+}
+
+//==============================================================================
+void ConstraintJacobianPattern::multiplyTranspose (
+  const Math::MatrixNd &G,
+  const Math::VectorNd &x,
+  Math::VectorNd &y) const
+{
+  y.setZero();
+  for (unsigned int i = 0; i < rows(); i++) {
+    for (unsigned int k = rowStart[i]; k < rowStart[i+1]; k++) {
+      y[columns[k]] += G(i, columns[k]) * x[i];
+    }
+  }
+}
+
+//==============================================================================
+#ifndef RBDL_USE_CASADI_MATH
+void SchurComplementWorkspace::resize (unsigned int n, unsigned int m)
+{
+  H_llt = Eigen::LLT<MatrixNd> (n);
+  K_llt = Eigen::LLT<MatrixNd> (m);
+  H_ldlt = Eigen::LDLT<MatrixNd> (n);
+  K_ldlt = Eigen::LDLT<MatrixNd> (m);
+  HinvGT = MatrixNd::Zero (n, m);
+  Hinvc = VectorNd::Zero (n);
+  K = MatrixNd::Zero (m, m);
+  rhs = VectorNd::Zero (m);
+  mu = VectorNd::Zero (m);
+}
+
+/* Whether the decomposition succeeded and none of its pivots is negligible
+ * compared to the largest one, i.e. the decomposed matrix is numerically
+ * positive definite. */
+static bool IsNumericallyPositiveDefinite (
+  const Eigen::LLT<MatrixNd> &decomposition)
+{
+  if (decomposition.info() != Eigen::Success) {
+    return false;
+  }
+  if (decomposition.rows() == 0) {
+    return true;
+  }
+
+  // the pivots are the squares of the diagonal of L
+  double min_pivot = decomposition.matrixLLT().diagonal().minCoeff();
+  double max_pivot = decomposition.matrixLLT().diagonal().maxCoeff();
+  return min_pivot * min_pivot > max_pivot * max_pivot
+    * decomposition.rows() * std::numeric_limits<double>::epsilon();
+}
+
+static bool IsNumericallyPositiveDefinite (
+  const Eigen::LDLT<MatrixNd> &decomposition)
+{
+  if (decomposition.info() != Eigen::Success) {
+    return false;
+  }
+  if (decomposition.rows() == 0) {
+    return true;
+  }
+
+  double min_pivot = decomposition.vectorD().minCoeff();
+  double max_pivot = decomposition.vectorD().maxCoeff();
+  return min_pivot > max_pivot
+    * decomposition.rows() * std::numeric_limits<double>::epsilon();
+}
+
+/* Solves the (regularized) system of SolveConstrainedSystemDirect()
+ *
+ *   [ H  G^T ] [ qddot ]   [ c     ]
+ *   [ G  -C  ] [ mu    ] = [ gamma ]
+ *
+ * via the Schur complement (G H^-1 G^T + C) mu = G H^-1 c - gamma, which is
+ * symmetric positive definite, using the symmetric decompositions
+ * H_decomposition and K_decomposition of the workspace. Returns false
+ * without touching x if H or the Schur complement is numerically singular.
+ */
+template <typename Decomposition>
+static bool SolveConstrainedSystemSchurComplement (
+  const Math::MatrixNd &H,
+  const Math::MatrixNd &G,
+  const Math::VectorNd &c,
+  const Math::VectorNd &gamma,
+  Math::VectorNd &x,
+  const ConstraintJacobianPattern *G_pattern,
+  const Math::VectorNd *compliance,
+  Decomposition &H_decomposition,
+  Decomposition &K_decomposition,
+  SchurComplementWorkspace &ws)
+{
+  const unsigned int n = c.rows();
+  const unsigned int m = gamma.rows();
+
+  H_decomposition.compute (H);
+  if (!IsNumericallyPositiveDefinite (H_decomposition)) {
+    LOG << "H is numerically singular" << std::endl;
+    return false;
+  }
+
+  ws.HinvGT = H_decomposition.solve (G.transpose());
+  ws.Hinvc = H_decomposition.solve (c);
+
+  if (G_pattern) {
+    ws.K.resize (m, m);
+    ws.rhs.resize (m);
+    for (unsigned int i = 0; i < m; i++) {
+      for (unsigned int j = 0; j <= i; j++) {
+        ws.K(i,j) = 0.;
+        for (unsigned int k = G_pattern->rowStart[i];
+             k < G_pattern->rowStart[i+1]; k++) {
+          ws.K(i,j) += G(i, G_pattern->columns[k])
+            * ws.HinvGT(G_pattern->columns[k], j);
+        }
+        ws.K(j,i) = ws.K(i,j);
+      }
+
+      ws.rhs[i] = -gamma[i];
+      for (unsigned int k = G_pattern->rowStart[i];
+           k < G_pattern->rowStart[i+1]; k++) {
+        ws.rhs[i] += G(i, G_pattern->columns[k])
+          * ws.Hinvc[G_pattern->columns[k]];
+      }
+    }
+  } else {
+    ws.K.noalias() = G * ws.HinvGT;
+    ws.rhs.noalias() = G * ws.Hinvc;
+    ws.rhs -= gamma;
+  }
+
+  if (compliance) {
+    ws.K.diagonal() += *compliance;
+  }
+
+  K_decomposition.compute (ws.K);
+  if (!IsNumericallyPositiveDefinite (K_decomposition)) {
+    LOG << "G H^-1 G^T + C is numerically singular" << std::endl;
+    return false;
+  }
+
+  ws.mu = K_decomposition.solve (ws.rhs);
+
+  x.head(n) = ws.Hinvc;
+  x.head(n).noalias() -= ws.HinvGT * ws.mu;
+  x.tail(m) = ws.mu;
+
+  LOG << "x = " << std::endl << x << std::endl;
+
+  return true;
+}
+#endif
+
 //==============================================================================
 RBDL_DLLAPI
 void SolveConstrainedSystemDirect (
@@ -666,15 +1203,62 @@ void SolveConstrainedSystemDirect (
   Math::MatrixNd &A,
   Math::VectorNd &b,
   Math::VectorNd &x,
-  Math::LinearSolver &linear_solver
+  Math::LinearSolver &linear_solver,
+  const ConstraintJacobianPattern *G_pattern,
+  const Math::VectorNd *compliance,
+  SchurComplementWorkspace *schur_workspace
 )
 {
+#ifndef RBDL_USE_CASADI_MATH
+  Math::LinearSolver kkt_solver = linear_solver;
+
+  if (linear_solver == LinearSolverLLT
+      || linear_solver == LinearSolverLDLT) {
+    SchurComplementWorkspace local_workspace;
+    SchurComplementWorkspace &ws = schur_workspace ? *schur_workspace
+                                                   : local_workspace;
+
+    bool solved = linear_solver == LinearSolverLLT
+      ? SolveConstrainedSystemSchurComplement (H, G, c, gamma, x, G_pattern,
+          compliance, ws.H_llt, ws.K_llt, ws)
+      : SolveConstrainedSystemSchurComplement (H, G, c, gamma, x, G_pattern,
+          compliance, ws.H_ldlt, ws.K_ldlt, ws);
+    if (solved) {
+      return;
+    }
+
+    // e.g. redundant constraints without compliance: the system is still
+    // consistent and is solved as a whole by a rank revealing solver
+    kkt_solver = LinearSolverColPivHouseholderQR;
+  }
+#endif
+
   // Build the system: Copy H
   A.block(0, 0, c.rows(), c.rows()) = H;
 
   // Copy G and G^T
-  A.block(0, c.rows(), c.rows(), gamma.rows()) = G.transpose();
-  A.block(c.rows(), 0, gamma.rows(), c.rows()) = G;
+  if (G_pattern) {
+    const unsigned int n = c.rows();
+    for (unsigned int i = 0; i < G_pattern->rows(); i++) {
+      for (unsigned int k = G_pattern->rowStart[i];
+           k < G_pattern->rowStart[i+1]; k++) {
+        unsigned int j = G_pattern->columns[k];
+        A(n + i, j) = G(i, j);
+        A(j, n + i) = G(i, j);
+      }
+    }
+  } else {
+    A.block(0, c.rows(), c.rows(), gamma.rows()) = G.transpose();
+    A.block(c.rows(), 0, gamma.rows(), c.rows()) = G;
+  }
+
+  // Compliant constraints: G qddot = gamma - diag(c) force, with the
+  // force being the negative of the multipliers in x
+  if (compliance) {
+    for (unsigned int i = 0; i < gamma.rows(); i++) {
+      A(c.rows() + i, c.rows() + i) = -(*compliance)[i];
+    }
+  }
 
   // Build the system: Copy -C + \tau
   b.block(0, 0, c.rows(), 1) = c;
@@ -687,7 +1271,7 @@ void SolveConstrainedSystemDirect (
   auto linsol = casadi::Linsol("linear_solver", "symbolicqr", A.sparsity());
   x = linsol.solve(A, b);
 #else
-  switch (linear_solver) {
+  switch (kkt_solver) {
   case (LinearSolverPartialPivLU) :
     x = A.partialPivLu().solve(b);
     break;
@@ -697,8 +1281,11 @@ void SolveConstrainedSystemDirect (
   case (LinearSolverHouseholderQR) :
     x = A.householderQr().solve(b);
     break;
+  case (LinearSolverMixedPrecisionLU) :
+    SolveLinearSystemMixedPrecision (A, b, x);
+    break;
   default:
-    LOG << "Error: Invalid linear solver: " << linear_solver << std::endl;
+    LOG << "Error: Invalid linear solver: " << kkt_solver << std::endl;
     assert (0);
     break;
   }
@@ -719,7 +1306,9 @@ void SolveConstrainedSystemRangeSpaceSparse (
   Math::VectorNd &lambda,
   Math::MatrixNd &K,
   Math::VectorNd &a,
-  Math::LinearSolver linear_solver
+  Math::LinearSolver linear_solver,
+  const ConstraintJacobianPattern *G_pattern,
+  const Math::VectorNd *compliance
 )
 {
   SparseFactorizeLTL (model, H);
@@ -735,9 +1324,38 @@ void SolveConstrainedSystemRangeSpaceSparse (
   VectorNd z (c);
   SparseSolveLTx (model, H, z);
 
-  K = Y.transpose() * Y;
+  if (G_pattern) {
+    // The columns of each row of G are closed under lambda_q. Solving with
+    // L^T only propagates towards the root, hence the columns of Y have the
+    // same pattern as the rows of G and the products below only need to run
+    // over it.
+    for (unsigned int i = 0; i < Y.cols(); i++) {
+      for (unsigned int j = 0; j <= i; j++) {
+        K(i,j) = 0.;
+        for (unsigned int k = G_pattern->rowStart[i];
+             k < G_pattern->rowStart[i+1]; k++) {
+          K(i,j) += Y(G_pattern->columns[k], i) * Y(G_pattern->columns[k], j);
+        }
+        K(j,i) = K(i,j);
+      }
+
+      a[i] = gamma[i];
+      for (unsigned int k = G_pattern->rowStart[i];
+           k < G_pattern->rowStart[i+1]; k++) {
+        a[i] -= Y(G_pattern->columns[k], i) * z[G_pattern->columns[k]];
+      }
+    }
+  } else {
+    K = Y.transpose() * Y;
 
-  a = gamma - Y.transpose() * z;
+    a = gamma - Y.transpose() * z;
+  }
+
+  if (compliance) {
+    for (unsigned int i = 0; i < K.rows(); i++) {
+      K(i,i) += (*compliance)[i];
+    }
+  }
 #ifdef RBDL_USE_CASADI_MATH
   auto linsol = casadi::Linsol("linear_solver", "symbolicqr", K.sparsity());
   lambda = linsol.solve(K, a);
@@ -745,7 +1363,12 @@ void SolveConstrainedSystemRangeSpaceSparse (
   lambda = K.llt().solve(a);
 #endif
 
-  qddot = c + G.transpose() * lambda;
+  if (G_pattern) {
+    G_pattern->multiplyTranspose (G, lambda, qddot);
+    qddot += c;
+  } else {
+    qddot = c + G.transpose() * lambda;
+  }
   SparseSolveLTx (model, H, qddot);
   SparseSolveLx (model, H, qddot);
 }
@@ -763,24 +1386,44 @@ void SolveConstrainedSystemNullSpace (
   Math::MatrixNd &Z,
   Math::VectorNd &qddot_y,
   Math::VectorNd &qddot_z,
-  Math::LinearSolver &linear_solver
+  Math::LinearSolver &linear_solver,
+  const ConstraintJacobianPattern *G_pattern
 )
 {
+  // G * Y is needed twice, evaluate it only once.
+  MatrixNd GY (G.rows(), Y.cols());
+  if (G_pattern) {
+    GY.setZero();
+    for (unsigned int i = 0; i < G_pattern->rows(); i++) {
+      for (unsigned int k = G_pattern->rowStart[i];
+           k < G_pattern->rowStart[i+1]; k++) {
+        GY.block(i, 0, 1, Y.cols()) += G(i, G_pattern->columns[k])
+          * Y.block(G_pattern->columns[k], 0, 1, Y.cols());
+      }
+    }
+  } else {
+    GY = G * Y;
+  }
 
 #ifdef RBDL_USE_CASADI_MATH
-    auto GY = G * Y;
     auto linsol = casadi::Linsol("linear_solver", "symbolicqr", GY.sparsity());
     qddot_y = linsol.solve(GY, gamma);
 #else
   switch (linear_solver) {
   case (LinearSolverPartialPivLU) :
-    qddot_y = (G * Y).partialPivLu().solve (gamma);
+  case (LinearSolverLLT) :
+  case (LinearSolverLDLT) :
+    // G Y is not symmetric
+    qddot_y = GY.partialPivLu().solve (gamma);
     break;
   case (LinearSolverColPivHouseholderQR) :
-    qddot_y = (G * Y).colPivHouseholderQr().solve (gamma);
+    qddot_y = GY.colPivHouseholderQr().solve (gamma);
     break;
   case (LinearSolverHouseholderQR) :
-    qddot_y = (G * Y).householderQr().solve (gamma);
+    qddot_y = GY.householderQr().solve (gamma);
+    break;
+  case (LinearSolverMixedPrecisionLU) :
+    SolveLinearSystemMixedPrecision (GY, gamma, qddot_y);
     break;
   default:
     LOG << "Error: Invalid linear solver: " << linear_solver << std::endl;
@@ -798,20 +1441,27 @@ void SolveConstrainedSystemNullSpace (
 #endif
   qddot = Y * qddot_y + Z * qddot_z;
 
+  // Y^T G^T lambda = Y^T (H qddot - c), i.e. the system matrix is (G Y)^T
 #ifdef RBDL_USE_CASADI_MATH
-    GY = G * Y;
-    linsol = casadi::Linsol("linear_solver", "symbolicqr", GY.sparsity());
-    lambda = linsol.solve(GY, Y.transpose() * (H * qddot - c));
+    auto GYT = GY.transpose();
+    linsol = casadi::Linsol("linear_solver", "symbolicqr", GYT.sparsity());
+    lambda = linsol.solve(GYT, Y.transpose() * (H * qddot - c));
 #else
   switch (linear_solver) {
   case (LinearSolverPartialPivLU) :
-    lambda = (G * Y).partialPivLu().solve (Y.transpose() * (H * qddot - c));
+  case (LinearSolverLLT) :
+  case (LinearSolverLDLT) :
+    lambda = GY.transpose().partialPivLu().solve (Y.transpose() * (H * qddot - c));
     break;
   case (LinearSolverColPivHouseholderQR) :
-    lambda = (G*Y).colPivHouseholderQr().solve (Y.transpose()*(H*qddot - c));
+    lambda = GY.transpose().colPivHouseholderQr().solve (Y.transpose()*(H*qddot - c));
     break;
   case (LinearSolverHouseholderQR) :
-    lambda = (G * Y).householderQr().solve (Y.transpose() * (H * qddot - c));
+    lambda = GY.transpose().householderQr().solve (Y.transpose() * (H * qddot - c));
+    break;
+  case (LinearSolverMixedPrecisionLU) :
+    SolveLinearSystemMixedPrecision (GY.transpose(),
+        Y.transpose() * (H * qddot - c), lambda);
     break;
   default:
     LOG << "Error: Invalid linear solver: " << linear_solver << std::endl;
@@ -838,10 +1488,19 @@ void CalcConstraintsPositionError (
     UpdateKinematicsCustom (model, &Q, NULL, NULL);
   }
 
-  for(unsigned int i=0; i<CS.constraints.size(); ++i) {
-    CS.constraints[i]->calcPositionError(model,0,Q,err, CS.cache,
-                                         update_kinematics);
-  }
+  // the kinematics are up to date, constraints evaluated in parallel must
+  // not update them again
+  bool update_constraint_kinematics = update_kinematics && CS.num_threads < 2;
+  ForEachConstraint(CS, [&](ContactConstraintGroup &group) {
+    group.body.update(model);
+    for (size_t k = 0; k < group.contactConstraintIndices.size(); ++k) {
+      CS.contactConstraints[group.contactConstraintIndices[k]]
+        ->calcPositionError(group.body, err);
+    }
+  }, [&](unsigned int i, ConstraintCache &cache) {
+    CS.constraints[i]->calcPositionError(model,0,Q,err, cache,
+                                         update_constraint_kinematics);
+  });
 }
 
 //==============================================================================
@@ -858,10 +1517,18 @@ void CalcConstraintsJacobian (
     UpdateKinematicsCustom (model, &Q, NULL, NULL);
   }
 
-  for(unsigned int i=0; i<CS.constraints.size(); ++i) {
-    CS.constraints[i]->calcConstraintJacobian(model,0,Q,CS.cache.vecNZeros,G,
-        CS.cache,update_kinematics);
-  }
+  bool update_constraint_kinematics = update_kinematics && CS.num_threads < 2;
+  ForEachConstraint(CS, [&](ContactConstraintGroup &group) {
+    group.body.update(model);
+    group.body.updateJacobian(model);
+    for (size_t k = 0; k < group.contactConstraintIndices.size(); ++k) {
+      CS.contactConstraints[group.contactConstraintIndices[k]]
+        ->calcConstraintJacobian(group.body, G);
+    }
+  }, [&](unsigned int i, ConstraintCache &cache) {
+    CS.constraints[i]->calcConstraintJacobian(model,0,Q,cache.vecNZeros,G,
+        cache,update_constraint_kinematics);
+  });
 }
 
 //==============================================================================
@@ -879,10 +1546,22 @@ void CalcConstraintsVelocityError (
 
   CalcConstraintsJacobian (model, Q, CS, CS.G, update_kinematics);
 
-  for(unsigned int i=0; i<CS.constraints.size(); ++i) {
-    CS.constraints[i]->calcVelocityError(model,0,Q,QDot,CS.G,err,CS.cache,
-                                         update_kinematics);
+  bool update_constraint_kinematics = update_kinematics;
+  if (update_kinematics
+      && (CS.num_threads > 1 || !CS.contact_groups.empty())) {
+    UpdateKinematicsCustom (model, &Q, &QDot, NULL);
+    update_constraint_kinematics = false;
   }
+  ForEachConstraint(CS, [&](ContactConstraintGroup &group) {
+    group.body.update(model);
+    for (size_t k = 0; k < group.contactConstraintIndices.size(); ++k) {
+      CS.contactConstraints[group.contactConstraintIndices[k]]
+        ->calcVelocityError(group.body, err);
+    }
+  }, [&](unsigned int i, ConstraintCache &cache) {
+    CS.constraints[i]->calcVelocityError(model,0,Q,QDot,CS.G,err,cache,
+                                         update_constraint_kinematics);
+  });
 
 }
 
@@ -929,13 +1608,23 @@ void CalcConstrainedSystemVariables (
   UpdateKinematicsCustom(model, NULL, NULL, &CS.QDDot_0);
 
 
-  for(unsigned int i=0; i<CS.constraints.size(); ++i) {
-    CS.constraints[i]->calcGamma(model,0,Q,QDot,CS.G,CS.gamma,CS.cache);
+  ForEachConstraint(CS, [&](ContactConstraintGroup &group) {
+    group.body.update(model);
+    for (size_t k = 0; k < group.contactConstraintIndices.size(); ++k) {
+      ContactConstraint &contact =
+        *CS.contactConstraints[group.contactConstraintIndices[k]];
+      contact.calcGamma(group.body, CS.gamma);
+      if(contact.isBaumgarteStabilizationEnabled()) {
+        contact.addInBaumgarteStabilizationForces(CS.err,CS.errd,CS.gamma);
+      }
+    }
+  }, [&](unsigned int i, ConstraintCache &cache) {
+    CS.constraints[i]->calcGamma(model,0,Q,QDot,CS.G,CS.gamma,cache);
     if(CS.constraints[i]->isBaumgarteStabilizationEnabled()) {
       CS.constraints[i]->addInBaumgarteStabilizationForces(
         CS.err,CS.errd,CS.gamma);
     }
-  }
+  });
 
 
 }
@@ -1003,45 +1692,173 @@ bool CalcAssemblyQ (
     // Extract the d = (Q - QInit) vector from x.
     d = x.block (0, 0, model.dof_count, 1);
 
-    // Update solution.
-    for (size_t i = 0; i < model.mJoints.size(); ++i) {
-      // If the joint is spherical, translate the corresponding components
-      // of d into a modification in the joint quaternion.
-      if (model.mJoints[i].mJointType == JointTypeSpherical) {
-        Quaternion quat = model.GetQuaternion(i, QInit);
-        Vector3d omega = d.block<3,1>(model.mJoints[i].q_index,0);
-        // Convert the 3d representation of the displacement to 4d and sum it
-        // to the components of the quaternion.
-        quat += quat.omegaToQDot(omega);
-        // The quaternion needs to be normalized after the previous sum.
-        quat /= quat.norm();
-        model.SetQuaternion(i, quat, QInit);
-      }
-      // If the current joint is not spherical, simply add the corresponding
-      // components of d to QInit.
-      else {
-        unsigned int qIdx = model.mJoints[i].q_index;
-        for(size_t j = 0; j < model.mJoints[i].mDoFCount; ++j) {
-          QInit[qIdx + j] += d[qIdx + j];
-        }
+    // Update solution.
+    ApplyAssemblyStep (model, d, QInit);
+
+    // Update the errors.
+    CalcConstraintsPositionError (model, QInit, cs, e);
+
+    // Check if the error and the step are small enough to end.
+    if (e.norm() < tolerance && d.norm() < tolerance) {
+      Q = QInit;
+      return true;
+    }
+  }
+
+  // Return false if maximum number of iterations is exceeded.
+  Q = QInit;
+  return false;
+}
+#endif
+
+//==============================================================================
+RBDL_DLLAPI
+void CalcAssemblyQDot (
+  Model &model,
+  const Math::VectorNd &Q,
+  const Math::VectorNd &QDotInit,
+  ConstraintSet &cs,
+  Math::VectorNd &QDot,
+  const Math::VectorNd &weights
+)
+{
+  if(QDot.size() != model.dof_count) {
+    throw Errors::RBDLDofMismatchError("Incorrect QDot vector size.\n");
+  }
+  if(Q.size() != model.q_size) {
+    throw Errors::RBDLDofMismatchError("Incorrect Q vector size.\n");
+  }
+  if(QDotInit.size() != QDot.size()) {
+    throw Errors::RBDLDofMismatchError("Incorrect QDotInit vector size.\n");
+  }
+  if(weights.size() != QDot.size()) {
+    throw Errors::RBDLDofMismatchError("Incorrect weight vector size.\n");
+  }
+
+  // Initialize variables.
+  MatrixNd constraintJac = MatrixNd::Zero(cs.size(), model.dof_count);
+  MatrixNd A = MatrixNd::Zero(cs.size() + model.dof_count, cs.size()
+                              + model.dof_count);
+  VectorNd b = VectorNd::Zero(cs.size() + model.dof_count);
+  VectorNd x = VectorNd::Zero(cs.size() + model.dof_count);
+
+  // The top-left block is the weight matrix and is constant.
+  for(unsigned int i = 0; i < weights.size(); ++i) {
+    A(i,i) = weights[i];
+    b[i] = weights[i] * QDotInit[i];
+  }
+  CalcConstraintsJacobian (model, Q, cs, constraintJac);
+  A.block (model.dof_count, 0, cs.size(), model.dof_count) = constraintJac;
+  A.block (0, model.dof_count, model.dof_count, cs.size())
+    = constraintJac.transpose();
+
+  // Solve the sistem A*x = b.
+  SolveLinearSystem (A, b, x, cs.linear_solver);
+
+  // Copy the result to the output variable.
+  QDot = x.block (0, 0, model.dof_count, 1);
+}
+
+#ifndef RBDL_USE_CASADI_MATH
+//==============================================================================
+void AssemblyWorkspace::resize (const Model &model, const ConstraintSet &CS)
+{
+  unsigned int n = model.dof_count;
+  unsigned int m = unsigned(CS.size());
+
+  if (G.rows() != m || G.cols() != n || q_previous.size() != model.q_size) {
+    G = MatrixNd::Zero(m, n);
+    WinvGT = MatrixNd::Zero(n, m);
+    K = MatrixNd::Zero(m, m);
+    K_ldlt = Eigen::LDLT<MatrixNd>(m);
+    e = VectorNd::Zero(m);
+    lambda = VectorNd::Zero(m);
+    d = VectorNd::Zero(n);
+    q_previous = VectorNd::Zero(model.q_size);
+    has_previous_solution = false;
+  }
+}
+
+//==============================================================================
+RBDL_DLLAPI
+bool CalcAssemblyQ (
+  Model &model,
+  const Math::VectorNd &QInit,
+  ConstraintSet &cs,
+  Math::VectorNd &Q,
+  const Math::VectorNd &weights,
+  AssemblyWorkspace &ws,
+  double tolerance,
+  unsigned int max_iter
+)
+{
+  if(Q.size() != model.q_size) {
+    throw Errors::RBDLDofMismatchError("Incorrect Q vector size.\n");
+  }
+  if(QInit.size() != model.q_size) {
+    throw Errors::RBDLDofMismatchError("Incorrect QInit vector size.\n");
+  }
+  if(weights.size() != model.dof_count) {
+    throw Errors::RBDLDofMismatchError("Incorrect weights vector size.\n");
+  }
+  if(weights.minCoeff() <= 0.) {
+    throw Errors::RBDLInvalidParameterError("Error: the weights of the "
+                                            "assembly have to be positive.\n");
+  }
+
+  ws.resize (model, cs);
+  ws.iterations = 0;
+
+  if (ws.warm_start && ws.has_previous_solution) {
+    CalcConstraintsPositionError (model, QInit, cs, ws.e);
+    double e_init = ws.e.norm();
+    CalcConstraintsPositionError (model, ws.q_previous, cs, ws.e);
+    if (ws.e.norm() <= e_init) {
+      Q = ws.q_previous;
+    } else {
+      Q = QInit;
+      CalcConstraintsPositionError (model, Q, cs, ws.e);
+    }
+  } else {
+    Q = QInit;
+    CalcConstraintsPositionError (model, Q, cs, ws.e);
+  }
+
+  if (ws.e.norm() < tolerance) {
+    ws.q_previous = Q;
+    ws.has_previous_solution = true;
+    return true;
+  }
+
+  for(unsigned int it = 0; it < max_iter; ++it) {
+    ws.iterations = it + 1;
+
+    // [W G^T; G 0] [d; lambda] = [0; -e] reduces to
+    //   G W^-1 G^T lambda = e,  d = -W^-1 G^T lambda
+    CalcConstraintsJacobian (model, Q, cs, ws.G);
+    for(unsigned int i = 0; i < ws.G.rows(); ++i) {
+      for(unsigned int j = 0; j < ws.G.cols(); ++j) {
+        ws.WinvGT(j,i) = ws.G(i,j) / weights[j];
       }
     }
+    ws.K.noalias() = ws.G * ws.WinvGT;
+    ws.K_ldlt.compute (ws.K);
+    ws.lambda = ws.K_ldlt.solve (ws.e);
+    ws.d.noalias() = -ws.WinvGT * ws.lambda;
 
-    // Update the errors.
-    CalcConstraintsPositionError (model, QInit, cs, e);
+    ApplyAssemblyStep (model, ws.d, Q);
 
-    // Check if the error and the step are small enough to end.
-    if (e.norm() < tolerance && d.norm() < tolerance) {
-      Q = QInit;
+    CalcConstraintsPositionError (model, Q, cs, ws.e);
+
+    if (ws.e.norm() < tolerance && ws.d.norm() < tolerance) {
+      ws.q_previous = Q;
+      ws.has_previous_solution = true;
       return true;
     }
   }
 
-  // Return false if maximum number of iterations is exceeded.
-  Q = QInit;
   return false;
 }
-#endif
 
 //==============================================================================
 RBDL_DLLAPI
@@ -1051,7 +1868,8 @@ void CalcAssemblyQDot (
   const Math::VectorNd &QDotInit,
   ConstraintSet &cs,
   Math::VectorNd &QDot,
-  const Math::VectorNd &weights
+  const Math::VectorNd &weights,
+  AssemblyWorkspace &ws
 )
 {
   if(QDot.size() != model.dof_count) {
@@ -1066,30 +1884,30 @@ void CalcAssemblyQDot (
   if(weights.size() != QDot.size()) {
     throw Errors::RBDLDofMismatchError("Incorrect weight vector size.\n");
   }
+  if(weights.minCoeff() <= 0.) {
+    throw Errors::RBDLInvalidParameterError("Error: the weights of the "
+                                            "assembly have to be positive.\n");
+  }
 
-  // Initialize variables.
-  MatrixNd constraintJac = MatrixNd::Zero(cs.size(), model.dof_count);
-  MatrixNd A = MatrixNd::Zero(cs.size() + model.dof_count, cs.size()
-                              + model.dof_count);
-  VectorNd b = VectorNd::Zero(cs.size() + model.dof_count);
-  VectorNd x = VectorNd::Zero(cs.size() + model.dof_count);
+  ws.resize (model, cs);
 
-  // The top-left block is the weight matrix and is constant.
-  for(unsigned int i = 0; i < weights.size(); ++i) {
-    A(i,i) = weights[i];
-    b[i] = weights[i] * QDotInit[i];
+  // [W G^T; G 0] [qdot; lambda] = [W qdot0; 0] reduces to
+  //   G W^-1 G^T lambda = G qdot0,  qdot = qdot0 - W^-1 G^T lambda
+  CalcConstraintsJacobian (model, Q, cs, ws.G);
+  for(unsigned int i = 0; i < ws.G.rows(); ++i) {
+    for(unsigned int j = 0; j < ws.G.cols(); ++j) {
+      ws.WinvGT(j,i) = ws.G(i,j) / weights[j];
+    }
   }
-  CalcConstraintsJacobian (model, Q, cs, constraintJac);
-  A.block (model.dof_count, 0, cs.size(), model.dof_count) = constraintJac;
-  A.block (0, model.dof_count, model.dof_count, cs.size())
-    = constraintJac.transpose();
-
-  // Solve the sistem A*x = b.
-  SolveLinearSystem (A, b, x, cs.linear_solver);
+  ws.K.noalias() = ws.G * ws.WinvGT;
+  ws.K_ldlt.compute (ws.K);
+  ws.e.noalias() = ws.G * QDotInit;
+  ws.lambda = ws.K_ldlt.solve (ws.e);
 
-  // Copy the result to the output variable.
-  QDot = x.block (0, 0, model.dof_count, 1);
+  ws.d.noalias() = ws.WinvGT * ws.lambda;
+  QDot = QDotInit - ws.d;
 }
+#endif
 
 //==============================================================================
 RBDL_DLLAPI
@@ -1110,7 +1928,10 @@ void ForwardDynamicsConstraintsDirect (
                                   f_ext);
 
   SolveConstrainedSystemDirect (CS.H, CS.G, Tau - CS.C, CS.gamma
-                                , CS.force, CS.A, CS.b, CS.x, CS.linear_solver);
+                                , CS.force, CS.A, CS.b, CS.x, CS.linear_solver
+                                , CS.sparse_jacobian ? &CS.G_pattern : NULL
+                                , &CS.compliance
+                                , GetSchurComplementWorkspace (CS));
 
   // Copy back QDDot
   for (unsigned int i = 0; i < model.dof_count; i++) {
@@ -1140,7 +1961,9 @@ void ForwardDynamicsConstraintsRangeSpaceSparse (
                                   f_ext);
 
   SolveConstrainedSystemRangeSpaceSparse (model, CS.H, CS.G, Tau - CS.C
-                                          , CS.gamma, QDDot, CS.force, CS.K, CS.a, CS.linear_solver);
+                                          , CS.gamma, QDDot, CS.force, CS.K, CS.a, CS.linear_solver
+                                          , CS.sparse_jacobian ? &CS.G_pattern : NULL
+                                          , &CS.compliance);
 }
 
 //==============================================================================
@@ -1170,8 +1993,69 @@ void ForwardDynamicsConstraintsNullSpace (
   CS.Z = CS.GT_qr_Q.block (0,CS.G.rows(),QDot.rows(), QDot.rows() - CS.G.rows());
 
   SolveConstrainedSystemNullSpace (CS.H, CS.G, Tau - CS.C, CS.gamma, QDDot
-                                   , CS.force, CS.Y, CS.Z, CS.qddot_y, CS.qddot_z, CS.linear_solver);
+                                   , CS.force, CS.Y, CS.Z, CS.qddot_y, CS.qddot_z, CS.linear_solver
+                                   , CS.sparse_jacobian ? &CS.G_pattern : NULL);
+
+}
+#endif
+
+//==============================================================================
+#ifndef RBDL_USE_CASADI_MATH
+RBDL_DLLAPI
+void SolveConstrainedSystemNullSpaceFactorized (
+  ConstraintSet &CS,
+  const VectorNd &Tau,
+  VectorNd &QDDot
+)
+{
+  LOG << "-------- " << __func__ << " --------" << std::endl;
+
+  NullSpaceQRFactorization &nsf = CS.null_space_factorization;
+
+  if (!nsf.factorized) {
+    throw Errors::RBDLError(
+      "Error: the null-space factorization of the constraint set has to be "
+      "computed with ConstraintSet::FactorizeNullSpace() first!\n");
+  }
+
+  unsigned int n = unsigned(CS.H.rows());
+  unsigned int m = unsigned(nsf.rows.size());
+
+  // range-space part: G_a Y = R^T
+  for (unsigned int k = 0; k < m; k++) {
+    CS.qddot_y[k] = CS.gamma[nsf.rows[k]];
+  }
+  nsf.R.topLeftCorner(m, m).triangularView<Eigen::Upper>().transpose()
+    .solveInPlace (CS.qddot_y.head(m));
 
+  QDDot.noalias() = nsf.Q.leftCols(m) * CS.qddot_y.head(m);
+
+  // null-space part: Z^T H Z qddot_z = Z^T (c - H Y qddot_y)
+  if (m < n) {
+    unsigned int nz = n - m;
+    nsf.w = Tau - CS.C;
+    nsf.w.noalias() -= CS.H * QDDot;
+    CS.qddot_z.head(nz).noalias() = nsf.Q.rightCols(nz).transpose() * nsf.w;
+
+    nsf.HZ.leftCols(nz).noalias() = CS.H * nsf.Q.rightCols(nz);
+    nsf.ZHZ.topLeftCorner(nz, nz).noalias() =
+      nsf.Q.rightCols(nz).transpose() * nsf.HZ.leftCols(nz);
+    nsf.ZHZ.topLeftCorner(nz, nz).llt().solveInPlace (CS.qddot_z.head(nz));
+
+    QDDot.noalias() += nsf.Q.rightCols(nz) * CS.qddot_z.head(nz);
+  }
+
+  // constraint forces: R lambda_a = Y^T (H qddot - c)
+  nsf.w.noalias() = CS.H * QDDot;
+  nsf.w -= Tau - CS.C;
+  nsf.rhs.head(m).noalias() = nsf.Q.leftCols(m).transpose() * nsf.w;
+  nsf.R.topLeftCorner(m, m).triangularView<Eigen::Upper>()
+    .solveInPlace (nsf.rhs.head(m));
+
+  CS.force.setZero();
+  for (unsigned int k = 0; k < m; k++) {
+    CS.force[nsf.rows[k]] = nsf.rhs[k];
+  }
 }
 #endif
 
@@ -1194,7 +2078,10 @@ void ComputeConstraintImpulsesDirect (
   CalcConstraintsJacobian (model, Q, CS, CS.G, false);
 
   SolveConstrainedSystemDirect (CS.H, CS.G, CS.H * QDotMinus, CS.v_plus
-                                , CS.impulse, CS.A, CS.b, CS.x, CS.linear_solver);
+                                , CS.impulse, CS.A, CS.b, CS.x, CS.linear_solver
+                                , CS.sparse_jacobian ? &CS.G_pattern : NULL
+                                , &CS.compliance
+                                , GetSchurComplementWorkspace (CS));
 
   // Copy back QDotPlus
   for (unsigned int i = 0; i < model.dof_count; i++) {
@@ -1227,7 +2114,9 @@ void ComputeConstraintImpulsesRangeSpaceSparse (
   CalcConstraintsJacobian (model, Q, CS, CS.G, false);
 
   SolveConstrainedSystemRangeSpaceSparse (model, CS.H, CS.G, CS.H * QDotMinus
-                                          , CS.v_plus, QDotPlus, CS.impulse, CS.K, CS.a, CS.linear_solver);
+                                          , CS.v_plus, QDotPlus, CS.impulse, CS.K, CS.a, CS.linear_solver
+                                          , CS.sparse_jacobian ? &CS.G_pattern : NULL
+                                          , &CS.compliance);
 
 }
 
@@ -1259,7 +2148,8 @@ void ComputeConstraintImpulsesNullSpace (
 
   SolveConstrainedSystemNullSpace (CS.H, CS.G, CS.H * QDotMinus, CS.v_plus
                                    , QDotPlus, CS.impulse, CS.Y, CS.Z, CS.qddot_y, CS.qddot_z
-                                   , CS.linear_solver);
+                                   , CS.linear_solver
+                                   , CS.sparse_jacobian ? &CS.G_pattern : NULL);
 }
 #endif
 
@@ -1305,7 +2195,7 @@ void ForwardDynamicsApplyConstraintForces (
 
   LOG << "--- first loop ---" << std::endl;
 
-  for (i = model.mBodies.size() - 1; i > 0; i--) {
+  for (i = model.mBodies.size() - 1; i > model.free_flyer_root_id; i--) {
     unsigned int q_index = model.mJoints[i].q_index;
 
     if (model.mJoints[i].mDoFCount == 3
@@ -1409,7 +2299,38 @@ void ForwardDynamicsApplyConstraintForces (
                               -model.gravity[1],
                               -model.gravity[2]);
 
-  for (i = 1; i < model.mBodies.size(); i++) {
+#ifndef RBDL_USE_CASADI_MATH
+  // free-flyer root (see ForwardDynamics()): IA a = f - pA and the joint
+  // accelerations are the components of a - X_r (X_t a_0 + c_t) - c_r
+  if (model.free_flyer_root_id != 0) {
+    unsigned int r = model.free_flyer_root_id;
+    unsigned int t = model.lambda[r];
+    unsigned int q_index_t = model.mJoints[t].q_index;
+    unsigned int q_index_r = model.mJoints[r].q_index;
+    const Matrix3d &E = model.X_lambda[r].E;
+
+    SpatialVector f;
+    f.block<3,1>(0,0) = Tau.segment<3>(q_index_r);
+    f.block<3,1>(3,0).noalias() = E * (Tau.segment<3>(q_index_t)
+                                       - model.pA[t].block<3,1>(3,0));
+    f -= model.pA[r];
+
+    model.free_flyer_IA_L.triangularView<Eigen::Lower>().solveInPlace (f);
+    model.free_flyer_IA_L.transpose().triangularView<Eigen::Upper>()
+      .solveInPlace (f);
+    model.a[r] = f;
+    model.a[t] = model.X_lambda[t].apply(model.a[0]) + model.c[t];
+
+    SpatialVector a_J = model.a[r] - model.X_lambda[r].apply(model.a[t])
+                        - model.c[r];
+    QDDot.segment<3>(q_index_r) = a_J.block<3,1>(0,0);
+    QDDot.segment<3>(q_index_t).noalias() =
+      E.transpose() * a_J.block<3,1>(3,0);
+    model.a[t].block<3,1>(3,0) += QDDot.segment<3>(q_index_t);
+  }
+#endif
+
+  for (i = model.free_flyer_root_id + 1; i < model.mBodies.size(); i++) {
     unsigned int q_index = model.mJoints[i].q_index;
     unsigned int lambda = model.lambda[i];
     SpatialTransform X_lambda = model.X_lambda[i];
@@ -1492,6 +2413,11 @@ void ForwardDynamicsAccelerationDeltas (
       CS.d_pA[i] = -model.X_base[i].applyAdjoint(f_t[i]);
     }
 
+    // the free-flyer root is handled below
+    if (i <= model.free_flyer_root_id) {
+      break;
+    }
+
     if (model.mJoints[i].mDoFCount == 3
         && model.mJoints[i].mJointType != JointTypeCustom) {
       CS.d_multdof3_u[i] = - model.multdof3_S[i].transpose() * (CS.d_pA[i]);
@@ -1548,7 +2474,35 @@ void ForwardDynamicsAccelerationDeltas (
   QDDot_t[0] = 0.;
   CS.d_a[0] = model.a[0];
 
-  for (unsigned int i = 1; i < model.mBodies.size(); i++) {
+#ifndef RBDL_USE_CASADI_MATH
+  if (model.free_flyer_root_id != 0) {
+    unsigned int r = model.free_flyer_root_id;
+    unsigned int t = model.lambda[r];
+    unsigned int q_index_t = model.mJoints[t].q_index;
+    unsigned int q_index_r = model.mJoints[r].q_index;
+    const Matrix3d &E = model.X_lambda[r].E;
+
+    SpatialVector f;
+    f.block<3,1>(0,0).setZero();
+    f.block<3,1>(3,0).noalias() = -E * CS.d_pA[t].block<3,1>(3,0);
+    f -= CS.d_pA[r];
+
+    model.free_flyer_IA_L.triangularView<Eigen::Lower>().solveInPlace (f);
+    model.free_flyer_IA_L.transpose().triangularView<Eigen::Upper>()
+      .solveInPlace (f);
+    CS.d_a[r] = f;
+    CS.d_a[t] = model.X_lambda[t].apply(CS.d_a[0]);
+
+    SpatialVector a_J = CS.d_a[r] - model.X_lambda[r].apply(CS.d_a[t]);
+    QDDot_t.segment<3>(q_index_r) = a_J.block<3,1>(0,0);
+    QDDot_t.segment<3>(q_index_t).noalias() =
+      E.transpose() * a_J.block<3,1>(3,0);
+    CS.d_a[t].block<3,1>(3,0) += QDDot_t.segment<3>(q_index_t);
+  }
+#endif
+
+  for (unsigned int i = model.free_flyer_root_id + 1;
+       i < model.mBodies.size(); i++) {
     unsigned int q_index = model.mJoints[i].q_index;
     unsigned int lambda = model.lambda[i];
 
@@ -1741,6 +2695,12 @@ void ForwardDynamicsContactsKokkevis (
 
 
 
+  // the test forces are applied with the opposite sign of CS.force, i.e.
+  // the compliance enters with a negative sign
+  for (unsigned int i = 0; i < CS.size(); i++) {
+    CS.K(i,i) -= CS.compliance[i];
+  }
+
   LOG << "K = " << std::endl << CS.K << std::endl;
   LOG << "a = " << std::endl << CS.a << std::endl;
 
@@ -1758,6 +2718,16 @@ void ForwardDynamicsContactsKokkevis (
   case (LinearSolverHouseholderQR) :
     CS.force = CS.K.householderQr().solve(CS.a);
     break;
+  case (LinearSolverLLT) :
+    // K is negative definite (see the compliance above)
+    CS.force = (-CS.K).llt().solve(-CS.a);
+    break;
+  case (LinearSolverLDLT) :
+    CS.force = CS.K.ldlt().solve(CS.a);
+    break;
+  case (LinearSolverMixedPrecisionLU) :
+    SolveLinearSystemMixedPrecision (CS.K, CS.a, CS.force);
+    break;
   default:
     LOG << "Error: Invalid linear solver: " << CS.linear_solver << std::endl;
     assert (0);
@@ -1825,7 +2795,11 @@ bool isConstrainedSystemFullyActuated(
   CalcConstrainedSystemVariables(model,Q,QDot,VectorNd::Zero(QDot.rows()),CS,
                                  update_kinematics, f_ext);
 
-  CS.GPT = CS.G*CS.P.transpose();
+  for(unsigned int j=0; j<nu; ++j) {
+    for(unsigned int i=0; i<nc; ++i) {
+      CS.GPT(i,j) = CS.G(i,CS.unactuated_dof_index[j]);
+    }
+  }
 
   CS.GPT_full_qr.compute(CS.GPT);
   unsigned int r = unsigned(CS.GPT_full_qr.rank());
@@ -1882,18 +2856,25 @@ void InverseDynamicsConstraints(
   //  [ I                         ][   -tau]   [  v*     ]
   //double alpha = 0.1;
 
-  CS.Ful = CS.S*CS.H*CS.S.transpose();
-  CS.Fur = CS.S*CS.H*CS.P.transpose();
-  CS.Fll = CS.P*CS.H*CS.S.transpose();
-  CS.Flr = CS.P*CS.H*CS.P.transpose();
+  // S and P are 0/1 selection matrices: instead of forming S*H*S' etc. the
+  // blocks are gathered using the index lists built in SetActuationMap.
+  const std::vector<unsigned int> &ia = CS.actuated_dof_index;
+  const std::vector<unsigned int> &iu = CS.unactuated_dof_index;
 
-  CS.GTu = CS.S*(CS.G.transpose());
-  CS.GTl = CS.P*(CS.G.transpose());
+  SelectBlock(CS.H, ia, ia, CS.Ful);
+  SelectBlock(CS.H, ia, iu, CS.Fur);
+  SelectBlock(CS.H, iu, ia, CS.Fll);
+  SelectBlock(CS.H, iu, iu, CS.Flr);
+
+  SelectTransposedColumns(CS.G, ia, CS.GTu);
+  SelectTransposedColumns(CS.G, iu, CS.GTl);
 
   //Exploiting the block triangular structure
   //u:
   //I u = S*qdd*
-  CS.u = CS.S*QDDotDesired;
+  for(unsigned int i=0; i<na; ++i) {
+    CS.u[i] = QDDotDesired[ia[i]];
+  }
   // v
   //(JP')v = -gamma - (JS')u
   //Using GT
@@ -1904,8 +2885,14 @@ void InverseDynamicsConstraints(
                      CS.v, CS.linear_solver);
 
   // lambda
+  for(unsigned int i=0; i<na; ++i) {
+    CS.Cu[i] = CS.C[ia[i]];
+  }
+  for(unsigned int i=0; i<nu; ++i) {
+    CS.Cl[i] = CS.C[iu[i]];
+  }
   SolveLinearSystem(CS.GTl,
-                    -CS.P*CS.C
+                    -CS.Cl
                     - CS.Fll*CS.u
                     - CS.Flr*CS.v,
                     CS.force,
@@ -1916,13 +2903,22 @@ void InverseDynamicsConstraints(
   }
 
   //Evaluating qdd
-  QDDotOutput = CS.S.transpose()*CS.u + CS.P.transpose()*CS.v;
+  for(unsigned int i=0; i<na; ++i) {
+    QDDotOutput[ia[i]] = CS.u[i];
+  }
+  for(unsigned int i=0; i<nu; ++i) {
+    QDDotOutput[iu[i]] = CS.v[i];
+  }
 
-  //Evaluating tau
-  TauOutput = -CS.S.transpose()*( -CS.S*CS.C
-                                  -( CS.Ful*CS.u
-                                     +CS.Fur*CS.v
-                                     -CS.GTu*CS.force));
+  //Evaluating tau: S'(SC + Ful u + Fur v - GTu lambda), only the actuated
+  //entries are non-zero
+  CS.Cu += CS.Ful*CS.u;
+  CS.Cu += CS.Fur*CS.v;
+  CS.Cu -= CS.GTu*CS.force;
+  TauOutput.setZero();
+  for(unsigned int i=0; i<na; ++i) {
+    TauOutput[ia[i]] = CS.Cu[i];
+  }
 
 
 
@@ -1986,31 +2982,62 @@ void InverseDynamicsConstraintsRelaxed(
   //  CS.Winv(i,i) = diagInv;
   //}
 
-  CS.W = 100.0*CS.S*CS.H*CS.S.transpose();
-  CS.Winv = CS.W.inverse();
-  CS.WinvSC = CS.Winv * CS.S * CS.C;
+  // S and P are 0/1 selection matrices: the blocks S*H*S' etc. are gathered
+  // using the index lists built in SetActuationMap.
+  const std::vector<unsigned int> &ia = CS.actuated_dof_index;
+  const std::vector<unsigned int> &iu = CS.unactuated_dof_index;
 
-  //CS.W = CS.S*CS.H*CS.S.transpose();
+  SelectBlock(CS.H, ia, ia, CS.Ful);
+  SelectBlock(CS.H, ia, iu, CS.Fur);
+  SelectBlock(CS.H, iu, ia, CS.Fll);
+  SelectBlock(CS.H, iu, iu, CS.Flr);
+
+  SelectTransposedColumns(CS.G, ia, CS.GTu);
+  SelectTransposedColumns(CS.G, iu, CS.GTl);
 
-  CS.F.block(  0,  0, na, na) = CS.S*CS.H*CS.S.transpose() + CS.W;
-  CS.F.block(  0, na, na, nu) = CS.S*CS.H*CS.P.transpose();
-  CS.F.block( na,  0, nu, na) = CS.P*CS.H*CS.S.transpose();
-  CS.F.block( na, na, nu, nu) = CS.P*CS.H*CS.P.transpose();
+  for(unsigned int i=0; i<na; ++i) {
+    CS.Cu[i] = CS.C[ia[i]];
+  }
+  for(unsigned int i=0; i<nu; ++i) {
+    CS.Cl[i] = CS.C[iu[i]];
+  }
 
-  CS.GT.block(  0, 0,na, nc) = CS.S*(CS.G.transpose());
-  CS.GT.block( na, 0,nu, nc) = CS.P*(CS.G.transpose());
+  CS.W = 100.0*CS.Ful;
 
-  CS.GT_qr.compute (CS.GT);
-  CS.GT_qr.householderQ().evalTo (CS.GT_qr_Q);
+  RelaxedKKTFactorization &fac = CS.relaxed_factorization;
+  bool refactorize = false;
+  if(fac.enabled) {
+    refactorize = !fac.factorized
+                  || (fac.refactorization_interval > 0
+                      && fac.frames_since_factorization
+                         >= fac.refactorization_interval);
+    if(refactorize) {
+      fac.W_llt.compute(CS.W);
+    }
+    double residualW = 0.;
+    unsigned int stepsW = 0;
+    if(!SolveWithRefinement(fac.W_llt, CS.W, CS.Cu, CS.WinvSC,
+                            fac.res_w, fac.delta_w,
+                            fac.residual_tolerance, fac.max_refinement_steps,
+                            residualW, stepsW) && !refactorize) {
+      refactorize = true;
+      fac.W_llt.compute(CS.W);
+      CS.WinvSC = fac.W_llt.solve(CS.Cu);
+    }
+  } else {
+    CS.Winv = CS.W.inverse();
+    CS.WinvSC = CS.Winv * CS.Cu;
+  }
 
-  //GT = [Y  Z] * [ R ]
-  //              [ 0 ]
+  //CS.W = CS.S*CS.H*CS.S.transpose();
 
-  CS.R  = CS.GT_qr_Q.transpose()*CS.GT;
-  CS.Ru = CS.R.block(0,0,nc,nc);
+  CS.F.block(  0,  0, na, na) = CS.Ful + CS.W;
+  CS.F.block(  0, na, na, nu) = CS.Fur;
+  CS.F.block( na,  0, nu, na) = CS.Fll;
+  CS.F.block( na, na, nu, nu) = CS.Flr;
 
-  CS.Y = CS.GT_qr_Q.block( 0, 0,  n, nc    );
-  CS.Z = CS.GT_qr_Q.block( 0, nc, n, (n-nc));
+  CS.GT.block(  0, 0,na, nc) = CS.GTu;
+  CS.GT.block( na, 0,nu, nc) = CS.GTl;
 
   //MM: Update to Henning's formulation s.t. the relaxed IDC operator will
   //    exactly satisfy QDDotControls if it is possible.
@@ -2024,10 +3051,12 @@ void InverseDynamicsConstraintsRelaxed(
   //    +SC - WS( qdd* + (S' W^-1 S)N )
   //
 
-  CS.u = CS.S*CS.C - CS.W*(CS.S*(QDDotControls
-                                 +(CS.S.transpose()*CS.WinvSC)));
+  for(unsigned int i=0; i<na; ++i) {
+    CS.u[i] = QDDotControls[ia[i]] + CS.WinvSC[i];
+  }
+  CS.u = CS.Cu - CS.W*CS.u;
   //CS.u =  CS.S*CS.C - CS.W*(CS.S*QDDotControls);
-  CS.v =  CS.P*CS.C;
+  CS.v =  CS.Cl;
 
   for(unsigned int i=0; i<CS.S.rows(); ++i) {
     CS.g[i] = CS.u[i];
@@ -2038,24 +3067,75 @@ void InverseDynamicsConstraintsRelaxed(
     ++j;
   }
 
-  //nc x nc system
-  SolveLinearSystem(CS.Ru.transpose(), CS.gamma, CS.py, CS.linear_solver);
+  if(fac.enabled) {
+    // The null-space solution below is the solution of the KKT system
+    //
+    //  [ F    GT ] [  p      ]   [ -g    ]
+    //  [ GT'  0  ] [ -lambda ] = [ gamma ]
+    //
+    // which is solved using the kept LU factorization and iterative
+    // refinement.
+    fac.K.block(0, 0, n,  n) = CS.F;
+    fac.K.block(0, n, n, nc) = CS.GT;
+    fac.K.block(n, 0, nc, n) = CS.GT.transpose();
+    fac.rhs.head(n)  = -CS.g;
+    fac.rhs.tail(nc) = CS.gamma;
+
+    if(refactorize) {
+      fac.kkt_lu.compute(fac.K);
+      fac.factorization_count++;
+      fac.frames_since_factorization = 0;
+      fac.factorized = true;
+    }
+    if(!SolveWithRefinement(fac.kkt_lu, fac.K, fac.rhs, fac.sol, fac.res,
+                            fac.delta, fac.residual_tolerance,
+                            fac.max_refinement_steps, fac.residual,
+                            fac.refinement_steps) && !refactorize) {
+      fac.kkt_lu.compute(fac.K);
+      fac.factorization_count++;
+      fac.frames_since_factorization = 0;
+      SolveWithRefinement(fac.kkt_lu, fac.K, fac.rhs, fac.sol, fac.res,
+                          fac.delta, fac.residual_tolerance,
+                          fac.max_refinement_steps, fac.residual,
+                          fac.refinement_steps);
+    }
+    fac.frames_since_factorization++;
 
-  //(n-nc) x (n-nc) system
-  SolveLinearSystem(CS.Z.transpose()*CS.F*CS.Z,
-                    CS.Z.transpose()*(-CS.F*CS.Y*CS.py-CS.g),
-                    CS.pz,
-                    CS.linear_solver);
+    QDDotOutput = fac.sol.head(n);
+    CS.force    = -fac.sol.tail(nc);
+  } else {
+    CS.GT_qr.compute (CS.GT);
+    CS.GT_qr.householderQ().evalTo (CS.GT_qr_Q);
+
+    //GT = [Y  Z] * [ R ]
+    //              [ 0 ]
+
+    CS.R  = CS.GT_qr_Q.transpose()*CS.GT;
+    CS.Ru = CS.R.block(0,0,nc,nc);
+
+    CS.Y = CS.GT_qr_Q.block( 0, 0,  n, nc    );
+    CS.Z = CS.GT_qr_Q.block( 0, nc, n, (n-nc));
 
-  //nc x nc system
-  SolveLinearSystem(CS.Ru,
-                    CS.Y.transpose()*(CS.g + CS.F*CS.Y*CS.py + CS.F*CS.Z*CS.pz),
-                    CS.force, CS.linear_solver);
+    //nc x nc system
+    SolveLinearSystem(CS.Ru.transpose(), CS.gamma, CS.py, CS.linear_solver);
 
-  //Eqn. 32d, the equation for qdd, is in error. Instead
-  // p = Ypy + Zpz = [v,w]
-  // qdd = S'v + P'w
-  QDDotOutput = CS.Y*CS.py + CS.Z*CS.pz;
+    //(n-nc) x (n-nc) system
+    SolveLinearSystem(CS.Z.transpose()*CS.F*CS.Z,
+                      CS.Z.transpose()*(-CS.F*CS.Y*CS.py-CS.g),
+                      CS.pz,
+                      CS.linear_solver);
+
+    //nc x nc system
+    SolveLinearSystem(CS.Ru,
+                      CS.Y.transpose()*(CS.g + CS.F*CS.Y*CS.py
+                                        + CS.F*CS.Z*CS.pz),
+                      CS.force, CS.linear_solver);
+
+    //Eqn. 32d, the equation for qdd, is in error. Instead
+    // p = Ypy + Zpz = [v,w]
+    // qdd = S'v + P'w
+    QDDotOutput = CS.Y*CS.py + CS.Z*CS.pz;
+  }
   for(unsigned int i=0; i<CS.S.rows(); ++i) {
     CS.u[i] = QDDotOutput[i];
   }
@@ -2065,16 +3145,72 @@ void InverseDynamicsConstraintsRelaxed(
     ++j;
   }
 
-  QDDotOutput = CS.S.transpose()*CS.u
-                +CS.P.transpose()*CS.v;
+  for(unsigned int i=0; i<na; ++i) {
+    QDDotOutput[ia[i]] = CS.u[i];
+  }
+  for(unsigned int i=0; i<nu; ++i) {
+    QDDotOutput[iu[i]] = CS.v[i];
+  }
 
-  TauOutput = (CS.S.transpose()*CS.W*CS.S)*(
-                QDDotControls+(CS.S.transpose()*CS.WinvSC)
-                -QDDotOutput);
+  //tau = S'WS(qdd* + S'W^-1SC - qdd), only the actuated entries are non-zero
+  for(unsigned int i=0; i<na; ++i) {
+    CS.Cu[i] = QDDotControls[ia[i]] + CS.WinvSC[i] - CS.u[i];
+  }
+  CS.Cu = CS.W*CS.Cu;
+  TauOutput.setZero();
+  for(unsigned int i=0; i<na; ++i) {
+    TauOutput[ia[i]] = CS.Cu[i];
+  }
   //TauOutput =  CS.S.transpose()*CS.W*CS.S*(QDDotControls - QDDotOutput);
 
 
 }
+
+RBDL_DLLAPI
+void InverseDynamicsConstraintsRelaxedSequence(
+  Model &model,
+  const std::vector<Math::VectorNd> &Q,
+  const std::vector<Math::VectorNd> &QDot,
+  const std::vector<Math::VectorNd> &QDDotControls,
+  ConstraintSet &CS,
+  std::vector<Math::VectorNd> &QDDotOutput,
+  std::vector<Math::VectorNd> &TauOutput,
+  std::vector<Math::VectorNd> *ForceOutput,
+  std::vector< std::vector<Math::SpatialVector> > *f_ext)
+{
+  LOG << "-------- " << __func__ << " --------" << std::endl;
+
+  size_t frames = Q.size();
+  if (QDot.size() != frames || QDDotControls.size() != frames
+      || (f_ext != NULL && f_ext->size() != frames)) {
+    throw Errors::RBDLSizeMismatchError("Error: the trajectory inputs of "
+                                        "InverseDynamicsConstraintsRelaxed"
+                                        "Sequence differ in length.\n");
+  }
+
+  QDDotOutput.resize(frames);
+  TauOutput.resize(frames);
+  if (ForceOutput != NULL) {
+    ForceOutput->resize(frames);
+  }
+
+  // a factorization from a previous, unrelated call is not used for the
+  // first frame of the trajectory
+  CS.relaxed_factorization.factorized = false;
+
+  for (size_t i = 0; i < frames; ++i) {
+    QDDotOutput[i].resize(model.dof_count);
+    TauOutput[i].resize(model.dof_count);
+
+    InverseDynamicsConstraintsRelaxed(model, Q[i], QDot[i], QDDotControls[i],
+                                      CS, QDDotOutput[i], TauOutput[i], true,
+                                      f_ext != NULL ? &(*f_ext)[i] : NULL);
+
+    if (ForceOutput != NULL) {
+      (*ForceOutput)[i] = CS.force;
+    }
+  }
+}
 #endif
 
 void SolveLinearSystem (
@@ -2095,6 +3231,9 @@ void SolveLinearSystem (
   // Solve the system A*x = b.
   switch (ls) {
   case (LinearSolverPartialPivLU) :
+  case (LinearSolverLLT) :
+  case (LinearSolverLDLT) :
+    // the assembly systems are symmetric but indefinite
     x = A.partialPivLu().solve(b);
     break;
   case (LinearSolverColPivHouseholderQR) :
@@ -2103,6 +3242,9 @@ void SolveLinearSystem (
   case (LinearSolverHouseholderQR) :
     x = A.householderQr().solve(b);
     break;
+  case (LinearSolverMixedPrecisionLU) :
+    SolveLinearSystemMixedPrecision (A, b, x);
+    break;
   default:
     std::ostringstream errormsg;
     errormsg << "Error: Invalid linear solver: " << ls << std::endl;
@@ -2112,6 +3254,322 @@ void SolveLinearSystem (
 #endif
 }
 
+//==============================================================================
+SchurComplementWorkspace* GetSchurComplementWorkspace (ConstraintSet& CS)
+{
+#ifdef RBDL_USE_CASADI_MATH
+  return NULL;
+#else
+  return &CS.schur_complement;
+#endif
+}
+
+#ifndef RBDL_USE_CASADI_MATH
+//==============================================================================
+void ApplyAssemblyStep (
+  const Model& model,
+  const VectorNd& d,
+  VectorNd& Q
+)
+{
+  for (size_t i = 0; i < model.mJoints.size(); ++i) {
+    // If the joint is spherical, translate the corresponding components
+    // of d into a modification in the joint quaternion.
+    if (model.mJoints[i].mJointType == JointTypeSpherical) {
+      Quaternion quat = model.GetQuaternion(i, Q);
+      Vector3d omega = d.block<3,1>(model.mJoints[i].q_index,0);
+      // Convert the 3d representation of the displacement to 4d and sum it
+      // to the components of the quaternion.
+      quat += quat.omegaToQDot(omega);
+      // The quaternion needs to be normalized after the previous sum.
+      quat /= quat.norm();
+      model.SetQuaternion(i, quat, Q);
+    }
+    // If the current joint is not spherical, simply add the corresponding
+    // components of d to Q.
+    else {
+      unsigned int qIdx = model.mJoints[i].q_index;
+      for(size_t j = 0; j < model.mJoints[i].mDoFCount; ++j) {
+        Q[qIdx + j] += d[qIdx + j];
+      }
+    }
+  }
+}
+#endif
+
+//==============================================================================
+/// block(i,j) = M(rows[i], cols[j]), e.g. S*M*P^T without the products
+void SelectBlock (
+  const MatrixNd& M,
+  const std::vector<unsigned int>& rows,
+  const std::vector<unsigned int>& cols,
+  MatrixNd& block
+)
+{
+  for(unsigned int j=0; j<cols.size(); ++j) {
+    for(unsigned int i=0; i<rows.size(); ++i) {
+      block(i,j) = M(rows[i],cols[j]);
+    }
+  }
+}
+
+//==============================================================================
+/// block(i,j) = M(j, cols[i]), e.g. S*M^T without the product
+void SelectTransposedColumns (
+  const MatrixNd& M,
+  const std::vector<unsigned int>& cols,
+  MatrixNd& block
+)
+{
+  for(unsigned int j=0; j<M.rows(); ++j) {
+    for(unsigned int i=0; i<cols.size(); ++i) {
+      block(i,j) = M(j,cols[i]);
+    }
+  }
+}
+
+//==============================================================================
+template <typename GroupFunction, typename Function>
+void ForEachConstraint (
+  ConstraintSet& CS,
+  GroupFunction group_fn,
+  Function fn
+)
+{
+  // Tasks are the contact groups followed by the remaining constraints
+  unsigned int ng = unsigned(CS.contact_groups.size());
+  unsigned int nc = ng + unsigned(CS.ungrouped_constraints.size());
+  unsigned int nt = std::min(CS.num_threads,
+                             unsigned(CS.thread_caches.size()) + 1);
+  nt = std::min(nt, nc);
+
+  auto task = [&CS, &group_fn, &fn, ng](unsigned int k,
+                                        ConstraintCache &cache) {
+    if (k < ng) {
+      group_fn(CS.contact_groups[k]);
+    } else {
+      fn(CS.ungrouped_constraints[k - ng], cache);
+    }
+  };
+
+  if (nt < 2) {
+    for (unsigned int k = 0; k < nc; ++k) {
+      task(k, CS.cache);
+    }
+    return;
+  }
+
+  // copies of a set do not share the threads of the original set
+  if (CS.workers.size() < nt - 1) {
+    CS.workers.Resize(CS.num_threads - 1);
+  }
+
+  // Contiguous chunks of tasks: chunk t is evaluated by thread t using its
+  // own cache, chunk 0 by the calling thread.
+  auto chunk = [&CS, &task, nt, nc](unsigned int t) {
+    ConstraintCache &cache = t == 0 ? CS.cache : CS.thread_caches[t - 1];
+    for (unsigned int k = t * nc / nt; k < (t + 1) * nc / nt; ++k) {
+      task(k, cache);
+    }
+  };
+  CS.workers.Run(nt, chunk);
+}
+
+//==============================================================================
+struct ConstraintWorkerPoolData {
+  ConstraintWorkerPoolData() :
+    generation (0),
+    num_active (0),
+    num_pending (0),
+    stop (false),
+    invoke (NULL),
+    task (NULL) {}
+
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors;
+  std::mutex mutex;
+  std::condition_variable start_condition;
+  std::condition_variable done_condition;
+
+  /// Incremented for every Run() such that the workers notice new work.
+  unsigned int generation;
+  /// Workers that take part in the current Run().
+  unsigned int num_active;
+  /// Workers that have not yet finished their task of the current Run().
+  unsigned int num_pending;
+  bool stop;
+
+  void (*invoke)(void*, unsigned int);
+  void *task;
+};
+
+/* Waits for RunTasks() and evaluates task (t + 1) until the pool stops. */
+static void ConstraintWorkerLoop (ConstraintWorkerPoolData &data,
+                                  unsigned int t,
+                                  unsigned int generation)
+{
+  while (true) {
+    std::unique_lock<std::mutex> lock (data.mutex);
+    data.start_condition.wait (lock, [&data, &generation]() {
+      return data.stop || data.generation != generation;
+    });
+    if (data.stop) {
+      return;
+    }
+    generation = data.generation;
+    if (t >= data.num_active) {
+      continue;
+    }
+    lock.unlock();
+
+    try {
+      data.invoke (data.task, t + 1);
+    } catch (...) {
+      data.errors[t] = std::current_exception();
+    }
+
+    lock.lock();
+    if (--data.num_pending == 0) {
+      data.done_condition.notify_one();
+    }
+  }
+}
+
+ConstraintWorkerPool::ConstraintWorkerPool() :
+  data (new ConstraintWorkerPoolData()) {
+}
+
+ConstraintWorkerPool::ConstraintWorkerPool (
+  const ConstraintWorkerPool &) :
+  data (new ConstraintWorkerPoolData()) {
+}
+
+ConstraintWorkerPool &ConstraintWorkerPool::operator= (
+  const ConstraintWorkerPool &)
+{
+  return *this;
+}
+
+ConstraintWorkerPool::~ConstraintWorkerPool()
+{
+  Resize (0);
+}
+
+void ConstraintWorkerPool::Resize (unsigned int num_workers)
+{
+  {
+    std::lock_guard<std::mutex> lock (data->mutex);
+    data->stop = true;
+  }
+  data->start_condition.notify_all();
+  for (size_t t = 0; t < data->threads.size(); ++t) {
+    data->threads[t].join();
+  }
+
+  data->threads.clear();
+  data->stop = false;
+  data->errors.assign (num_workers, std::exception_ptr());
+
+  // the new workers wait for the next generation
+  ConstraintWorkerPoolData &pool_data = *data;
+  unsigned int generation = data->generation;
+  for (unsigned int t = 0; t < num_workers; ++t) {
+    data->threads.push_back (std::thread ([&pool_data, t, generation]() {
+      ConstraintWorkerLoop (pool_data, t, generation);
+    }));
+  }
+}
+
+unsigned int ConstraintWorkerPool::size() const
+{
+  return unsigned (data->threads.size());
+}
+
+void ConstraintWorkerPool::RunTasks (unsigned int num_threads,
+                                     void (*invoke)(void*, unsigned int),
+                                     void *task)
+{
+  assert (num_threads >= 1 && num_threads - 1 <= size());
+
+  {
+    std::lock_guard<std::mutex> lock (data->mutex);
+    data->invoke = invoke;
+    data->task = task;
+    data->num_active = num_threads - 1;
+    data->num_pending = num_threads - 1;
+    for (size_t t = 0; t < data->errors.size(); ++t) {
+      data->errors[t] = std::exception_ptr();
+    }
+    ++data->generation;
+  }
+  data->start_condition.notify_all();
+
+  std::exception_ptr error;
+  try {
+    invoke (task, 0);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  // the tasks reference the stack of the caller, so all workers have to be
+  // done before returning (or rethrowing)
+  {
+    std::unique_lock<std::mutex> lock (data->mutex);
+    data->done_condition.wait (lock, [this]() {
+      return data->num_pending == 0;
+    });
+  }
+
+  if (error) {
+    std::rethrow_exception (error);
+  }
+  for (size_t t = 0; t < data->errors.size(); ++t) {
+    if (data->errors[t]) {
+      std::rethrow_exception (data->errors[t]);
+    }
+  }
+}
+
+#ifndef RBDL_USE_CASADI_MATH
+//==============================================================================
+template <typename Decomposition>
+bool SolveWithRefinement (
+  const Decomposition& dec,
+  const MatrixNd& A,
+  const VectorNd& b,
+  VectorNd& x,
+  VectorNd& r,
+  VectorNd& dx,
+  double tol,
+  unsigned int max_steps,
+  double& residual,
+  unsigned int& steps
+)
+{
+  // dec is the factorization of a matrix close to A: iterative refinement
+  // x <- x + dec^-1 (b - A x) converges to the solution of A x = b
+  double b_norm = b.norm();
+  if (b_norm == 0.) {
+    b_norm = 1.;
+  }
+
+  x = dec.solve(b);
+  for (steps = 0; ; ++steps) {
+    r = b;
+    r.noalias() -= A * x;
+    residual = r.norm() / b_norm;
+    if (residual <= tol) {
+      return true;
+    }
+    if (steps == max_steps) {
+      return false;
+    }
+    dx = dec.solve(r);
+    x += dx;
+  }
+}
+#endif
+
 //==============================================================================
 unsigned int GetMovableBodyId (Model& model, unsigned int id)
 {
@@ -2242,6 +3700,26 @@ void ConstraintSet::calcVelocityError(
 }
 //==============================================================================
 
+void ConstraintSet::setCompliance(
+  unsigned int groupIndex,
+  double complianceOfConstraint)
+{
+  assert(groupIndex <= unsigned(constraints.size()-1));
+
+  if (complianceOfConstraint < 0.) {
+    throw Errors::RBDLInvalidParameterError(
+        "Error: the compliance of a constraint must not be negative!\n");
+  }
+
+  constraints[groupIndex]->setCompliance(complianceOfConstraint);
+
+  if (bound) {
+    constraints[groupIndex]->setComplianceInSystem(compliance);
+  }
+}
+
+//==============================================================================
+
 void ConstraintSet::calcBaumgarteStabilizationForces(
   unsigned int groupIndex,
   Model& model,
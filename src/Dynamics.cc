@@ -7,6 +7,7 @@
 
 #include <iostream>
 #include <limits>
+#include <type_traits>
 #include <assert.h>
 #include <string.h>
 
@@ -18,11 +19,77 @@
 #include "rbdl/Body.h"
 #include "rbdl/Dynamics.h"
 #include "rbdl/Kinematics.h"
+#include "rbdl/rbdl_errors.h"
 
 namespace RigidBodyDynamics {
 
 using namespace Math;
 
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Views of the storage of a custom joint with DoF degrees of
+ * freedom.
+ *
+ * DoF is Eigen::Dynamic for joints with more than 6 degrees of freedom.
+ * The storage is sized by Model::AddBodyCustomJoint() so the maps stay
+ * valid during a call of an algorithm.
+ */
+template <int DoF>
+struct CustomJointMaps {
+  typedef Eigen::Matrix<double, 6, DoF> Matrix6D;
+  typedef Eigen::Matrix<double, DoF, DoF> MatrixDD;
+  typedef Eigen::Matrix<double, DoF, 1> VectorD;
+
+  explicit CustomJointMaps (CustomJoint &joint) :
+    S (joint.S.data(), 6, joint.mDoFCount),
+    U (joint.U.data(), 6, joint.mDoFCount),
+    Dinv (joint.Dinv.data(), joint.mDoFCount, joint.mDoFCount),
+    u (joint.u.data(), joint.mDoFCount),
+    d_u (joint.d_u.data(), joint.mDoFCount)
+  { }
+
+  Eigen::Map<Matrix6D> S;
+  Eigen::Map<Matrix6D> U;
+  Eigen::Map<MatrixDD> Dinv;
+  Eigen::Map<VectorD> u;
+  Eigen::Map<VectorD> d_u;
+};
+
+/** \brief Calls f with std::integral_constant<int, dof> for custom joints
+ * with 1 to 6 degrees of freedom (see CustomJointN) such that the
+ * computations of the joint use fixed-size matrices, and with
+ * std::integral_constant<int, Eigen::Dynamic> otherwise. */
+template <typename Function>
+static void DispatchCustomJointDoF (unsigned int dof, Function &&f) {
+  switch (dof) {
+    case 1: f (std::integral_constant<int, 1>()); break;
+    case 2: f (std::integral_constant<int, 2>()); break;
+    case 3: f (std::integral_constant<int, 3>()); break;
+    case 4: f (std::integral_constant<int, 4>()); break;
+    case 5: f (std::integral_constant<int, 5>()); break;
+    case 6: f (std::integral_constant<int, 6>()); break;
+    default: f (std::integral_constant<int, Eigen::Dynamic>()); break;
+  }
+}
+#endif
+
+/** \brief Computes the generalized forces S^T f of a custom joint. */
+static void CalcCustomJointTau (
+    CustomJoint &custom_joint,
+    unsigned int q_index,
+    const SpatialVector &f,
+    VectorNd &Tau) {
+#ifdef RBDL_USE_CASADI_MATH
+  Tau.block(q_index, 0, custom_joint.mDoFCount, 1)
+    = custom_joint.S.transpose() * f;
+#else
+  DispatchCustomJointDoF (custom_joint.mDoFCount, [&] (auto dof) {
+    CustomJointMaps<decltype(dof)::value> joint (custom_joint);
+    Tau.segment (q_index, custom_joint.mDoFCount).noalias() =
+      joint.S.transpose() * f;
+  });
+#endif
+}
+
 RBDL_DLLAPI void InverseDynamics (
     Model &model,
     const VectorNd &Q,
@@ -59,6 +126,7 @@ RBDL_DLLAPI void InverseDynamics (
       }
     }else if(model.mJoints[i].mJointType == JointTypeCustom){
       unsigned int k = model.mJoints[i].custom_joint_index;
+#ifdef RBDL_USE_CASADI_MATH
       VectorNd customJointQDDot(model.mCustomJoints[k]->mDoFCount);
       for(unsigned z = 0; z < model.mCustomJoints[k]->mDoFCount; ++z){
         customJointQDDot[z] = QDDot[q_index+z];
@@ -66,6 +134,16 @@ RBDL_DLLAPI void InverseDynamics (
       model.a[i] =  model.X_lambda[i].apply(model.a[lambda])
         + model.c[i]
         + model.mCustomJoints[k]->S * customJointQDDot;
+#else
+      model.a[i] =  model.X_lambda[i].apply(model.a[lambda]) + model.c[i];
+
+      DispatchCustomJointDoF (model.mCustomJoints[k]->mDoFCount,
+          [&] (auto dof) {
+        CustomJointMaps<decltype(dof)::value> joint (*model.mCustomJoints[k]);
+        model.a[i].noalias() +=
+          joint.S * QDDot.segment (q_index, joint.S.cols());
+      });
+#endif
     }
 
     if (!model.mBodies[i].mIsVirtual) {
@@ -83,7 +161,8 @@ RBDL_DLLAPI void InverseDynamics (
     }
   }
 
-  for (unsigned int i = model.mBodies.size() - 1; i > 0; i--) {
+  for (unsigned int i = model.mBodies.size() - 1;
+      i > model.free_flyer_root_id; i--) {
     if(model.mJoints[i].mJointType != JointTypeCustom){
       if (model.mJoints[i].mDoFCount == 1) {
         Tau[model.mJoints[i].q_index] = model.S[i].dot(model.f[i]);
@@ -93,15 +172,28 @@ RBDL_DLLAPI void InverseDynamics (
       }
     } else if (model.mJoints[i].mJointType == JointTypeCustom) {  
       unsigned int k = model.mJoints[i].custom_joint_index;
-      Tau.block(model.mJoints[i].q_index,0,
-          model.mCustomJoints[k]->mDoFCount, 1)
-        = model.mCustomJoints[k]->S.transpose() * model.f[i];
+      CalcCustomJointTau (*model.mCustomJoints[k], model.mJoints[i].q_index,
+          model.f[i], Tau);
     }
 
     if (model.lambda[i] != 0) {
       model.f[model.lambda[i]] = model.f[model.lambda[i]] + model.X_lambda[i].applyTranspose(model.f[i]);
     }
   }
+
+#ifndef RBDL_USE_CASADI_MATH
+  // free-flyer root: tau_r = S_r^T f_r and tau_t = S_t^T (f_t + X_r^T f_r)
+  // with X_r S_t = [0; E]
+  if (model.free_flyer_root_id != 0) {
+    unsigned int r = model.free_flyer_root_id;
+    unsigned int t = model.lambda[r];
+
+    Tau.segment<3>(model.mJoints[r].q_index) = model.f[r].block<3,1>(0,0);
+    Tau.segment<3>(model.mJoints[t].q_index) = model.f[t].block<3,1>(3,0);
+    Tau.segment<3>(model.mJoints[t].q_index).noalias() +=
+      model.X_lambda[r].E.transpose() * model.f[r].block<3,1>(3,0);
+  }
+#endif
 }
 
 RBDL_DLLAPI void NonlinearEffects ( 
@@ -125,7 +217,8 @@ RBDL_DLLAPI void NonlinearEffects (
   for (unsigned int i = 1; i < model.mBodies.size(); i++) {
     if (model.lambda[i] == 0) {
       model.v[i] = model.v_J[i];
-      model.a[i] = model.X_lambda[i].apply(spatial_gravity);
+      model.c[i] = model.c_J[i];
+      model.a[i] = model.X_lambda[i].apply(spatial_gravity) + model.c[i];
     }	else {
       model.v[i] = model.X_lambda[i].apply(model.v[model.lambda[i]]) + model.v_J[i];
       model.c[i] = model.c_J[i] + crossm(model.v[i],model.v_J[i]);
@@ -158,9 +251,8 @@ RBDL_DLLAPI void NonlinearEffects (
       }
     } else if(model.mJoints[i].mJointType == JointTypeCustom) {
       unsigned int k = model.mJoints[i].custom_joint_index;
-      Tau.block(model.mJoints[i].q_index,0,
-          model.mCustomJoints[k]->mDoFCount, 1)
-        = model.mCustomJoints[k]->S.transpose() * model.f[i];
+      CalcCustomJointTau (*model.mCustomJoints[k], model.mJoints[i].q_index,
+          model.f[i], Tau);
     }
 
     if (model.lambda[i] != 0) {
@@ -169,6 +261,218 @@ RBDL_DLLAPI void NonlinearEffects (
   }
 }
 
+RBDL_DLLAPI void CalcGravityTorques (
+    Model &model,
+    const VectorNd &Q,
+    VectorNd &Tau,
+    bool update_kinematics) {
+  LOG << "-------- " << __func__ << " --------" << std::endl;
+
+  // negated gravity as in InverseDynamics() with zero QDot and QDDot
+  Vector3d a_gravity (-model.gravity[0], -model.gravity[1], -model.gravity[2]);
+
+  // gravity compensating wrench of each body at its CoM in base coordinates
+  for (unsigned int i = 1; i < model.mBodies.size(); i++) {
+    if (update_kinematics) {
+      unsigned int lambda = model.lambda[i];
+      jcalc_X_lambda_S (model, i, Q);
+
+      if (lambda != 0) {
+        model.X_base[i] = model.X_lambda[i] * model.X_base[lambda];
+      } else {
+        model.X_base[i] = model.X_lambda[i];
+      }
+    }
+
+    Scalar mass = model.mBodies[i].mMass;
+    Vector3d com = model.X_base[i].E.transpose()
+      * model.mBodies[i].mCenterOfMass + model.X_base[i].r;
+    Vector3d force = mass * a_gravity;
+    Vector3d torque = com.cross(force);
+
+    model.f[i].set (torque[0], torque[1], torque[2],
+        force[0], force[1], force[2]);
+  }
+
+  // the wrenches are all expressed in base coordinates and can therefore
+  // be summed up without transforming them
+  for (unsigned int i = model.mBodies.size() - 1; i > 0; i--) {
+    SpatialVector f_i = model.X_base[i].applyAdjoint (model.f[i]);
+
+    if(model.mJoints[i].mJointType != JointTypeCustom){
+      if (model.mJoints[i].mDoFCount == 1) {
+        Tau[model.mJoints[i].q_index] = model.S[i].dot(f_i);
+      } else if (model.mJoints[i].mDoFCount == 3) {
+        Tau.block<3,1>(model.mJoints[i].q_index, 0)
+          = model.multdof3_S[i].transpose() * f_i;
+      }
+    } else if (model.mJoints[i].mJointType == JointTypeCustom) {
+      unsigned int k = model.mJoints[i].custom_joint_index;
+      CalcCustomJointTau (*model.mCustomJoints[k], model.mJoints[i].q_index,
+          f_i, Tau);
+    }
+
+    if (model.lambda[i] != 0) {
+      model.f[model.lambda[i]] += model.f[i];
+    }
+  }
+}
+
+/** \brief Returns the matrix of the operator \f$ (h \bar{\times}^*) \f$
+ * for which \f$ (h \bar{\times}^*) v = v \times^* h \f$.
+ */
+static SpatialMatrix crossf_bar (const SpatialVector &h) {
+  return SpatialMatrix (
+      0,  h[2], -h[1],     0,  h[5], -h[4],
+      -h[2],     0,  h[0], -h[5],     0,  h[3],
+      h[1], -h[0],     0,  h[4], -h[3],     0,
+      0,  h[5], -h[4],     0,     0,     0,
+      -h[5],     0,  h[3],     0,     0,     0,
+      h[4], -h[3],     0,     0,     0,     0
+      );
+}
+
+RBDL_DLLAPI void CalcCoriolisMatrix (
+    Model &model,
+    const VectorNd &Q,
+    const VectorNd &QDot,
+    MatrixNd &C,
+    bool update_kinematics) {
+  LOG << "-------- " << __func__ << " --------" << std::endl;
+
+  assert (C.rows() == model.dof_count && C.cols() == model.dof_count);
+
+  if (model.mCustomJoints.size() > 0) {
+    throw Errors::RBDLMissingImplementationError(
+        "CalcCoriolisMatrix() does not support custom joints!\n");
+  }
+
+  if (update_kinematics) {
+    UpdateKinematicsCustom (model, &Q, &QDot, NULL);
+  }
+
+  // body Coriolis factors B_i = 1/2 (v x* I - I v x + (I v) xbar*) which
+  // satisfy dI/dt = B_i + B_i^T
+  for (unsigned int i = 1; i < model.mBodies.size(); i++) {
+    SpatialMatrix I_i = model.I[i].toMatrix();
+    model.Ic[i] = model.I[i];
+    model.Bc[i] = 0.5 * (crossf(model.v[i]) * I_i - I_i * crossm(model.v[i])
+        + crossf_bar(I_i * model.v[i]));
+  }
+
+  C.setZero();
+
+  for (unsigned int i = model.mBodies.size() - 1; i > 0; i--) {
+    unsigned int lambda = model.lambda[i];
+
+    if (lambda != 0) {
+      model.Ic[lambda] = model.Ic[lambda]
+        + model.X_lambda[i].applyTranspose(model.Ic[i]);
+      model.Bc[lambda] += model.X_lambda[i].toMatrixTranspose() * model.Bc[i]
+        * model.X_lambda[i].toMatrix();
+    }
+
+    unsigned int dof_index_i = model.mJoints[i].q_index;
+
+    for (unsigned int di = 0; di < model.mJoints[i].mDoFCount; di++) {
+      SpatialVector S_i = jcalc_S_column (model, i, di);
+      SpatialVector S_dot_i = crossm(model.v[i], S_i)
+        + jcalc_S_dot_column (model, i, di, Q, QDot);
+
+      // C(j,i) = S_j^T F1 and C(i,j) = F2^T dS_j/dt + F3^T S_j for all
+      // joints j that support body i
+      SpatialVector F1 = model.Ic[i] * S_dot_i + model.Bc[i] * S_i;
+      SpatialVector F2 = model.Ic[i] * S_i;
+      SpatialVector F3 = model.Bc[i].transpose() * S_i;
+
+      for (unsigned int dj = 0; dj < model.mJoints[i].mDoFCount; dj++) {
+        C(dof_index_i + dj, dof_index_i + di)
+          = jcalc_S_column (model, i, dj).dot(F1);
+      }
+
+      unsigned int j = i;
+
+      while (model.lambda[j] != 0) {
+        F1 = model.X_lambda[j].applyTranspose(F1);
+        F2 = model.X_lambda[j].applyTranspose(F2);
+        F3 = model.X_lambda[j].applyTranspose(F3);
+        j = model.lambda[j];
+
+        unsigned int dof_index_j = model.mJoints[j].q_index;
+
+        for (unsigned int dj = 0; dj < model.mJoints[j].mDoFCount; dj++) {
+          SpatialVector S_j = jcalc_S_column (model, j, dj);
+          SpatialVector S_dot_j = crossm(model.v[j], S_j)
+            + jcalc_S_dot_column (model, j, dj, Q, QDot);
+
+          C(dof_index_j + dj, dof_index_i + di) = S_j.dot(F1);
+          C(dof_index_i + di, dof_index_j + dj) = F2.dot(S_dot_j)
+            + F3.dot(S_j);
+        }
+      }
+    }
+  }
+}
+
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Sets the entries of H that couple the DoFs of a descendant of
+ * the free-flyer root with the root, where F = Ic S are the composite
+ * forces of these DoFs in root coordinates. The entries of the
+ * translational joint are S_t^T X_r^T F = E^T F_lin. */
+template <typename ForceMatrix>
+static void SetFreeFlyerRootCoupling (
+    const Model &model,
+    const ForceMatrix &F,
+    unsigned int dof_index_i,
+    MatrixNd &H) {
+  unsigned int r = model.free_flyer_root_id;
+  unsigned int dof_index_r = model.mJoints[r].q_index;
+  unsigned int dof_index_t = model.mJoints[model.lambda[r]].q_index;
+  unsigned int dof = F.cols();
+
+  H.block(dof_index_r, dof_index_i, 3, dof) = F.template topRows<3>();
+  H.block(dof_index_t, dof_index_i, 3, dof).noalias() =
+    model.X_lambda[r].E.transpose() * F.template bottomRows<3>();
+  H.block(dof_index_i, dof_index_r, dof, 3) =
+    H.block(dof_index_r, dof_index_i, 3, dof).transpose();
+  H.block(dof_index_i, dof_index_t, dof, 3) =
+    H.block(dof_index_t, dof_index_i, 3, dof).transpose();
+}
+#endif
+
+/** \brief Sets the entries of H that couple the DoFs with the composite
+ * forces F in coordinates of body j with the DoFs of the custom joint of
+ * body j. */
+template <typename ForceMatrix>
+static void SetCustomJointCoupling (
+    Model &model,
+    const ForceMatrix &F,
+    unsigned int dof_index_i,
+    unsigned int j,
+    MatrixNd &H) {
+  CustomJoint &custom_joint =
+    *model.mCustomJoints[model.mJoints[j].custom_joint_index];
+  unsigned int dof_index_j = model.mJoints[j].q_index;
+  unsigned int dof_i = F.cols();
+  unsigned int dof_j = custom_joint.mDoFCount;
+
+#ifdef RBDL_USE_CASADI_MATH
+  MatrixNd H_temp2 = F.transpose() * custom_joint.S;
+
+  H.block(dof_index_i, dof_index_j, dof_i, dof_j) = H_temp2;
+  H.block(dof_index_j, dof_index_i, dof_j, dof_i) = H_temp2.transpose();
+#else
+  DispatchCustomJointDoF (dof_j, [&] (auto dof) {
+    CustomJointMaps<decltype(dof)::value> joint (custom_joint);
+
+    H.block(dof_index_i, dof_index_j, dof_i, dof_j).noalias() =
+      F.transpose() * joint.S;
+    H.block(dof_index_j, dof_index_i, dof_j, dof_i) =
+      H.block(dof_index_i, dof_index_j, dof_i, dof_j).transpose();
+  });
+#endif
+}
+
 RBDL_DLLAPI void CompositeRigidBodyAlgorithm (
     Model& model,
     const VectorNd &Q,
@@ -185,7 +489,8 @@ RBDL_DLLAPI void CompositeRigidBodyAlgorithm (
     model.Ic[i] = model.I[i];
   }
 
-  for (unsigned int i = model.mBodies.size() - 1; i > 0; i--) {
+  for (unsigned int i = model.mBodies.size() - 1;
+      i > model.free_flyer_root_id; i--) {
     if (model.lambda[i] != 0) {
       model.Ic[model.lambda[i]] = model.Ic[model.lambda[i]] + model.X_lambda[i].applyTranspose(model.Ic[i]);
     }
@@ -206,6 +511,13 @@ RBDL_DLLAPI void CompositeRigidBodyAlgorithm (
         j = model.lambda[j];
         dof_index_j = model.mJoints[j].q_index;
 
+#ifndef RBDL_USE_CASADI_MATH
+        if (j == model.free_flyer_root_id) {
+          SetFreeFlyerRootCoupling (model, F, dof_index_i, H);
+          break;
+        }
+#endif
+
         if(model.mJoints[j].mJointType != JointTypeCustom) {
           if (model.mJoints[j].mDoFCount == 1) {
             H(dof_index_i,dof_index_j) = F.dot(model.S[j]);
@@ -220,20 +532,8 @@ RBDL_DLLAPI void CompositeRigidBodyAlgorithm (
             H.block<1,3>(dof_index_i,dof_index_j) = H_temp2.transpose();
             H.block<3,1>(dof_index_j,dof_index_i) = H_temp2;
           }
-        } else if (model.mJoints[j].mJointType == JointTypeCustom){        
-          unsigned int k      = model.mJoints[j].custom_joint_index;
-          unsigned int dof    = model.mCustomJoints[k]->mDoFCount;
-          VectorNd H_temp2    =
-            (F.transpose() * model.mCustomJoints[k]->S).transpose();
-
-          LOG << F.transpose()
-            << std::endl
-            << model.mCustomJoints[j]->S << std::endl;
-
-          LOG << H_temp2.transpose() << std::endl;
-
-          H.block(dof_index_i,dof_index_j,1,dof) = H_temp2.transpose();
-          H.block(dof_index_j,dof_index_i,dof,1) = H_temp2;
+        } else if (model.mJoints[j].mJointType == JointTypeCustom){
+          SetCustomJointCoupling (model, F, dof_index_i, j, H);
         }
       }
     } else if (model.mJoints[i].mDoFCount == 3
@@ -249,6 +549,13 @@ RBDL_DLLAPI void CompositeRigidBodyAlgorithm (
         j = model.lambda[j];
         dof_index_j = model.mJoints[j].q_index;
 
+#ifndef RBDL_USE_CASADI_MATH
+        if (j == model.free_flyer_root_id) {
+          SetFreeFlyerRootCoupling (model, F_63, dof_index_i, H);
+          break;
+        }
+#endif
+
         if(model.mJoints[j].mJointType != JointTypeCustom){
           if (model.mJoints[j].mDoFCount == 1) {
             Vector3d H_temp2 = F_63.transpose() * (model.S[j]);
@@ -262,24 +569,19 @@ RBDL_DLLAPI void CompositeRigidBodyAlgorithm (
             H.block<3,3>(dof_index_j,dof_index_i) = H_temp2.transpose();
           }
         } else if (model.mJoints[j].mJointType == JointTypeCustom){
-          unsigned int k = model.mJoints[j].custom_joint_index;
-          unsigned int dof = model.mCustomJoints[k]->mDoFCount;
-
-          MatrixNd H_temp2 = F_63.transpose() * (model.mCustomJoints[k]->S);
-
-          H.block(dof_index_i,dof_index_j,3,dof) = H_temp2;
-          H.block(dof_index_j,dof_index_i,dof,3) = H_temp2.transpose();
+          SetCustomJointCoupling (model, F_63, dof_index_i, j, H);
         }
       }
-    } else if (model.mJoints[i].mJointType == JointTypeCustom) {      
-      unsigned int kI = model.mJoints[i].custom_joint_index;
-      unsigned int dofI = model.mCustomJoints[kI]->mDoFCount;
+    } else if (model.mJoints[i].mJointType == JointTypeCustom) {
+      CustomJoint &custom_joint =
+        *model.mCustomJoints[model.mJoints[i].custom_joint_index];
+      unsigned int dofI = custom_joint.mDoFCount;
 
-      MatrixNd F_Nd = model.Ic[i].toMatrix()
-        * model.mCustomJoints[kI]->S;
+#ifdef RBDL_USE_CASADI_MATH
+      MatrixNd F_Nd = model.Ic[i].toMatrix() * custom_joint.S;
 
       H.block(dof_index_i, dof_index_i,dofI,dofI)
-        = model.mCustomJoints[kI]->S.transpose() * F_Nd;
+        = custom_joint.S.transpose() * F_Nd;
 
       unsigned int j = i;
       unsigned int dof_index_j = dof_index_i;
@@ -304,18 +606,392 @@ RBDL_DLLAPI void CompositeRigidBodyAlgorithm (
                 H_temp2.cols(),H_temp2.rows()) = H_temp2.transpose();
           }
         } else if (model.mJoints[j].mJointType == JointTypeCustom){
-          unsigned int k   = model.mJoints[j].custom_joint_index;
-          unsigned int dof = model.mCustomJoints[k]->mDoFCount;
+          SetCustomJointCoupling (model, F_Nd, dof_index_i, j, H);
+        }
+      }
+#else
+      DispatchCustomJointDoF (dofI, [&] (auto dof) {
+        typedef CustomJointMaps<decltype(dof)::value> Maps;
+        Maps joint (custom_joint);
 
-          MatrixNd H_temp2 = F_Nd.transpose() * (model.mCustomJoints[k]->S);
+        typename Maps::Matrix6D F_Nd = model.Ic[i].toMatrix() * joint.S;
+        H.block(dof_index_i, dof_index_i, dofI, dofI).noalias() =
+          joint.S.transpose() * F_Nd;
 
-          H.block(dof_index_i,dof_index_j,3,dof) = H_temp2;
-          H.block(dof_index_j,dof_index_i,dof,3) = H_temp2.transpose();
+        unsigned int j = i;
+        unsigned int dof_index_j = dof_index_i;
+
+        while (model.lambda[j] != 0) {
+          F_Nd = model.X_lambda[j].toMatrixTranspose() * F_Nd;
+          j = model.lambda[j];
+          dof_index_j = model.mJoints[j].q_index;
+
+          if (j == model.free_flyer_root_id) {
+            SetFreeFlyerRootCoupling (model, F_Nd, dof_index_i, H);
+            break;
+          }
+
+          if(model.mJoints[j].mJointType != JointTypeCustom){
+            if (model.mJoints[j].mDoFCount == 1) {
+              H.block(dof_index_i, dof_index_j, dofI, 1).noalias() =
+                F_Nd.transpose() * model.S[j];
+              H.block(dof_index_j, dof_index_i, 1, dofI) =
+                H.block(dof_index_i, dof_index_j, dofI, 1).transpose();
+            } else if (model.mJoints[j].mDoFCount == 3) {
+              H.block(dof_index_i, dof_index_j, dofI, 3).noalias() =
+                F_Nd.transpose() * model.multdof3_S[j];
+              H.block(dof_index_j, dof_index_i, 3, dofI) =
+                H.block(dof_index_i, dof_index_j, dofI, 3).transpose();
+            }
+          } else if (model.mJoints[j].mJointType == JointTypeCustom){
+            SetCustomJointCoupling (model, F_Nd, dof_index_i, j, H);
+          }
         }
+      });
+#endif
+    }
+  }
+
+#ifndef RBDL_USE_CASADI_MATH
+  // free-flyer root: S^T Ic S with S = [S_r, X_r S_t] = diag(1, E)
+  if (model.free_flyer_root_id != 0) {
+    unsigned int r = model.free_flyer_root_id;
+    unsigned int dof_index_r = model.mJoints[r].q_index;
+    unsigned int dof_index_t = model.mJoints[model.lambda[r]].q_index;
+
+    SpatialMatrix Ic = model.Ic[r].toMatrix();
+    Matrix3d H_rt = Ic.block<3,3>(0,3) * model.X_lambda[r].E;
+
+    H.block<3,3>(dof_index_r, dof_index_r) = Ic.block<3,3>(0,0);
+    H.block<3,3>(dof_index_r, dof_index_t) = H_rt;
+    H.block<3,3>(dof_index_t, dof_index_r) = H_rt.transpose();
+    H.block<3,3>(dof_index_t, dof_index_t) =
+      Matrix3d::Identity() * model.Ic[r].m;
+  }
+#endif
+}
+
+/** \brief Computes U = IA S and Dinv = (S^T U)^-1 of a custom joint. */
+static void CalcCustomJointUDinv (
+    const SpatialMatrix &IA,
+    CustomJoint &custom_joint) {
+#ifdef RBDL_USE_CASADI_MATH
+  custom_joint.U = IA * custom_joint.S;
+  custom_joint.Dinv = (custom_joint.S.transpose() * custom_joint.U).inverse();
+#else
+  DispatchCustomJointDoF (custom_joint.mDoFCount, [&] (auto dof) {
+    typedef CustomJointMaps<decltype(dof)::value> Maps;
+    Maps joint (custom_joint);
+
+    joint.U.noalias() = IA * joint.S;
+
+    typename Maps::MatrixDD D;
+    D.noalias() = joint.S.transpose() * joint.U;
+    joint.Dinv = D.inverse();
+  });
+#endif
+}
+
+/** \brief Returns the articulated inertia IA - U Dinv U^T that a custom
+ * joint passes to its parent. */
+static SpatialMatrix CalcCustomJointIa (
+    const SpatialMatrix &IA,
+    CustomJoint &custom_joint) {
+#ifdef RBDL_USE_CASADI_MATH
+  return IA - (custom_joint.U * custom_joint.Dinv * custom_joint.U.transpose());
+#else
+  SpatialMatrix Ia = IA;
+
+  DispatchCustomJointDoF (custom_joint.mDoFCount, [&] (auto dof) {
+    typedef CustomJointMaps<decltype(dof)::value> Maps;
+    Maps joint (custom_joint);
+
+    typename Maps::Matrix6D U_Dinv;
+    U_Dinv.noalias() = joint.U * joint.Dinv;
+    Ia.noalias() -= U_Dinv * joint.U.transpose();
+  });
+
+  return Ia;
+#endif
+}
+
+/** \brief Computes u = tau - S^T pA of a custom joint. */
+static void CalcCustomJointBiasForce (
+    const VectorNd &Tau,
+    unsigned int q_index,
+    const SpatialVector &pA,
+    CustomJoint &custom_joint) {
+#ifdef RBDL_USE_CASADI_MATH
+  VectorNd tau_temp(Tau.block(q_index, 0, custom_joint.mDoFCount, 1));
+  custom_joint.u = tau_temp - custom_joint.S.transpose() * pA;
+#else
+  DispatchCustomJointDoF (custom_joint.mDoFCount, [&] (auto dof) {
+    CustomJointMaps<decltype(dof)::value> joint (custom_joint);
+
+    joint.u = Tau.segment (q_index, custom_joint.mDoFCount);
+    joint.u.noalias() -= joint.S.transpose() * pA;
+  });
+#endif
+}
+
+/** \brief Returns U Dinv u of a custom joint. */
+static SpatialVector CalcCustomJointUDinvu (CustomJoint &custom_joint) {
+#ifdef RBDL_USE_CASADI_MATH
+  return custom_joint.U * custom_joint.Dinv * custom_joint.u;
+#else
+  SpatialVector U_Dinv_u;
+
+  DispatchCustomJointDoF (custom_joint.mDoFCount, [&] (auto dof) {
+    typedef CustomJointMaps<decltype(dof)::value> Maps;
+    Maps joint (custom_joint);
+
+    typename Maps::VectorD Dinv_u;
+    Dinv_u.noalias() = joint.Dinv * joint.u;
+    U_Dinv_u.noalias() = joint.U * Dinv_u;
+  });
+
+  return U_Dinv_u;
+#endif
+}
+
+/** \brief Computes the accelerations of a custom joint from the
+ * acceleration a of its body without the joint acceleration and adds
+ * S qddot to a. */
+static void CalcCustomJointQDDot (
+    CustomJoint &custom_joint,
+    unsigned int q_index,
+    SpatialVector &a,
+    VectorNd &QDDot) {
+  unsigned int dof = custom_joint.mDoFCount;
+
+#ifdef RBDL_USE_CASADI_MATH
+  VectorNd qdd_temp = custom_joint.Dinv
+    * (custom_joint.u - custom_joint.U.transpose() * a);
+
+  for (unsigned int z = 0; z < dof; ++z) {
+    QDDot[q_index + z] = qdd_temp[z];
+  }
+
+  a = a + custom_joint.S * qdd_temp;
+#else
+  DispatchCustomJointDoF (dof, [&] (auto joint_dof) {
+    typedef CustomJointMaps<decltype(joint_dof)::value> Maps;
+    Maps joint (custom_joint);
+
+    typename Maps::VectorD u_a = joint.u;
+    u_a.noalias() -= joint.U.transpose() * a;
+
+    typename Maps::VectorD qdd;
+    qdd.noalias() = joint.Dinv * u_a;
+    QDDot.segment (q_index, dof) = qdd;
+    a.noalias() += joint.S * qdd;
+  });
+#endif
+}
+
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief Computes Model::free_flyer_IA_L from the articulated body
+ * inertia of the free-flyer root. */
+static void CalcFreeFlyerRootIALLT (Model &model) {
+  Eigen::LLT<Eigen::Matrix<double, 6, 6> > IA_llt (
+      model.IA[model.free_flyer_root_id]);
+
+  model.free_flyer_IA_L = IA_llt.matrixLLT();
+}
+
+/** \brief Computes the accelerations of the free-flyer root.
+ *
+ * The translational joint t and the spherical joint r of the root form a
+ * 6-DoF joint with motion subspace [S_r, X_r S_t] = diag(1, E). As there is
+ * no parent that takes up parts of the articulated body inertia, the
+ * acceleration of the root follows from IA a = f - pA with the joint force
+ * f = [tau_r; E (tau_t - S_t^T pA_t)]. The joint accelerations are then
+ * the components of a - X_r (X_t a_0 + c_t) - c_r.
+ */
+static void CalcFreeFlyerRootQDDot (
+    Model &model,
+    const VectorNd &Tau,
+    VectorNd &QDDot) {
+  unsigned int r = model.free_flyer_root_id;
+  unsigned int t = model.lambda[r];
+  unsigned int q_index_t = model.mJoints[t].q_index;
+  unsigned int q_index_r = model.mJoints[r].q_index;
+  const Matrix3d &E = model.X_lambda[r].E;
+
+  SpatialVector f;
+  f.block<3,1>(0,0) = Tau.segment<3>(q_index_r);
+  f.block<3,1>(3,0).noalias() = E * (Tau.segment<3>(q_index_t)
+      - model.pA[t].block<3,1>(3,0));
+  f -= model.pA[r];
+
+  model.free_flyer_IA_L.triangularView<Eigen::Lower>().solveInPlace (f);
+  model.free_flyer_IA_L.transpose().triangularView<Eigen::Upper>()
+    .solveInPlace (f);
+  model.a[r] = f;
+  model.a[t] = model.X_lambda[t].apply(model.a[model.lambda[t]])
+    + model.c[t];
+
+  SpatialVector a_J = model.a[r]
+    - model.X_lambda[r].apply(model.a[t])
+    - model.c[r];
+
+  QDDot.segment<3>(q_index_r) = a_J.block<3,1>(0,0);
+  QDDot.segment<3>(q_index_t).noalias() =
+    E.transpose() * a_J.block<3,1>(3,0);
+  model.a[t].block<3,1>(3,0) += QDDot.segment<3>(q_index_t);
+
+  LOG << "a[" << r << "] = " << model.a[r].transpose() << std::endl;
+}
+#endif
+
+#ifndef RBDL_USE_CASADI_MATH
+/** \brief ForwardDynamics() with the per-body quantities kept in
+ * Model::body_arena (see Model::use_body_arena). */
+static void ForwardDynamicsBodyArena (
+    Model &model,
+    const VectorNd &Q,
+    const VectorNd &QDot,
+    const VectorNd &Tau,
+    VectorNd &QDDot,
+    std::vector<SpatialVector> *f_ext) {
+  std::vector<ArticulatedBodyRecord> &records = model.body_arena;
+  unsigned int r = model.free_flyer_root_id;
+
+  records[0].v.setZero();
+  model.v[0].setZero();
+
+  for (unsigned int i = 1; i < model.mBodies.size(); i++) {
+    ArticulatedBodyRecord &body = records[i];
+    unsigned int lambda = model.lambda[i];
+
+    jcalc (model, i, Q, QDot);
+    body.X_lambda = model.X_lambda[i];
+
+    if (lambda != 0) {
+      model.X_base[i] = body.X_lambda * model.X_base[lambda];
+    } else {
+      model.X_base[i] = body.X_lambda;
+    }
+
+    body.v = body.X_lambda.apply (records[lambda].v) + model.v_J[i];
+    body.c = model.c_J[i] + crossm (body.v, model.v_J[i]);
+    model.I[i].setSpatialMatrix (body.IA);
+    body.pA = crossf (body.v, model.I[i] * body.v);
+
+    if (f_ext != NULL && (*f_ext)[i] != SpatialVector::Zero()) {
+      body.pA -= model.X_base[i].toMatrixAdjoint() * (*f_ext)[i];
+    }
+
+    model.v[i] = body.v;
+    model.c[i] = body.c;
+  }
+
+  for (unsigned int i = model.mBodies.size() - 1; i > r; i--) {
+    ArticulatedBodyRecord &body = records[i];
+    unsigned int q_index = model.mJoints[i].q_index;
+    unsigned int lambda = model.lambda[i];
+    SpatialMatrix Ia;
+    SpatialVector pa;
+
+    if (model.mJoints[i].mDoFCount == 1
+        && model.mJoints[i].mJointType != JointTypeCustom) {
+      body.U.noalias() = body.IA * model.S[i];
+      body.d = model.S[i].dot (body.U);
+      body.u = Tau[q_index] - model.S[i].dot (body.pA);
+
+      model.U[i] = body.U;
+      model.d[i] = body.d;
+      model.u[i] = body.u;
+
+      if (lambda != 0) {
+        Ia = body.IA;
+        Ia.noalias() -= body.U * (body.U / body.d).transpose();
+        pa = body.pA + body.U * (body.u / body.d);
+        pa.noalias() += Ia * body.c;
+      }
+    } else if (model.mJoints[i].mDoFCount == 3
+        && model.mJoints[i].mJointType != JointTypeCustom) {
+      model.multdof3_U[i].noalias() = body.IA * model.multdof3_S[i];
+      model.multdof3_Dinv[i] = (model.multdof3_S[i].transpose()
+          * model.multdof3_U[i]).inverse().eval();
+      model.multdof3_u[i] = Tau.segment<3>(q_index);
+      model.multdof3_u[i].noalias() -=
+        model.multdof3_S[i].transpose() * body.pA;
+
+      if (lambda != 0) {
+        Matrix63 U_Dinv = model.multdof3_U[i] * model.multdof3_Dinv[i];
+        Ia = body.IA;
+        Ia.noalias() -= U_Dinv * model.multdof3_U[i].transpose();
+        pa = body.pA;
+        pa.noalias() += U_Dinv * model.multdof3_u[i];
+        pa.noalias() += Ia * body.c;
       }
+    } else if (model.mJoints[i].mJointType == JointTypeCustom) {
+      CustomJoint &custom_joint =
+        *model.mCustomJoints[model.mJoints[i].custom_joint_index];
+
+      CalcCustomJointUDinv (body.IA, custom_joint);
+      CalcCustomJointBiasForce (Tau, q_index, body.pA, custom_joint);
+
+      if (lambda != 0) {
+        Ia = CalcCustomJointIa (body.IA, custom_joint);
+        pa = body.pA + CalcCustomJointUDinvu (custom_joint);
+        pa.noalias() += Ia * body.c;
+      }
+    }
+
+    if (lambda != 0) {
+      records[lambda].IA.noalias() += body.X_lambda.toMatrixTranspose()
+        * Ia * body.X_lambda.toMatrix();
+      records[lambda].pA.noalias() += body.X_lambda.applyTranspose (pa);
     }
   }
+
+  records[0].a.set (0., 0., 0.,
+      -model.gravity[0], -model.gravity[1], -model.gravity[2]);
+  model.a[0] = records[0].a;
+
+  // the root solve works on the model arrays
+  if (r != 0) {
+    unsigned int t = model.lambda[r];
+    model.IA[r] = records[r].IA;
+    model.pA[r] = records[r].pA;
+    model.pA[t] = records[t].pA;
+
+    CalcFreeFlyerRootIALLT (model);
+    CalcFreeFlyerRootQDDot (model, Tau, QDDot);
+
+    records[t].a = model.a[t];
+    records[r].a = model.a[r];
+  }
+
+  for (unsigned int i = r + 1; i < model.mBodies.size(); i++) {
+    ArticulatedBodyRecord &body = records[i];
+    unsigned int q_index = model.mJoints[i].q_index;
+
+    body.a = body.X_lambda.apply (records[model.lambda[i]].a) + body.c;
+
+    if (model.mJoints[i].mDoFCount == 1
+        && model.mJoints[i].mJointType != JointTypeCustom) {
+      QDDot[q_index] = (body.u - body.U.dot (body.a)) / body.d;
+      body.a += model.S[i] * QDDot[q_index];
+    } else if (model.mJoints[i].mDoFCount == 3
+        && model.mJoints[i].mJointType != JointTypeCustom) {
+      Vector3d u_a = model.multdof3_u[i];
+      u_a.noalias() -= model.multdof3_U[i].transpose() * body.a;
+      Vector3d qdd = model.multdof3_Dinv[i] * u_a;
+      QDDot.segment<3>(q_index) = qdd;
+      body.a.noalias() += model.multdof3_S[i] * qdd;
+    } else if (model.mJoints[i].mJointType == JointTypeCustom) {
+      CalcCustomJointQDDot (
+          *model.mCustomJoints[model.mJoints[i].custom_joint_index],
+          q_index, body.a, QDDot);
+    }
+
+    model.a[i] = body.a;
+  }
 }
+#endif
 
 RBDL_DLLAPI void ForwardDynamics (
     Model &model,
@@ -335,6 +1011,13 @@ RBDL_DLLAPI void ForwardDynamics (
   LOG << "Tau        = " << Tau.transpose() << std::endl;
   LOG << "---" << std::endl;
 
+#ifndef RBDL_USE_CASADI_MATH
+  if (model.use_body_arena) {
+    ForwardDynamicsBodyArena (model, Q, QDot, Tau, QDDot, f_ext);
+    return;
+  }
+#endif
+
   // Reset the velocity of the root body
   model.v[0].setZero();
 
@@ -377,7 +1060,7 @@ RBDL_DLLAPI void ForwardDynamics (
 
   LOG << "--- first loop ---" << std::endl;
 
-  for (i = model.mBodies.size() - 1; i > 0; i--) {
+  for (i = model.mBodies.size() - 1; i > model.free_flyer_root_id; i--) {
     unsigned int q_index = model.mJoints[i].q_index;
 
     if (model.mJoints[i].mDoFCount == 1
@@ -465,37 +1148,18 @@ RBDL_DLLAPI void ForwardDynamics (
           << std::endl;
       }
     } else if (model.mJoints[i].mJointType == JointTypeCustom) {
-      unsigned int kI   = model.mJoints[i].custom_joint_index;
-      unsigned int dofI = model.mCustomJoints[kI]->mDoFCount;
-      model.mCustomJoints[kI]->U =
-        model.IA[i] * model.mCustomJoints[kI]->S;
+      unsigned int kI = model.mJoints[i].custom_joint_index;
+      CustomJoint &custom_joint = *model.mCustomJoints[kI];
 
-#ifdef RBDL_USE_CASADI_MATH
-      model.mCustomJoints[kI]->Dinv
-        = (model.mCustomJoints[kI]->S.transpose()
-            * model.mCustomJoints[kI]->U).inverse();
-#else
-      model.mCustomJoints[kI]->Dinv
-        = (model.mCustomJoints[kI]->S.transpose()
-            * model.mCustomJoints[kI]->U).inverse().eval();
-#endif
-      VectorNd tau_temp(Tau.block(q_index,0,dofI,1));
-      model.mCustomJoints[kI]->u = tau_temp
-        - model.mCustomJoints[kI]->S.transpose() * model.pA[i];
+      CalcCustomJointUDinv (model.IA[i], custom_joint);
+      CalcCustomJointBiasForce (Tau, q_index, model.pA[i], custom_joint);
 
-      //      LOG << "multdof3_u[" << i << "] = " 
-      //      << model.multdof3_u[i].transpose() << std::endl;
       unsigned int lambda = model.lambda[i];
       if (lambda != 0) {
-        SpatialMatrix Ia = model.IA[i]
-          - (model.mCustomJoints[kI]->U
-              * model.mCustomJoints[kI]->Dinv
-              * model.mCustomJoints[kI]->U.transpose());
-        SpatialVector pa =  model.pA[i] 
+        SpatialMatrix Ia = CalcCustomJointIa (model.IA[i], custom_joint);
+        SpatialVector pa =  model.pA[i]
           + Ia * model.c[i]
-          + (model.mCustomJoints[kI]->U
-              * model.mCustomJoints[kI]->Dinv
-              * model.mCustomJoints[kI]->u);
+          + CalcCustomJointUDinvu (custom_joint);
 
 #ifdef RBDL_USE_CASADI_MATH
         model.IA[lambda] += model.X_lambda[i].toMatrixTranspose()
@@ -515,11 +1179,23 @@ RBDL_DLLAPI void ForwardDynamics (
     }
   }
 
+#ifndef RBDL_USE_CASADI_MATH
+  if (model.free_flyer_root_id != 0) {
+    CalcFreeFlyerRootIALLT (model);
+  }
+#endif
+
   //  ClearLogOutput();
 
   model.a[0] = spatial_gravity * -1.;
 
-  for (i = 1; i < model.mBodies.size(); i++) {
+#ifndef RBDL_USE_CASADI_MATH
+  if (model.free_flyer_root_id != 0) {
+    CalcFreeFlyerRootQDDot (model, Tau, QDDot);
+  }
+#endif
+
+  for (i = model.free_flyer_root_id + 1; i < model.mBodies.size(); i++) {
     unsigned int q_index = model.mJoints[i].q_index;
     unsigned int lambda = model.lambda[i];
     SpatialTransform X_lambda = model.X_lambda[i];
@@ -540,20 +1216,9 @@ RBDL_DLLAPI void ForwardDynamics (
       model.a[i] = model.a[i] + model.multdof3_S[i] * qdd_temp;
     } else if (model.mJoints[i].mJointType == JointTypeCustom) {
       unsigned int kI = model.mJoints[i].custom_joint_index;
-      unsigned int dofI=model.mCustomJoints[kI]->mDoFCount;
-
-      VectorNd qdd_temp = model.mCustomJoints[kI]->Dinv
-        * (  model.mCustomJoints[kI]->u
-            - model.mCustomJoints[kI]->U.transpose()
-            * model.a[i]);
-
-      for(int z=0; z<dofI; ++z){
-        QDDot[q_index+z] = qdd_temp[z];
-      }
-
-      model.a[i] = model.a[i]
-        + model.mCustomJoints[kI]->S * qdd_temp;
-    } 
+      CalcCustomJointQDDot (*model.mCustomJoints[kI], q_index, model.a[i],
+          QDDot);
+    }
   }
 
   LOG << "QDDot = " << QDDot.transpose() << std::endl;
@@ -610,6 +1275,12 @@ RBDL_DLLAPI void ForwardDynamicsLagrangian (
     case (LinearSolverLLT) :
       QDDot = H->llt().solve (*C * -1. + Tau);
       break;
+    case (LinearSolverLDLT) :
+      QDDot = H->ldlt().solve (*C * -1. + Tau);
+      break;
+    case (LinearSolverMixedPrecisionLU) :
+      SolveLinearSystemMixedPrecision (*H, *C * -1. + Tau, QDDot);
+      break;
     default:
       LOG << "Error: Invalid linear solver: " << linear_solver << std::endl;
       assert (0);
@@ -628,6 +1299,98 @@ RBDL_DLLAPI void ForwardDynamicsLagrangian (
   LOG << "x = " << QDDot << std::endl;
 }
 
+/** \brief Computes the articulated body inertias and the joint space
+ * quantities U and D of the Articulated Body Algorithm without any bias
+ * forces. Expects model.IA to be initialized with the body inertias.
+ *
+ * For a free-flyer root only Model::free_flyer_IA_L is computed.
+ */
+static void CalcArticulatedBodyInertias (Model &model) {
+  for (unsigned int i = model.mBodies.size() - 1;
+      i > model.free_flyer_root_id; i--) {
+    if (model.mJoints[i].mDoFCount == 1
+        && model.mJoints[i].mJointType != JointTypeCustom) {
+      model.U[i] = model.IA[i] * model.S[i];
+      model.d[i] = model.S[i].dot(model.U[i]);
+      //      LOG << "u[" << i << "] = " << model.u[i] << std::endl;
+      unsigned int lambda = model.lambda[i];
+
+      if (lambda != 0) {
+        SpatialMatrix Ia = model.IA[i] - 
+          model.U[i] * (model.U[i] / model.d[i]).transpose();
+
+#ifdef RBDL_USE_CASADI_MATH
+        model.IA[lambda] += model.X_lambda[i].toMatrixTranspose()
+          * Ia
+          * model.X_lambda[i].toMatrix();
+#else
+        model.IA[lambda].noalias() += model.X_lambda[i].toMatrixTranspose()
+          * Ia
+          * model.X_lambda[i].toMatrix();
+#endif
+      }
+    } else if (model.mJoints[i].mDoFCount == 3
+        && model.mJoints[i].mJointType != JointTypeCustom) {
+
+      model.multdof3_U[i] = model.IA[i] * model.multdof3_S[i];
+
+#ifdef RBDL_USE_CASADI_MATH
+      model.multdof3_Dinv[i] = 
+        (model.multdof3_S[i].transpose() * model.multdof3_U[i]).inverse();
+#else
+      model.multdof3_Dinv[i] = 
+        (model.multdof3_S[i].transpose()*model.multdof3_U[i]).inverse().eval();
+#endif
+      //      LOG << "mCustomJoints[kI]->u[" << i << "] = "
+      //<< model.mCustomJoints[kI]->u[i].transpose() << std::endl;
+
+      unsigned int lambda = model.lambda[i];
+
+      if (lambda != 0) {
+        SpatialMatrix Ia = model.IA[i]
+          - ( model.multdof3_U[i]
+              * model.multdof3_Dinv[i]
+              * model.multdof3_U[i].transpose());
+
+#ifdef RBDL_USE_CASADI_MATH
+        model.IA[lambda] +=
+          model.X_lambda[i].toMatrixTranspose()
+          * Ia * model.X_lambda[i].toMatrix();
+#else
+        model.IA[lambda].noalias() +=
+          model.X_lambda[i].toMatrixTranspose()
+          * Ia
+          * model.X_lambda[i].toMatrix();
+#endif
+      }
+    } else if (model.mJoints[i].mJointType == JointTypeCustom) {
+      unsigned int kI = model.mJoints[i].custom_joint_index;
+      CalcCustomJointUDinv (model.IA[i], *model.mCustomJoints[kI]);
+
+      unsigned int lambda = model.lambda[i];
+
+      if (lambda != 0) {
+        SpatialMatrix Ia = CalcCustomJointIa (model.IA[i],
+            *model.mCustomJoints[kI]);
+#ifdef RBDL_USE_CASADI_MATH
+        model.IA[lambda] += model.X_lambda[i].toMatrixTranspose()
+          * Ia * model.X_lambda[i].toMatrix();
+#else
+        model.IA[lambda].noalias() += model.X_lambda[i].toMatrixTranspose()
+          * Ia
+          * model.X_lambda[i].toMatrix();
+#endif
+      }
+    }
+  }
+
+#ifndef RBDL_USE_CASADI_MATH
+  if (model.free_flyer_root_id != 0) {
+    CalcFreeFlyerRootIALLT (model);
+  }
+#endif
+}
+
 RBDL_DLLAPI void CalcMInvTimesTau ( Model &model,
     const VectorNd &Q,
     const VectorNd &Tau,
@@ -660,103 +1423,12 @@ RBDL_DLLAPI void CalcMInvTimesTau ( Model &model,
   // ClearLogOutput();
 
   if (update_kinematics) {
-    // Compute Articulate Body Inertias
-    for (unsigned int i = model.mBodies.size() - 1; i > 0; i--) {
-      unsigned int q_index = model.mJoints[i].q_index;
-
-      if (model.mJoints[i].mDoFCount == 1
-          && model.mJoints[i].mJointType != JointTypeCustom) {
-        model.U[i] = model.IA[i] * model.S[i];
-        model.d[i] = model.S[i].dot(model.U[i]);
-        //      LOG << "u[" << i << "] = " << model.u[i] << std::endl;
-        unsigned int lambda = model.lambda[i];
-
-        if (lambda != 0) {
-          SpatialMatrix Ia = model.IA[i] - 
-            model.U[i] * (model.U[i] / model.d[i]).transpose();
-
-#ifdef RBDL_USE_CASADI_MATH
-          model.IA[lambda] += model.X_lambda[i].toMatrixTranspose()
-            * Ia
-            * model.X_lambda[i].toMatrix();
-#else
-          model.IA[lambda].noalias() += model.X_lambda[i].toMatrixTranspose()
-            * Ia
-            * model.X_lambda[i].toMatrix();
-#endif
-        }
-      } else if (model.mJoints[i].mDoFCount == 3
-          && model.mJoints[i].mJointType != JointTypeCustom) {
-
-        model.multdof3_U[i] = model.IA[i] * model.multdof3_S[i];
-
-#ifdef RBDL_USE_CASADI_MATH
-        model.multdof3_Dinv[i] = 
-          (model.multdof3_S[i].transpose() * model.multdof3_U[i]).inverse();
-#else
-        model.multdof3_Dinv[i] = 
-          (model.multdof3_S[i].transpose()*model.multdof3_U[i]).inverse().eval();
-#endif
-        //      LOG << "mCustomJoints[kI]->u[" << i << "] = "
-        //<< model.mCustomJoints[kI]->u[i].transpose() << std::endl;
-
-        unsigned int lambda = model.lambda[i];
-
-        if (lambda != 0) {
-          SpatialMatrix Ia = model.IA[i]
-            - ( model.multdof3_U[i]
-                * model.multdof3_Dinv[i]
-                * model.multdof3_U[i].transpose());
-
-#ifdef RBDL_USE_CASADI_MATH
-          model.IA[lambda] +=
-            model.X_lambda[i].toMatrixTranspose()
-            * Ia * model.X_lambda[i].toMatrix();
-#else
-          model.IA[lambda].noalias() +=
-            model.X_lambda[i].toMatrixTranspose()
-            * Ia
-            * model.X_lambda[i].toMatrix();
-#endif
-        }
-      } else if (model.mJoints[i].mJointType == JointTypeCustom) {
-        unsigned int kI     = model.mJoints[i].custom_joint_index;
-        unsigned int dofI   = model.mCustomJoints[kI]->mDoFCount;
-        model.mCustomJoints[kI]->U = model.IA[i] * model.mCustomJoints[kI]->S;
-
-#ifdef RBDL_USE_CASADI_MATH
-        model.mCustomJoints[kI]->Dinv=(model.mCustomJoints[kI]->S.transpose()
-            * model.mCustomJoints[kI]->U
-            ).inverse();
-#else
-        model.mCustomJoints[kI]->Dinv = (model.mCustomJoints[kI]->S.transpose()
-            * model.mCustomJoints[kI]->U
-            ).inverse().eval();
-#endif
-        //      LOG << "mCustomJoints[kI]->u[" << i << "] = "
-        //<< model.mCustomJoints[kI]->u.transpose() << std::endl;
-        unsigned int lambda = model.lambda[i];
-
-        if (lambda != 0) {
-          SpatialMatrix Ia = model.IA[i] 
-            - ( model.mCustomJoints[kI]->U
-                * model.mCustomJoints[kI]->Dinv
-                * model.mCustomJoints[kI]->U.transpose());
-#ifdef RBDL_USE_CASADI_MATH
-          model.IA[lambda] += model.X_lambda[i].toMatrixTranspose()
-            * Ia * model.X_lambda[i].toMatrix();
-#else
-          model.IA[lambda].noalias() += model.X_lambda[i].toMatrixTranspose()
-            * Ia
-            * model.X_lambda[i].toMatrix();
-#endif
-        }
-      }
-    }
+    CalcArticulatedBodyInertias (model);
   }
 
   // compute articulated bias forces
-  for (unsigned int i = model.mBodies.size() - 1; i > 0; i--) {
+  for (unsigned int i = model.mBodies.size() - 1;
+      i > model.free_flyer_root_id; i--) {
     unsigned int q_index = model.mJoints[i].q_index;
 
     if (model.mJoints[i].mDoFCount == 1
@@ -804,21 +1476,15 @@ RBDL_DLLAPI void CalcMInvTimesTau ( Model &model,
           << model.pA[lambda].transpose() << std::endl;
       }
     } else if (model.mJoints[i].mJointType == JointTypeCustom) {
-      unsigned int kI     = model.mJoints[i].custom_joint_index;
-      unsigned int dofI   = model.mCustomJoints[kI]->mDoFCount;
-      VectorNd tau_temp(Tau.block(q_index,0,dofI,1));
-
-      model.mCustomJoints[kI]->u = 
-        tau_temp - ( model.mCustomJoints[kI]->S.transpose()* model.pA[i]);
-      //      LOG << "mCustomJoints[kI]->u"
-      // << model.mCustomJoints[kI]->u.transpose() << std::endl;
+      unsigned int kI = model.mJoints[i].custom_joint_index;
+      CalcCustomJointBiasForce (Tau, q_index, model.pA[i],
+          *model.mCustomJoints[kI]);
+
       unsigned int lambda = model.lambda[i];
 
       if (lambda != 0) {
         SpatialVector pa = model.pA[i]
-          + (   model.mCustomJoints[kI]->U
-              * model.mCustomJoints[kI]->Dinv
-              * model.mCustomJoints[kI]->u);
+          + CalcCustomJointUDinvu (*model.mCustomJoints[kI]);
 
 #ifdef RBDL_USE_CASADI_MATH
         model.pA[lambda] += model.X_lambda[i].applyTranspose(pa);
@@ -834,7 +1500,14 @@ RBDL_DLLAPI void CalcMInvTimesTau ( Model &model,
 
   //  ClearLogOutput();
 
-  for (unsigned int i = 1; i < model.mBodies.size(); i++) {
+#ifndef RBDL_USE_CASADI_MATH
+  if (model.free_flyer_root_id != 0) {
+    CalcFreeFlyerRootQDDot (model, Tau, QDDot);
+  }
+#endif
+
+  for (unsigned int i = model.free_flyer_root_id + 1;
+      i < model.mBodies.size(); i++) {
     unsigned int q_index = model.mJoints[i].q_index;
     unsigned int lambda = model.lambda[i];
     SpatialTransform X_lambda = model.X_lambda[i];
@@ -857,23 +1530,251 @@ RBDL_DLLAPI void CalcMInvTimesTau ( Model &model,
       QDDot[q_index + 2]  = qdd_temp[2];
       model.a[i]          = model.a[i] + model.multdof3_S[i] * qdd_temp;
     } else if (model.mJoints[i].mJointType == JointTypeCustom) {
-      unsigned int kI     = model.mJoints[i].custom_joint_index;
-      unsigned int dofI   = model.mCustomJoints[kI]->mDoFCount;
+      unsigned int kI = model.mJoints[i].custom_joint_index;
+      CalcCustomJointQDDot (*model.mCustomJoints[kI], q_index, model.a[i],
+          QDDot);
+    }
+  }
+
+  LOG << "QDDot = " << QDDot.transpose() << std::endl;
+}
+
+OperationalSpaceTaskSet::OperationalSpaceTaskSet() {
+}
+
+unsigned int OperationalSpaceTaskSet::AddRow (
+    unsigned int body_id,
+    const Vector3d &body_point,
+    const SpatialVector &axis) {
+  body_ids.push_back (body_id);
+  body_points.push_back (body_point);
+  axes.push_back (axis);
+
+  return body_ids.size() - 1;
+}
+
+unsigned int OperationalSpaceTaskSet::AddPointTask (
+    unsigned int body_id,
+    const Vector3d &body_point) {
+  unsigned int index = AddRow (body_id, body_point,
+      SpatialVector (0., 0., 0., 1., 0., 0.));
+  AddRow (body_id, body_point, SpatialVector (0., 0., 0., 0., 1., 0.));
+  AddRow (body_id, body_point, SpatialVector (0., 0., 0., 0., 0., 1.));
+
+  return index;
+}
+
+unsigned int OperationalSpaceTaskSet::AddPointTask6D (
+    unsigned int body_id,
+    const Vector3d &body_point) {
+  unsigned int index = AddRow (body_id, body_point,
+      SpatialVector (1., 0., 0., 0., 0., 0.));
+  AddRow (body_id, body_point, SpatialVector (0., 1., 0., 0., 0., 0.));
+  AddRow (body_id, body_point, SpatialVector (0., 0., 1., 0., 0., 0.));
+  AddRow (body_id, body_point, SpatialVector (0., 0., 0., 1., 0., 0.));
+  AddRow (body_id, body_point, SpatialVector (0., 0., 0., 0., 1., 0.));
+  AddRow (body_id, body_point, SpatialVector (0., 0., 0., 0., 0., 1.));
+
+  return index;
+}
+
+void OperationalSpaceTaskSet::clear () {
+  body_ids.clear();
+  body_points.clear();
+  axes.clear();
+  movable_body_ids.clear();
+}
+
+RBDL_DLLAPI void CalcDelassus (
+    Model &model,
+    const VectorNd &Q,
+    OperationalSpaceTaskSet &tasks,
+    MatrixNd &Delassus,
+    bool update_kinematics) {
+  LOG << "-------- " << __func__ << " --------" << std::endl;
+
+  const unsigned int m = tasks.size();
+
+  if (tasks.Y.rows() != model.dof_count || tasks.Y.cols() != m) {
+    tasks.Y.resize (model.dof_count, m);
+  }
+  if (tasks.movable_body_ids.size() != m) {
+    tasks.movable_body_ids.resize (m);
+  }
+  if (Delassus.rows() != m || Delassus.cols() != m) {
+    Delassus.resize (m, m);
+  }
 
-      VectorNd qdd_temp = model.mCustomJoints[kI]->Dinv
-        * (  model.mCustomJoints[kI]->u 
-            - model.mCustomJoints[kI]->U.transpose() * model.a[i]);
+  if (update_kinematics) {
+    UpdateKinematicsCustom (model, &Q, NULL, NULL);
 
-      for(unsigned z = 0; z < dofI; ++z){
-        QDDot[q_index+z]      = qdd_temp[z];
+    // zero bias accelerations so that CalcMInvTimesTau() can reuse the
+    // articulated body inertias without updating the kinematics
+    for (unsigned int i = 1; i < model.mBodies.size(); i++) {
+      model.c[i].setZero();
+      model.I[i].setSpatialMatrix (model.IA[i]);
+    }
+
+    CalcArticulatedBodyInertias (model);
+  }
+
+  // propagate the test force of every row to the root as the bias forces
+  // of the Articulated Body Algorithm: at each supporting joint i the
+  // projection S_i^T phi is stored and the force that is transmitted to
+  // the parent is X^T (phi - U_i D_i^-1 S_i^T phi)
+  for (unsigned int r = 0; r < m; r++) {
+    unsigned int body_id = tasks.body_ids[r];
+    unsigned int movable_body_id = body_id;
+
+    if (model.IsFixedBodyId (body_id)) {
+      unsigned int fbody_id = body_id - model.fixed_body_discriminator;
+      movable_body_id = model.mFixedBodies[fbody_id].mMovableParent;
+    }
+    tasks.movable_body_ids[r] = movable_body_id;
+
+    Vector3d point_base = CalcBodyToBaseCoordinates (model, Q, body_id,
+        tasks.body_points[r], false);
+    SpatialVector phi = model.X_base[movable_body_id].applyAdjoint (
+        Xtrans (point_base).applyTranspose (tasks.axes[r]));
+
+    unsigned int i = movable_body_id;
+
+    while (i != 0) {
+      unsigned int q_index = model.mJoints[i].q_index;
+
+#ifndef RBDL_USE_CASADI_MATH
+      // the free-flyer root keeps the full test force, its rows of Y are
+      // L^-1 phi split into [lin; ang] with L = Model::free_flyer_IA_L
+      if (i == model.free_flyer_root_id) {
+        unsigned int q_index_t = model.mJoints[model.lambda[i]].q_index;
+        model.free_flyer_IA_L.triangularView<Eigen::Lower>()
+          .solveInPlace (phi);
+        tasks.Y.block<3,1>(q_index_t, r) = phi.block<3,1>(3,0);
+        tasks.Y.block<3,1>(q_index, r) = phi.block<3,1>(0,0);
+        break;
       }
+#endif
 
-      model.a[i] =    model.a[i]
-        + model.mCustomJoints[kI]->S * qdd_temp;
+      if (model.mJoints[i].mDoFCount == 1
+          && model.mJoints[i].mJointType != JointTypeCustom) {
+        Scalar y = model.S[i].dot (phi);
+        tasks.Y(q_index, r) = y;
+        phi -= model.U[i] * (y / model.d[i]);
+      } else if (model.mJoints[i].mDoFCount == 3
+          && model.mJoints[i].mJointType != JointTypeCustom) {
+        Vector3d y = model.multdof3_S[i].transpose() * phi;
+        tasks.Y.block<3,1>(q_index, r) = y;
+        phi -= model.multdof3_U[i] * (model.multdof3_Dinv[i] * y);
+      } else if (model.mJoints[i].mJointType == JointTypeCustom) {
+        unsigned int kI = model.mJoints[i].custom_joint_index;
+        unsigned int dofI = model.mCustomJoints[kI]->mDoFCount;
+#ifdef RBDL_USE_CASADI_MATH
+        tasks.Y.block(q_index, r, dofI, 1) =
+          model.mCustomJoints[kI]->S.transpose() * phi;
+        phi -= model.mCustomJoints[kI]->U
+          * (model.mCustomJoints[kI]->Dinv * tasks.Y.block(q_index, r, dofI, 1));
+#else
+        DispatchCustomJointDoF (dofI, [&] (auto dof) {
+          typedef CustomJointMaps<decltype(dof)::value> Maps;
+          Maps joint (*model.mCustomJoints[kI]);
+
+          typename Maps::VectorD y = joint.S.transpose() * phi;
+          typename Maps::VectorD Dinv_y = joint.Dinv * y;
+          tasks.Y.block(q_index, r, dofI, 1) = y;
+          phi.noalias() -= joint.U * Dinv_y;
+        });
+#endif
+      }
+
+      phi = model.X_lambda[i].applyTranspose (phi);
+      i = model.lambda[i];
     }
   }
 
-  LOG << "QDDot = " << QDDot.transpose() << std::endl;
+  // J M^-1 J^T = Y^T D^-1 Y where rows r and s only share the joints that
+  // support both of their bodies, i.e. the path from their nearest common
+  // ancestor to the root (parents always have smaller ids than children).
+  for (unsigned int r = 0; r < m; r++) {
+    for (unsigned int s = 0; s <= r; s++) {
+      unsigned int j = tasks.movable_body_ids[r];
+      unsigned int k = tasks.movable_body_ids[s];
+
+      while (j != k) {
+        if (j > k) {
+          j = model.lambda[j];
+        } else {
+          k = model.lambda[k];
+        }
+      }
+
+      Scalar value = 0.;
+
+      while (j != 0) {
+        unsigned int q_index = model.mJoints[j].q_index;
+
+#ifndef RBDL_USE_CASADI_MATH
+        if (j == model.free_flyer_root_id) {
+          unsigned int q_index_t = model.mJoints[model.lambda[j]].q_index;
+          SpatialVector phi_r, phi_s;
+          phi_r << tasks.Y.block<3,1>(q_index, r),
+                tasks.Y.block<3,1>(q_index_t, r);
+          phi_s << tasks.Y.block<3,1>(q_index, s),
+                tasks.Y.block<3,1>(q_index_t, s);
+          value += phi_r.dot (phi_s);
+          break;
+        }
+#endif
+
+        if (model.mJoints[j].mDoFCount == 1
+            && model.mJoints[j].mJointType != JointTypeCustom) {
+          value += tasks.Y(q_index, r) * tasks.Y(q_index, s) / model.d[j];
+        } else if (model.mJoints[j].mDoFCount == 3
+            && model.mJoints[j].mJointType != JointTypeCustom) {
+          value += tasks.Y.block<3,1>(q_index, r).dot (
+              model.multdof3_Dinv[j] * tasks.Y.block<3,1>(q_index, s));
+        } else if (model.mJoints[j].mJointType == JointTypeCustom) {
+          unsigned int kI = model.mJoints[j].custom_joint_index;
+          unsigned int dofI = model.mCustomJoints[kI]->mDoFCount;
+#ifdef RBDL_USE_CASADI_MATH
+          value += tasks.Y.col(r).segment(q_index, dofI).dot (
+              model.mCustomJoints[kI]->Dinv
+              * tasks.Y.col(s).segment(q_index, dofI));
+#else
+          DispatchCustomJointDoF (dofI, [&] (auto dof) {
+            typedef CustomJointMaps<decltype(dof)::value> Maps;
+            Maps joint (*model.mCustomJoints[kI]);
+
+            typename Maps::VectorD Dinv_y =
+              joint.Dinv * tasks.Y.col(s).segment(q_index, dofI);
+            value += tasks.Y.col(r).segment(q_index, dofI).dot (Dinv_y);
+          });
+#endif
+        }
+
+        j = model.lambda[j];
+      }
+
+      Delassus(r, s) = value;
+      Delassus(s, r) = value;
+    }
+  }
+}
+
+#ifndef RBDL_USE_CASADI_MATH
+RBDL_DLLAPI void CalcOperationalSpaceInertia (
+    Model &model,
+    const VectorNd &Q,
+    OperationalSpaceTaskSet &tasks,
+    MatrixNd &Lambda,
+    bool update_kinematics) {
+  LOG << "-------- " << __func__ << " --------" << std::endl;
+
+  CalcDelassus (model, Q, tasks, Lambda, update_kinematics);
+
+  tasks.delassus_llt.compute (Lambda);
+  Lambda.setIdentity();
+  tasks.delassus_llt.solveInPlace (Lambda);
 }
+#endif
 
 } /* namespace RigidBodyDynamics */
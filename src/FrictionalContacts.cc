@@ -0,0 +1,298 @@
+/*
+ * RBDL - Rigid Body Dynamics Library
+ * Copyright (c) 2011-2018 Martin Felis <martin@fysx.org>
+ *
+ * Licensed under the zlib license. See LICENSE for more details.
+ */
+
+#include <iostream>
+#include <limits>
+#include <assert.h>
+
+#include "rbdl/rbdl_mathutils.h"
+#include "rbdl/Logging.h"
+
+#include "rbdl/Model.h"
+#include "rbdl/Dynamics.h"
+#include "rbdl/Kinematics.h"
+#include "rbdl/FrictionalContacts.h"
+#include "rbdl/rbdl_errors.h"
+
+#ifndef RBDL_USE_CASADI_MATH
+
+namespace RigidBodyDynamics {
+
+using namespace Math;
+
+FrictionalContactSet::FrictionalContactSet() :
+  friction_model (FrictionModelCone),
+  max_iterations (100),
+  tolerance (1.0e-10),
+  warm_start (true),
+  num_iterations (0),
+  residual (0.),
+  bound (false) {
+}
+
+unsigned int FrictionalContactSet::AddContact (
+    unsigned int body_id,
+    const Vector3d &body_point,
+    const Vector3d &normal,
+    double friction_coefficient,
+    double restitution_coefficient) {
+  assert (bound == false);
+
+  if (friction_coefficient < 0.) {
+    throw Errors::RBDLInvalidParameterError (
+        "Error: the friction coefficient of a contact must not be negative!\n");
+  }
+
+  body_ids.push_back (body_id);
+  body_points.push_back (body_point);
+  normals.push_back (Vector3d::Zero());
+  tangents1.push_back (Vector3d::Zero());
+  tangents2.push_back (Vector3d::Zero());
+  friction_coefficients.push_back (friction_coefficient);
+  restitution_coefficients.push_back (restitution_coefficient);
+  active.push_back (true);
+  normal_velocity_bias.push_back (0.);
+
+  unsigned int contact_index = body_ids.size() - 1;
+  SetContactNormal (contact_index, normal);
+
+  // normal, first and second tangent, see SolveFrictionalContactImpulses()
+  for (unsigned int j = 0; j < 3; j++) {
+    tasks.AddRow (body_id, body_point, SpatialVector::Zero());
+  }
+
+  return contact_index;
+}
+
+void FrictionalContactSet::SetContactNormal (
+    unsigned int contact_index,
+    const Vector3d &normal) {
+  assert (contact_index < size());
+
+  Vector3d n = normal.normalized();
+
+  // construct the first tangent from the base axis that is the least
+  // aligned with the normal
+  unsigned int axis_index = 0;
+  n.cwiseAbs().minCoeff (&axis_index);
+  Vector3d axis = Vector3d::Zero();
+  axis[axis_index] = 1.;
+
+  Vector3d t1 = axis - n * n.dot (axis);
+  t1.normalize();
+
+  normals[contact_index] = n;
+  tangents1[contact_index] = t1;
+  tangents2[contact_index] = n.cross (t1);
+}
+
+bool FrictionalContactSet::Bind (const Model &model) {
+  assert (bound == false);
+
+  if (bound) {
+    throw Errors::RBDLError(
+        "Error: binding an already bound frictional contact set!\n");
+  }
+
+  unsigned int n_rows = 3 * size();
+
+  impulses = VectorNd::Zero (n_rows);
+  W = MatrixNd::Zero (n_rows, n_rows);
+  J = MatrixNd::Zero (n_rows, model.qdot_size);
+  G = MatrixNd::Zero (3, model.qdot_size);
+  velocity = VectorNd::Zero (n_rows);
+  target_velocity = VectorNd::Zero (size());
+  generalized_impulse = VectorNd::Zero (model.qdot_size);
+  qdot_delta = VectorNd::Zero (model.qdot_size);
+
+  tasks.movable_body_ids.resize (n_rows);
+  tasks.Y = MatrixNd::Zero (model.qdot_size, n_rows);
+
+  num_iterations = 0;
+  residual = 0.;
+
+  bound = true;
+
+  return bound;
+}
+
+void FrictionalContactSet::clear () {
+  body_ids.clear();
+  body_points.clear();
+  normals.clear();
+  tangents1.clear();
+  tangents2.clear();
+  friction_coefficients.clear();
+  restitution_coefficients.clear();
+  active.clear();
+  normal_velocity_bias.clear();
+  tasks.clear();
+
+  impulses.resize (0);
+  num_iterations = 0;
+  residual = 0.;
+
+  bound = false;
+}
+
+RBDL_DLLAPI void SolveFrictionalContactImpulses (
+    Model &model,
+    const VectorNd &Q,
+    const VectorNd &QDotMinus,
+    FrictionalContactSet &CS,
+    VectorNd &QDotPlus,
+    bool update_kinematics) {
+  LOG << "-------- " << __func__ << " --------" << std::endl;
+
+  assert (CS.bound);
+
+  unsigned int n_contacts = CS.size();
+  bool any_active = false;
+
+  for (unsigned int i = 0; i < n_contacts; i++) {
+    if (CS.active[i]) {
+      any_active = true;
+    } else {
+      CS.impulses.segment<3>(3 * i).setZero();
+    }
+  }
+
+  CS.num_iterations = 0;
+  CS.residual = 0.;
+
+  if (!any_active) {
+    CS.impulses.setZero();
+    QDotPlus = QDotMinus;
+    return;
+  }
+
+  if (!CS.warm_start) {
+    CS.impulses.setZero();
+  }
+
+  // contact frames: normal, first and second tangent in base coordinates
+  for (unsigned int i = 0; i < n_contacts; i++) {
+    for (unsigned int j = 0; j < 3; j++) {
+      CS.tasks.body_points[3 * i + j] = CS.body_points[i];
+    }
+    CS.tasks.axes[3 * i].set (0., 0., 0.,
+        CS.normals[i][0], CS.normals[i][1], CS.normals[i][2]);
+    CS.tasks.axes[3 * i + 1].set (0., 0., 0.,
+        CS.tangents1[i][0], CS.tangents1[i][1], CS.tangents1[i][2]);
+    CS.tasks.axes[3 * i + 2].set (0., 0., 0.,
+        CS.tangents2[i][0], CS.tangents2[i][1], CS.tangents2[i][2]);
+  }
+
+  CalcDelassus (model, Q, CS.tasks, CS.W, update_kinematics);
+
+  for (unsigned int i = 0; i < n_contacts; i++) {
+    unsigned int k = 3 * i;
+
+    CS.G.setZero();
+    CalcPointJacobian (model, Q, CS.body_ids[i], CS.body_points[i], CS.G,
+        false);
+    CS.J.row(k).noalias() = CS.normals[i].transpose() * CS.G;
+    CS.J.row(k + 1).noalias() = CS.tangents1[i].transpose() * CS.G;
+    CS.J.row(k + 2).noalias() = CS.tangents2[i].transpose() * CS.G;
+
+    // contacts that cannot be moved (e.g. on bodies fixed to the base) are
+    // skipped below and must not keep the impulses of a warm start
+    if (CS.W(k, k) <= 0.) {
+      CS.impulses.segment<3>(k).setZero();
+    }
+  }
+
+  CS.velocity.noalias() = CS.J * QDotMinus;
+
+  for (unsigned int i = 0; i < n_contacts; i++) {
+    CS.target_velocity[i] = CS.normal_velocity_bias[i]
+      - CS.restitution_coefficients[i] * std::min (CS.velocity[3 * i], 0.);
+  }
+
+  // projected Gauss-Seidel: the contact velocities v = W lambda + c are
+  // evaluated with the impulses of the current sweep. W is symmetric so
+  // that its (contiguous) columns are used instead of its rows.
+  for (unsigned int iter = 0; iter < CS.max_iterations; iter++) {
+    CS.residual = 0.;
+
+    for (unsigned int i = 0; i < n_contacts; i++) {
+      if (!CS.active[i]) {
+        continue;
+      }
+
+      unsigned int k = 3 * i;
+      double mu = CS.friction_coefficients[i];
+
+      if (CS.W(k, k) <= 0.) {
+        continue;
+      }
+
+      double lambda_n_old = CS.impulses[k];
+      double v_n = CS.velocity[k] + CS.W.col(k).dot (CS.impulses);
+      double lambda_n = std::max (0.,
+          lambda_n_old - (v_n - CS.target_velocity[i]) / CS.W(k, k));
+      CS.impulses[k] = lambda_n;
+
+      double lambda_t1_old = CS.impulses[k + 1];
+      double lambda_t2_old = CS.impulses[k + 2];
+      double lambda_t1 = 0.;
+      double lambda_t2 = 0.;
+
+      if (mu > 0. && lambda_n > 0.) {
+        double v_t1 = CS.velocity[k + 1] + CS.W.col(k + 1).dot (CS.impulses);
+        double v_t2 = CS.velocity[k + 2] + CS.W.col(k + 2).dot (CS.impulses);
+        lambda_t1 = lambda_t1_old;
+        lambda_t2 = lambda_t2_old;
+
+        if (CS.W(k + 1, k + 1) > 0.) {
+          lambda_t1 -= v_t1 / CS.W(k + 1, k + 1);
+        }
+        if (CS.W(k + 2, k + 2) > 0.) {
+          lambda_t2 -= v_t2 / CS.W(k + 2, k + 2);
+        }
+
+        double limit = mu * lambda_n;
+
+        if (CS.friction_model == FrictionModelPyramid) {
+          lambda_t1 = std::min (std::max (lambda_t1, -limit), limit);
+          lambda_t2 = std::min (std::max (lambda_t2, -limit), limit);
+        } else {
+          double norm = sqrt (lambda_t1 * lambda_t1 + lambda_t2 * lambda_t2);
+          if (norm > limit) {
+            lambda_t1 *= limit / norm;
+            lambda_t2 *= limit / norm;
+          }
+        }
+      }
+
+      CS.impulses[k + 1] = lambda_t1;
+      CS.impulses[k + 2] = lambda_t2;
+
+      CS.residual = std::max (CS.residual, fabs (lambda_n - lambda_n_old));
+      CS.residual = std::max (CS.residual, fabs (lambda_t1 - lambda_t1_old));
+      CS.residual = std::max (CS.residual, fabs (lambda_t2 - lambda_t2_old));
+    }
+
+    CS.num_iterations = iter + 1;
+
+    if (CS.residual <= CS.tolerance) {
+      break;
+    }
+  }
+
+  LOG << "impulses = " << CS.impulses.transpose() << std::endl;
+
+  // the articulated body inertias of CalcDelassus() are still valid
+  CS.generalized_impulse.noalias() = CS.J.transpose() * CS.impulses;
+  CalcMInvTimesTau (model, Q, CS.generalized_impulse, CS.qdot_delta, false);
+
+  QDotPlus = QDotMinus + CS.qdot_delta;
+}
+
+} /* namespace RigidBodyDynamics */
+
+#endif
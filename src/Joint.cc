@@ -438,4 +438,179 @@ RBDL_DLLAPI void jcalc_X_lambda_S (
     throw Errors::RBDLError("Error: invalid joint type!");
   }
 }
+
+RBDL_DLLAPI SpatialVector jcalc_S_column (
+    const Model &model,
+    unsigned int joint_id,
+    unsigned int dof
+    ) {
+  const Joint &joint = model.mJoints[joint_id];
+
+  if (joint.mJointType == JointTypeCustom) {
+    return model.mCustomJoints[joint.custom_joint_index]->S.col(dof);
+  } else if (joint.mDoFCount == 1) {
+    return model.S[joint_id];
+  }
+
+  return model.multdof3_S[joint_id].col(dof);
+}
+
+RBDL_DLLAPI SpatialVector jcalc_S_dot_column (
+    const Model &model,
+    unsigned int joint_id,
+    unsigned int dof,
+    const VectorNd &q,
+    const VectorNd &qdot
+    ) {
+  const Joint &joint = model.mJoints[joint_id];
+  unsigned int q_index = joint.q_index;
+
+  if (joint.mJointType == JointTypeHelical) {
+    Vector3d axis = model.S[joint_id].block<3,1>(0,0);
+    Vector3d trans = model.S[joint_id].block<3,1>(3,0);
+    Vector3d trans_dot = - qdot[q_index] * axis.cross(trans);
+    return SpatialVector (0., 0., 0., trans_dot[0], trans_dot[1],
+                          trans_dot[2]);
+  } else if (joint.mJointType != JointTypeEulerZYX
+             && joint.mJointType != JointTypeEulerXYZ
+             && joint.mJointType != JointTypeEulerYXZ) {
+    return SpatialVector::Zero();
+  }
+
+  if (dof == 2) {
+    return SpatialVector::Zero();
+  }
+
+  Scalar s1 = sin (q[q_index + 1]);
+  Scalar c1 = cos (q[q_index + 1]);
+  Scalar s2 = sin (q[q_index + 2]);
+  Scalar c2 = cos (q[q_index + 2]);
+  Scalar qdot1 = qdot[q_index + 1];
+  Scalar qdot2 = qdot[q_index + 2];
+
+  if (joint.mJointType == JointTypeEulerZYX) {
+    if (dof == 0) {
+      return SpatialVector (-c1 * qdot1,
+                            -s1 * s2 * qdot1 + c1 * c2 * qdot2,
+                            -s1 * c2 * qdot1 - c1 * s2 * qdot2,
+                            0., 0., 0.);
+    }
+    return SpatialVector (0., -s2 * qdot2, -c2 * qdot2, 0., 0., 0.);
+  } else if (joint.mJointType == JointTypeEulerXYZ) {
+    if (dof == 0) {
+      return SpatialVector (-s2 * c1 * qdot2 - c2 * s1 * qdot1,
+                            -c2 * c1 * qdot2 + s2 * s1 * qdot1,
+                            c1 * qdot1,
+                            0., 0., 0.);
+    }
+    return SpatialVector (c2 * qdot2, -s2 * qdot2, 0., 0., 0., 0.);
+  }
+
+  // JointTypeEulerYXZ
+  if (dof == 0) {
+    return SpatialVector (c2 * c1 * qdot2 - s2 * s1 * qdot1,
+                          -s2 * c1 * qdot2 - c2 * s1 * qdot1,
+                          -c1 * qdot1,
+                          0., 0., 0.);
+  }
+  return SpatialVector (-s2 * qdot2, -c2 * qdot2, 0., 0., 0., 0.);
+}
+
+MultiDofJoint::MultiDofJoint (const Joint &joint) {
+  mDoFCount = joint.mDoFCount;
+
+  for (unsigned int j = 0; j < mDoFCount; j++) {
+    SpatialVector axis = joint.mJointAxes[j];
+    Vector3d rotation (axis[0], axis[1], axis[2]);
+    Vector3d translation (axis[3], axis[4], axis[5]);
+
+#ifdef RBDL_USE_CASADI_MATH
+    bool is_rotation = translation.is_zero();
+    bool is_translation = rotation.is_zero();
+#else
+    bool is_rotation = translation == Vector3d (0., 0., 0.);
+    bool is_translation = rotation == Vector3d (0., 0., 0.);
+#endif
+
+    if (is_rotation == is_translation) {
+      throw Errors::RBDLError(
+          "Error: the axes of a native multi-dof joint must either be a "
+          "rotation or a translation!\n");
+    }
+
+    mAxes.push_back (axis);
+    mAxisIsRotation.push_back (is_rotation);
+  }
+
+  S = MatrixNd::Zero (6, mDoFCount);
+  U = MatrixNd::Zero (6, mDoFCount);
+  Dinv = MatrixNd::Zero (mDoFCount, mDoFCount);
+  u = VectorNd::Zero (mDoFCount);
+  d_u = VectorNd::Zero (mDoFCount);
+}
+
+MultiDofJoint* MultiDofJoint::Clone () const {
+  return new MultiDofJoint (*this);
+}
+
+void MultiDofJoint::calcTransformAndMotionSubspace (
+    const VectorNd &q,
+    unsigned int q_index) {
+  // The axis of the j-th joint of the chain is constant in its own frame
+  // and is transformed into the body frame by the joints after it.
+  XJ = SpatialTransform();
+
+  for (int j = int(mDoFCount) - 1; j >= 0; j--) {
+    S.col(j) = XJ.apply (mAxes[j]);
+
+    if (mAxisIsRotation[j]) {
+      XJ = XJ * Xrot (q[q_index + j],
+          Vector3d (mAxes[j][0], mAxes[j][1], mAxes[j][2]));
+    } else {
+      XJ = XJ * Xtrans (Vector3d (mAxes[j][3], mAxes[j][4], mAxes[j][5])
+          * q[q_index + j]);
+    }
+  }
+}
+
+void MultiDofJoint::jcalc (
+    Model &model,
+    unsigned int joint_id,
+    const VectorNd &q,
+    const VectorNd &qdot) {
+  unsigned int q_index = model.mJoints[joint_id].q_index;
+
+  calcTransformAndMotionSubspace (q, q_index);
+  model.X_J[joint_id] = XJ;
+
+  SpatialVector v_J (0., 0., 0., 0., 0., 0.);
+  for (unsigned int j = 0; j < mDoFCount; j++) {
+    v_J += S.col(j) * qdot[q_index + j];
+  }
+
+  // The bias acceleration of the chain is the sum of the cross products
+  // of the velocity of each intermediate frame with the velocity of its
+  // joint. Relative to the body velocity this is
+  //   c_J = sum_j (v_j - v_J) x (S_j qdot_j)
+  // with the velocity v_j of the frame after the j-th joint.
+  SpatialVector v_j (0., 0., 0., 0., 0., 0.);
+  SpatialVector c_J (0., 0., 0., 0., 0., 0.);
+  for (unsigned int j = 0; j < mDoFCount; j++) {
+    SpatialVector v_joint = S.col(j) * qdot[q_index + j];
+    v_j += v_joint;
+    c_J += crossm (v_j - v_J, v_joint);
+  }
+
+  model.v_J[joint_id] = v_J;
+  model.c_J[joint_id] = c_J;
+}
+
+void MultiDofJoint::jcalc_X_lambda_S (
+    Model &model,
+    unsigned int joint_id,
+    const VectorNd &q) {
+  calcTransformAndMotionSubspace (q, model.mJoints[joint_id].q_index);
+  model.X_lambda[joint_id] = XJ * model.X_T[joint_id];
+}
+
 }
@@ -8,6 +8,8 @@
 #include <iostream>
 #include <limits>
 #include <cstring>
+#include <algorithm>
+#include <thread>
 #include <assert.h>
 
 #include "rbdl/rbdl_mathutils.h"
@@ -90,11 +92,9 @@ RBDL_DLLAPI void UpdateKinematicsCustom(
     for (i = 1; i < model.mBodies.size(); i++) {
       unsigned int lambda = model.lambda[i];
 
-      VectorNd QDot_zero (VectorNd::Zero (model.q_size));
-
-      jcalc (model, i, (*Q), QDot_zero);
-
-      model.X_lambda[i] = model.X_J[i] * model.X_T[i];
+      // only the joint transformations and motion subspaces are needed
+      // here, which also avoids a zero velocity vector per body
+      jcalc_X_lambda_S (model, i, *Q);
 
       if (lambda != 0) {
         model.X_base[i] = model.X_lambda[i] * model.X_base[lambda];
@@ -865,84 +865,98 @@ bool InverseKinematics (
   assert (Qinit.size() == model.q_size);
   assert (Qres.size() == Qinit.size());
 
-  CS.J = MatrixNd::Zero(CS.num_constraints, model.qdot_size);
-  CS.e = VectorNd::Zero(CS.num_constraints);
+  const unsigned int n = model.qdot_size;
+
+  // The workspace only gets (re-)allocated if the problem size changed so
+  // that the iterations below do not allocate memory.
+  if (CS.J.rows() != CS.num_constraints || CS.J.cols() != n) {
+    CS.J = MatrixNd::Zero(CS.num_constraints, n);
+    CS.e = VectorNd::Zero(CS.num_constraints);
+  }
+  if (CS.G.rows() != 6 || CS.G.cols() != n) {
+    CS.G = MatrixNd::Zero(6, n);
+    CS.A = MatrixNd::Zero(n, n);
+    CS.A_ldlt = Eigen::LDLT<MatrixNd> (n);
+    CS.ek = VectorNd::Zero(n);
+    CS.delta_theta = VectorNd::Zero(n);
+  }
+
   double mass;
+  Vector3d com;
 
   Qres = Qinit;
 
   for (CS.num_steps = 0; CS.num_steps < CS.max_steps; CS.num_steps++) {
+    // all constraints share one kinematics update per iteration
     UpdateKinematicsCustom (model, &Qres, NULL, NULL);
 
+    bool com_valid = false;
+
     for (unsigned int k = 0; k < CS.body_ids.size(); k++) {
-      CS.G = MatrixNd::Zero(6, model.qdot_size);
-      CalcPointJacobian6D (model, Qres, CS.body_ids[k], CS.body_points[k], CS.G, false);
-      Vector3d point_base = CalcBodyToBaseCoordinates (model, Qres, CS.body_ids[k], CS.body_points[k], false);
-      Matrix3d R = CalcBodyWorldOrientation(model, Qres, CS.body_ids[k], false);
-      Vector3d angular_velocity = R.transpose()*CalcAngularVelocityfromMatrix(R*CS.target_orientations[k].transpose());
-
-      //assign offsets and Jacobians
-      if (CS.constraint_type[k] == InverseKinematicsConstraintSet::ConstraintTypeFull){
-        for (unsigned int i = 0; i < 3; i++){
-          unsigned int row = CS.constraint_row_index[k] + i;
-          CS.e[row + 3] = CS.constraint_weight.at(k)*(CS.target_positions[k][i] - point_base[i]);
-          CS.e[row] = CS.constraint_weight.at(k)*angular_velocity[i];
-          for (unsigned int j = 0; j < model.qdot_size; j++) {
-            CS.J(row + 3, j) = CS.constraint_weight.at(k)*CS.G (i + 3,j);
-            CS.J(row, j) = CS.constraint_weight.at(k)*CS.G (i,j);
-          }
+      const double weight = CS.constraint_weight[k];
+      const unsigned int row = CS.constraint_row_index[k];
+      const InverseKinematicsConstraintSet::ConstraintType type
+        = CS.constraint_type[k];
+
+      // CalcPointJacobian6D only fills the columns of the supporting joints
+      CS.G.setZero();
+
+      if (type == InverseKinematicsConstraintSet::ConstraintTypePositionCoMXY) {
+        if (!com_valid) {
+          Utils::CalcCenterOfMass (model, Qres, Qres, NULL, mass, com, NULL,
+                                   NULL, NULL, NULL, false);
+          com_valid = true;
         }
+        CalcPointJacobian6D (model, Qres, CS.body_ids[k], com, CS.G, false);
+
+        CS.e.segment<2>(row) = weight
+          * (CS.target_positions[k].head<2>() - com.head<2>());
+        CS.J.middleRows<2>(row) = weight * CS.G.middleRows<2>(3);
+        continue;
       }
-      else if (CS.constraint_type[k] == InverseKinematicsConstraintSet::ConstraintTypeOrientation){
-        for (unsigned int i = 0; i < 3; i++){
-          unsigned int row = CS.constraint_row_index[k] + i;
-          CS.e[row] = CS.constraint_weight.at(k)*angular_velocity[i];
-          for (unsigned int j = 0; j < model.qdot_size; j++) {
-            CS.J(row, j) = CS.constraint_weight.at(k)*CS.G (i,j);
-          }
-        }
-      }
-      else if (CS.constraint_type[k] == InverseKinematicsConstraintSet::ConstraintTypePosition){
-        for (unsigned int i = 0; i < 3; i++){
-          unsigned int row = CS.constraint_row_index[k] + i;
-          CS.e[row] = CS.constraint_weight.at(k)*(CS.target_positions[k][i] - point_base[i]);
-          for (unsigned int j = 0; j < model.qdot_size; j++) {
-            CS.J(row, j) = CS.constraint_weight.at(k)*CS.G (i + 3,j);
-          }
-        }
-      }
-      else if (CS.constraint_type[k] == InverseKinematicsConstraintSet::ConstraintTypePositionXY){
-        for (unsigned int i = 0; i < 2; i++){
-          unsigned int row = CS.constraint_row_index[k] + i;
-          CS.e[row] = CS.constraint_weight.at(k)*(CS.target_positions[k][i] - point_base[i]);
-          for (unsigned int j = 0; j < model.qdot_size; j++) {
-            CS.J(row, j) = CS.constraint_weight.at(k)*CS.G (i + 3,j);
-          }
-        }
-      }
-      else if (CS.constraint_type[k] == InverseKinematicsConstraintSet::ConstraintTypePositionZ){
-        
-        unsigned int row = CS.constraint_row_index[k];
-        CS.e[row] = CS.constraint_weight.at(k)*(CS.target_positions[k][2] - point_base[2]);
-        for (unsigned int j = 0; j < model.qdot_size; j++) {
-          CS.J(row, j) = CS.constraint_weight.at(k)*CS.G (2 + 3,j);
-        }
-        
-      }
-      else if (CS.constraint_type[k] == InverseKinematicsConstraintSet::ConstraintTypePositionCoMXY){
-        Utils::CalcCenterOfMass (model, Qres, Qres, NULL, mass, point_base, NULL, NULL, NULL, NULL, false);
-		CalcPointJacobian6D (model, Qres, CS.body_ids[k], point_base, CS.G, false);
-      
-        for (unsigned int i = 0; i < 2; i++){
-          unsigned int row = CS.constraint_row_index[k] + i;
-          CS.e[row] = CS.constraint_weight.at(k)*(CS.target_positions[k][i] - point_base[i]);
-          for (unsigned int j = 0; j < model.qdot_size; j++) {
-            CS.J(row, j) = CS.constraint_weight.at(k)*CS.G (i + 3,j);
-          }
+
+      CalcPointJacobian6D (model, Qres, CS.body_ids[k], CS.body_points[k],
+                           CS.G, false);
+
+      if (type == InverseKinematicsConstraintSet::ConstraintTypeFull
+          || type == InverseKinematicsConstraintSet::ConstraintTypeOrientation) {
+        Matrix3d R = CalcBodyWorldOrientation(model, Qres, CS.body_ids[k],
+                                              false);
+        Vector3d angular_velocity = R.transpose()
+          * CalcAngularVelocityfromMatrix(
+              R * CS.target_orientations[k].transpose());
+
+        CS.e.segment<3>(row) = weight * angular_velocity;
+        CS.J.middleRows<3>(row) = weight * CS.G.topRows<3>();
+
+        if (type == InverseKinematicsConstraintSet::ConstraintTypeOrientation) {
+          continue;
         }
       }
-      else {
-        assert (false && !"Invalid inverse kinematics constraint");
+
+      Vector3d point_base = CalcBodyToBaseCoordinates (model, Qres,
+                            CS.body_ids[k], CS.body_points[k], false);
+      Vector3d point_error = weight * (CS.target_positions[k] - point_base);
+
+      switch (type) {
+        case InverseKinematicsConstraintSet::ConstraintTypeFull:
+          CS.e.segment<3>(row + 3) = point_error;
+          CS.J.middleRows<3>(row + 3) = weight * CS.G.bottomRows<3>();
+          break;
+        case InverseKinematicsConstraintSet::ConstraintTypePosition:
+          CS.e.segment<3>(row) = point_error;
+          CS.J.middleRows<3>(row) = weight * CS.G.bottomRows<3>();
+          break;
+        case InverseKinematicsConstraintSet::ConstraintTypePositionXY:
+          CS.e.segment<2>(row) = point_error.head<2>();
+          CS.J.middleRows<2>(row) = weight * CS.G.middleRows<2>(3);
+          break;
+        case InverseKinematicsConstraintSet::ConstraintTypePositionZ:
+          CS.e[row] = point_error[2];
+          CS.J.row(row) = weight * CS.G.row(5);
+          break;
+        default:
+          assert (false && !"Invalid inverse kinematics constraint");
       }
     }
 
@@ -956,51 +970,304 @@ bool InverseKinematics (
       return true;
     }
 
-    //     // "task space" from puppeteer
-    //     MatrixNd Ek = MatrixNd::Zero (CS.e.size(), CS.e.size());
-    // 
-    //     for (size_t ei = 0; ei < CS.e.size(); ei ++) {
-    // //      Ek(ei,ei) = CS.error_norm * CS.error_norm * 0.5 + CS.lambda;
-    //       Ek(ei,ei) = CS.e[ei]*CS.e[ei] * 0.5 + CS.lambda;
-    //     }
-    // 
-    //     MatrixNd JJT_Ek_wnI = CS.J * CS.J.transpose() + Ek;
-    // 
-    //     VectorNd delta_theta = CS.J.transpose() * JJT_Ek_wnI.colPivHouseholderQr().solve (CS.e);
-    // 
-    //     LOG << "change = " << delta_theta << std::endl;
+    // "joint space" from puppeteer: solve the damped normal equations
+    //   (J^T J + Wn) delta_theta = J^T e
+    // with Wn(i,i) = 0.5 * (J^T e)_i^2 + lambda. The matrix is symmetric
+    // positive definite for lambda > 0 and is factorized in place.
+    CS.ek.noalias() = CS.J.transpose() * CS.e;
+    CS.A.noalias() = CS.J.transpose() * CS.J;
 
+    for (unsigned int wi = 0; wi < n; wi++) {
+      CS.A(wi, wi) += CS.ek[wi] * CS.ek[wi] * 0.5 + CS.lambda;
+    }
 
-    // "joint space" from puppeteer
+    CS.A_ldlt.compute (CS.A);
+    CS.delta_theta = CS.A_ldlt.solve (CS.ek);
 
-    double Ek = 0.;
+    Qres += CS.delta_theta;
+    CS.delta_q_norm = CS.delta_theta.norm();
+    if (CS.delta_q_norm < CS.step_tol) {
+      LOG << "reached convergence after " << CS.num_steps << " steps" << std::endl;
+      return true;
+    }
+  }
 
-    for (size_t ei = 0; ei < CS.e.size(); ei ++) {
-      Ek += CS.e[ei] * CS.e[ei] * 0.5;
+  return false;
+}
+
+static bool InverseKinematicsChunk (
+    Model &model,
+    const VectorNd &Qinit,
+    InverseKinematicsConstraintSet &CS,
+    const std::vector<std::vector<Vector3d> > &target_positions,
+    const std::vector<std::vector<Matrix3d> > *target_orientations,
+    unsigned int frame_begin,
+    unsigned int frame_end,
+    std::vector<VectorNd> &Qres,
+    std::vector<unsigned int> &num_steps,
+    std::vector<double> &error_norms
+    ) {
+  bool success = true;
+  const VectorNd *q_start = &Qinit;
+
+  for (unsigned int f = frame_begin; f < frame_end; f++) {
+    for (unsigned int k = 0; k < CS.body_ids.size(); k++) {
+      CS.target_positions[k] = target_positions[f][k];
+      if (target_orientations != NULL) {
+        CS.target_orientations[k] = (*target_orientations)[f][k];
+      }
+    }
+
+    if (!InverseKinematics (model, *q_start, CS, Qres[f])) {
+      success = false;
     }
+    num_steps[f] = CS.num_steps;
+    error_norms[f] = CS.error_norm;
+
+    // warm start the next frame
+    q_start = &Qres[f];
+  }
+
+  return success;
+}
 
-    VectorNd ek = CS.J.transpose() * CS.e;
-    MatrixNd Wn = MatrixNd::Zero (Qres.size(), Qres.size());
+RBDL_DLLAPI
+bool InverseKinematicsTrajectory (
+    Model &model,
+    const Math::VectorNd &Qinit,
+    const InverseKinematicsConstraintSet &CS,
+    const std::vector<std::vector<Math::Vector3d> > &target_positions,
+    std::vector<Math::VectorNd> &Qres,
+    std::vector<unsigned int> &num_steps,
+    std::vector<double> &error_norms,
+    unsigned int num_threads,
+    const std::vector<std::vector<Math::Matrix3d> > *target_orientations
+    ) {
+  assert (Qinit.size() == model.q_size);
 
-    assert (ek.size() == Qres.size());
+  unsigned int num_frames = target_positions.size();
 
-    for (size_t wi = 0; wi < Qres.size(); wi++) {
-      Wn(wi, wi) = ek[wi] * ek[wi] * 0.5 + CS.lambda;
-      //      Wn(wi, wi) = Ek + 1.0e-3;
+  if (target_orientations != NULL
+      && target_orientations->size() != num_frames) {
+    throw Errors::RBDLSizeMismatchError(
+        "Number of frames of target orientations and target positions "
+        "do not match.\n");
+  }
+  for (unsigned int f = 0; f < num_frames; f++) {
+    if (target_positions[f].size() != CS.body_ids.size()
+        || (target_orientations != NULL
+          && (*target_orientations)[f].size() != CS.body_ids.size())) {
+      throw Errors::RBDLSizeMismatchError(
+          "Number of targets does not match the number of inverse "
+          "kinematics constraints.\n");
     }
+  }
 
-    MatrixNd A = CS.J.transpose() * CS.J + Wn;
-    VectorNd delta_theta = A.colPivHouseholderQr().solve(CS.J.transpose() * CS.e);
+  Qres.resize (num_frames);
+  for (unsigned int f = 0; f < num_frames; f++) {
+    if (Qres[f].size() != model.q_size) {
+      Qres[f] = VectorNd::Zero (model.q_size);
+    }
+  }
+  num_steps.resize (num_frames);
+  error_norms.resize (num_frames);
 
-    Qres = Qres + delta_theta;
-    CS.delta_q_norm = delta_theta.norm();
-    if (CS.delta_q_norm < CS.step_tol) {
-      LOG << "reached convergence after " << CS.num_steps << " steps" << std::endl;
-      return true;
+  if (num_threads == 0) {
+    num_threads = std::max (1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::max (1u, std::min (num_threads, num_frames));
+
+  // contiguous chunks so that warm starting works within each chunk
+  std::vector<unsigned int> chunk_begin (num_threads + 1);
+  for (unsigned int t = 0; t <= num_threads; t++) {
+    chunk_begin[t] = (num_frames * t) / num_threads;
+  }
+
+  std::vector<InverseKinematicsConstraintSet> chunk_cs (num_threads, CS);
+  // custom joints keep state, every thread needs its own instances
+  std::vector<Model> chunk_models;
+  chunk_models.reserve (num_threads - 1);
+  for (unsigned int t = 1; t < num_threads; t++) {
+    chunk_models.push_back (model.CloneForThread());
+  }
+  std::vector<char> chunk_success (num_threads, 1);
+
+  std::vector<std::thread> threads;
+  threads.reserve (num_threads - 1);
+  for (unsigned int t = 1; t < num_threads; t++) {
+    threads.push_back (std::thread ([&, t] () {
+      chunk_success[t] = InverseKinematicsChunk (chunk_models[t - 1], Qinit,
+          chunk_cs[t], target_positions, target_orientations,
+          chunk_begin[t], chunk_begin[t + 1], Qres, num_steps, error_norms);
+    }));
+  }
+
+  chunk_success[0] = InverseKinematicsChunk (model, Qinit, chunk_cs[0],
+      target_positions, target_orientations, chunk_begin[0], chunk_begin[1],
+      Qres, num_steps, error_norms);
+
+  for (unsigned int t = 0; t < threads.size(); t++) {
+    threads[t].join();
+  }
+
+  for (unsigned int t = 0; t < num_threads; t++) {
+    if (!chunk_success[t]) {
+      return false;
     }
   }
 
-  return false;
+  return true;
+}
+
+/** \brief Returns the quaternion of the rotation exp(phi), where phi is
+ * given in body coordinates, i.e. quat * exp(phi) is the rotated
+ * orientation. */
+static Quaternion CalcQuaternionExp (const Vector3d &phi) {
+  double theta = phi.norm();
+  double s = 0.5 - theta * theta / 48.;
+
+  if (theta > 1.0e-6) {
+    s = std::sin (0.5 * theta) / theta;
+  }
+
+  return Quaternion (phi[0] * s, phi[1] * s, phi[2] * s,
+                     std::cos (0.5 * theta));
+}
+
+/** \brief Returns phi such that CalcQuaternionExp (phi) = quat (quat must
+ * be normalized). */
+static Vector3d CalcQuaternionLog (const Quaternion &quat) {
+  Vector3d v (quat[0], quat[1], quat[2]);
+  double w = quat[3];
+
+  // shortest rotation
+  if (w < 0.) {
+    v = -v;
+    w = -w;
+  }
+
+  double sin_half = v.norm();
+  double scale = 2. / w;
+
+  if (sin_half > 1.0e-6) {
+    scale = 2. * std::atan2 (sin_half, w) / sin_half;
+  }
+
+  return v * scale;
+}
+
+/** \brief Returns the left Jacobian V(phi) of SO(3) that maps the body
+ * velocity of a constant body twist to the translation of exp(phi). If
+ * inverse is true, V(phi)^-1 is returned. */
+static Matrix3d CalcSO3LeftJacobian (const Vector3d &phi, bool inverse) {
+  double theta2 = phi.squaredNorm();
+  double theta = std::sqrt (theta2);
+  Matrix3d phi_cross = VectorCrossMatrix (phi);
+
+  if (inverse) {
+    double c2 = 1. / 12. + theta2 / 720.;
+
+    if (theta > 1.0e-6) {
+      c2 = (1. - 0.5 * theta * std::sin (theta) / (1. - std::cos (theta)))
+           / theta2;
+    }
+
+    return Matrix3d::Identity() - 0.5 * phi_cross
+           + c2 * phi_cross * phi_cross;
+  }
+
+  double c1 = 0.5 - theta2 / 24.;
+  double c2 = 1. / 6. - theta2 / 120.;
+
+  if (theta > 1.0e-6) {
+    c1 = (1. - std::cos (theta)) / theta2;
+    c2 = (theta - std::sin (theta)) / (theta2 * theta);
+  }
+
+  return Matrix3d::Identity() + c1 * phi_cross + c2 * phi_cross * phi_cross;
+}
+
+RBDL_DLLAPI void IntegrateConfiguration (
+    const Model &model,
+    const VectorNd &Q,
+    const VectorNd &QDot,
+    double dt,
+    VectorNd &QNext) {
+  QNext = Q;
+
+  unsigned int root_id = model.free_flyer_root_id;
+
+  for (unsigned int i = 1; i < model.mJoints.size(); i++) {
+    unsigned int q_index = model.mJoints[i].q_index;
+
+    if (root_id != 0 && i == model.lambda[root_id]) {
+      // integrated together with the free-flyer root
+      continue;
+    } else if (i == root_id) {
+      unsigned int q_index_t = model.mJoints[model.lambda[i]].q_index;
+      Quaternion quat = model.GetQuaternion (i, Q);
+      Matrix3d E = quat.toMatrix();
+
+      Vector3d phi = QDot.segment<3>(q_index) * dt;
+      Vector3d v_body = E * QDot.segment<3>(q_index_t) * dt;
+
+      QNext.segment<3>(q_index_t) = Q.segment<3>(q_index_t)
+        + E.transpose() * (CalcSO3LeftJacobian (phi, false) * v_body);
+
+      quat = quat * CalcQuaternionExp (phi);
+      quat.normalize();
+      model.SetQuaternion (i, quat, QNext);
+    } else if (model.mJoints[i].mJointType == JointTypeSpherical) {
+      Quaternion quat = model.GetQuaternion (i, Q)
+        * CalcQuaternionExp (QDot.segment<3>(q_index) * dt);
+      quat.normalize();
+      model.SetQuaternion (i, quat, QNext);
+    } else {
+      unsigned int dof = model.mJoints[i].mDoFCount;
+      QNext.segment (q_index, dof) = Q.segment (q_index, dof)
+        + QDot.segment (q_index, dof) * dt;
+    }
+  }
+}
+
+RBDL_DLLAPI void CalcConfigurationDifference (
+    const Model &model,
+    const VectorNd &Q0,
+    const VectorNd &Q1,
+    VectorNd &QDot) {
+  if (QDot.size() != model.qdot_size) {
+    QDot.resize (model.qdot_size);
+  }
+
+  unsigned int root_id = model.free_flyer_root_id;
+
+  for (unsigned int i = 1; i < model.mJoints.size(); i++) {
+    unsigned int q_index = model.mJoints[i].q_index;
+
+    if (root_id != 0 && i == model.lambda[root_id]) {
+      continue;
+    } else if (i == root_id) {
+      unsigned int q_index_t = model.mJoints[model.lambda[i]].q_index;
+      Quaternion quat0 = model.GetQuaternion (i, Q0);
+      Matrix3d E0 = quat0.toMatrix();
+
+      Vector3d phi = CalcQuaternionLog (quat0.conjugate()
+                                        * model.GetQuaternion (i, Q1));
+      Vector3d v_body = CalcSO3LeftJacobian (phi, true)
+        * (E0 * (Q1.segment<3>(q_index_t) - Q0.segment<3>(q_index_t)));
+
+      QDot.segment<3>(q_index) = phi;
+      QDot.segment<3>(q_index_t) = E0.transpose() * v_body;
+    } else if (model.mJoints[i].mJointType == JointTypeSpherical) {
+      QDot.segment<3>(q_index) = CalcQuaternionLog (
+          model.GetQuaternion (i, Q0).conjugate()
+          * model.GetQuaternion (i, Q1));
+    } else {
+      unsigned int dof = model.mJoints[i].mDoFCount;
+      QDot.segment (q_index, dof) = Q1.segment (q_index, dof)
+        - Q0.segment (q_index, dof);
+    }
+  }
 }
 #endif
 }
@@ -38,6 +38,10 @@ Model::Model()
   previously_added_body_id = 0;
 
   gravity = Vector3d (0., -9.81, 0.);
+  emulate_multi_dof_joints = true;
+#ifndef RBDL_USE_CASADI_MATH
+  use_body_arena = false;
+#endif
 
   // state information
   v.push_back(zero_spatial);
@@ -59,6 +63,10 @@ Model::Model()
   multdof3_u.push_back (Vector3d::Zero());
   multdof3_w_index.push_back (0);
 
+  // Free-flyer root
+  free_flyer_root_id = 0;
+  free_flyer_IA_L = SpatialMatrix::Zero();
+
   // Dynamic variables
   c.push_back(zero_spatial);
   IA.push_back(SpatialMatrix::Identity());
@@ -76,6 +84,11 @@ Model::Model()
   I.push_back(rbi);
   hc.push_back (zero_spatial);
   hdotc.push_back (zero_spatial);
+  Icdot.push_back (SpatialMatrix::Zero());
+  Bc.push_back (SpatialMatrix::Zero());
+#ifndef RBDL_USE_CASADI_MATH
+  body_arena.push_back (ArticulatedBodyRecord());
+#endif
 
   // Bodies
   X_lambda.push_back(SpatialTransform());
@@ -181,6 +194,17 @@ unsigned int AddBodyMultiDofJoint (
     throw Errors::RBDLError(errormsg.str());
   }
 
+  if (!model.emulate_multi_dof_joints && joint_count > 1) {
+    std::shared_ptr<MultiDofJoint> multi_dof_joint (new MultiDofJoint (joint));
+    model.mMultiDofJoints.push_back (multi_dof_joint);
+
+    return model.AddBodyCustomJoint (parent_id,
+                                     joint_frame,
+                                     multi_dof_joint.get(),
+                                     body,
+                                     body_name);
+  }
+
   Body null_body (0., Vector3d (0., 0., 0.), Vector3d (0., 0., 0.));
   null_body.mIsVirtual = true;
 
@@ -188,16 +212,26 @@ unsigned int AddBodyMultiDofJoint (
   SpatialTransform joint_frame_transform;
 
   if (joint.mJointType == JointTypeFloatingBase) {
+    bool is_root = (parent_id == 0 && model.mBodies.size() == 1);
+
     null_parent = model.AddBody (parent_id,
                                  joint_frame,
                                  JointTypeTranslationXYZ,
                                  null_body);
 
-    return model.AddBody (null_parent,
-                          SpatialTransform(),
-                          JointTypeSpherical,
-                          body,
-                          body_name);
+    unsigned int body_id = model.AddBody (null_parent,
+                                          SpatialTransform(),
+                                          JointTypeSpherical,
+                                          body,
+                                          body_name);
+
+#ifndef RBDL_USE_CASADI_MATH
+    if (is_root) {
+      model.free_flyer_root_id = body_id;
+    }
+#endif
+
+    return body_id;
   }
 
   Joint single_dof_joint;
@@ -273,6 +307,19 @@ unsigned int Model::AddBody(
   assert (lambda.size() > 0);
   assert (joint.mJointType != JointTypeUndefined);
 
+  // the free-flyer root requires that its virtual parent has no other
+  // children, including fixed ones whose mass would be merged into it
+  if (free_flyer_root_id != 0) {
+    unsigned int movable_parent_id = parent_id;
+    if (IsFixedBodyId(parent_id)) {
+      movable_parent_id =
+        mFixedBodies[parent_id - fixed_body_discriminator].mMovableParent;
+    }
+    if (movable_parent_id == lambda[free_flyer_root_id]) {
+      free_flyer_root_id = 0;
+    }
+  }
+
   if (joint.mJointType == JointTypeFixed) {
     previously_added_body_id = AddBodyFixedJoint (*this,
                                parent_id,
@@ -425,6 +472,11 @@ unsigned int Model::AddBody(
   I.push_back (rbi);
   hc.push_back (SpatialVector(0., 0., 0., 0., 0., 0.));
   hdotc.push_back (SpatialVector(0., 0., 0., 0., 0., 0.));
+  Icdot.push_back (SpatialMatrix::Zero());
+  Bc.push_back (SpatialMatrix::Zero());
+#ifndef RBDL_USE_CASADI_MATH
+  body_arena.push_back (ArticulatedBodyRecord());
+#endif
 
   if (mBodies.size() == fixed_body_discriminator) {
     std::ostringstream errormsg;
@@ -493,6 +545,27 @@ unsigned int Model::AddBodyCustomJoint (
   const Body &body,
   std::string body_name)
 {
+#ifndef RBDL_USE_CASADI_MATH
+  // the algorithms work on fixed-size views of this storage and expect it
+  // to have the size of the joint
+  unsigned int dof = custom_joint->mDoFCount;
+  if (custom_joint->S.rows() != 6 || custom_joint->S.cols() != dof) {
+    custom_joint->S = MatrixNd::Zero (6, dof);
+  }
+  if (custom_joint->U.rows() != 6 || custom_joint->U.cols() != dof) {
+    custom_joint->U = MatrixNd::Zero (6, dof);
+  }
+  if (custom_joint->Dinv.rows() != dof || custom_joint->Dinv.cols() != dof) {
+    custom_joint->Dinv = MatrixNd::Zero (dof, dof);
+  }
+  if (custom_joint->u.size() != dof) {
+    custom_joint->u = VectorNd::Zero (dof);
+  }
+  if (custom_joint->d_u.size() != dof) {
+    custom_joint->d_u = VectorNd::Zero (dof);
+  }
+#endif
+
   Joint proxy_joint (JointTypeCustom, custom_joint->mDoFCount);
   proxy_joint.custom_joint_index = mCustomJoints.size();
   //proxy_joint.mDoFCount = custom_joint->mDoFCount; //MM added. Otherwise
@@ -509,3 +582,148 @@ unsigned int Model::AddBodyCustomJoint (
   return body_id;
 }
 
+
+ModelOrderingMap Model::OptimizeOrdering ()
+{
+  ModelOrderingMap ordering;
+
+  // depth-first order of the movable bodies, children in the order they
+  // were added
+  std::vector<unsigned int> order;
+  std::vector<unsigned int> stack (1, 0);
+
+  while (stack.size() > 0) {
+    unsigned int id = stack.back();
+    stack.pop_back();
+    order.push_back (id);
+
+    for (unsigned int j = mu[id].size(); j > 0; j--) {
+      stack.push_back (mu[id][j - 1]);
+    }
+  }
+
+  ordering.body.resize (mBodies.size());
+  for (unsigned int i = 0; i < order.size(); i++) {
+    ordering.body[order[i]] = i;
+  }
+
+  // names of the movable bodies by id
+  std::vector<std::string> body_names (mBodies.size());
+  std::map<std::string, unsigned int>::const_iterator name_iter;
+  for (name_iter = mBodyNameMap.begin(); name_iter != mBodyNameMap.end();
+       ++name_iter) {
+    if (name_iter->second < mBodies.size()) {
+      body_names[name_iter->second] = name_iter->first;
+    }
+  }
+
+  Model reordered;
+  reordered.gravity = gravity;
+  reordered.emulate_multi_dof_joints = emulate_multi_dof_joints;
+#ifndef RBDL_USE_CASADI_MATH
+  reordered.use_body_arena = use_body_arena;
+#endif
+  reordered.fixed_body_discriminator = fixed_body_discriminator;
+  reordered.mMultiDofJoints = mMultiDofJoints;
+  reordered.mClonedCustomJoints = mClonedCustomJoints;
+
+  // the joints of the model are already expanded to single joints and
+  // custom joints which are added again with their joint frames X_T
+  for (unsigned int k = 1; k < order.size(); k++) {
+    unsigned int i = order[k];
+    unsigned int parent_id = ordering.body[lambda[i]];
+
+    if (mJoints[i].mJointType == JointTypeCustom) {
+      reordered.AddBodyCustomJoint (parent_id, X_T[i],
+                                    mCustomJoints[mJoints[i].custom_joint_index],
+                                    mBodies[i], body_names[i]);
+    } else {
+      reordered.AddBody (parent_id, X_T[i], mJoints[i], mBodies[i],
+                         body_names[i]);
+    }
+  }
+
+  reordered.mFixedBodies = mFixedBodies;
+  for (unsigned int i = 0; i < reordered.mFixedBodies.size(); i++) {
+    reordered.mFixedBodies[i].mMovableParent =
+      ordering.body[mFixedBodies[i].mMovableParent];
+  }
+
+  for (name_iter = mBodyNameMap.begin(); name_iter != mBodyNameMap.end();
+       ++name_iter) {
+    if (name_iter->second >= fixed_body_discriminator) {
+      reordered.mBodyNameMap[name_iter->first] = name_iter->second;
+    }
+  }
+
+  // the virtual body of the free-flyer root and the root itself come
+  // first in depth-first order
+  reordered.free_flyer_root_id = ordering.body[free_flyer_root_id];
+  if (previously_added_body_id < mBodies.size()) {
+    reordered.previously_added_body_id =
+      ordering.body[previously_added_body_id];
+  } else {
+    reordered.previously_added_body_id = previously_added_body_id;
+  }
+
+  ordering.q.resize (q_size);
+  ordering.qdot.resize (qdot_size);
+  for (unsigned int i = 1; i < mBodies.size(); i++) {
+    const Joint &joint = mJoints[i];
+    const Joint &new_joint = reordered.mJoints[ordering.body[i]];
+
+    for (unsigned int j = 0; j < joint.mDoFCount; j++) {
+      ordering.q[joint.q_index + j] = new_joint.q_index + j;
+      ordering.qdot[joint.q_index + j] = new_joint.q_index + j;
+    }
+
+    if (joint.mJointType == JointTypeSpherical) {
+      ordering.q[multdof3_w_index[i]] =
+        reordered.multdof3_w_index[ordering.body[i]];
+    }
+  }
+
+  *this = reordered;
+
+  return ordering;
+}
+
+Model Model::CloneForThread () const
+{
+  Model clone (*this);
+  clone.mMultiDofJoints.clear();
+  clone.mClonedCustomJoints.clear();
+
+  for (unsigned int k = 0; k < mCustomJoints.size(); k++) {
+    bool is_multi_dof_joint = false;
+
+    for (unsigned int j = 0; j < mMultiDofJoints.size(); j++) {
+      if (mMultiDofJoints[j].get() == mCustomJoints[k]) {
+        std::shared_ptr<MultiDofJoint> joint_clone (
+          mMultiDofJoints[j]->Clone());
+        clone.mMultiDofJoints.push_back (joint_clone);
+        clone.mCustomJoints[k] = joint_clone.get();
+        is_multi_dof_joint = true;
+        break;
+      }
+    }
+
+    if (is_multi_dof_joint) {
+      continue;
+    }
+
+    CustomJoint *joint_clone = mCustomJoints[k]->Clone();
+    if (joint_clone == NULL) {
+      std::ostringstream errormsg;
+      errormsg << "Error: cannot clone model: custom joint " << k
+               << " does not implement CustomJoint::Clone()." << std::endl;
+      throw Errors::RBDLError(errormsg.str());
+    }
+
+    clone.mClonedCustomJoints.push_back (
+      std::shared_ptr<CustomJoint> (joint_clone));
+    clone.mCustomJoints[k] = joint_clone;
+  }
+
+  return clone;
+}
@@ -0,0 +1,191 @@
+/*
+ * RBDL - Rigid Body Dynamics Library
+ * Copyright (c) 2011-2018 Martin Felis <martin@fysx.org>
+ *
+ * Licensed under the zlib license. See LICENSE for more details.
+ */
+
+#include <atomic>
+#include <exception>
+#include <sstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "rbdl/Model.h"
+#include "rbdl/Simulator.h"
+#include "rbdl/Rollout.h"
+#include "rbdl/rbdl_errors.h"
+
+#ifndef RBDL_USE_CASADI_MATH
+
+namespace RigidBodyDynamics {
+
+using namespace Math;
+
+void RolloutBuffer::Resize (const Model &model, unsigned int num_rollouts,
+    unsigned int num_steps) {
+  this->num_rollouts = num_rollouts;
+  this->num_steps = num_steps;
+
+  q = MatrixNd::Zero (model.q_size, num_rollouts * (num_steps + 1));
+  qdot = MatrixNd::Zero (model.qdot_size, num_rollouts * (num_steps + 1));
+  tau = MatrixNd::Zero (model.qdot_size, num_rollouts * num_steps);
+}
+
+RolloutWorker::RolloutWorker (const Model &model) :
+  model (model.CloneForThread()) {
+  simulator.Bind (this->model);
+}
+
+RolloutEngine::RolloutEngine() :
+  integrator (SimulatorIntegratorSemiImplicit),
+  dt (1.0e-3) {
+}
+
+/* Pins the calling thread to the CPU of the worker (if any). A CPU that
+ * does not exist leaves the thread unpinned. */
+static void PinWorkerThread (const std::vector<int> &cpu_affinity,
+    unsigned int thread) {
+#if defined(__linux__)
+  if (cpu_affinity.empty()) {
+    return;
+  }
+
+  cpu_set_t cpu_set;
+  CPU_ZERO (&cpu_set);
+  CPU_SET (cpu_affinity[thread % cpu_affinity.size()], &cpu_set);
+  pthread_setaffinity_np (pthread_self(), sizeof (cpu_set_t), &cpu_set);
+#else
+  (void) cpu_affinity;
+  (void) thread;
+#endif
+}
+
+/* Runs task (t) on num_threads (pinned) threads and rethrows the first
+ * exception of a thread in the calling thread. */
+template <typename Task>
+static void RunOnWorkerThreads (const std::vector<int> &cpu_affinity,
+    unsigned int num_threads, Task task) {
+  std::vector<std::exception_ptr> errors (num_threads);
+  std::vector<std::thread> threads;
+  threads.reserve (num_threads);
+
+  for (unsigned int t = 0; t < num_threads; t++) {
+    threads.push_back (std::thread ([&cpu_affinity, &errors, &task, t]() {
+      try {
+        PinWorkerThread (cpu_affinity, t);
+        task (t);
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    }));
+  }
+
+  for (unsigned int t = 0; t < num_threads; t++) {
+    threads[t].join();
+  }
+
+  for (unsigned int t = 0; t < num_threads; t++) {
+    if (errors[t]) {
+      std::rethrow_exception (errors[t]);
+    }
+  }
+}
+
+bool RolloutEngine::Bind (const Model &model, unsigned int num_threads) {
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
+
+  workers.assign (num_threads, std::shared_ptr<RolloutWorker>());
+
+  RunOnWorkerThreads (cpu_affinity, num_threads, [this, &model](
+        unsigned int t) {
+    workers[t] = std::make_shared<RolloutWorker> (model);
+  });
+
+  if (setup_worker) {
+    for (unsigned int t = 0; t < num_threads; t++) {
+      setup_worker (t, *workers[t]);
+    }
+  }
+
+  return true;
+}
+
+void RolloutEngine::Run (const MatrixNd &Q0,
+    const MatrixNd &QDot0,
+    const MatrixNd *Controls,
+    RolloutBuffer &buffer) {
+  if (workers.size() == 0) {
+    throw Errors::RBDLError ("Error: RolloutEngine has not been bound to a "
+        "model. Call RolloutEngine::Bind() first.\n");
+  }
+
+  const Model &model = workers[0]->model;
+  const unsigned int num_rollouts = buffer.num_rollouts;
+  const unsigned int num_steps = buffer.num_steps;
+
+  if (Q0.rows() != model.q_size || QDot0.rows() != model.qdot_size
+      || Q0.cols() != num_rollouts || QDot0.cols() != num_rollouts
+      || buffer.q.rows() != model.q_size
+      || buffer.q.cols() != num_rollouts * (num_steps + 1)
+      || buffer.qdot.rows() != model.qdot_size
+      || buffer.qdot.cols() != num_rollouts * (num_steps + 1)
+      || buffer.tau.rows() != model.qdot_size
+      || buffer.tau.cols() != num_rollouts * num_steps
+      || (Controls != NULL && (Controls->rows() != model.qdot_size
+          || Controls->cols() != num_rollouts * num_steps))) {
+    std::ostringstream errormsg;
+    errormsg << "Error: invalid sizes of the initial states, controls or "
+             << "buffer for " << num_rollouts << " rollouts of "
+             << num_steps << " steps." << std::endl;
+    throw Errors::RBDLError (errormsg.str());
+  }
+
+  // rollouts are claimed one at a time such that the workers stay busy
+  // until all rollouts are done
+  std::atomic<unsigned int> next_rollout (0);
+
+  RunOnWorkerThreads (cpu_affinity, workers.size(), [&](unsigned int t) {
+    Simulator &simulator = workers[t]->simulator;
+    simulator.integrator = integrator;
+    simulator.dt = dt;
+
+    for (unsigned int r = next_rollout++; r < num_rollouts;
+        r = next_rollout++) {
+      unsigned int state_col = r * (num_steps + 1);
+      unsigned int control_col = r * num_steps;
+
+      simulator.time = 0.;
+      simulator.q = Q0.col (r);
+      simulator.qdot = QDot0.col (r);
+      buffer.q.col (state_col) = simulator.q;
+      buffer.qdot.col (state_col) = simulator.qdot;
+
+      for (unsigned int k = 0; k < num_steps; k++) {
+        if (Controls != NULL) {
+          simulator.tau = Controls->col (control_col + k);
+        } else if (control_callback) {
+          control_callback (r, k, simulator, simulator.tau);
+        } else {
+          simulator.tau.setZero();
+        }
+        buffer.tau.col (control_col + k) = simulator.tau;
+
+        simulator.Step();
+
+        buffer.q.col (state_col + k + 1) = simulator.q;
+        buffer.qdot.col (state_col + k + 1) = simulator.qdot;
+      }
+    }
+  });
+}
+
+}
+
+#endif
@@ -0,0 +1,296 @@
+/*
+ * RBDL - Rigid Body Dynamics Library
+ * Copyright (c) 2011-2018 Martin Felis <martin@fysx.org>
+ *
+ * Licensed under the zlib license. See LICENSE for more details.
+ */
+
+#include <iostream>
+
+#include "rbdl/rbdl_mathutils.h"
+#include "rbdl/Logging.h"
+
+#include "rbdl/Model.h"
+#include "rbdl/Dynamics.h"
+#include "rbdl/Kinematics.h"
+#include "rbdl/Constraints.h"
+#include "rbdl/FrictionalContacts.h"
+#include "rbdl/Simulator.h"
+#include "rbdl/rbdl_errors.h"
+
+#ifndef RBDL_USE_CASADI_MATH
+
+namespace RigidBodyDynamics {
+
+using namespace Math;
+
+Simulator::Simulator() :
+  integrator (SimulatorIntegratorSemiImplicit),
+  dt (1.0e-3),
+  constraint_set (NULL),
+  constraint_solver (ConstraintSolverDirect),
+  contacts (NULL),
+  f_ext (NULL),
+  time (0.),
+  model (NULL),
+  bound (false) {
+}
+
+bool Simulator::Bind (Model &model) {
+  this->model = &model;
+
+  q = VectorNd::Zero (model.q_size);
+  for (unsigned int i = 1; i < model.mJoints.size(); i++) {
+    if (model.mJoints[i].mJointType == JointTypeSpherical) {
+      model.SetQuaternion (i, Quaternion(), q);
+    }
+  }
+  qdot = VectorNd::Zero (model.qdot_size);
+  qddot = VectorNd::Zero (model.qdot_size);
+  tau = VectorNd::Zero (model.qdot_size);
+  time = 0.;
+
+  q_next = q;
+  qdot_next = VectorNd::Zero (model.qdot_size);
+  theta = VectorNd::Zero (model.qdot_size);
+  theta_dot.assign (4, VectorNd::Zero (model.qdot_size));
+  qddot_stage.assign (4, VectorNd::Zero (model.qdot_size));
+
+  bound = true;
+
+  return bound;
+}
+
+void Simulator::SetConstraintSet (ConstraintSet *constraint_set,
+    ConstraintSolver solver) {
+  this->constraint_set = constraint_set;
+  constraint_solver = solver;
+}
+
+/* Accelerations of the model, subject to the constraint set of the
+ * simulator (if any). */
+static void CalcAccelerations (
+    Simulator &simulator,
+    const VectorNd &Q,
+    const VectorNd &QDot,
+    VectorNd &QDDot) {
+  Model &model = *simulator.model;
+
+  if (simulator.constraint_set == NULL) {
+    ForwardDynamics (model, Q, QDot, simulator.tau, QDDot, simulator.f_ext);
+    return;
+  }
+
+  ConstraintSet &CS = *simulator.constraint_set;
+
+  switch (simulator.constraint_solver) {
+    case ConstraintSolverDirect:
+      ForwardDynamicsConstraintsDirect (model, Q, QDot, simulator.tau, CS,
+          QDDot, true, simulator.f_ext);
+      break;
+    case ConstraintSolverRangeSpaceSparse:
+      ForwardDynamicsConstraintsRangeSpaceSparse (model, Q, QDot,
+          simulator.tau, CS, QDDot, true, simulator.f_ext);
+      break;
+    case ConstraintSolverNullSpace:
+      ForwardDynamicsConstraintsNullSpace (model, Q, QDot, simulator.tau,
+          CS, QDDot, true, simulator.f_ext);
+      break;
+    default:
+      throw Errors::RBDLError ("Error: invalid constraint solver.\n");
+  }
+}
+
+/* Velocities that remove the velocity error of the constraint set of the
+ * simulator at Q. */
+static void CalcConstraintImpulses (
+    Simulator &simulator,
+    const VectorNd &Q,
+    const VectorNd &QDotMinus,
+    VectorNd &QDotPlus) {
+  Model &model = *simulator.model;
+  ConstraintSet &CS = *simulator.constraint_set;
+
+  switch (simulator.constraint_solver) {
+    case ConstraintSolverDirect:
+      ComputeConstraintImpulsesDirect (model, Q, QDotMinus, CS, QDotPlus);
+      break;
+    case ConstraintSolverRangeSpaceSparse:
+      ComputeConstraintImpulsesRangeSpaceSparse (model, Q, QDotMinus, CS,
+          QDotPlus);
+      break;
+    case ConstraintSolverNullSpace:
+      ComputeConstraintImpulsesNullSpace (model, Q, QDotMinus, CS,
+          QDotPlus);
+      break;
+    default:
+      throw Errors::RBDLError ("Error: invalid constraint solver.\n");
+  }
+}
+
+/* Computes the velocities ThetaDot of the chart coordinates Theta of
+ * Q = IntegrateConfiguration (Q0, Theta, 1) that correspond to the
+ * generalized velocities QDot at Q.
+ *
+ * For a spherical joint Q = Q0 exp (theta) and its body angular velocity
+ * omega yields theta' = dexp^-1_{-theta} (omega) = omega + 1/2 [theta,
+ * omega] + 1/12 [theta, [theta, omega]] + ... which is truncated after the
+ * second order term. The same holds for the body twist of a free-flyer
+ * root with the twist xi = (theta_r, E0 theta_t) of the chart, where the
+ * Lie bracket is the spatial cross product. */
+static void CalcChartVelocity (
+    const Model &model,
+    const VectorNd &Q0,
+    const VectorNd &Q,
+    const VectorNd &Theta,
+    const VectorNd &QDot,
+    VectorNd &ThetaDot) {
+  ThetaDot = QDot;
+
+  unsigned int root_id = model.free_flyer_root_id;
+
+  for (unsigned int i = 1; i < model.mJoints.size(); i++) {
+    unsigned int q_index = model.mJoints[i].q_index;
+
+    if (i == root_id) {
+      unsigned int q_index_t = model.mJoints[model.lambda[i]].q_index;
+      Matrix3d E0 = model.GetQuaternion (i, Q0).toMatrix();
+      Matrix3d E = model.GetQuaternion (i, Q).toMatrix();
+
+      SpatialVector xi;
+      xi.segment<3>(0) = Theta.segment<3>(q_index);
+      xi.segment<3>(3) = E0 * Theta.segment<3>(q_index_t);
+
+      SpatialVector twist;
+      twist.segment<3>(0) = QDot.segment<3>(q_index);
+      twist.segment<3>(3) = E * QDot.segment<3>(q_index_t);
+
+      SpatialVector ad_twist = crossm (xi, twist);
+      SpatialVector xi_dot = twist + 0.5 * ad_twist
+        + (1. / 12.) * crossm (xi, ad_twist);
+
+      ThetaDot.segment<3>(q_index) = xi_dot.segment<3>(0);
+      ThetaDot.segment<3>(q_index_t) = E0.transpose() * xi_dot.segment<3>(3);
+    } else if (model.mJoints[i].mJointType == JointTypeSpherical) {
+      Vector3d phi = Theta.segment<3>(q_index);
+      Vector3d ad_omega = phi.cross (QDot.segment<3>(q_index));
+
+      ThetaDot.segment<3>(q_index) = QDot.segment<3>(q_index)
+        + 0.5 * ad_omega + (1. / 12.) * phi.cross (ad_omega);
+    }
+  }
+}
+
+static void StepSymplecticEuler (Simulator &simulator) {
+  CalcAccelerations (simulator, simulator.q, simulator.qdot,
+      simulator.qddot);
+
+  simulator.qdot += simulator.dt * simulator.qddot;
+  IntegrateConfiguration (*simulator.model, simulator.q, simulator.qdot,
+      simulator.dt, simulator.q_next);
+  simulator.q = simulator.q_next;
+}
+
+static void StepSemiImplicit (Simulator &simulator) {
+  Model &model = *simulator.model;
+
+  CalcAccelerations (simulator, simulator.q, simulator.qdot,
+      simulator.qddot);
+  simulator.qdot_next = simulator.qdot + simulator.dt * simulator.qddot;
+
+  if (simulator.constraint_set != NULL) {
+    CalcConstraintImpulses (simulator, simulator.q, simulator.qdot_next,
+        simulator.qdot);
+    if (simulator.contacts != NULL) {
+      simulator.qdot_next = simulator.qdot;
+    }
+  }
+
+  if (simulator.contacts != NULL) {
+    SolveFrictionalContactImpulses (model, simulator.q, simulator.qdot_next,
+        *simulator.contacts, simulator.qdot);
+  } else if (simulator.constraint_set == NULL) {
+    simulator.qdot = simulator.qdot_next;
+  }
+
+  IntegrateConfiguration (model, simulator.q, simulator.qdot, simulator.dt,
+      simulator.q_next);
+  simulator.q = simulator.q_next;
+}
+
+static void StepRungeKutta4 (Simulator &simulator) {
+  Model &model = *simulator.model;
+  const double h = simulator.dt;
+  const double stage_weights[3] = { 0.5 * h, 0.5 * h, h };
+
+  VectorNd &q = simulator.q;
+  VectorNd &qdot = simulator.qdot;
+  std::vector<VectorNd> &theta_dot = simulator.theta_dot;
+  std::vector<VectorNd> &qddot_stage = simulator.qddot_stage;
+
+  CalcAccelerations (simulator, q, qdot, qddot_stage[0]);
+  theta_dot[0] = qdot;
+
+  for (unsigned int k = 1; k < 4; k++) {
+    simulator.theta = stage_weights[k - 1] * theta_dot[k - 1];
+    simulator.qdot_next = qdot + stage_weights[k - 1] * qddot_stage[k - 1];
+    IntegrateConfiguration (model, q, simulator.theta, 1.,
+        simulator.q_next);
+
+    CalcAccelerations (simulator, simulator.q_next, simulator.qdot_next,
+        qddot_stage[k]);
+    CalcChartVelocity (model, q, simulator.q_next, simulator.theta,
+        simulator.qdot_next, theta_dot[k]);
+  }
+
+  simulator.theta = (h / 6.) * (theta_dot[0] + 2. * theta_dot[1]
+      + 2. * theta_dot[2] + theta_dot[3]);
+  simulator.qddot = qddot_stage[0];
+  qdot += (h / 6.) * (qddot_stage[0] + 2. * qddot_stage[1]
+      + 2. * qddot_stage[2] + qddot_stage[3]);
+
+  IntegrateConfiguration (model, q, simulator.theta, 1., simulator.q_next);
+  q = simulator.q_next;
+}
+
+void Simulator::Step () {
+  if (!bound) {
+    throw Errors::RBDLError ("Error: Simulator has not been bound to a "
+        "model. Call Simulator::Bind() first.\n");
+  }
+
+  if (contacts != NULL && integrator != SimulatorIntegratorSemiImplicit) {
+    throw Errors::RBDLError ("Error: frictional contacts are only "
+        "supported by SimulatorIntegratorSemiImplicit.\n");
+  }
+
+  if (pre_step) {
+    pre_step (*this);
+  }
+
+  switch (integrator) {
+    case SimulatorIntegratorSymplecticEuler:
+      StepSymplecticEuler (*this);
+      break;
+    case SimulatorIntegratorSemiImplicit:
+      StepSemiImplicit (*this);
+      break;
+    case SimulatorIntegratorRungeKutta4:
+      StepRungeKutta4 (*this);
+      break;
+    default:
+      throw Errors::RBDLError ("Error: invalid simulator integrator.\n");
+  }
+
+  time += dt;
+}
+
+void Simulator::Advance (unsigned int num_steps) {
+  for (unsigned int i = 0; i < num_steps; i++) {
+    Step();
+  }
+}
+
+}
+
+#endif
@@ -121,6 +121,58 @@ RBDL_DLLAPI bool LinSolveGaussElimPivot (MatrixNd A, VectorNd b, VectorNd &x) {
 
   return true;
 }
+
+RBDL_DLLAPI bool SolveLinearSystemMixedPrecision (
+    const MatrixNd &A,
+    const VectorNd &b,
+    VectorNd &x,
+    double tolerance,
+    unsigned int max_steps,
+    unsigned int *steps) {
+  Eigen::PartialPivLU<Eigen::MatrixXf> lu (A.cast<float>());
+
+  if (tolerance <= 0.) {
+    tolerance = std::sqrt (static_cast<double> (A.rows()))
+      * std::numeric_limits<double>::epsilon();
+  }
+
+  const double A_norm = A.cwiseAbs().rowwise().sum().maxCoeff();
+  const double b_norm = b.lpNorm<Eigen::Infinity>();
+
+  x = lu.solve (b.cast<float>()).cast<double>();
+  VectorNd r (b.size());
+
+  for (unsigned int i = 0; ; i++) {
+    r = b;
+    r.noalias() -= A * x;
+    double scale = A_norm * x.lpNorm<Eigen::Infinity>() + b_norm;
+    double residual = r.lpNorm<Eigen::Infinity>();
+    if (scale > 0.) {
+      residual /= scale;
+    }
+
+    if (steps) {
+      *steps = i;
+    }
+
+    if (residual <= tolerance) {
+      return true;
+    }
+
+    // no convergence, e.g. as A is too ill-conditioned for single precision
+    if (i == max_steps || !std::isfinite (residual)) {
+      break;
+    }
+
+    x += lu.solve (r.cast<float>()).cast<double>();
+  }
+
+  LOG << "Mixed precision refinement did not converge, solving the system "
+    << "in double precision" << std::endl;
+  x = A.partialPivLu().solve (b);
+
+  return false;
+}
 #endif
 
 RBDL_DLLAPI void SpatialMatrixSetSubmatrix(
@@ -279,6 +279,128 @@ RBDL_DLLAPI void CalcCenterOfMass (
   }
 }
 
+RBDL_DLLAPI void CalcCentroidalMomentumMatrix (
+  Model &model,
+  const Math::VectorNd &q,
+  Math::MatrixNd &A_G,
+  bool update_kinematics)
+{
+  assert (A_G.rows() == 6 && A_G.cols() == model.qdot_size);
+
+  if (update_kinematics) {
+    UpdateKinematicsCustom (model, &q, NULL, NULL);
+  }
+
+  // composite rigid body inertias as in CompositeRigidBodyAlgorithm()
+  for (size_t i = 1; i < model.mBodies.size(); i++) {
+    model.Ic[i] = model.I[i];
+  }
+
+  SpatialRigidBodyInertia Itot (0., Vector3d (0., 0., 0.), Matrix3d::Zero());
+
+  for (size_t i = model.mBodies.size() - 1; i > 0; i--) {
+    unsigned int lambda = model.lambda[i];
+
+    if (lambda != 0) {
+      model.Ic[lambda] = model.Ic[lambda] + model.X_lambda[i].applyTranspose (
+                           model.Ic[i]);
+    } else {
+      Itot = Itot + model.X_lambda[i].applyTranspose (model.Ic[i]);
+    }
+  }
+
+  SpatialTransform X_G = Xtrans (Itot.h / Itot.m);
+
+  // the momentum of the subtree of body i due to the motion of joint i
+  for (size_t i = 1; i < model.mBodies.size(); i++) {
+    unsigned int q_index = model.mJoints[i].q_index;
+
+    for (unsigned int dof = 0; dof < model.mJoints[i].mDoFCount; dof++) {
+      SpatialVector h = model.Ic[i] * jcalc_S_column (model, i, dof);
+      A_G.block<6,1>(0, q_index + dof)
+        = X_G.applyAdjoint (model.X_base[i].applyTranspose (h));
+    }
+  }
+}
+
+RBDL_DLLAPI void CalcCentroidalMomentumMatrixDot (
+  Model &model,
+  const Math::VectorNd &q,
+  const Math::VectorNd &qdot,
+  Math::MatrixNd &A_G_dot,
+  bool update_kinematics)
+{
+  assert (A_G_dot.rows() == 6 && A_G_dot.cols() == model.qdot_size);
+
+  if (model.mCustomJoints.size() > 0) {
+    throw Errors::RBDLMissingImplementationError(
+      "Error: CalcCentroidalMomentumMatrixDot() does not support custom "
+      "joints.\n");
+  }
+
+  if (update_kinematics) {
+    UpdateKinematicsCustom (model, &q, &qdot, NULL);
+  }
+
+  // composite inertias, their rates of change
+  //   d/dt I = v x* I - I v x
+  // and the composite momenta
+  for (size_t i = 1; i < model.mBodies.size(); i++) {
+    model.Ic[i] = model.I[i];
+    SpatialMatrix I = model.I[i].toMatrix();
+    model.Icdot[i] = crossf (model.v[i]) * I - I * crossm (model.v[i]);
+    model.hc[i] = I * model.v[i];
+  }
+
+  SpatialRigidBodyInertia Itot (0., Vector3d (0., 0., 0.), Matrix3d::Zero());
+  SpatialVector htot (SpatialVector::Zero());
+
+  for (size_t i = model.mBodies.size() - 1; i > 0; i--) {
+    unsigned int lambda = model.lambda[i];
+
+    if (lambda != 0) {
+      model.Ic[lambda] = model.Ic[lambda] + model.X_lambda[i].applyTranspose (
+                           model.Ic[i]);
+      model.hc[lambda] = model.hc[lambda] + model.X_lambda[i].applyTranspose (
+                           model.hc[i]);
+
+      SpatialMatrix X = model.X_lambda[i].toMatrix();
+      model.Icdot[lambda].noalias() += X.transpose() * model.Icdot[i] * X;
+    } else {
+      Itot = Itot + model.X_lambda[i].applyTranspose (model.Ic[i]);
+      htot = htot + model.X_lambda[i].applyTranspose (model.hc[i]);
+    }
+  }
+
+  Vector3d com = Itot.h / Itot.m;
+  Vector3d com_velocity = htot.block<3,1>(3,0) / Itot.m;
+  SpatialTransform X_G = Xtrans (com);
+
+  // The column of the subtree momentum h = X_base^T Ic S changes with
+  // the composite inertia and the motion subspace, which moves with the
+  // body (v x S) and may depend on q (S_dot). Shifting it to the moving
+  // COM adds -com_velocity x f to the angular part.
+  for (size_t i = 1; i < model.mBodies.size(); i++) {
+    unsigned int q_index = model.mJoints[i].q_index;
+
+    for (unsigned int dof = 0; dof < model.mJoints[i].mDoFCount; dof++) {
+      SpatialVector S = jcalc_S_column (model, i, dof);
+      SpatialVector S_dot = crossm (model.v[i], S)
+        + jcalc_S_dot_column (model, i, dof, q, qdot);
+
+      SpatialVector h = model.X_base[i].applyTranspose (model.Ic[i] * S);
+      SpatialVector h_dot = model.X_base[i].applyTranspose (
+          model.Icdot[i] * S + model.Ic[i] * S_dot);
+
+      h_dot = X_G.applyAdjoint (h_dot);
+      Vector3d f = h.block<3,1>(3,0);
+      h_dot.block<3,1>(0,0) -= com_velocity.cross (f);
+
+      A_G_dot.block<6,1>(0, q_index + dof) = h_dot;
+    }
+  }
+}
+
 RBDL_DLLAPI void CalcZeroMomentPoint (
   Model &model,
   const Math::VectorNd &q,
@@ -360,6 +482,114 @@ RBDL_DLLAPI void CalcZeroMomentPoint (
   return;
 }
 
+WholeBodyQuantities::WholeBodyQuantities() :
+  mass (0.),
+  com (Vector3d::Zero()),
+  com_velocity (Vector3d::Zero()),
+  com_acceleration (Vector3d::Zero()),
+  angular_momentum (Vector3d::Zero()),
+  change_of_angular_momentum (Vector3d::Zero()),
+  kinetic_energy (0.),
+  potential_energy (0.),
+  zmp (Vector3d::Zero())
+{
+}
+
+RBDL_DLLAPI void CalcWholeBodyQuantities (
+  Model &model,
+  const Math::VectorNd &q,
+  const Math::VectorNd &qdot,
+  const Math::VectorNd &qddot,
+  WholeBodyQuantities &quantities,
+  const Math::Vector3d &normal,
+  bool update_kinematics)
+{
+  if (update_kinematics) {
+    UpdateKinematicsCustom (model, &q, &qdot, &qddot);
+  }
+
+  Scalar kinetic_energy = 0.;
+
+  // momentum, change of momentum and kinetic energy of each single body
+  for (size_t i = 1; i < model.mBodies.size(); i++) {
+    model.Ic[i] = model.I[i];
+    model.hc[i] = model.Ic[i] * model.v[i];
+    model.hdotc[i] = model.Ic[i] * model.a[i] + crossf(model.v[i],
+                     model.hc[i]);
+    kinetic_energy += 0.5 * model.v[i].dot (model.hc[i]);
+  }
+
+  SpatialRigidBodyInertia I_tot (0., Vector3d (0., 0., 0.), Matrix3d::Zero());
+  SpatialVector h_tot (SpatialVector::Zero());
+  SpatialVector hdot_tot (SpatialVector::Zero());
+
+  for (size_t i = model.mBodies.size() - 1; i > 0; i--) {
+    unsigned int lambda = model.lambda[i];
+
+    if (lambda != 0) {
+      model.Ic[lambda] = model.Ic[lambda] + model.X_lambda[i].applyTranspose (
+                           model.Ic[i]);
+      model.hc[lambda] = model.hc[lambda] + model.X_lambda[i].applyTranspose (
+                           model.hc[i]);
+      model.hdotc[lambda] = model.hdotc[lambda] + model.X_lambda[i].applyTranspose (
+                              model.hdotc[i]);
+    } else {
+      I_tot = I_tot + model.X_lambda[i].applyTranspose (model.Ic[i]);
+      h_tot = h_tot + model.X_lambda[i].applyTranspose (model.hc[i]);
+      hdot_tot = hdot_tot + model.X_lambda[i].applyTranspose (model.hdotc[i]);
+    }
+  }
+
+  const Scalar mass = I_tot.m;
+  const Vector3d com = I_tot.h / mass;
+  const Vector3d g (model.gravity[0], model.gravity[1], model.gravity[2]);
+
+  quantities.mass = mass;
+  quantities.com = com;
+  quantities.com_velocity = h_tot.block<3,1>(3,0) / mass;
+  quantities.com_acceleration = hdot_tot.block<3,1>(3,0) / mass;
+  quantities.kinetic_energy = kinetic_energy;
+  quantities.potential_energy = - mass * com.dot (g);
+
+  // project momentum and change of momentum onto CoM
+  SpatialTransform Xcom = Xtrans (com);
+  h_tot = Xcom.applyAdjoint (h_tot);
+  hdot_tot = Xcom.applyAdjoint (hdot_tot);
+  quantities.angular_momentum = h_tot.block<3,1>(0,0);
+  quantities.change_of_angular_momentum = hdot_tot.block<3,1>(0,0);
+
+  // ZMP from the net external force at the CoM (see CalcZeroMomentPoint())
+  hdot_tot = hdot_tot - mass * SpatialVector (0., 0., 0., g[0], g[1], g[2]);
+  hdot_tot = Xcom.inverse().applyAdjoint (hdot_tot);
+
+  Vector3d n_0 = hdot_tot.block<3,1>(0,0);
+  Vector3d f = hdot_tot.block<3,1>(3,0);
+  quantities.zmp = normal.cross(n_0) / normal.dot(f);
+}
+
+RBDL_DLLAPI void CalcWholeBodyQuantities (
+  Model &model,
+  const std::vector<Math::VectorNd> &Q,
+  const std::vector<Math::VectorNd> &QDot,
+  const std::vector<Math::VectorNd> &QDDot,
+  std::vector<WholeBodyQuantities> &quantities,
+  const Math::Vector3d &normal)
+{
+  if (QDot.size() != Q.size() || QDDot.size() != Q.size()) {
+    throw Errors::RBDLSizeMismatchError(
+      "Q, QDot and QDDot must have the same number of states!\n");
+  }
+
+  if (quantities.size() != Q.size()) {
+    quantities.resize (Q.size());
+  }
+
+  for (size_t k = 0; k < Q.size(); k++) {
+    CalcWholeBodyQuantities (model, Q[k], QDot[k], QDDot[k], quantities[k],
+                             normal, true);
+  }
+}
+
 RBDL_DLLAPI Scalar CalcPotentialEnergy (
   Model &model,
   const Math::VectorNd &q,
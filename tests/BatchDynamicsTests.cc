@@ -0,0 +1,279 @@
+#include <iostream>
+
+#include "rbdl/Logging.h"
+
+#include "rbdl/Model.h"
+#include "rbdl/Dynamics.h"
+#include "rbdl/Kinematics.h"
+#include "rbdl/BatchDynamics.h"
+
+#include "rbdl_tests.h"
+#include "Human36Fixture.h"
+
+using namespace std;
+using namespace RigidBodyDynamics;
+using namespace RigidBodyDynamics::Math;
+
+const double TEST_PREC = 1.0e-10;
+
+/* Fills the states with deterministic pseudo random values, quaternions of
+ * spherical joints are normalized. */
+static void FillBatchStates (const Model &model, unsigned int num_states,
+    MatrixNd &Q, MatrixNd &QDot, MatrixNd &Tau) {
+  Q = MatrixNd::Zero (model.q_size, num_states);
+  QDot = MatrixNd::Zero (model.qdot_size, num_states);
+  Tau = MatrixNd::Zero (model.qdot_size, num_states);
+
+  for (unsigned int s = 0; s < num_states; s++) {
+    for (unsigned int i = 0; i < model.q_size; i++) {
+      Q(i, s) = 0.8 * sin (1.3 * i + 0.7 * s + 0.1);
+    }
+    for (unsigned int i = 0; i < model.qdot_size; i++) {
+      QDot(i, s) = 1.2 * cos (0.9 * i - 0.4 * s);
+      Tau(i, s) = 2. * sin (0.5 * i + 1.1 * s);
+    }
+
+    VectorNd q = Q.col(s);
+    for (unsigned int i = 1; i < model.mJoints.size(); i++) {
+      if (model.mJoints[i].mJointType == JointTypeSpherical) {
+        model.SetQuaternion (i, Quaternion (model.GetQuaternion (i, q)
+              / model.GetQuaternion (i, q).norm()), q);
+      }
+    }
+    Q.col(s) = q;
+  }
+}
+
+struct BatchChainFixture {
+  BatchChainFixture () {
+    ClearLogOutput();
+    model.gravity = Vector3d (0., -9.81, 0.);
+
+    base_id = model.AddBody (0, SpatialTransform(),
+        Joint (JointTypeFloatingBase),
+        Body (2., Vector3d (0.1, 0.05, -0.1), Vector3d (0.3, 0.5, 0.7)));
+    unsigned int arm_id = model.AddBody (base_id,
+        Xtrans (Vector3d (0.3, 0., 0.1)), Joint (JointTypeSpherical),
+        Body (1., Vector3d (0.2, 0.1, 0.), Vector3d (0.1, 0.2, 0.15)));
+    unsigned int slider_id = model.AddBody (arm_id,
+        SpatialTransform (Matrix3d (0., 1., 0., -1., 0., 0., 0., 0., 1.),
+          Vector3d (0.4, 0., 0.)),
+        Joint (SpatialVector (0., 0., 0., 0.6, 0., 0.8)),
+        Body (0.5, Vector3d (0.15, 0., 0.), Vector3d (0.05, 0.06, 0.04)));
+    tip_id = model.AddBody (slider_id, Xtrans (Vector3d (0., 0.2, 0.)),
+        Joint (JointTypeRevolute, Vector3d (0., 0.6, 0.8)),
+        Body (0.7, Vector3d (0., 0.1, 0.05), Vector3d (0.02, 0.03, 0.04)));
+    model.AddBody (base_id, Xtrans (Vector3d (-0.2, 0., 0.)),
+        Joint (SpatialVector (0., 0., 1., 0., 0., 0.)),
+        Body (0.3, Vector3d (-0.1, 0., 0.), Vector3d (0.01, 0.01, 0.01)));
+    fixed_id = model.AddBody (tip_id,
+        Xtrans (Vector3d (0.1, 0.1, 0.)) * Xroty (0.4), Joint (JointTypeFixed),
+        Body (0.2, Vector3d (0.05, 0., 0.), Vector3d (0.01, 0.01, 0.01)));
+
+    num_states = 11;
+    FillBatchStates (model, num_states, Q, QDot, Tau);
+  }
+
+  Model model;
+  unsigned int base_id;
+  unsigned int tip_id;
+  unsigned int fixed_id;
+  unsigned int num_states;
+
+  MatrixNd Q;
+  MatrixNd QDot;
+  MatrixNd Tau;
+};
+
+TEST_CASE_METHOD (BatchChainFixture, __FILE__"_BatchDynamicsMatchesScalar",
+    "") {
+  BatchWorkspace workspace;
+  workspace.Bind (model);
+  REQUIRE (workspace.lane_parallel);
+  REQUIRE (workspace.lanes >= 4);
+
+  MatrixNd QDDot (model.qdot_size, num_states);
+  MatrixNd TauID (model.qdot_size, num_states);
+  MatrixNd points (3, num_states);
+  MatrixNd fixed_points (3, num_states);
+
+  ForwardDynamicsBatch (model, Q, QDot, Tau, workspace, QDDot);
+  InverseDynamicsBatch (model, Q, QDot, QDDot, workspace, TauID);
+  CalcBodyToBaseCoordinatesBatch (model, Q, tip_id,
+      Vector3d (0.1, -0.2, 0.3), workspace, points);
+  CalcBodyToBaseCoordinatesBatch (model, Q, fixed_id,
+      Vector3d (0.1, -0.2, 0.3), workspace, fixed_points);
+
+  CHECK_THAT (Tau, AllCloseMatrix (TauID, TEST_PREC, TEST_PREC));
+
+  for (unsigned int s = 0; s < num_states; s++) {
+    VectorNd q = Q.col(s);
+    VectorNd qdot = QDot.col(s);
+    VectorNd tau = Tau.col(s);
+    VectorNd qddot = VectorNd::Zero (model.qdot_size);
+
+    ForwardDynamics (model, q, qdot, tau, qddot);
+    CHECK_THAT (qddot, AllCloseVector (VectorNd (QDDot.col(s)), TEST_PREC,
+          TEST_PREC));
+
+    Vector3d point = CalcBodyToBaseCoordinates (model, q, tip_id,
+        Vector3d (0.1, -0.2, 0.3));
+    CHECK_THAT (point, AllCloseVector (Vector3d (points.col(s)), TEST_PREC,
+          TEST_PREC));
+    point = CalcBodyToBaseCoordinates (model, q, fixed_id,
+        Vector3d (0.1, -0.2, 0.3));
+    CHECK_THAT (point, AllCloseVector (Vector3d (fixed_points.col(s)),
+          TEST_PREC, TEST_PREC));
+  }
+}
+
+TEST_CASE_METHOD (BatchChainFixture, __FILE__"_BatchDynamicsFloat", "") {
+  BatchWorkspace workspace;
+  workspace.Bind (model);
+  REQUIRE (workspace.lanes_float == 2 * workspace.lanes);
+
+  MatrixNd QDDot (model.qdot_size, num_states);
+  MatrixNd TauID (model.qdot_size, num_states);
+  MatrixNd points (3, num_states);
+  ForwardDynamicsBatch (model, Q, QDot, Tau, workspace, QDDot);
+  InverseDynamicsBatch (model, Q, QDot, QDDot, workspace, TauID);
+  CalcBodyToBaseCoordinatesBatch (model, Q, fixed_id,
+      Vector3d (0.1, -0.2, 0.3), workspace, points);
+
+  MatrixNf Qf = Q.cast<float>();
+  MatrixNf QDotf = QDot.cast<float>();
+  MatrixNf Tauf = Tau.cast<float>();
+  MatrixNf QDDotf = QDDot.cast<float>();
+  MatrixNf QDDot_float (model.qdot_size, num_states);
+  MatrixNf Tau_float (model.qdot_size, num_states);
+  MatrixNf points_float (3, num_states);
+
+  ForwardDynamicsBatch (model, Qf, QDotf, Tauf, workspace, QDDot_float);
+  InverseDynamicsBatch (model, Qf, QDotf, QDDotf, workspace, Tau_float);
+  CalcBodyToBaseCoordinatesBatch (model, Qf, fixed_id,
+      Vector3d (0.1, -0.2, 0.3), workspace, points_float);
+
+  const double float_prec = 1.0e-3;
+  CHECK_THAT (QDDot, AllCloseMatrix (MatrixNd (QDDot_float.cast<double>()),
+        float_prec, float_prec));
+  CHECK_THAT (Tau, AllCloseMatrix (MatrixNd (Tau_float.cast<double>()),
+        float_prec, float_prec));
+  CHECK_THAT (points, AllCloseMatrix (MatrixNd (points_float.cast<double>()),
+        1.0e-5, 1.0e-5));
+
+  // models that are not evaluated lane-parallel are evaluated in double
+  // precision
+  model.AddBody (tip_id, Xtrans (Vector3d (0., 0.1, 0.)),
+      Joint (JointTypeEulerZYX),
+      Body (0.4, Vector3d (0., 0.1, 0.), Vector3d (0.02, 0.01, 0.02)));
+  FillBatchStates (model, num_states, Q, QDot, Tau);
+  workspace.Bind (model);
+  REQUIRE_FALSE (workspace.lane_parallel);
+
+  QDDot.resize (model.qdot_size, num_states);
+  QDDot_float.resize (model.qdot_size, num_states);
+  ForwardDynamicsBatch (model, Q, QDot, Tau, workspace, QDDot);
+  ForwardDynamicsBatch (model, MatrixNf (Q.cast<float>()),
+      MatrixNf (QDot.cast<float>()), MatrixNf (Tau.cast<float>()), workspace,
+      QDDot_float);
+  CHECK_THAT (QDDot, AllCloseMatrix (MatrixNd (QDDot_float.cast<double>()),
+        float_prec, float_prec));
+
+  MatrixNf too_small (model.qdot_size, num_states - 1);
+  CHECK_THROWS_AS (ForwardDynamicsBatch (model, MatrixNf (Q.cast<float>()),
+        MatrixNf (QDot.cast<float>()), MatrixNf (Tau.cast<float>()),
+        workspace, too_small), Errors::RBDLError);
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_BatchDynamicsHuman36", "") {
+  const unsigned int num_states = 9;
+
+  MatrixNd Q, QDot, Tau;
+  FillBatchStates (*model_emulated, num_states, Q, QDot, Tau);
+
+  BatchWorkspace workspace;
+  workspace.Bind (*model_emulated);
+  CHECK (workspace.lane_parallel);
+
+  MatrixNd QDDot (model_emulated->qdot_size, num_states);
+  ForwardDynamicsBatch (*model_emulated, Q, QDot, Tau, workspace, QDDot);
+
+  // Euler joints are evaluated state by state
+  BatchWorkspace workspace_3dof;
+  workspace_3dof.Bind (*model_3dof);
+  CHECK_FALSE (workspace_3dof.lane_parallel);
+
+  MatrixNd QDDot_3dof (model_3dof->qdot_size, num_states);
+  ForwardDynamicsBatch (*model_3dof, Q, QDot, Tau, workspace_3dof,
+      QDDot_3dof);
+  MatrixNd Tau_3dof (model_3dof->qdot_size, num_states);
+  InverseDynamicsBatch (*model_3dof, Q, QDot, QDDot_3dof, workspace_3dof,
+      Tau_3dof);
+  CHECK_THAT (Tau, AllCloseMatrix (Tau_3dof, TEST_PREC, TEST_PREC));
+
+  for (unsigned int s = 0; s < num_states; s++) {
+    VectorNd q = Q.col(s);
+    VectorNd qdot = QDot.col(s);
+    VectorNd tau = Tau.col(s);
+
+    ForwardDynamics (*model_emulated, q, qdot, tau, qddot_emulated);
+    CHECK_THAT (qddot_emulated, AllCloseVector (VectorNd (QDDot.col(s)),
+          TEST_PREC, TEST_PREC));
+
+    ForwardDynamics (*model_3dof, q, qdot, tau, qddot_3dof);
+    CHECK_THAT (qddot_3dof, AllCloseVector (VectorNd (QDDot_3dof.col(s)),
+          TEST_PREC, TEST_PREC));
+  }
+
+  MatrixNf Qf = Q.cast<float>();
+  MatrixNf QDotf = QDot.cast<float>();
+  MatrixNf Tauf = Tau.cast<float>();
+  MatrixNf QDDotf (model_emulated->qdot_size, num_states);
+  ForwardDynamicsBatch (*model_emulated, Qf, QDotf, Tauf, workspace, QDDotf);
+  CHECK_THAT (QDDot, AllCloseMatrix (MatrixNd (QDDotf.cast<double>()),
+        1.0e-3, 1.0e-3));
+
+  if (HeapAllocationCountAvailable()) {
+    size_t allocations = HeapAllocationCount();
+    ForwardDynamicsBatch (*model_emulated, Q, QDot, Tau, workspace, QDDot);
+    InverseDynamicsBatch (*model_emulated, Q, QDot, QDDot, workspace, Tau);
+    ForwardDynamicsBatch (*model_emulated, Qf, QDotf, Tauf, workspace,
+        QDDotf);
+    CHECK (HeapAllocationCount() - allocations == 0);
+  }
+}
+
+TEST_CASE_METHOD (BatchChainFixture, __FILE__"_BatchDynamicsCustomJoint",
+    "") {
+  // native multi-dof joints are custom joints
+  model.emulate_multi_dof_joints = false;
+  model.AddBody (tip_id, Xtrans (Vector3d (0., 0.1, 0.)),
+      Joint (SpatialVector (1., 0., 0., 0., 0., 0.),
+        SpatialVector (0., 1., 0., 0., 0., 0.)),
+      Body (0.4, Vector3d (0., 0.1, 0.), Vector3d (0.02, 0.01, 0.02)));
+  FillBatchStates (model, num_states, Q, QDot, Tau);
+
+  BatchWorkspace workspace;
+  MatrixNd QDDot (model.qdot_size, num_states);
+  CHECK_THROWS_AS (ForwardDynamicsBatch (model, Q, QDot, Tau, workspace,
+        QDDot), Errors::RBDLError);
+
+  workspace.Bind (model);
+  CHECK_FALSE (workspace.lane_parallel);
+  ForwardDynamicsBatch (model, Q, QDot, Tau, workspace, QDDot);
+
+  for (unsigned int s = 0; s < num_states; s++) {
+    VectorNd q = Q.col(s);
+    VectorNd qdot = QDot.col(s);
+    VectorNd tau = Tau.col(s);
+    VectorNd qddot = VectorNd::Zero (model.qdot_size);
+
+    ForwardDynamics (model, q, qdot, tau, qddot);
+    CHECK_THAT (qddot, AllCloseVector (VectorNd (QDDot.col(s)), TEST_PREC,
+          TEST_PREC));
+  }
+
+  MatrixNd too_small (model.qdot_size, num_states - 1);
+  CHECK_THROWS_AS (ForwardDynamicsBatch (model, Q, QDot, Tau, workspace,
+        too_small), Errors::RBDLError);
+}
@@ -1073,6 +1073,217 @@ TEST_CASE_METHOD (Human36,
   );
 }
 
+TEST_CASE_METHOD (Human36,
+                  __FILE__"_ForwardDynamicsConstraintsSparseJacobian", "") {
+  randomizeStates();
+
+  unsigned int foot_r = model_3dof->GetBodyId ("foot_r");
+  unsigned int foot_l = model_3dof->GetBodyId ("foot_l");
+  unsigned int hand_r = model_3dof->GetBodyId ("hand_r");
+  unsigned int hand_l = model_3dof->GetBodyId ("hand_l");
+
+  ConstraintSet cs_dense;
+  ConstraintSet cs_sparse;
+  ConstraintSet *sets[2] = { &cs_dense, &cs_sparse };
+
+  for (unsigned int i = 0; i < 2; i++) {
+    sets[i]->AddContactConstraint (foot_r, Vector3d (0.1, 0., -0.05),
+                                   Vector3d (1., 0., 0.));
+    sets[i]->AddContactConstraint (foot_r, Vector3d (0.1, 0., -0.05),
+                                   Vector3d (0., 1., 0.));
+    sets[i]->AddContactConstraint (foot_l, Vector3d (0.1, 0., -0.05),
+                                   Vector3d (0., 0., 1.));
+    sets[i]->AddContactConstraint (hand_r, Vector3d (0.1, 0., -0.05),
+                                   Vector3d (1., 0., 0.));
+    sets[i]->AddContactConstraint (hand_l, Vector3d (-0.1, 0., -0.05),
+                                   Vector3d (0., 1., 0.));
+  }
+  cs_sparse.SetSparseJacobian (true);
+  cs_dense.Bind (*model_3dof);
+  cs_sparse.Bind (*model_3dof);
+
+  REQUIRE (cs_sparse.G_pattern.rows() == cs_sparse.size());
+  REQUIRE (cs_sparse.G_pattern.columns.size()
+           < cs_sparse.size() * model_3dof->qdot_size);
+
+  MatrixNd G_dense (MatrixNd::Zero (cs_dense.size(), model_3dof->qdot_size));
+  MatrixNd G_sparse (MatrixNd::Zero (cs_sparse.size(), model_3dof->qdot_size));
+  CalcConstraintsJacobian (*model_3dof, q, cs_dense, G_dense);
+  CalcConstraintsJacobian (*model_3dof, q, cs_sparse, G_sparse);
+
+  CHECK_THAT (G_dense, AllCloseMatrix(G_sparse, TEST_PREC, TEST_PREC));
+
+  VectorNd Gqdot (VectorNd::Zero (cs_sparse.size()));
+  VectorNd GTlambda (VectorNd::Zero (model_3dof->qdot_size));
+  VectorNd lambda (VectorNd::Constant (cs_sparse.size(), 1.3));
+  cs_sparse.G_pattern.multiply (G_sparse, qdot, Gqdot);
+  cs_sparse.G_pattern.multiplyTranspose (G_sparse, lambda, GTlambda);
+
+  CHECK_THAT (VectorNd(G_dense * qdot),
+              AllCloseVector(Gqdot, TEST_PREC, TEST_PREC));
+  CHECK_THAT (VectorNd(G_dense.transpose() * lambda),
+              AllCloseVector(GTlambda, TEST_PREC, TEST_PREC));
+
+  VectorNd qddot_dense (VectorNd::Zero (qddot.size()));
+  VectorNd qddot_sparse (VectorNd::Zero (qddot.size()));
+
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs_dense,
+                                    qddot_dense);
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs_sparse,
+                                    qddot_sparse);
+  CHECK_THAT (qddot_dense, AllCloseVector(qddot_sparse, TEST_PREC,
+                                          TEST_PREC * qddot_dense.norm()));
+  CHECK_THAT (cs_dense.force, AllCloseVector(cs_sparse.force, TEST_PREC,
+                                             TEST_PREC * cs_dense.force.norm()));
+
+  ForwardDynamicsConstraintsRangeSpaceSparse (*model_3dof, q, qdot, tau,
+                                              cs_sparse, qddot_sparse);
+  CHECK_THAT (qddot_dense, AllCloseVector(qddot_sparse, TEST_PREC,
+                                          TEST_PREC * qddot_dense.norm() * 10.));
+  CHECK_THAT (cs_dense.force, AllCloseVector(cs_sparse.force, TEST_PREC,
+                                             TEST_PREC * cs_dense.force.norm() * 10.));
+
+  ForwardDynamicsConstraintsNullSpace (*model_3dof, q, qdot, tau,
+                                       cs_sparse, qddot_sparse);
+  CHECK_THAT (qddot_dense, AllCloseVector(qddot_sparse, TEST_PREC,
+                                          TEST_PREC * qddot_dense.norm() * 10.));
+  CHECK_THAT (cs_dense.force, AllCloseVector(cs_sparse.force, TEST_PREC,
+                                             TEST_PREC * cs_dense.force.norm() * 10.));
+}
+
+TEST_CASE_METHOD (Human36,
+                  __FILE__"_ConstraintsParallelEvaluation", "") {
+  randomizeStates();
+
+  unsigned int foot_r = model_3dof->GetBodyId ("foot_r");
+  unsigned int foot_l = model_3dof->GetBodyId ("foot_l");
+  unsigned int hand_r = model_3dof->GetBodyId ("hand_r");
+  unsigned int hand_l = model_3dof->GetBodyId ("hand_l");
+
+  ConstraintSet cs_serial;
+  ConstraintSet cs_parallel;
+  ConstraintSet *sets[2] = { &cs_serial, &cs_parallel };
+
+  SpatialTransform X_r (Matrix3d::Identity(), Vector3d (0.1, 0., -0.05));
+  SpatialTransform X_l (Matrix3d::Identity(), Vector3d (-0.1, 0., -0.05));
+
+  for (unsigned int i = 0; i < 2; i++) {
+    sets[i]->AddContactConstraint (foot_r, Vector3d (0.1, 0., -0.05),
+                                   Vector3d (1., 0., 0.));
+    sets[i]->AddContactConstraint (foot_r, Vector3d (0.1, 0., -0.05),
+                                   Vector3d (0., 1., 0.));
+    sets[i]->AddContactConstraint (foot_l, Vector3d (0.1, 0., -0.05),
+                                   Vector3d (0., 0., 1.));
+    sets[i]->AddLoopConstraint (hand_r, hand_l, X_r, X_l,
+                                SpatialVector (0., 0., 0., 1., 0., 0.),
+                                true, 0.1);
+    sets[i]->AddLoopConstraint (hand_r, hand_l, X_r, X_l,
+                                SpatialVector (0., 0., 0., 0., 1., 0.),
+                                true, 0.1);
+    sets[i]->AddLoopConstraint (hand_r, hand_l, X_r, X_l,
+                                SpatialVector (0., 0., 1., 0., 0., 0.),
+                                true, 0.1);
+  }
+  cs_parallel.SetNumThreads (3);
+  cs_serial.Bind (*model_3dof);
+  cs_parallel.Bind (*model_3dof);
+
+  REQUIRE (cs_parallel.thread_caches.size() == 2);
+
+  VectorNd err_serial (VectorNd::Zero (cs_serial.size()));
+  VectorNd err_parallel (VectorNd::Zero (cs_parallel.size()));
+  CalcConstraintsPositionError (*model_3dof, q, cs_serial, err_serial);
+  CalcConstraintsPositionError (*model_3dof, q, cs_parallel, err_parallel);
+  CHECK_THAT (err_serial, AllCloseVector(err_parallel, TEST_PREC, TEST_PREC));
+
+  CalcConstraintsVelocityError (*model_3dof, q, qdot, cs_serial, err_serial);
+  CalcConstraintsVelocityError (*model_3dof, q, qdot, cs_parallel,
+                                err_parallel);
+  CHECK_THAT (err_serial, AllCloseVector(err_parallel, TEST_PREC, TEST_PREC));
+
+  CalcConstrainedSystemVariables (*model_3dof, q, qdot, tau, cs_serial);
+  CalcConstrainedSystemVariables (*model_3dof, q, qdot, tau, cs_parallel);
+  CHECK_THAT (cs_serial.G, AllCloseMatrix(cs_parallel.G, TEST_PREC,
+                                          TEST_PREC));
+  CHECK_THAT (cs_serial.gamma, AllCloseVector(cs_parallel.gamma, TEST_PREC,
+                                              TEST_PREC));
+
+  VectorNd qddot_serial (VectorNd::Zero (qddot.size()));
+  VectorNd qddot_parallel (VectorNd::Zero (qddot.size()));
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs_serial,
+                                    qddot_serial);
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs_parallel,
+                                    qddot_parallel);
+  CHECK_THAT (qddot_serial, AllCloseVector(qddot_parallel, TEST_PREC,
+                                           TEST_PREC));
+  CHECK_THAT (cs_serial.force, AllCloseVector(cs_parallel.force, TEST_PREC,
+                                              TEST_PREC));
+}
+
+TEST_CASE_METHOD (Human36,
+                  __FILE__"_ContactConstraintGroups", "") {
+  randomizeStates();
+
+  unsigned int foot_r = model_3dof->GetBodyId ("foot_r");
+  unsigned int foot_l = model_3dof->GetBodyId ("foot_l");
+  unsigned int hand_r = model_3dof->GetBodyId ("hand_r");
+
+  ConstraintSet cs;
+  cs.AddContactConstraint (foot_r, Vector3d ( 0.1,  0.05, -0.05),
+                           Vector3d (1., 0., 0.));
+  cs.AddContactConstraint (foot_r, Vector3d ( 0.1,  0.05, -0.05),
+                           Vector3d (0., 1., 0.));
+  cs.AddContactConstraint (foot_r, Vector3d ( 0.1, -0.05, -0.05),
+                           Vector3d (0., 0., 1.));
+  cs.AddContactConstraint (foot_r, Vector3d (-0.1,  0.05, -0.05),
+                           Vector3d (0., 0., 1.));
+  cs.AddContactConstraint (hand_r, Vector3d ( 0.1,  0., -0.05),
+                           Vector3d (0., 0., 1.));
+  cs.AddContactConstraint (foot_l, Vector3d ( 0.1,  0.05, -0.05),
+                           Vector3d (0., 0., 1.));
+  cs.AddContactConstraint (foot_l, Vector3d (-0.1, -0.05, -0.05),
+                           Vector3d (0., 1., 0.));
+  cs.Bind (*model_3dof);
+
+  // foot_r and foot_l form groups, hand_r is evaluated on its own
+  REQUIRE (cs.contact_groups.size() == 2);
+  REQUIRE (cs.ungrouped_constraints.size() == 1);
+
+  // Reference: every constraint evaluated on its own
+  unsigned int nc = unsigned (cs.size());
+  MatrixNd G_ref (MatrixNd::Zero (nc, model_3dof->qdot_size));
+  VectorNd err_ref (VectorNd::Zero (nc));
+  VectorNd errd_ref (VectorNd::Zero (nc));
+  VectorNd gamma_ref (VectorNd::Zero (nc));
+  VectorNd qddot_zero (VectorNd::Zero (model_3dof->qdot_size));
+
+  UpdateKinematicsCustom (*model_3dof, &q, &qdot, &qddot_zero);
+  for (unsigned int i = 0; i < cs.constraints.size(); i++) {
+    cs.constraints[i]->calcConstraintJacobian (*model_3dof, 0., q, qdot,
+                                               G_ref, cs.cache);
+    cs.constraints[i]->calcPositionError (*model_3dof, 0., q, err_ref,
+                                          cs.cache);
+    cs.constraints[i]->calcVelocityError (*model_3dof, 0., q, qdot, G_ref,
+                                          errd_ref, cs.cache);
+    cs.constraints[i]->calcGamma (*model_3dof, 0., q, qdot, G_ref,
+                                  gamma_ref, cs.cache);
+  }
+
+  MatrixNd G (MatrixNd::Zero (nc, model_3dof->qdot_size));
+  VectorNd err (VectorNd::Zero (nc));
+  CalcConstraintsJacobian (*model_3dof, q, cs, G);
+  CHECK_THAT (G_ref, AllCloseMatrix(G, TEST_PREC, TEST_PREC));
+
+  CalcConstraintsPositionError (*model_3dof, q, cs, err);
+  CHECK_THAT (err_ref, AllCloseVector(err, TEST_PREC, TEST_PREC));
+
+  CalcConstraintsVelocityError (*model_3dof, q, qdot, cs, err);
+  CHECK_THAT (errd_ref, AllCloseVector(err, TEST_PREC, TEST_PREC));
+
+  CalcConstrainedSystemVariables (*model_3dof, q, qdot, tau, cs);
+  CHECK_THAT (gamma_ref, AllCloseVector(cs.gamma, TEST_PREC, TEST_PREC));
+}
+
 TEST_CASE_METHOD (Human36,
                   __FILE__"_ForwardDynamicsContactsImpulses", "") {
   VectorNd qddot_lagrangian (VectorNd::Zero(qddot.size()));
@@ -1124,3 +1335,425 @@ TEST_CASE_METHOD (Human36,
               AllCloseVector(heel_right_velocity, TEST_PREC, TEST_PREC)
   );
 }
+
+// Human36 with both feet in contact (three directions each), optionally
+// with a redundant duplicate of the normal direction of the left foot.
+static void AddFeetContacts (Human36 &human, ConstraintSet &cs,
+                             bool redundant) {
+  Vector3d heel_point (-0.03, 0., -0.03);
+  unsigned int feet[2] = { human.body_id_3dof[Human36::BodyFootLeft],
+                           human.body_id_3dof[Human36::BodyFootRight] };
+
+  for (unsigned int i = 0; i < 2; i++) {
+    cs.AddContactConstraint (feet[i], heel_point, Vector3d (1., 0., 0.));
+    cs.AddContactConstraint (feet[i], heel_point, Vector3d (0., 1., 0.));
+    cs.AddContactConstraint (feet[i], heel_point, Vector3d (0., 0., 1.));
+  }
+
+  if (redundant) {
+    cs.AddContactConstraint (feet[0], heel_point, Vector3d (0., 0., 1.));
+  }
+}
+
+static void SetAllCompliances (ConstraintSet &cs, double compliance) {
+  for (unsigned int i = 0; i <= cs.getGroupIndexMax(); i++) {
+    cs.setCompliance (i, compliance);
+  }
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestCompliantConstraintsSolvers", "") {
+  randomizeStates();
+
+  ConstraintSet cs;
+  AddFeetContacts (*this, cs, false);
+  SetAllCompliances (cs, 1.0e-3);
+
+  ConstraintSet cs_llt = cs.Copy();
+  ConstraintSet cs_ldlt = cs.Copy();
+  ConstraintSet cs_range_space = cs.Copy();
+  ConstraintSet cs_kokkevis = cs.Copy();
+  cs_llt.linear_solver = LinearSolverLLT;
+  cs_ldlt.linear_solver = LinearSolverLDLT;
+  cs_kokkevis.linear_solver = LinearSolverLLT;
+
+  cs.Bind (*model_3dof);
+  cs_llt.Bind (*model_3dof);
+  cs_ldlt.Bind (*model_3dof);
+  cs_range_space.Bind (*model_3dof);
+  cs_kokkevis.Bind (*model_3dof);
+
+  VectorNd qddot = VectorNd::Zero (qdot.size());
+  VectorNd qddot_llt = VectorNd::Zero (qdot.size());
+  VectorNd qddot_ldlt = VectorNd::Zero (qdot.size());
+  VectorNd qddot_range_space = VectorNd::Zero (qdot.size());
+  VectorNd qddot_kokkevis = VectorNd::Zero (qdot.size());
+
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs, qddot);
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs_llt,
+                                    qddot_llt);
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs_ldlt,
+                                    qddot_ldlt);
+  ForwardDynamicsConstraintsRangeSpaceSparse (*model_3dof, q, qdot, tau,
+                                              cs_range_space,
+                                              qddot_range_space);
+  ForwardDynamicsContactsKokkevis (*model_3dof, q, qdot, tau, cs_kokkevis,
+                                   qddot_kokkevis);
+
+  // the constraints are relaxed by the compliance times the force
+  VectorNd relaxed_gamma = cs.gamma;
+  for (unsigned int i = 0; i < cs.size(); i++) {
+    relaxed_gamma[i] -= 1.0e-3 * cs.force[i];
+  }
+  VectorNd constraint_acceleration = cs.G * qddot;
+  CHECK_THAT (relaxed_gamma,
+              AllCloseVector (constraint_acceleration, 1.0e-9, 1.0e-9));
+  CHECK (fabs(cs.force.dot (constraint_acceleration - cs.gamma)) > 1.0e-6);
+
+  CHECK_THAT (qddot, AllCloseVector (qddot_llt, 1.0e-9, 1.0e-9));
+  CHECK_THAT (qddot, AllCloseVector (qddot_ldlt, 1.0e-9, 1.0e-9));
+  CHECK_THAT (qddot, AllCloseVector (qddot_range_space, 1.0e-9, 1.0e-9));
+  CHECK_THAT (qddot, AllCloseVector (qddot_kokkevis, 1.0e-9, 1.0e-9));
+
+  CHECK_THAT (cs.force, AllCloseVector (cs_llt.force, 1.0e-9, 1.0e-9));
+  CHECK_THAT (cs.force, AllCloseVector (cs_ldlt.force, 1.0e-9, 1.0e-9));
+  CHECK_THAT (cs.force, AllCloseVector (cs_range_space.force, 1.0e-9, 1.0e-9));
+  CHECK_THAT (cs.force, AllCloseVector (cs_kokkevis.force, 1.0e-9, 1.0e-9));
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestRigidConstraintsLLT", "") {
+  randomizeStates();
+
+  ConstraintSet cs;
+  AddFeetContacts (*this, cs, false);
+  ConstraintSet cs_llt = cs.Copy();
+  cs_llt.linear_solver = LinearSolverLLT;
+  cs.Bind (*model_3dof);
+  cs_llt.Bind (*model_3dof);
+
+  VectorNd qddot = VectorNd::Zero (qdot.size());
+  VectorNd qddot_llt = VectorNd::Zero (qdot.size());
+
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs, qddot);
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs_llt,
+                                    qddot_llt);
+
+  CHECK_THAT (qddot, AllCloseVector (qddot_llt, 1.0e-9, 1.0e-9));
+  CHECK_THAT (cs.force, AllCloseVector (cs_llt.force, 1.0e-9, 1.0e-9));
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestCompliantRedundantConstraints", "") {
+  randomizeStates();
+
+  ConstraintSet cs;
+  AddFeetContacts (*this, cs, true);
+  cs.linear_solver = LinearSolverLLT;
+  cs.Bind (*model_3dof);
+  SetAllCompliances (cs, 1.0e-6);
+
+  VectorNd qddot = VectorNd::Zero (qdot.size());
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs, qddot);
+
+  REQUIRE (cs.size() == 7);
+  CHECK (qddot.allFinite());
+  CHECK (cs.force.allFinite());
+
+  // the force of the left foot normal is shared by both rows
+  unsigned int normal_row = 2;
+  unsigned int duplicate_row = 6;
+  CHECK_THAT (cs.force[normal_row],
+              IsClose (cs.force[duplicate_row], 1.0e-9, 1.0e-9));
+
+  // and the constraints are (nearly) satisfied
+  VectorNd constraint_acceleration = cs.G * qddot;
+  CHECK_THAT (cs.gamma,
+              AllCloseVector (constraint_acceleration, 1.0e-4, 1.0e-4));
+
+  ConstraintSet cs_range_space;
+  AddFeetContacts (*this, cs_range_space, true);
+  cs_range_space.Bind (*model_3dof);
+  SetAllCompliances (cs_range_space, 1.0e-6);
+
+  VectorNd qddot_range_space = VectorNd::Zero (qdot.size());
+  ForwardDynamicsConstraintsRangeSpaceSparse (*model_3dof, q, qdot, tau,
+                                              cs_range_space,
+                                              qddot_range_space);
+  CHECK_THAT (qddot, AllCloseVector (qddot_range_space, 1.0e-8, 1.0e-8));
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestCompliantConstraintImpulses", "") {
+  randomizeStates();
+
+  ConstraintSet cs;
+  AddFeetContacts (*this, cs, false);
+  cs.linear_solver = LinearSolverLDLT;
+  cs.Bind (*model_3dof);
+  SetAllCompliances (cs, 1.0e-2);
+  CHECK (cs.getCompliance (0) == 1.0e-2);
+
+  ConstraintSet cs_range_space = cs.Copy();
+  cs_range_space.Bind (*model_3dof);
+
+  VectorNd qdotplus = VectorNd::Zero (qdot.size());
+  VectorNd qdotplus_range_space = VectorNd::Zero (qdot.size());
+  ComputeConstraintImpulsesDirect (*model_3dof, q, qdot, cs, qdotplus);
+  ComputeConstraintImpulsesRangeSpaceSparse (*model_3dof, q, qdot,
+                                             cs_range_space,
+                                             qdotplus_range_space);
+
+  CHECK_THAT (qdotplus, AllCloseVector (qdotplus_range_space, 1.0e-9, 1.0e-9));
+
+  // ComputeConstraintImpulsesDirect() reports the negative impulses
+  VectorNd relaxed_v_plus = cs.v_plus;
+  for (unsigned int i = 0; i < cs.size(); i++) {
+    relaxed_v_plus[i] -= 1.0e-2 * cs_range_space.impulse[i];
+    CHECK_THAT (cs.impulse[i],
+                IsClose (-cs_range_space.impulse[i], 1.0e-9, 1.0e-9));
+  }
+  VectorNd constraint_velocity = cs.G * qdotplus;
+  CHECK_THAT (relaxed_v_plus,
+              AllCloseVector (constraint_velocity, 1.0e-9, 1.0e-9));
+
+  CHECK_THROWS_AS (cs.setCompliance (0, -1.), Errors::RBDLInvalidParameterError);
+}
+
+static void CheckNullSpaceFactorization (ConstraintSet &cs) {
+  const NullSpaceQRFactorization &nsf = cs.null_space_factorization;
+  unsigned int n = nsf.Q.rows();
+  unsigned int m = nsf.rows.size();
+
+  MatrixNd QTQ = nsf.Q.transpose() * nsf.Q;
+  MatrixNd identity = MatrixNd::Identity (n, n);
+  CHECK_THAT (QTQ, AllCloseMatrix (identity, 1.0e-12, 1.0e-12));
+
+  MatrixNd GaT (n, m);
+  for (unsigned int k = 0; k < m; k++) {
+    GaT.col(k) = cs.G.row(nsf.rows[k]).transpose();
+  }
+  MatrixNd QR = nsf.Q.leftCols(m)
+    * nsf.R.topLeftCorner(m, m).triangularView<Eigen::Upper>();
+  CHECK_THAT (GaT, AllCloseMatrix (QR, 1.0e-12, 1.0e-12));
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestNullSpaceFactorized", "") {
+  randomizeStates();
+
+  ConstraintSet cs;
+  AddFeetContacts (*this, cs, false);
+  ConstraintSet cs_reference = cs.Copy();
+  cs.Bind (*model_3dof);
+  cs_reference.Bind (*model_3dof);
+
+  VectorNd qddot = VectorNd::Zero (qdot.size());
+  VectorNd qddot_reference = VectorNd::Zero (qdot.size());
+
+  CalcConstrainedSystemVariables (*model_3dof, q, qdot, tau, cs);
+  cs.FactorizeNullSpace();
+  SolveConstrainedSystemNullSpaceFactorized (cs, tau, qddot);
+  CheckNullSpaceFactorization (cs);
+
+  ForwardDynamicsConstraintsNullSpace (*model_3dof, q, qdot, tau, cs_reference,
+                                       qddot_reference);
+
+  CHECK_THAT (qddot_reference, AllCloseVector (qddot, 1.0e-9, 1.0e-9));
+  CHECK_THAT (cs_reference.force, AllCloseVector (cs.force, 1.0e-9, 1.0e-9));
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestNullSpaceFactorizedActivation", "") {
+  randomizeStates();
+
+  ConstraintSet cs;
+  AddFeetContacts (*this, cs, false);
+  ConstraintSet cs_all = cs.Copy();
+  cs.Bind (*model_3dof);
+  cs_all.Bind (*model_3dof);
+
+  // only the right foot (second group) in contact
+  ConstraintSet cs_right;
+  Vector3d heel_point (-0.03, 0., -0.03);
+  cs_right.AddContactConstraint (body_id_3dof[BodyFootRight], heel_point,
+                                 Vector3d (1., 0., 0.));
+  cs_right.AddContactConstraint (body_id_3dof[BodyFootRight], heel_point,
+                                 Vector3d (0., 1., 0.));
+  cs_right.AddContactConstraint (body_id_3dof[BodyFootRight], heel_point,
+                                 Vector3d (0., 0., 1.));
+  cs_right.Bind (*model_3dof);
+
+  VectorNd qddot = VectorNd::Zero (qdot.size());
+  VectorNd qddot_all = VectorNd::Zero (qdot.size());
+  VectorNd qddot_right = VectorNd::Zero (qdot.size());
+
+  ForwardDynamicsConstraintsNullSpace (*model_3dof, q, qdot, tau, cs_all,
+                                       qddot_all);
+  ForwardDynamicsConstraintsNullSpace (*model_3dof, q, qdot, tau, cs_right,
+                                       qddot_right);
+
+  CalcConstrainedSystemVariables (*model_3dof, q, qdot, tau, cs);
+  cs.FactorizeNullSpace();
+
+  // removing the left foot with Givens rotations
+  cs.DeactivateConstraint (0);
+  CHECK (!cs.IsConstraintActive (0));
+  CHECK (cs.IsConstraintActive (1));
+  CHECK (cs.null_space_factorization.update_count == 3);
+  CheckNullSpaceFactorization (cs);
+
+  SolveConstrainedSystemNullSpaceFactorized (cs, tau, qddot);
+  CHECK_THAT (qddot_right, AllCloseVector (qddot, 1.0e-9, 1.0e-9));
+  VectorNd force_right = cs.force.tail(3);
+  CHECK_THAT (cs_right.force, AllCloseVector (force_right, 1.0e-9, 1.0e-9));
+  CHECK (cs.force.head(3).isZero());
+
+  // adding it again: the rows are now in a different order
+  cs.ActivateConstraint (0);
+  CHECK (cs.IsConstraintActive (0));
+  CheckNullSpaceFactorization (cs);
+
+  SolveConstrainedSystemNullSpaceFactorized (cs, tau, qddot);
+  CHECK_THAT (qddot_all, AllCloseVector (qddot, 1.0e-9, 1.0e-9));
+  CHECK_THAT (cs_all.force, AllCloseVector (cs.force, 1.0e-9, 1.0e-9));
+
+  // deactivating before the factorization gives the same result
+  cs.DeactivateConstraint (1);
+  cs.FactorizeNullSpace();
+  CHECK (cs.null_space_factorization.update_count == 0);
+  cs.ActivateConstraint (1);
+  cs.DeactivateConstraint (0);
+  CheckNullSpaceFactorization (cs);
+
+  SolveConstrainedSystemNullSpaceFactorized (cs, tau, qddot);
+  CHECK_THAT (qddot_right, AllCloseVector (qddot, 1.0e-9, 1.0e-9));
+
+  ConstraintSet cs_unfactorized = cs_all.Copy();
+  cs_unfactorized.Bind (*model_3dof);
+  CHECK_THROWS_AS (SolveConstrainedSystemNullSpaceFactorized (cs_unfactorized,
+                   tau, qddot), Errors::RBDLError);
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestRigidConstraintsMixedPrecisionLU",
+                  "") {
+  randomizeStates();
+
+  ConstraintSet cs;
+  AddFeetContacts (*this, cs, false);
+  ConstraintSet cs_mixed = cs.Copy();
+  ConstraintSet cs_null_space = cs.Copy();
+  ConstraintSet cs_null_space_mixed = cs.Copy();
+  ConstraintSet cs_kokkevis = cs.Copy();
+  ConstraintSet cs_kokkevis_mixed = cs.Copy();
+  cs_mixed.linear_solver = LinearSolverMixedPrecisionLU;
+  cs_null_space_mixed.linear_solver = LinearSolverMixedPrecisionLU;
+  cs_kokkevis_mixed.linear_solver = LinearSolverMixedPrecisionLU;
+  cs.Bind (*model_3dof);
+  cs_mixed.Bind (*model_3dof);
+  cs_null_space.Bind (*model_3dof);
+  cs_null_space_mixed.Bind (*model_3dof);
+  cs_kokkevis.Bind (*model_3dof);
+  cs_kokkevis_mixed.Bind (*model_3dof);
+
+  VectorNd qddot = VectorNd::Zero (qdot.size());
+  VectorNd qddot_mixed = VectorNd::Zero (qdot.size());
+
+  // the systems of the random states have condition numbers of about 1e7,
+  // hence the solutions only agree relative to their largest entries
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs, qddot);
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs_mixed,
+                                    qddot_mixed);
+  double prec = 1.0e-11 * std::max (qddot.lpNorm<Eigen::Infinity>(),
+                                    cs.force.lpNorm<Eigen::Infinity>());
+  CHECK_THAT (qddot, AllCloseVector (qddot_mixed, prec, 1.0e-9));
+  CHECK_THAT (cs.force, AllCloseVector (cs_mixed.force, prec, 1.0e-9));
+
+  ForwardDynamicsConstraintsNullSpace (*model_3dof, q, qdot, tau,
+                                       cs_null_space, qddot);
+  ForwardDynamicsConstraintsNullSpace (*model_3dof, q, qdot, tau,
+                                       cs_null_space_mixed, qddot_mixed);
+  CHECK_THAT (qddot, AllCloseVector (qddot_mixed, prec, 1.0e-9));
+  CHECK_THAT (cs_null_space.force,
+              AllCloseVector (cs_null_space_mixed.force, prec, 1.0e-9));
+
+  ForwardDynamicsContactsKokkevis (*model_3dof, q, qdot, tau, cs_kokkevis,
+                                   qddot);
+  ForwardDynamicsContactsKokkevis (*model_3dof, q, qdot, tau,
+                                   cs_kokkevis_mixed, qddot_mixed);
+  CHECK_THAT (qddot, AllCloseVector (qddot_mixed, prec, 1.0e-9));
+  CHECK_THAT (cs_kokkevis.force,
+              AllCloseVector (cs_kokkevis_mixed.force, prec, 1.0e-9));
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestRedundantRigidConstraintsSymmetric",
+                  "") {
+  randomizeStates();
+
+  ConstraintSet cs;
+  AddFeetContacts (*this, cs, false);
+  cs.Bind (*model_3dof);
+
+  VectorNd qddot = VectorNd::Zero (qdot.size());
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs, qddot);
+  double prec = 1.0e-11 * std::max (qddot.lpNorm<Eigen::Infinity>(),
+                                    cs.force.lpNorm<Eigen::Infinity>());
+
+  // without compliance the Schur complement of the redundant constraints is
+  // singular and the system is solved as a whole
+  LinearSolver solvers[2] = { LinearSolverLLT, LinearSolverLDLT };
+  for (unsigned int k = 0; k < 2; k++) {
+    ConstraintSet cs_redundant;
+    AddFeetContacts (*this, cs_redundant, true);
+    cs_redundant.linear_solver = solvers[k];
+    cs_redundant.Bind (*model_3dof);
+
+    VectorNd qddot_redundant = VectorNd::Zero (qdot.size());
+    ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau,
+                                      cs_redundant, qddot_redundant);
+
+    REQUIRE (cs_redundant.size() == 7);
+    CHECK (qddot_redundant.allFinite());
+    CHECK (cs_redundant.force.allFinite());
+    CHECK_THAT (qddot, AllCloseVector (qddot_redundant, prec, 1.0e-9));
+
+    // the normal force of the left foot is shared by both of its rows
+    CHECK_THAT (cs.force[2], IsClose (cs_redundant.force[2]
+                                      + cs_redundant.force[6], prec, 1.0e-9));
+  }
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestSymmetricSolversJacobianPattern",
+                  "") {
+  randomizeStates();
+
+  ConstraintSet cs;
+  AddFeetContacts (*this, cs, false);
+  SetAllCompliances (cs, 1.0e-3);
+  cs.linear_solver = LinearSolverLDLT;
+
+  ConstraintSet cs_sparse = cs.Copy();
+  cs_sparse.SetSparseJacobian (true);
+  ConstraintSet cs_null_space = cs.Copy();
+  ConstraintSet cs_null_space_lu = cs.Copy();
+  cs_null_space_lu.linear_solver = LinearSolverPartialPivLU;
+
+  cs.Bind (*model_3dof);
+  cs_sparse.Bind (*model_3dof);
+  cs_null_space.Bind (*model_3dof);
+  cs_null_space_lu.Bind (*model_3dof);
+  REQUIRE (cs_sparse.G_pattern.rows() == cs.size());
+
+  VectorNd qddot = VectorNd::Zero (qdot.size());
+  VectorNd qddot_sparse = VectorNd::Zero (qdot.size());
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs, qddot);
+  ForwardDynamicsConstraintsDirect (*model_3dof, q, qdot, tau, cs_sparse,
+                                    qddot_sparse);
+  CHECK_THAT (qddot, AllCloseVector (qddot_sparse, 1.0e-9, 1.0e-9));
+  CHECK_THAT (cs.force, AllCloseVector (cs_sparse.force, 1.0e-9, 1.0e-9));
+
+  // G Y of the null-space method is not symmetric, the symmetric solvers
+  // use the LU decomposition
+  ForwardDynamicsConstraintsNullSpace (*model_3dof, q, qdot, tau,
+                                       cs_null_space, qddot);
+  ForwardDynamicsConstraintsNullSpace (*model_3dof, q, qdot, tau,
+                                       cs_null_space_lu, qddot_sparse);
+  CHECK (qddot.allFinite());
+  CHECK_THAT (qddot, AllCloseVector (qddot_sparse, 0., 0.));
+  CHECK_THAT (cs_null_space.force,
+              AllCloseVector (cs_null_space_lu.force, 0., 0.));
+}
@@ -379,6 +379,44 @@ private:
 
 
 
+/* Throws when its position error is evaluated, e.g. to check that the
+ * exceptions of constraints evaluated by worker threads reach the caller. */
+class ThrowingCustomConstraint : public RigidBodyDynamics::Constraint
+{
+public:
+  ThrowingCustomConstraint()
+    :Constraint(NULL,ConstraintTypeCustom,1,
+                std::numeric_limits<unsigned int>::max())
+  {
+  }
+
+  void bind(const Model &) override {}
+
+  void calcConstraintJacobian(Model &, const double, const VectorNd &,
+                              const VectorNd &, MatrixNd &,
+                              ConstraintCache &, bool) override {}
+
+  void calcGamma(Model &, const double, const VectorNd &, const VectorNd &,
+                 const MatrixNd &, VectorNd &, ConstraintCache &,
+                 bool) override {}
+
+  void calcPositionError(Model &, const double, const VectorNd &,
+                         VectorNd &, ConstraintCache &, bool) override {
+    throw Errors::RBDLError("Error: ThrowingCustomConstraint evaluated.\n");
+  }
+
+  void calcVelocityError(Model &, const double, const VectorNd &,
+                         const VectorNd &, const MatrixNd &, VectorNd &,
+                         ConstraintCache &, bool) override {}
+
+  void calcConstraintForces(Model &, const double, const VectorNd &,
+                            const VectorNd &, const MatrixNd &,
+                            const VectorNd &, std::vector<unsigned int> &,
+                            std::vector<SpatialTransform> &,
+                            std::vector<SpatialVector> &,
+                            ConstraintCache &, bool, bool) override {}
+};
+
 class DoublePerpendicularPendulumCustomConstraint {
 
 public:
@@ -721,3 +759,35 @@ TEST_CASE(__FILE__"_CustomConstraintCorrectnessTest", "") {
     CHECK_THAT(a030[i],IsClose(a030c[i],TEST_PREC, TEST_PREC));
   }
 }
+
+TEST_CASE(__FILE__"_CustomConstraintWorkerException", "") {
+  DoublePerpendicularPendulumCustomConstraint dbcc;
+
+  // every constraint is evaluated by its own thread, the throwing
+  // constraint by the last worker
+  ConstraintSet cs;
+  cs.AddCustomConstraint(dbcc.ccPJZaxis);
+  cs.AddCustomConstraint(dbcc.ccPJYaxis);
+  cs.AddCustomConstraint(std::make_shared<ThrowingCustomConstraint>());
+  cs.SetNumThreads(3);
+  cs.Bind(dbcc.model);
+  REQUIRE(cs.workers.size() == 2);
+
+  VectorNd err = VectorNd::Zero(cs.size());
+  CHECK_THROWS_AS(CalcConstraintsPositionError(dbcc.model, dbcc.q, cs, err),
+                  Errors::RBDLError);
+
+  // the workers are still usable after the exception
+  MatrixNd G = MatrixNd::Zero(cs.size(), dbcc.model.dof_count);
+  MatrixNd G_serial = MatrixNd::Zero(dbcc.cs.size(), dbcc.model.dof_count);
+  CalcConstraintsJacobian(dbcc.model, dbcc.q, cs, G);
+  CalcConstraintsJacobian(dbcc.model, dbcc.q, dbcc.cs, G_serial);
+  CHECK_THAT(G_serial, AllCloseMatrix(MatrixNd(G.topRows(dbcc.cs.size())),
+                                      TEST_PREC, TEST_PREC));
+
+  // copies start their own workers
+  ConstraintSet cs_copy = cs.Copy();
+  CHECK(cs_copy.workers.size() == 0);
+  cs_copy.Bind(dbcc.model);
+  CHECK(cs_copy.workers.size() == 2);
+}
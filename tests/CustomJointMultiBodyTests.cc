@@ -1010,6 +1010,300 @@ TEST_CASE_METHOD (CustomJointMultiBodyFixture,
 
 }
 
+//==============================================================================
+/*
+  Custom joints derived from CustomJointN run through the fixed-size code
+  paths of the algorithms. The results have to match a model with the
+  equivalent built-in joints and, as for the native multi-DoF joints, the
+  dynamics algorithms must not allocate memory on the heap.
+*/
+//==============================================================================
+
+struct CustomRevoluteXJointN : public CustomJointN<1> {
+  virtual void jcalc (Model &model,
+                      unsigned int joint_id,
+                      const Math::VectorNd &q,
+                      const Math::VectorNd &qdot)
+  {
+    model.X_J[joint_id] = Xrotx(q[model.mJoints[joint_id].q_index]);
+    MotionSubspace() << 1., 0., 0., 0., 0., 0.;
+    model.v_J[joint_id] = MotionSubspace()
+      * qdot.segment<1>(model.mJoints[joint_id].q_index);
+    model.c_J[joint_id].setZero();
+  }
+
+  virtual void jcalc_X_lambda_S ( Model &model,
+                                  unsigned int joint_id,
+                                  const Math::VectorNd &q)
+  {
+    model.X_lambda[joint_id] =
+      Xrotx (q[model.mJoints[joint_id].q_index]) * model.X_T[joint_id];
+    MotionSubspace() << 1., 0., 0., 0., 0., 0.;
+  }
+
+  virtual CustomJoint* Clone () const {
+    return new CustomRevoluteXJointN (*this);
+  }
+};
+
+struct CustomEulerZYXJointN : public CustomJointN<3> {
+  void calcTransformAndMotionSubspace (Model &model,
+                                       unsigned int joint_id,
+                                       const Math::VectorNd &q)
+  {
+    unsigned int q_index = model.mJoints[joint_id].q_index;
+    double s0 = sin (q[q_index]);
+    double c0 = cos (q[q_index]);
+    double s1 = sin (q[q_index + 1]);
+    double c1 = cos (q[q_index + 1]);
+    double s2 = sin (q[q_index + 2]);
+    double c2 = cos (q[q_index + 2]);
+
+    model.X_J[joint_id] = SpatialTransform (Matrix3d(
+                       c0 * c1,                s0 * c1,     -s1,
+        c0 * s1 * s2 - s0 * c2, s0 * s1 * s2 + c0 * c2, c1 * s2,
+        c0 * s1 * c2 + s0 * s2, s0 * s1 * c2 - c0 * s2, c1 * c2
+        ), Vector3d::Zero());
+
+    MotionSubspace().setZero();
+    MotionSubspace()(0,0) = -s1;
+    MotionSubspace()(0,2) = 1.;
+    MotionSubspace()(1,0) = c1 * s2;
+    MotionSubspace()(1,1) = c2;
+    MotionSubspace()(2,0) = c1 * c2;
+    MotionSubspace()(2,1) = - s2;
+  }
+
+  virtual void jcalc (Model &model,
+                      unsigned int joint_id,
+                      const Math::VectorNd &q,
+                      const Math::VectorNd &qdot)
+  {
+    calcTransformAndMotionSubspace (model, joint_id, q);
+
+    unsigned int q_index = model.mJoints[joint_id].q_index;
+    double s1 = sin (q[q_index + 1]);
+    double c1 = cos (q[q_index + 1]);
+    double s2 = sin (q[q_index + 2]);
+    double c2 = cos (q[q_index + 2]);
+    double qdot0 = qdot[q_index];
+    double qdot1 = qdot[q_index + 1];
+    double qdot2 = qdot[q_index + 2];
+
+    model.v_J[joint_id] = MotionSubspace() * qdot.segment<3>(q_index);
+    model.c_J[joint_id].set(
+        -c1*qdot0*qdot1,
+        -s1*s2*qdot0*qdot1 + c1*c2*qdot0*qdot2 - s2*qdot1*qdot2,
+        -s1*c2*qdot0*qdot1 - c1*s2*qdot0*qdot2 - c2*qdot1*qdot2,
+        0., 0., 0.
+        );
+  }
+
+  virtual void jcalc_X_lambda_S ( Model &model,
+                                  unsigned int joint_id,
+                                  const Math::VectorNd &q)
+  {
+    calcTransformAndMotionSubspace (model, joint_id, q);
+    model.X_lambda[joint_id] = model.X_J[joint_id] * model.X_T[joint_id];
+  }
+
+  virtual CustomJoint* Clone () const {
+    return new CustomEulerZYXJointN (*this);
+  }
+};
+
+struct CustomJointNFixture {
+  CustomJointNFixture () {
+    Body body_a (1., Vector3d (0.1, 0.2, 0.3), Vector3d (1.1, 1.2, 1.3));
+    Body body_b (2., Vector3d (0.2, -0.1, 0.4), Vector3d (0.5, 0.6, 0.7));
+    SpatialTransform X_ab = Xtrans (Vector3d (0.3, -0.2, 0.5))
+      * Xrotz (0.4);
+
+    Joint joint_rx (SpatialVector (1., 0., 0., 0., 0., 0.));
+    Joint joint_zyx (JointTypeEulerZYX);
+
+    unsigned int ref_1 = reference_model.AddBody (0, X_ab, joint_zyx, body_a);
+    unsigned int ref_2 = reference_model.AddBody (ref_1, X_ab, joint_rx,
+                                                  body_b);
+    reference_model.AddBody (ref_2, X_ab, joint_zyx, body_a);
+    reference_model.AddBody (ref_1, X_ab, joint_rx, body_b);
+
+    unsigned int cus_1 = custom_model.AddBodyCustomJoint (0, X_ab,
+                                                          &zyx_joint_1, body_a);
+    unsigned int cus_2 = custom_model.AddBodyCustomJoint (cus_1, X_ab,
+                                                          &rx_joint_1, body_b);
+    custom_model.AddBodyCustomJoint (cus_2, X_ab, &zyx_joint_2, body_a);
+    custom_model.AddBodyCustomJoint (cus_1, X_ab, &rx_joint_2, body_b);
+
+    q = VectorNd::Zero (reference_model.q_size);
+    qdot = VectorNd::Zero (reference_model.qdot_size);
+    tau = VectorNd::Zero (reference_model.qdot_size);
+    for (unsigned int i = 0; i < q.size(); i++) {
+      q[i] = 0.3 * i - 0.7;
+      qdot[i] = 0.5 - 0.2 * i;
+      tau[i] = 0.1 * i * i - 0.4;
+    }
+  }
+
+  Model reference_model;
+  Model custom_model;
+
+  CustomEulerZYXJointN zyx_joint_1;
+  CustomEulerZYXJointN zyx_joint_2;
+  CustomRevoluteXJointN rx_joint_1;
+  CustomRevoluteXJointN rx_joint_2;
+
+  VectorNd q;
+  VectorNd qdot;
+  VectorNd tau;
+};
+
+TEST_CASE_METHOD (CustomJointNFixture, __FILE__"_TestCustomJointNDynamics",
+                  "") {
+  REQUIRE (custom_model.dof_count == reference_model.dof_count);
+
+  VectorNd qddot_ref = VectorNd::Zero (reference_model.qdot_size);
+  VectorNd qddot_cus = VectorNd::Zero (reference_model.qdot_size);
+  ForwardDynamics (reference_model, q, qdot, tau, qddot_ref);
+  ForwardDynamics (custom_model, q, qdot, tau, qddot_cus);
+  CHECK_THAT (qddot_ref, AllCloseVector (qddot_cus, TEST_PREC, TEST_PREC));
+
+  VectorNd tau_ref = VectorNd::Zero (reference_model.qdot_size);
+  VectorNd tau_cus = VectorNd::Zero (reference_model.qdot_size);
+  InverseDynamics (reference_model, q, qdot, qddot_ref, tau_ref);
+  InverseDynamics (custom_model, q, qdot, qddot_ref, tau_cus);
+  CHECK_THAT (tau_ref, AllCloseVector (tau_cus, TEST_PREC, TEST_PREC));
+  CHECK_THAT (tau, AllCloseVector (tau_cus, TEST_PREC, TEST_PREC));
+
+  MatrixNd H_ref = MatrixNd::Zero (reference_model.qdot_size,
+                                   reference_model.qdot_size);
+  MatrixNd H_cus = H_ref;
+  CompositeRigidBodyAlgorithm (reference_model, q, H_ref);
+  CompositeRigidBodyAlgorithm (custom_model, q, H_cus);
+  CHECK_THAT (H_ref, AllCloseMatrix (H_cus, TEST_PREC, TEST_PREC));
+
+  CalcMInvTimesTau (reference_model, q, tau, qddot_ref);
+  CalcMInvTimesTau (custom_model, q, tau, qddot_cus);
+  CHECK_THAT (qddot_ref, AllCloseVector (qddot_cus, TEST_PREC, TEST_PREC));
+}
+
+TEST_CASE_METHOD (CustomJointNFixture,
+                  __FILE__"_TestCustomJointNNoHeapAllocations", "") {
+  if (!HeapAllocationCountAvailable()) {
+    WARN ("heap allocation counting not available, skipping test");
+    return;
+  }
+
+  VectorNd qddot = VectorNd::Zero (custom_model.qdot_size);
+  VectorNd tau_id = VectorNd::Zero (custom_model.qdot_size);
+  MatrixNd H = MatrixNd::Zero (custom_model.qdot_size,
+                               custom_model.qdot_size);
+
+  ForwardDynamics (custom_model, q, qdot, tau, qddot);
+  InverseDynamics (custom_model, q, qdot, qddot, tau_id);
+  CompositeRigidBodyAlgorithm (custom_model, q, H);
+  CalcMInvTimesTau (custom_model, q, tau, qddot);
+
+  size_t allocations = HeapAllocationCount();
+  ForwardDynamics (custom_model, q, qdot, tau, qddot);
+  CHECK (HeapAllocationCount() - allocations == 0);
+
+  allocations = HeapAllocationCount();
+  InverseDynamics (custom_model, q, qdot, qddot, tau_id);
+  CHECK (HeapAllocationCount() - allocations == 0);
+
+  allocations = HeapAllocationCount();
+  CompositeRigidBodyAlgorithm (custom_model, q, H);
+  CHECK (HeapAllocationCount() - allocations == 0);
+
+  allocations = HeapAllocationCount();
+  CalcMInvTimesTau (custom_model, q, tau, qddot);
+  CHECK (HeapAllocationCount() - allocations == 0);
+}
+
+TEST_CASE_METHOD (CustomJointNFixture, __FILE__"_TestCloneForThread", "") {
+  custom_model.emulate_multi_dof_joints = false;
+  custom_model.AddBody (3, Xtrans (Vector3d (0.1, 0.2, 0.3)),
+                        Joint (SpatialVector (0., 0., 1., 0., 0., 0.),
+                               SpatialVector (1., 0., 0., 0., 0., 0.)),
+                        Body (1., Vector3d (0.1, 0.2, 0.3),
+                              Vector3d (1.1, 1.2, 1.3)));
+  REQUIRE (custom_model.mMultiDofJoints.size() == 1);
+
+  Model clone = custom_model.CloneForThread();
+  REQUIRE (clone.mCustomJoints.size() == custom_model.mCustomJoints.size());
+  CHECK (clone.mMultiDofJoints.size() == 1);
+  CHECK (clone.mClonedCustomJoints.size() == 4);
+  for (unsigned int k = 0; k < clone.mCustomJoints.size(); k++) {
+    CHECK (clone.mCustomJoints[k] != custom_model.mCustomJoints[k]);
+  }
+
+  VectorNd q_ext = VectorNd::Zero (custom_model.q_size);
+  VectorNd qdot_ext = VectorNd::Zero (custom_model.qdot_size);
+  VectorNd tau_ext = VectorNd::Zero (custom_model.qdot_size);
+  for (unsigned int i = 0; i < q_ext.size(); i++) {
+    q_ext[i] = 0.2 * i - 0.5;
+    qdot_ext[i] = 0.3 - 0.1 * i;
+    tau_ext[i] = 0.05 * i * i - 0.2;
+  }
+
+  VectorNd qddot_model = VectorNd::Zero (custom_model.qdot_size);
+  VectorNd qddot_clone = VectorNd::Zero (custom_model.qdot_size);
+  ForwardDynamics (custom_model, q_ext, qdot_ext, tau_ext, qddot_model);
+  MatrixNd S_model = custom_model.mCustomJoints[0]->S;
+
+  // running the clone with another state must not touch the joints of the
+  // original model
+  ForwardDynamics (clone, -q_ext, qdot_ext, tau_ext, qddot_clone);
+  CHECK_THAT (S_model, AllCloseMatrix (custom_model.mCustomJoints[0]->S,
+                                       0., 0.));
+
+  ForwardDynamics (clone, q_ext, qdot_ext, tau_ext, qddot_clone);
+  CHECK_THAT (qddot_model, AllCloseVector (qddot_clone, 0., 0.));
+
+  CustomJointTypeRevoluteX joint_without_clone;
+  custom_model.AddBodyCustomJoint (1, Xtrans (Vector3d (0.1, 0.2, 0.3)),
+                                   &joint_without_clone,
+                                   Body (1., Vector3d (0.1, 0.2, 0.3),
+                                         Vector3d (1.1, 1.2, 1.3)));
+  CHECK_THROWS_AS (custom_model.CloneForThread(), Errors::RBDLError);
+}
+
+TEST_CASE_METHOD (CustomJointNFixture,
+                  __FILE__"_TestInverseKinematicsTrajectoryThreads", "") {
+  const unsigned int num_frames = 9;
+  Vector3d local_point (0.2, 0.1, -0.3);
+
+  InverseKinematicsConstraintSet cs;
+  cs.AddPointConstraint (3, local_point, Vector3d::Zero());
+  cs.AddPointConstraint (4, local_point, Vector3d::Zero());
+
+  std::vector<std::vector<Vector3d> > target_positions (num_frames);
+  VectorNd q_frame (q);
+  for (unsigned int f = 0; f < num_frames; f++) {
+    q_frame = q + 0.02 * f * qdot;
+    for (unsigned int k = 0; k < 2; k++) {
+      target_positions[f].push_back (CalcBodyToBaseCoordinates (
+          reference_model, q_frame, 3 + k, local_point));
+    }
+  }
+
+  std::vector<VectorNd> qres_ref, qres_cus;
+  std::vector<unsigned int> steps_ref, steps_cus;
+  std::vector<double> errors_ref, errors_cus;
+
+  // the chunks of the custom model are solved concurrently on clones
+  CHECK (InverseKinematicsTrajectory (reference_model, q, cs,
+      target_positions, qres_ref, steps_ref, errors_ref, 3));
+  CHECK (InverseKinematicsTrajectory (custom_model, q, cs,
+      target_positions, qres_cus, steps_cus, errors_cus, 3));
+
+  for (unsigned int f = 0; f < num_frames; f++) {
+    CHECK (errors_cus[f] < 1.0e-10);
+    CHECK_THAT (qres_ref[f], AllCloseVector (qres_cus[f], 1.0e-8, 1.0e-8));
+  }
+}
+
 //
 //Completed?
 // x  : implement test for UpdateKinematicsCustom
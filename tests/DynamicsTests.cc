@@ -11,6 +11,7 @@
 #include "rbdl_tests.h"
 
 #include "Fixtures.h"
+#include "Human36Fixture.h"
 
 using namespace std;
 using namespace RigidBodyDynamics;
@@ -797,3 +798,102 @@ TEST_CASE_METHOD ( FixedBase3DoF,
               AllCloseVector(qddot_minv, TEST_PREC, TEST_PREC)
   );
 }
+
+void TestDelassus (Model &model, const unsigned int *body_ids,
+                   const double TOL = 1.0e-10) {
+  VectorNd q = VectorNd::Random (model.q_size);
+
+  Vector3d point (0.1, -0.2, 0.3);
+  SpatialVector axis (0.3, -0.1, 0.2, 0.5, 0.7, -0.4);
+
+  OperationalSpaceTaskSet tasks;
+  tasks.AddPointTask (body_ids[Human36::BodyFootRight], point);
+  tasks.AddPointTask6D (body_ids[Human36::BodyHandLeft], point);
+  tasks.AddPointTask (body_ids[Human36::BodyUpperTrunk], point);
+  tasks.AddRow (body_ids[Human36::BodyHead], point, axis);
+  REQUIRE (tasks.size() == 13);
+
+  // reference: J M^-1 J^T from the dense Jacobians and CRBA
+  MatrixNd J (MatrixNd::Zero (tasks.size(), model.qdot_size));
+  MatrixNd G3 (MatrixNd::Zero (3, model.qdot_size));
+  MatrixNd G6 (MatrixNd::Zero (6, model.qdot_size));
+
+  CalcPointJacobian (model, q, body_ids[Human36::BodyFootRight], point, G3);
+  J.block(0, 0, 3, model.qdot_size) = G3;
+  CalcPointJacobian6D (model, q, body_ids[Human36::BodyHandLeft], point, G6);
+  J.block(3, 0, 6, model.qdot_size) = G6;
+  G3.setZero();
+  CalcPointJacobian (model, q, body_ids[Human36::BodyUpperTrunk], point, G3);
+  J.block(9, 0, 3, model.qdot_size) = G3;
+  G6.setZero();
+  CalcPointJacobian6D (model, q, body_ids[Human36::BodyHead], point, G6);
+  J.row(12) = axis.transpose() * G6;
+
+  MatrixNd M (MatrixNd::Zero (model.qdot_size, model.qdot_size));
+  CompositeRigidBodyAlgorithm (model, q, M);
+  MatrixNd delassus_ref = J * M.llt().solve (J.transpose());
+
+  MatrixNd delassus;
+  CalcDelassus (model, q, tasks, delassus);
+  CHECK_THAT (delassus_ref, AllCloseMatrix(delassus, TOL, TOL));
+
+  MatrixNd lambda;
+  CalcOperationalSpaceInertia (model, q, tasks, lambda);
+  MatrixNd identity = MatrixNd::Identity (tasks.size(), tasks.size());
+  MatrixNd product = lambda * delassus_ref;
+  CHECK_THAT (identity, AllCloseMatrix(product, 1.0e-8, 1.0e-8));
+
+  // reuse of the articulated body inertias
+  VectorNd tau = VectorNd::Zero (model.qdot_size);
+  VectorNd qddot = VectorNd::Zero (model.qdot_size);
+  UpdateKinematicsCustom (model, &q, NULL, NULL);
+  CalcMInvTimesTau (model, q, tau, qddot);
+  MatrixNd delassus_cached;
+  CalcDelassus (model, q, tasks, delassus_cached, false);
+  CHECK_THAT (delassus_ref, AllCloseMatrix(delassus_cached, TOL, TOL));
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestDelassusHuman36", "") {
+  TestDelassus (*model_emulated, body_id_emulated);
+  TestDelassus (*model_3dof, body_id_3dof);
+}
+
+void TestForwardDynamicsBodyArena (Model &model, const VectorNd &q,
+                                   const VectorNd &qdot, const VectorNd &tau) {
+  std::vector<SpatialVector> f_ext (model.mBodies.size(),
+                                    SpatialVector::Zero());
+  f_ext[model.mBodies.size() - 1] =
+    SpatialVector (0.3, -0.1, 0.2, 10., -20., 5.);
+
+  VectorNd qddot_ref = VectorNd::Zero (model.qdot_size);
+  VectorNd qddot_arena = VectorNd::Zero (model.qdot_size);
+
+  model.use_body_arena = false;
+  ForwardDynamics (model, q, qdot, tau, qddot_ref, &f_ext);
+  Model reference = model;
+
+  model.use_body_arena = true;
+  ForwardDynamics (model, q, qdot, tau, qddot_arena, &f_ext);
+
+  CHECK_THAT (qddot_ref, AllCloseVector (qddot_arena, TEST_PREC, TEST_PREC));
+  CHECK_THAT (reference.d, AllCloseVector (model.d, TEST_PREC, TEST_PREC));
+  CHECK_THAT (reference.u, AllCloseVector (model.u, TEST_PREC, TEST_PREC));
+
+  for (unsigned int i = 1; i < model.mBodies.size(); i++) {
+    CHECK_THAT (reference.v[i], AllCloseVector (model.v[i], TEST_PREC,
+                                                TEST_PREC));
+    CHECK_THAT (reference.c[i], AllCloseVector (model.c[i], TEST_PREC,
+                                                TEST_PREC));
+    CHECK_THAT (reference.a[i], AllCloseVector (model.a[i], TEST_PREC,
+                                                TEST_PREC));
+    CHECK_THAT (reference.U[i], AllCloseVector (model.U[i], TEST_PREC,
+                                                TEST_PREC));
+  }
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestForwardDynamicsBodyArena", "") {
+  randomizeStates();
+
+  TestForwardDynamicsBodyArena (*model_emulated, q, qdot, tau);
+  TestForwardDynamicsBodyArena (*model_3dof, q, qdot, tau);
+}
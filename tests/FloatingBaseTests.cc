@@ -6,6 +6,7 @@
 #include "rbdl/Model.h"
 #include "rbdl/Kinematics.h"
 #include "rbdl/Dynamics.h"
+#include "rbdl/Constraints.h"
 
 #include "rbdl_tests.h"
 
@@ -14,6 +15,7 @@ using namespace RigidBodyDynamics;
 using namespace RigidBodyDynamics::Math;
 
 const double TEST_PREC = 1.0e-14;
+const double TEST_LAX = 1.0e-10;
 
 struct FloatingBaseFixture {
   FloatingBaseFixture () {
@@ -592,4 +594,272 @@ TEST_CASE_METHOD(FloatingBaseFixture,
   );
 }
 
+// Compares the free-flyer root (ff_model) with the same model whose floating
+// base is built from a TranslationXYZ and a Spherical joint and therefore
+// uses the generic algorithms (ref_model).
+struct FreeFlyerRootFixture {
+  FreeFlyerRootFixture () {
+    ClearLogOutput();
+    ff_model.gravity = Vector3d (0., 0., -9.81);
+    ref_model.gravity = Vector3d (0., 0., -9.81);
+
+    Body base (5., Vector3d (0.1, 0.2, -0.1), Vector3d (0.6, 0.5, 0.4));
+    Body link (1.2, Vector3d (0., 0., -0.3), Vector3d (0.1, 0.12, 0.03));
+    Body null_body (0., Vector3d (0., 0., 0.), Vector3d (0., 0., 0.));
+    null_body.mIsVirtual = true;
+
+    SpatialTransform root_frame (
+        rotz (0.3) * roty (-0.2), Vector3d (0.1, 0., 0.2));
+
+    base_id = ff_model.AddBody (0, root_frame, Joint (JointTypeFloatingBase),
+        base, "base");
+    unsigned int trans_id = ref_model.AddBody (0, root_frame,
+        Joint (JointTypeTranslationXYZ), null_body);
+    ref_model.AddBody (trans_id, SpatialTransform(),
+        Joint (JointTypeSpherical), base, "base");
+
+    Model *models[2] = { &ff_model, &ref_model };
+    for (unsigned int k = 0; k < 2; k++) {
+      unsigned int hip = models[k]->AddBody (base_id,
+          Xtrans (Vector3d (0., -0.1, -0.1)), Joint (JointTypeEulerZYX), link);
+      unsigned int knee = models[k]->AddBody (hip,
+          Xtrans (Vector3d (0., 0., -0.4)),
+          Joint (SpatialVector (0., 1., 0., 0., 0., 0.)), link);
+      foot_id = models[k]->AddBody (knee, Xtrans (Vector3d (0., 0., -0.4)),
+          Joint (JointTypeSpherical), link);
+      arm_id = models[k]->AddBody (base_id, Xtrans (Vector3d (0., 0.2, 0.3)),
+          Joint (SpatialVector (1., 0., 0., 0., 0., 0.)), link);
+    }
+
+    q = VectorNd::Zero (ff_model.q_size);
+    qdot = VectorNd::Zero (ff_model.qdot_size);
+    qddot = VectorNd::Zero (ff_model.qdot_size);
+    tau = VectorNd::Zero (ff_model.qdot_size);
+
+    for (unsigned int i = 0; i < q.size(); i++) {
+      q[i] = 0.3 * sin (1.7 * i + 0.4);
+    }
+    for (unsigned int i = 0; i < qdot.size(); i++) {
+      qdot[i] = 0.9 * cos (1.3 * i);
+      qddot[i] = 0.7 * sin (2.1 * i + 1.);
+      tau[i] = 2.5 * cos (0.7 * i + 0.3);
+    }
+
+    Quaternion quat = ff_model.GetQuaternion (base_id, q);
+    ff_model.SetQuaternion (base_id, Quaternion (quat / quat.norm()), q);
+    quat = ff_model.GetQuaternion (foot_id, q);
+    ff_model.SetQuaternion (foot_id, Quaternion (quat / quat.norm()), q);
+  }
+
+  Model ff_model;
+  Model ref_model;
+  unsigned int base_id;
+  unsigned int foot_id;
+  unsigned int arm_id;
+
+  VectorNd q, qdot, qddot, tau;
+};
+
+TEST_CASE_METHOD (FreeFlyerRootFixture,
+                  __FILE__"_TestFreeFlyerRootId", "") {
+  REQUIRE (base_id == 2);
+  CHECK (ff_model.free_flyer_root_id == base_id);
+  CHECK (ref_model.free_flyer_root_id == 0);
+
+  // a floating base that is not the first body is handled generically
+  unsigned int second_base = ff_model.AddBody (0, SpatialTransform(),
+      Joint (JointTypeFloatingBase), ff_model.mBodies[base_id]);
+  CHECK (ff_model.free_flyer_root_id == base_id);
+  CHECK (second_base != base_id);
+
+  // as is a root whose virtual parent has another child
+  ff_model.AddBody (1, SpatialTransform(), Joint (JointTypeRevoluteX),
+      ff_model.mBodies[base_id]);
+  CHECK (ff_model.free_flyer_root_id == 0);
+}
+
+TEST_CASE_METHOD (FreeFlyerRootFixture,
+                  __FILE__"_TestFreeFlyerRootFixedChild", "") {
+  // a fixed body attached to the virtual parent of the root adds its mass
+  // to the virtual body, the model is then handled generically
+  Body payload (0.8, Vector3d (0.1, 0., 0.2), Vector3d (0.05, 0.04, 0.03));
+  ff_model.AddBody (1, Xtrans (Vector3d (0., 0., 0.3)),
+      Joint (JointTypeFixed), payload);
+  ref_model.AddBody (1, Xtrans (Vector3d (0., 0., 0.3)),
+      Joint (JointTypeFixed), payload);
+  CHECK (ff_model.free_flyer_root_id == 0);
+
+  VectorNd qddot_ff = VectorNd::Zero (ff_model.qdot_size);
+  VectorNd qddot_ref = VectorNd::Zero (ref_model.qdot_size);
+  ForwardDynamics (ff_model, q, qdot, tau, qddot_ff);
+  ForwardDynamics (ref_model, q, qdot, tau, qddot_ref);
+  CHECK_THAT (qddot_ref, AllCloseVector (qddot_ff, TEST_LAX, TEST_LAX));
+}
+
+TEST_CASE_METHOD (FreeFlyerRootFixture,
+                  __FILE__"_TestFreeFlyerRootForwardDynamics", "") {
+  std::vector<SpatialVector> f_ext (ff_model.mBodies.size(),
+      SpatialVector::Zero());
+  f_ext[base_id] = SpatialVector (0.3, -0.2, 0.5, 4., -2., 9.);
+  f_ext[foot_id] = SpatialVector (0.1, 0.2, -0.1, 1., 2., 30.);
+
+  VectorNd qddot_ff = VectorNd::Zero (ff_model.qdot_size);
+  VectorNd qddot_ref = VectorNd::Zero (ref_model.qdot_size);
+
+  ForwardDynamics (ff_model, q, qdot, tau, qddot_ff);
+  ForwardDynamics (ref_model, q, qdot, tau, qddot_ref);
+  CHECK_THAT (qddot_ref, AllCloseVector (qddot_ff, TEST_LAX, TEST_LAX));
+
+  ForwardDynamics (ff_model, q, qdot, tau, qddot_ff, &f_ext);
+  ForwardDynamics (ref_model, q, qdot, tau, qddot_ref, &f_ext);
+  CHECK_THAT (qddot_ref, AllCloseVector (qddot_ff, TEST_LAX, TEST_LAX));
+
+  for (unsigned int i = 1; i < ff_model.mBodies.size(); i++) {
+    CHECK_THAT (ref_model.a[i],
+        AllCloseVector (ff_model.a[i], TEST_LAX, TEST_LAX));
+  }
+
+  // the accelerations are consistent with the inverse dynamics
+  VectorNd tau_id = VectorNd::Zero (ff_model.qdot_size);
+  InverseDynamics (ff_model, q, qdot, qddot_ff, tau_id, &f_ext);
+  CHECK_THAT (tau, AllCloseVector (tau_id, TEST_LAX, TEST_LAX));
+}
+
+TEST_CASE_METHOD (FreeFlyerRootFixture,
+                  __FILE__"_TestFreeFlyerRootInverseDynamics", "") {
+  std::vector<SpatialVector> f_ext (ff_model.mBodies.size(),
+      SpatialVector::Zero());
+  f_ext[base_id] = SpatialVector (0.3, -0.2, 0.5, 4., -2., 9.);
+  f_ext[arm_id] = SpatialVector (0.1, 0.2, -0.1, 1., 2., 3.);
+
+  VectorNd tau_ff = VectorNd::Zero (ff_model.qdot_size);
+  VectorNd tau_ref = VectorNd::Zero (ref_model.qdot_size);
 
+  InverseDynamics (ff_model, q, qdot, qddot, tau_ff, &f_ext);
+  InverseDynamics (ref_model, q, qdot, qddot, tau_ref, &f_ext);
+
+  CHECK_THAT (tau_ref, AllCloseVector (tau_ff, TEST_LAX, TEST_LAX));
+}
+
+TEST_CASE_METHOD (FreeFlyerRootFixture,
+                  __FILE__"_TestFreeFlyerRootCompositeRigidBody", "") {
+  MatrixNd H_ff = MatrixNd::Zero (ff_model.qdot_size, ff_model.qdot_size);
+  MatrixNd H_ref = MatrixNd::Zero (ref_model.qdot_size, ref_model.qdot_size);
+
+  CompositeRigidBodyAlgorithm (ff_model, q, H_ff);
+  CompositeRigidBodyAlgorithm (ref_model, q, H_ref);
+
+  CHECK_THAT (H_ref, AllCloseMatrix (H_ff, TEST_LAX, TEST_LAX));
+}
+
+TEST_CASE_METHOD (FreeFlyerRootFixture,
+                  __FILE__"_TestFreeFlyerRootCalcMInvTimesTau", "") {
+  VectorNd qddot_ff = VectorNd::Zero (ff_model.qdot_size);
+  VectorNd qddot_ref = VectorNd::Zero (ref_model.qdot_size);
+
+  CalcMInvTimesTau (ff_model, q, tau, qddot_ff);
+  CalcMInvTimesTau (ref_model, q, tau, qddot_ref);
+  CHECK_THAT (qddot_ref, AllCloseVector (qddot_ff, TEST_LAX, TEST_LAX));
+
+  // reuse of the articulated body inertias
+  CalcMInvTimesTau (ff_model, q, qdot, qddot_ff, false);
+  CalcMInvTimesTau (ref_model, q, qdot, qddot_ref, false);
+  CHECK_THAT (qddot_ref, AllCloseVector (qddot_ff, TEST_LAX, TEST_LAX));
+
+  MatrixNd H = MatrixNd::Zero (ff_model.qdot_size, ff_model.qdot_size);
+  CompositeRigidBodyAlgorithm (ff_model, q, H);
+  VectorNd H_qddot = H * qddot_ff;
+  CHECK_THAT (qdot, AllCloseVector (H_qddot, TEST_LAX, TEST_LAX));
+}
+
+TEST_CASE_METHOD (FreeFlyerRootFixture,
+                  __FILE__"_TestFreeFlyerRootContactsKokkevis", "") {
+  ConstraintSet cs_ff;
+  cs_ff.AddContactConstraint (foot_id, Vector3d (0.1, 0., -0.05),
+      Vector3d (0., 0., 1.));
+  cs_ff.AddContactConstraint (foot_id, Vector3d (0.1, 0., -0.05),
+      Vector3d (1., 0., 0.));
+  cs_ff.AddContactConstraint (base_id, Vector3d (0., 0.1, 0.),
+      Vector3d (0., 1., 0.));
+  ConstraintSet cs_ref = cs_ff.Copy();
+  cs_ff.Bind (ff_model);
+  cs_ref.Bind (ref_model);
+
+  VectorNd qddot_ff = VectorNd::Zero (ff_model.qdot_size);
+  VectorNd qddot_ref = VectorNd::Zero (ref_model.qdot_size);
+
+  ForwardDynamicsContactsKokkevis (ff_model, q, qdot, tau, cs_ff, qddot_ff);
+  ForwardDynamicsContactsKokkevis (ref_model, q, qdot, tau, cs_ref,
+      qddot_ref);
+
+  CHECK_THAT (qddot_ref, AllCloseVector (qddot_ff, TEST_LAX, TEST_LAX));
+  CHECK_THAT (cs_ref.force, AllCloseVector (cs_ff.force, TEST_LAX, TEST_LAX));
+}
+
+TEST_CASE_METHOD (FreeFlyerRootFixture,
+                  __FILE__"_TestFreeFlyerRootCalcDelassus", "") {
+  OperationalSpaceTaskSet tasks;
+  tasks.AddPointTask6D (foot_id, Vector3d (0.1, 0., -0.05));
+  tasks.AddPointTask (arm_id, Vector3d (0., 0., -0.5));
+  tasks.AddPointTask (base_id, Vector3d (0.2, 0., 0.));
+
+  MatrixNd delassus_ff, delassus_ref;
+  CalcDelassus (ff_model, q, tasks, delassus_ff);
+  CalcDelassus (ref_model, q, tasks, delassus_ref);
+
+  CHECK_THAT (delassus_ref,
+      AllCloseMatrix (delassus_ff, TEST_LAX, TEST_LAX));
+}
+
+TEST_CASE_METHOD (FreeFlyerRootFixture,
+                  __FILE__"_TestIntegrateConfiguration", "") {
+  double dt = 1.0e-7;
+  VectorNd q_next = VectorNd::Zero (ff_model.q_size);
+
+  // for small time steps the positions change with their time derivatives
+  IntegrateConfiguration (ff_model, q, qdot, dt, q_next);
+  VectorNd q_rate = (q_next - q) / dt;
+
+  Quaternion quat = ff_model.GetQuaternion (base_id, q);
+  Vector4d quat_rate = quat.omegaToQDot (qdot.segment<3>(3));
+  CHECK_THAT (quat_rate, AllCloseVector (
+        ff_model.GetQuaternion (base_id, q_rate), 1.0e-6, 1.0e-6));
+  Vector3d trans_rate = q_rate.segment<3>(0);
+  Vector3d trans_qdot = qdot.segment<3>(0);
+  CHECK_THAT (trans_qdot, AllCloseVector (trans_rate, 1.0e-6, 1.0e-6));
+
+  quat = ff_model.GetQuaternion (foot_id, q);
+  quat_rate = quat.omegaToQDot (
+      qdot.segment<3>(ff_model.mJoints[foot_id].q_index));
+  CHECK_THAT (quat_rate, AllCloseVector (
+        ff_model.GetQuaternion (foot_id, q_rate), 1.0e-6, 1.0e-6));
+
+  // the root moves on a screw with constant body velocities
+  double h = 0.8;
+  IntegrateConfiguration (ff_model, q, qdot, h, q_next);
+
+  Vector3d omega = qdot.segment<3>(3);
+  Vector3d v_body = ff_model.GetQuaternion (base_id, q).toMatrix()
+    * qdot.segment<3>(0);
+  VectorNd q_steps = q;
+  for (unsigned int k = 0; k < 1000; k++) {
+    Quaternion quat_k = ff_model.GetQuaternion (base_id, q_steps);
+    q_steps.segment<3>(0) += quat_k.toMatrix().transpose() * v_body
+      * (h / 1000.);
+    quat_k = quat_k
+      * Quaternion::fromAxisAngle (omega, omega.norm() * h / 1000.);
+    ff_model.SetQuaternion (base_id, quat_k, q_steps);
+  }
+  Vector3d root_next = q_next.segment<3>(0);
+  Vector3d root_steps = q_steps.segment<3>(0);
+  CHECK_THAT (root_steps, AllCloseVector (root_next, 1.0e-3, 1.0e-3));
+
+  // CalcConfigurationDifference inverts IntegrateConfiguration
+  VectorNd qdot_diff;
+  CalcConfigurationDifference (ff_model, q, q_next, qdot_diff);
+  VectorNd qdot_h = qdot * h;
+  CHECK_THAT (qdot_h, AllCloseVector (qdot_diff, TEST_LAX, TEST_LAX));
+
+  IntegrateConfiguration (ff_model, q, qdot_diff, 1., q);
+  CHECK_THAT (q_next, AllCloseVector (q, TEST_LAX, TEST_LAX));
+}
@@ -0,0 +1,326 @@
+#include <iostream>
+
+#include "rbdl/Logging.h"
+
+#include "rbdl/Model.h"
+#include "rbdl/Dynamics.h"
+#include "rbdl/Kinematics.h"
+#include "rbdl/FrictionalContacts.h"
+
+#include "rbdl_tests.h"
+
+#include "Human36Fixture.h"
+
+using namespace std;
+using namespace RigidBodyDynamics;
+using namespace RigidBodyDynamics::Math;
+
+const double TEST_PREC = 1.0e-12;
+
+struct PointMassFixture {
+  PointMassFixture () {
+    ClearLogOutput();
+    model = new Model;
+    model->gravity = Vector3d (0., 0., -9.81);
+
+    body_id = model->AddBody (0, Xtrans (Vector3d (0., 0., 0.)),
+        Joint (JointTypeTranslationXYZ),
+        Body (2., Vector3d (0., 0., 0.), Vector3d (1., 1., 1.)));
+
+    Q = VectorNd::Zero (model->q_size);
+    QDotMinus = VectorNd::Zero (model->qdot_size);
+    QDotPlus = VectorNd::Zero (model->qdot_size);
+  }
+
+  ~PointMassFixture () {
+    delete model;
+  }
+
+  void AddGroundContact (double mu, double e = 0.) {
+    contacts.AddContact (body_id, Vector3d (0., 0., 0.),
+        Vector3d (0., 0., 1.), mu, e);
+    contacts.Bind (*model);
+  }
+
+  Model *model;
+  unsigned int body_id;
+  FrictionalContactSet contacts;
+
+  VectorNd Q;
+  VectorNd QDotMinus;
+  VectorNd QDotPlus;
+};
+
+// Checks the impulse-momentum balance, the signorini conditions and the
+// friction cone (or pyramid) of the impulses of a solved contact set.
+void CheckFrictionalContactConditions (
+    Model &model,
+    const VectorNd &Q,
+    const VectorNd &QDotMinus,
+    const VectorNd &QDotPlus,
+    const FrictionalContactSet &CS,
+    double prec) {
+  MatrixNd H = MatrixNd::Zero (model.qdot_size, model.qdot_size);
+  CompositeRigidBodyAlgorithm (model, Q, H);
+
+  VectorNd generalized_impulse = VectorNd::Zero (model.qdot_size);
+  MatrixNd G = MatrixNd::Zero (3, model.qdot_size);
+
+  for (unsigned int i = 0; i < CS.size(); i++) {
+    G.setZero();
+    CalcPointJacobian (model, Q, CS.body_ids[i], CS.body_points[i], G);
+
+    Vector3d v = G * QDotPlus;
+    double v_n = v.dot (CS.normals[i]);
+    double lambda_n = CS.impulses[3 * i];
+    double lambda_t = CS.impulses.segment<2>(3 * i + 1).norm();
+    double mu = CS.friction_coefficients[i];
+
+    CHECK (lambda_n >= 0.);
+    CHECK (v_n >= -prec);
+    CHECK_THAT (lambda_n * v_n, IsClose (0., prec, prec));
+
+    if (CS.friction_model == FrictionModelCone) {
+      CHECK (lambda_t <= mu * lambda_n + prec);
+    } else {
+      CHECK (fabs (CS.impulses[3 * i + 1]) <= mu * lambda_n + prec);
+      CHECK (fabs (CS.impulses[3 * i + 2]) <= mu * lambda_n + prec);
+    }
+
+    Vector3d impulse = CS.normals[i] * lambda_n
+      + CS.tangents1[i] * CS.impulses[3 * i + 1]
+      + CS.tangents2[i] * CS.impulses[3 * i + 2];
+    generalized_impulse += G.transpose() * impulse;
+  }
+
+  VectorNd momentum_change = H * (QDotPlus - QDotMinus);
+  CHECK_THAT (generalized_impulse,
+      AllCloseVector (momentum_change, prec, prec));
+}
+
+TEST_CASE_METHOD (PointMassFixture, __FILE__"_TestContactFrame", "") {
+  contacts.AddContact (body_id, Vector3d (0., 0., 0.),
+      Vector3d (1., 2., 3.), 0.5);
+
+  Vector3d n = contacts.normals[0];
+  Vector3d t1 = contacts.tangents1[0];
+  Vector3d t2 = contacts.tangents2[0];
+
+  CHECK_THAT (Vector3d (1., 2., 3.).normalized(),
+      AllCloseVector (n, TEST_PREC, TEST_PREC));
+  CHECK_THAT (1., IsClose (t1.norm(), TEST_PREC, TEST_PREC));
+  CHECK_THAT (0., IsClose (n.dot (t1), TEST_PREC, TEST_PREC));
+  CHECK_THAT (n, AllCloseVector (t1.cross (t2), TEST_PREC, TEST_PREC));
+}
+
+TEST_CASE_METHOD (PointMassFixture, __FILE__"_TestSliding", "") {
+  AddGroundContact (0.3);
+
+  FrictionModel models[2] = { FrictionModelPyramid, FrictionModelCone };
+
+  for (unsigned int m = 0; m < 2; m++) {
+    contacts.friction_model = models[m];
+
+    QDotMinus = Vector3d (1., 0., -2.);
+    SolveFrictionalContactImpulses (*model, Q, QDotMinus, contacts, QDotPlus);
+
+    CHECK_THAT (4., IsClose (contacts.impulses[0], TEST_PREC, TEST_PREC));
+    CHECK_THAT (VectorNd (Vector3d (0.4, 0., 0.)),
+        AllCloseVector (QDotPlus, TEST_PREC, TEST_PREC));
+    CheckFrictionalContactConditions (*model, Q, QDotMinus, QDotPlus,
+        contacts, TEST_PREC);
+  }
+}
+
+TEST_CASE_METHOD (PointMassFixture, __FILE__"_TestSticking", "") {
+  AddGroundContact (1.);
+
+  QDotMinus = Vector3d (1., -0.5, -2.);
+  SolveFrictionalContactImpulses (*model, Q, QDotMinus, contacts, QDotPlus);
+
+  CHECK_THAT (VectorNd (Vector3d (0., 0., 0.)),
+      AllCloseVector (QDotPlus, TEST_PREC, TEST_PREC));
+  CheckFrictionalContactConditions (*model, Q, QDotMinus, QDotPlus,
+      contacts, TEST_PREC);
+}
+
+TEST_CASE_METHOD (PointMassFixture, __FILE__"_TestConeAndPyramid", "") {
+  AddGroundContact (0.3);
+
+  QDotMinus = Vector3d (1., 1., -2.);
+
+  contacts.friction_model = FrictionModelPyramid;
+  SolveFrictionalContactImpulses (*model, Q, QDotMinus, contacts, QDotPlus);
+  CHECK_THAT (VectorNd (Vector3d (0.4, 0.4, 0.)),
+      AllCloseVector (QDotPlus, TEST_PREC, TEST_PREC));
+
+  contacts.friction_model = FrictionModelCone;
+  SolveFrictionalContactImpulses (*model, Q, QDotMinus, contacts, QDotPlus);
+  double v_t = 1. - 0.6 / sqrt (2.);
+  CHECK_THAT (VectorNd (Vector3d (v_t, v_t, 0.)),
+      AllCloseVector (QDotPlus, TEST_PREC, TEST_PREC));
+  CheckFrictionalContactConditions (*model, Q, QDotMinus, QDotPlus,
+      contacts, TEST_PREC);
+}
+
+TEST_CASE_METHOD (PointMassFixture, __FILE__"_TestRestitutionAndSeparation",
+    "") {
+  AddGroundContact (0.3, 0.5);
+
+  QDotMinus = Vector3d (0., 0., -2.);
+  SolveFrictionalContactImpulses (*model, Q, QDotMinus, contacts, QDotPlus);
+  CHECK_THAT (VectorNd (Vector3d (0., 0., 1.)),
+      AllCloseVector (QDotPlus, TEST_PREC, TEST_PREC));
+
+  // separating contacts do not get an impulse
+  QDotMinus = Vector3d (1., 0., 2.);
+  SolveFrictionalContactImpulses (*model, Q, QDotMinus, contacts, QDotPlus);
+  CHECK_THAT (QDotMinus, AllCloseVector (QDotPlus, TEST_PREC, TEST_PREC));
+  CHECK_THAT (VectorNd::Zero (3),
+      AllCloseVector (contacts.impulses, TEST_PREC, TEST_PREC));
+
+  // neither do inactive contacts
+  QDotMinus = Vector3d (1., 0., -2.);
+  contacts.active[0] = false;
+  SolveFrictionalContactImpulses (*model, Q, QDotMinus, contacts, QDotPlus);
+  CHECK_THAT (QDotMinus, AllCloseVector (QDotPlus, TEST_PREC, TEST_PREC));
+  CHECK (contacts.num_iterations == 0);
+}
+
+TEST_CASE_METHOD (PointMassFixture, __FILE__"_TestImmovableContact", "") {
+  unsigned int fixed_id = model->AddBody (0, Xtrans (Vector3d (1., 0., 0.)),
+      Joint (JointTypeFixed),
+      Body (1., Vector3d (0., 0., 0.), Vector3d (1., 1., 1.)));
+
+  contacts.AddContact (body_id, Vector3d (0., 0., 0.),
+      Vector3d (0., 0., 1.), 0.5);
+  contacts.AddContact (fixed_id, Vector3d (0., 0., 0.),
+      Vector3d (0., 0., 1.), 0.5);
+  contacts.Bind (*model);
+  contacts.warm_start = true;
+
+  QDotMinus = Vector3d (1., 0., -2.);
+  SolveFrictionalContactImpulses (*model, Q, QDotMinus, contacts, QDotPlus);
+  CHECK (contacts.impulses.segment<3>(3).isZero());
+
+  VectorNd QDotPlus_ref = QDotPlus;
+
+  // stale warm start impulses of the contact on the fixed body must not be
+  // applied to the model
+  contacts.impulses.segment<3>(3) = Vector3d (10., 5., -5.);
+  SolveFrictionalContactImpulses (*model, Q, QDotMinus, contacts, QDotPlus);
+  CHECK (contacts.impulses.segment<3>(3).isZero());
+  CHECK_THAT (QDotPlus_ref, AllCloseVector (QDotPlus, TEST_PREC, TEST_PREC));
+  CheckFrictionalContactConditions (*model, Q, QDotMinus, QDotPlus,
+      contacts, TEST_PREC);
+}
+
+TEST_CASE (__FILE__"_TestBoxCorners", "") {
+  Model model;
+  model.gravity = Vector3d (0., 0., -9.81);
+
+  unsigned int box_id = model.AddBody (0, Xtrans (Vector3d (0., 0., 0.)),
+      Joint (JointTypeFloatingBase),
+      Body (3., Vector3d (0., 0., 0.), Vector3d (0.2, 0.3, 0.4)));
+
+  FrictionalContactSet contacts;
+  contacts.max_iterations = 2000;
+  contacts.tolerance = 1.0e-14;
+  for (int i = -1; i <= 1; i += 2) {
+    for (int j = -1; j <= 1; j += 2) {
+      contacts.AddContact (box_id, Vector3d (0.5 * i, 0.3 * j, -0.2),
+          Vector3d (0., 0., 1.), 0.5);
+    }
+  }
+  contacts.Bind (model);
+
+  VectorNd Q = VectorNd::Zero (model.q_size);
+  model.SetQuaternion (box_id, Quaternion::fromXYZAngles (
+        Vector3d (0.02, -0.03, 0.1)), Q);
+  Q[2] = 0.2;
+
+  VectorNd QDotMinus = VectorNd::Zero (model.qdot_size);
+  QDotMinus << 0.3, -0.1, -1., 0.2, -0.1, 0.5;
+  VectorNd QDotPlus = VectorNd::Zero (model.qdot_size);
+
+  FrictionModel models[2] = { FrictionModelPyramid, FrictionModelCone };
+
+  for (unsigned int m = 0; m < 2; m++) {
+    contacts.friction_model = models[m];
+    SolveFrictionalContactImpulses (model, Q, QDotMinus, contacts, QDotPlus);
+
+    CheckFrictionalContactConditions (model, Q, QDotMinus, QDotPlus,
+        contacts, 1.0e-8);
+
+    // the contacts dissipate energy
+    CHECK (Utils::CalcKineticEnergy (model, Q, QDotPlus)
+        <= Utils::CalcKineticEnergy (model, Q, QDotMinus));
+  }
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestFeetContactsWarmStart", "") {
+  randomizeStates();
+
+  FrictionalContactSet contacts;
+  contacts.max_iterations = 5000;
+  contacts.tolerance = 1.0e-13;
+  unsigned int feet[2] = {
+    body_id_emulated[BodyFootLeft], body_id_emulated[BodyFootRight] };
+  for (unsigned int i = 0; i < 2; i++) {
+    contacts.AddContact (feet[i], Vector3d (0.1, 0.05, -0.05),
+        Vector3d (0., 0., 1.), 0.8);
+    contacts.AddContact (feet[i], Vector3d (-0.05, -0.05, -0.05),
+        Vector3d (0., 0.1, 1.), 0.4);
+  }
+  contacts.Bind (*model_emulated);
+
+  // push all contact points towards the ground
+  VectorNd QDotMinus = qdot;
+  VectorNd QDotPlus = VectorNd::Zero (model_emulated->qdot_size);
+  QDotMinus[2] = -2.;
+
+  contacts.warm_start = false;
+  SolveFrictionalContactImpulses (*model_emulated, q, QDotMinus, contacts,
+      QDotPlus);
+  unsigned int cold_iterations = contacts.num_iterations;
+
+  CHECK (contacts.impulses.norm() > 0.);
+  CheckFrictionalContactConditions (*model_emulated, q, QDotMinus, QDotPlus,
+      contacts, 1.0e-8);
+
+  contacts.warm_start = true;
+  VectorNd impulses = contacts.impulses;
+  SolveFrictionalContactImpulses (*model_emulated, q, QDotMinus, contacts,
+      QDotPlus);
+
+  CHECK (contacts.num_iterations < cold_iterations);
+  CHECK_THAT (impulses, AllCloseVector (contacts.impulses, 1.0e-10, 1.0e-10));
+}
+
+TEST_CASE_METHOD (Human36, __FILE__"_TestNoHeapAllocations", "") {
+  if (!HeapAllocationCountAvailable()) {
+    WARN ("heap allocation counting not available, skipping test");
+    return;
+  }
+
+  randomizeStates();
+
+  FrictionalContactSet contacts;
+  contacts.AddContact (body_id_3dof[BodyFootLeft], Vector3d (0.1, 0., -0.05),
+      Vector3d (0., 0., 1.), 0.8);
+  contacts.AddContact (body_id_3dof[BodyFootRight], Vector3d (0.1, 0., -0.05),
+      Vector3d (0., 0., 1.), 0.8);
+  contacts.Bind (*model_3dof);
+
+  VectorNd QDotMinus = qdot;
+  VectorNd QDotPlus = VectorNd::Zero (model_3dof->qdot_size);
+  QDotMinus[2] = -2.;
+
+  SolveFrictionalContactImpulses (*model_3dof, q, QDotMinus, contacts,
+      QDotPlus);
+
+  size_t allocations = HeapAllocationCount();
+  SolveFrictionalContactImpulses (*model_3dof, q, QDotMinus, contacts,
+      QDotPlus);
+  CHECK (HeapAllocationCount() - allocations == 0);
+}
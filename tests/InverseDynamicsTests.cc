@@ -1,5 +1,7 @@
 #include <iostream>
 
+#include "Fixtures.h"
+#include "Human36Fixture.h"
 #include "rbdl/Logging.h"
 
 #include "rbdl/Model.h"
@@ -77,3 +79,66 @@ TEST_CASE_METHOD(InverseDynamicsFixture,
   );
 }
 #endif
+
+void TestGravityTorques (Model &model, const double TOL = 1.0e-12) {
+  VectorNd q = VectorNd::Random (model.q_size);
+  VectorNd qdot_zero = VectorNd::Zero (model.qdot_size);
+  VectorNd qddot_zero = VectorNd::Zero (model.qdot_size);
+  VectorNd tau_id = VectorNd::Zero (model.qdot_size);
+  VectorNd tau_gravity = VectorNd::Zero (model.qdot_size);
+
+  InverseDynamics (model, q, qdot_zero, qddot_zero, tau_id);
+  CalcGravityTorques (model, q, tau_gravity);
+
+  CHECK_THAT (tau_id, AllCloseVector(tau_gravity, TOL, TOL));
+}
+
+TEST_CASE_METHOD(Human36, __FILE__"_TestGravityTorquesHuman36", "") {
+  TestGravityTorques (*model_emulated);
+  TestGravityTorques (*model_3dof);
+}
+
+TEST_CASE_METHOD(FloatingBase12DoF,
+                 __FILE__"_TestGravityTorquesFloatingBase12DoF", "") {
+  TestGravityTorques (*model);
+}
+
+void TestCoriolisMatrix (Model &model, const double TOL = 1.0e-10) {
+  const double EPS = 1.0e-7;
+
+  VectorNd q = VectorNd::Random (model.q_size);
+  VectorNd qdot = VectorNd::Random (model.qdot_size);
+  VectorNd nle = VectorNd::Zero (model.qdot_size);
+  VectorNd gravity = VectorNd::Zero (model.qdot_size);
+
+  MatrixNd C = MatrixNd::Zero (model.qdot_size, model.qdot_size);
+  MatrixNd H_plus = MatrixNd::Zero (model.qdot_size, model.qdot_size);
+  MatrixNd H_minus = MatrixNd::Zero (model.qdot_size, model.qdot_size);
+
+  NonlinearEffects (model, q, qdot, nle);
+  CalcGravityTorques (model, q, gravity);
+  CalcCoriolisMatrix (model, q, qdot, C);
+
+  // C(q, qdot) qdot are the velocity dependent forces
+  VectorNd coriolis = C * qdot;
+  CHECK_THAT (nle - gravity, AllCloseVector(coriolis, TOL, TOL));
+
+  // dM/dt - 2 C is skew-symmetric, dM/dt via central differences along qdot
+  CompositeRigidBodyAlgorithm (model, q + EPS * qdot, H_plus);
+  CompositeRigidBodyAlgorithm (model, q - EPS * qdot, H_minus);
+  MatrixNd H_dot = (H_plus - H_minus) / (2. * EPS);
+  MatrixNd N = H_dot - 2. * C;
+  MatrixNd N_skew = - N.transpose();
+
+  CHECK_THAT (N, AllCloseMatrix(N_skew, 1.0e-6, 1.0e-6));
+}
+
+TEST_CASE_METHOD(Human36, __FILE__"_TestCoriolisMatrixHuman36", "") {
+  TestCoriolisMatrix (*model_emulated);
+  TestCoriolisMatrix (*model_3dof);
+}
+
+TEST_CASE_METHOD(FloatingBase12DoF,
+                 __FILE__"_TestCoriolisMatrixFloatingBase12DoF", "") {
+  TestCoriolisMatrix (*model);
+}
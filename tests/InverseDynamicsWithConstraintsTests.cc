@@ -377,6 +377,18 @@ TEST_CASE_METHOD(PlanarBipedFloatingBase,
 
   cs[0].SetActuationMap(model, dofActuated);
 
+  //The index lists have to select the same entries as S and P
+  CHECK(cs[0].actuated_dof_index.size() == unsigned (cs[0].S.rows()));
+  CHECK(cs[0].unactuated_dof_index.size() == unsigned (cs[0].P.rows()));
+  for(unsigned int i=0; i<cs[0].actuated_dof_index.size();++i){
+    CHECK(dofActuated[cs[0].actuated_dof_index[i]]);
+    CHECK(cs[0].S(i,cs[0].actuated_dof_index[i]) == 1.);
+  }
+  for(unsigned int i=0; i<cs[0].unactuated_dof_index.size();++i){
+    CHECK(dofActuated[cs[0].unactuated_dof_index[i]] == false);
+    CHECK(cs[0].P(i,cs[0].unactuated_dof_index[i]) == 1.);
+  }
+
   //Test to see if this model is compatiable with the exact IDC operator
   bool isCompatible = isConstrainedSystemFullyActuated(
                         model,q,qd,cs[0]);
@@ -542,6 +554,81 @@ TEST_CASE_METHOD(PlanarBipedFloatingBase,
 }
 
 
+TEST_CASE_METHOD(PlanarBipedFloatingBase,
+                 __FILE__"_RelaxedFactorizationReuse", "") {
+
+  unsigned int n = unsigned (int (q.rows()));
+  std::vector<bool> dofActuated(n);
+  for(unsigned int i=0; i<n;++i){
+    dofActuated[i] = (i>=3);
+  }
+
+  //cs[1]: single stance, which needs the relaxed operator
+  cs[1].SetActuationMap(model, dofActuated);
+
+  //A slowly varying trajectory around a standing pose
+  unsigned int frames = 20;
+  std::vector< VectorNd > qSeq(frames), qdSeq(frames), qddSeq(frames);
+  for(unsigned int k=0; k<frames; ++k){
+    double t = 0.01*double(k);
+    qSeq[k]   = VectorNd::Zero(n);
+    qdSeq[k]  = VectorNd::Zero(n);
+    qddSeq[k] = VectorNd::Zero(n);
+    qSeq[k][1] = 1.0;
+    qSeq[k][3] = M_PI*0.25 + 0.1*sin(t);
+    qSeq[k][4] =-M_PI*0.25;
+    qSeq[k][5] =-M_PI*0.25 + 0.1*cos(t);
+    qSeq[k][6] = M_PI*0.25;
+    qdSeq[k][3] = 0.1*cos(t);
+    qdSeq[k][5] =-0.1*sin(t);
+    qddSeq[k][3] =-0.1*sin(t);
+    qddSeq[k][5] =-0.1*cos(t);
+  }
+
+  //Reference: a new factorization in every frame
+  std::vector< VectorNd > qddRef(frames), tauRef(frames), lambdaRef(frames);
+  for(unsigned int k=0; k<frames; ++k){
+    qddRef[k] = VectorNd::Zero(n);
+    tauRef[k] = VectorNd::Zero(n);
+    InverseDynamicsConstraintsRelaxed(model,qSeq[k],qdSeq[k],qddSeq[k],
+                                      cs[1],qddRef[k],tauRef[k]);
+    lambdaRef[k] = cs[1].force;
+  }
+
+  std::vector< VectorNd > qddOut, tauOut, lambdaOut;
+
+  //Refactorize only when the residual tolerance is not met
+  cs[1].SetRelaxedFactorizationReuse(true, 0, 1.0e-12, 6);
+  InverseDynamicsConstraintsRelaxedSequence(model,qSeq,qdSeq,qddSeq,cs[1],
+                                            qddOut,tauOut,&lambdaOut);
+  REQUIRE(qddOut.size() == frames);
+  CHECK(cs[1].relaxed_factorization.factorization_count >= 1);
+  CHECK(cs[1].relaxed_factorization.factorization_count < frames);
+
+  for(unsigned int k=0; k<frames; ++k){
+    for(unsigned int i=0; i<n; ++i){
+      CHECK_THAT(qddOut[k][i], IsClose(qddRef[k][i], 1e-9, 1e-9));
+      CHECK_THAT(tauOut[k][i], IsClose(tauRef[k][i], 1e-9, 1e-9));
+    }
+    for(unsigned int i=0; i<lambdaRef[k].rows(); ++i){
+      CHECK_THAT(lambdaOut[k][i], IsClose(lambdaRef[k][i], 1e-9, 1e-9));
+    }
+  }
+
+  //Refactorize every 5 frames
+  cs[1].SetRelaxedFactorizationReuse(true, 5, 1.0e-12, 6);
+  InverseDynamicsConstraintsRelaxedSequence(model,qSeq,qdSeq,qddSeq,cs[1],
+                                            qddOut,tauOut);
+  CHECK(cs[1].relaxed_factorization.factorization_count >= frames/5);
+
+  for(unsigned int k=0; k<frames; ++k){
+    for(unsigned int i=0; i<n; ++i){
+      CHECK_THAT(qddOut[k][i], IsClose(qddRef[k][i], 1e-9, 1e-9));
+      CHECK_THAT(tauOut[k][i], IsClose(tauRef[k][i], 1e-9, 1e-9));
+    }
+  }
+}
+
 TEST_CASE_METHOD(SpatialBipedFloatingBase,
                  __FILE__"_TestCorrectness2", "") {
 
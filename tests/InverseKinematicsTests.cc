@@ -580,3 +580,145 @@ TEST_CASE_METHOD ( Human36,
               AllCloseMatrix(result_orientation5, TEST_PREC, TEST_PREC)
   );
 }
+
+TEST_CASE_METHOD ( Human36,
+                   __FILE__"_TrajectoryWarmStartAndChunks", "") {
+  const unsigned int num_frames = 12;
+  const unsigned int bodies[] = {
+    body_id_emulated[BodyPelvis],
+    body_id_emulated[BodyFootRight],
+    body_id_emulated[BodyFootLeft],
+    body_id_emulated[BodyHandRight],
+    body_id_emulated[BodyHandLeft]
+  };
+  const unsigned int num_bodies = 5;
+  Vector3d local_point (0.1, 0., -0.1);
+
+  InverseKinematicsConstraintSet cs;
+  for (unsigned int k = 0; k < num_bodies; k++) {
+    cs.AddFullConstraint (bodies[k], local_point, Vector3d::Zero(),
+                          Matrix3d::Identity());
+  }
+
+  // a smooth motion of the pelvis, legs and arms
+  std::vector<std::vector<Vector3d> > target_positions (num_frames);
+  std::vector<std::vector<Matrix3d> > target_orientations (num_frames);
+  for (unsigned int f = 0; f < num_frames; f++) {
+    double s = 0.05 * f;
+    q.setZero();
+    q[0] = s;
+    q[2] = 0.05 * sin (s);
+    q[HipRightRY] = -0.3 * s;
+    q[HipLeftRY] = 0.3 * s;
+    q[KneeRightRY] = 0.2 + 0.1 * s;
+    q[KneeLeftRY] = 0.2 - 0.1 * s;
+    q[ShoulderRightRY] = 0.2 * s;
+    q[ShoulderLeftRY] = -0.2 * s;
+
+    UpdateKinematicsCustom (*model, &q, NULL, NULL);
+    for (unsigned int k = 0; k < num_bodies; k++) {
+      target_positions[f].push_back (
+          CalcBodyToBaseCoordinates (*model, q, bodies[k], local_point,
+                                     false));
+      target_orientations[f].push_back (
+          CalcBodyWorldOrientation (*model, q, bodies[k], false));
+    }
+  }
+
+  VectorNd qinit (VectorNd::Zero (model->q_size));
+  std::vector<VectorNd> qres_serial, qres_parallel;
+  std::vector<unsigned int> steps_serial, steps_parallel;
+  std::vector<double> errors_serial, errors_parallel;
+
+  CHECK (InverseKinematicsTrajectory (*model, qinit, cs, target_positions,
+                                      qres_serial, steps_serial,
+                                      errors_serial, 1,
+                                      &target_orientations));
+  CHECK (InverseKinematicsTrajectory (*model, qinit, cs, target_positions,
+                                      qres_parallel, steps_parallel,
+                                      errors_parallel, 3,
+                                      &target_orientations));
+
+  REQUIRE (qres_serial.size() == num_frames);
+  REQUIRE (steps_parallel.size() == num_frames);
+  REQUIRE (errors_parallel.size() == num_frames);
+
+  for (unsigned int f = 0; f < num_frames; f++) {
+    CHECK (errors_serial[f] < 1.0e-10);
+    CHECK (errors_parallel[f] < 1.0e-10);
+    // the first chunk is solved exactly like the serial trajectory, the
+    // other chunks may end up in a different redundant configuration
+    if (f < num_frames / 3) {
+      CHECK_THAT (qres_serial[f],
+                  AllCloseVector(qres_parallel[f], TEST_PREC, TEST_PREC));
+    }
+
+    UpdateKinematicsCustom (*model, &qres_parallel[f], NULL, NULL);
+    for (unsigned int k = 0; k < num_bodies; k++) {
+      CHECK_THAT (target_positions[f][k],
+                  AllCloseVector(CalcBodyToBaseCoordinates (*model,
+                      qres_parallel[f], bodies[k], local_point, false),
+                      1.0e-8, 1.0e-8));
+    }
+  }
+
+  // the warm started frame needs fewer iterations than a cold start
+  InverseKinematicsConstraintSet cs_cold (cs);
+  for (unsigned int k = 0; k < num_bodies; k++) {
+    cs_cold.target_positions[k] = target_positions[num_frames - 1][k];
+    cs_cold.target_orientations[k] = target_orientations[num_frames - 1][k];
+  }
+  VectorNd qres_cold (qinit);
+  CHECK (InverseKinematics (*model, qinit, cs_cold, qres_cold));
+  CHECK (steps_serial[num_frames - 1] < cs_cold.num_steps);
+
+  // the constraint set itself is not modified
+  CHECK_THAT (cs.target_positions[0],
+              AllCloseVector(Vector3d (0., 0., 0.), TEST_PREC, TEST_PREC));
+
+  target_positions[3].pop_back();
+  CHECK_THROWS_AS (InverseKinematicsTrajectory (*model, qinit, cs,
+                       target_positions, qres_serial, steps_serial,
+                       errors_serial),
+                   Errors::RBDLSizeMismatchError);
+}
+
+TEST_CASE_METHOD ( Human36,
+                   __FILE__"_NoHeapAllocationsPerIteration", "") {
+  if (!HeapAllocationCountAvailable()) {
+    WARN ("Heap allocations cannot be counted on this platform.");
+    return;
+  }
+
+  randomizeStates();
+
+  // unreachable targets so that all iterations are performed
+  InverseKinematicsConstraintSet cs;
+  cs.AddFullConstraint (body_id_emulated[BodyFootRight],
+                        Vector3d (0.1, 0., 0.), Vector3d (10., 0., 0.),
+                        Matrix3d::Identity());
+  cs.AddPointConstraint (body_id_emulated[BodyHandRight],
+                         Vector3d (0., 0.1, 0.), Vector3d (0., -10., 1.));
+  cs.AddOrientationConstraint (body_id_emulated[BodyHead],
+                               Matrix3d::Identity());
+  cs.AddPointConstraintXY (body_id_emulated[BodyHandLeft],
+                           Vector3d (0., 0.1, 0.), Vector3d (0., 10., 0.));
+  cs.AddPointConstraintZ (body_id_emulated[BodyFootLeft],
+                          Vector3d (0., 0.1, 0.), Vector3d (0., 0., 10.));
+  cs.AddPointConstraintCoMXY (body_id_emulated[BodyPelvis],
+                              Vector3d (1., 1., 0.));
+
+  VectorNd qres (q);
+
+  // the first call sizes the workspace
+  cs.max_steps = 1;
+  InverseKinematics (*model, q, cs, qres);
+
+  cs.max_steps = 20;
+  size_t allocation_count = HeapAllocationCount();
+  CHECK_FALSE (InverseKinematics (*model, q, cs, qres));
+  allocation_count = HeapAllocationCount() - allocation_count;
+
+  REQUIRE (cs.num_steps == cs.max_steps);
+  CHECK (allocation_count == 0);
+}
@@ -2475,6 +2475,69 @@ TEST_CASE_METHOD(SliderCrank3DSphericalJoint,
   CHECK_THAT(qdInit[0], IsClose(qd[0], TEST_PREC, TEST_PREC));
 }
 
+TEST_CASE_METHOD(SliderCrank3DSphericalJoint,
+                 __FILE__"_TestSliderCrank3DSphericalJointAssemblyWorkspace",
+                 "") {
+  VectorNd qWeights(model.dof_count);
+  VectorNd qdWeights(model.dof_count);
+  VectorNd qInit(model.q_size);
+  VectorNd qdInit(model.dof_count);
+  VectorNd qRef(model.q_size);
+  VectorNd qdRef(model.dof_count);
+  AssemblyWorkspace workspace;
+
+  qWeights[0] = 1.;
+  qWeights[1] = 2.;
+  qWeights[2] = 1.;
+  qWeights[3] = 0.5;
+  qWeights[4] = 1.;
+
+  Quaternion quat = Quaternion::fromZYXAngles(Vector3d(-0.25 * M_PI, 0.1,0.1));
+  qInit[0] = 0.4;
+  qInit[1] = 0.25 * M_PI;
+  model.SetQuaternion(id_s, quat, qInit);
+
+  // The Schur-reduced iterations take the same steps as the full system
+  REQUIRE (CalcAssemblyQ(model, qInit, cs, qRef, qWeights, 1e-14, 800));
+  REQUIRE (CalcAssemblyQ(model, qInit, cs, q, qWeights, workspace, 1e-14,
+                         800));
+  CHECK_THAT(qRef, AllCloseVector(q, 1e-10, 1e-10));
+  unsigned int coldIterations = workspace.iterations;
+
+  qdWeights[0] = 1.;
+  qdWeights[1] = 3.;
+  qdWeights[2] = 1.;
+  qdWeights[3] = 1.;
+  qdWeights[4] = 2.;
+
+  qdInit[0] = -0.2;
+  qdInit[1] = 0.1 * M_PI;
+  qdInit[2] = -0.1 * M_PI;
+  qdInit[3] = 0.;
+  qdInit[4] = 0.1 * M_PI;
+
+  CalcAssemblyQDot(model, q, qdInit, cs, qdRef, qdWeights);
+  CalcAssemblyQDot(model, q, qdInit, cs, qd, qdWeights, workspace);
+  CHECK_THAT(qdRef, AllCloseVector(qd, TEST_PREC, TEST_PREC));
+
+  // A slightly different initial guess starts at the previous solution
+  workspace.warm_start = true;
+  qInit[0] += 1e-3;
+  qInit[1] -= 1e-3;
+  REQUIRE (CalcAssemblyQ(model, qInit, cs, q, qWeights, workspace, 1e-14,
+                         800));
+  CHECK (workspace.iterations < coldIterations);
+
+  VectorNd err(VectorNd::Zero(cs.size()));
+  CalcConstraintsPositionError(model, q, cs, err);
+  CHECK (err.norm() < 1e-14);
+
+  // Non-positive weights cannot be eliminated
+  qWeights[2] = 0.;
+  CHECK_THROWS_AS (CalcAssemblyQ(model, qInit, cs, q, qWeights, workspace),
+                   Errors::RBDLInvalidParameterError);
+}
+
 TEST_CASE_METHOD(SliderCrank3DSphericalJoint,
                  __FILE__"_TestSliderCrank3DSphericalJointForwardDynamics", "") {
 
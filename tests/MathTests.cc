@@ -52,6 +52,40 @@ TEST_CASE (__FILE__"_GaussElimPivot", "") {
   CHECK_THAT (test_result, AllCloseVector(x, TEST_PREC, TEST_PREC));
 }
 
+TEST_CASE (__FILE__"_SolveLinearSystemMixedPrecision", "") {
+  ClearLogOutput();
+
+  const unsigned int n = 12;
+  MatrixNd A (n, n);
+  VectorNd b (n);
+  VectorNd x (n);
+
+  for (unsigned int i = 0; i < n; i++) {
+    for (unsigned int j = 0; j < n; j++) {
+      A(i,j) = sin (1.3 * i + 0.7 * j);
+    }
+    A(i,i) += 4.;
+    b[i] = 100. * cos (0.3 * i);
+  }
+
+  unsigned int steps = 0;
+  CHECK (SolveLinearSystemMixedPrecision (A, b, x, 0., 10, &steps));
+  CHECK (steps > 0);
+  CHECK_THAT (VectorNd (A.partialPivLu().solve (b)),
+              AllCloseVector (x, 1.0e-12, 1.0e-12));
+
+  // the Hilbert matrix is too ill-conditioned for single precision
+  for (unsigned int i = 0; i < n; i++) {
+    for (unsigned int j = 0; j < n; j++) {
+      A(i,j) = 1. / (i + j + 1.);
+    }
+  }
+
+  CHECK_FALSE (SolveLinearSystemMixedPrecision (A, b, x, 1.0e-14, 10));
+  CHECK_THAT (VectorNd (A.partialPivLu().solve (b)),
+              AllCloseVector (x, 0., 0.));
+}
+
 TEST_CASE (__FILE__"_Dynamic_1D_initialize_value", "") {
   VectorNd myvector_10 = VectorNd::Constant ((size_t) 10, 12.);
 
@@ -684,3 +684,105 @@ TEST_CASE (__FILE__"_CalcBodyWorldOrientationFixedJoint", "") {
   );
 }
 
+
+TEST_CASE (__FILE__"_OptimizeOrdering", "") {
+  Model model;
+  model.gravity = Vector3d (0., -9.81, 0.);
+
+  Body body (1., Vector3d (0.1, 0.2, -0.3), Vector3d (0.4, 0.5, 0.6));
+  Joint joint_rot_z (SpatialVector (0., 0., 1., 0., 0., 0.));
+  Joint joint_rot_y (SpatialVector (0., 1., 0., 0., 0., 0.));
+  SpatialTransform X = Xtrans (Vector3d (0.2, -0.1, 0.3)) * Xrotx (0.3);
+
+  // branches are added alternately such that their bodies interleave
+  unsigned int base = model.AddBody (0, SpatialTransform(),
+                                     Joint (JointTypeFloatingBase), body,
+                                     "base");
+  unsigned int left_1 = model.AddBody (base, X, joint_rot_z, body, "left_1");
+  unsigned int right_1 = model.AddBody (base, X, Joint (JointTypeSpherical),
+                                        body, "right_1");
+  unsigned int left_2 = model.AddBody (left_1, X, Joint (JointTypeEulerZYX),
+                                       body, "left_2");
+  unsigned int right_2 = model.AddBody (right_1, X, joint_rot_y, body,
+                                        "right_2");
+  unsigned int left_fixed = model.AddBody (left_2, X,
+                                           Joint (JointTypeFixed), body,
+                                           "left_fixed");
+  model.AddBody (right_2, X, joint_rot_z, body, "right_3");
+
+  VectorNd q = VectorNd::Zero (model.q_size);
+  VectorNd qdot = VectorNd::Zero (model.qdot_size);
+  VectorNd tau = VectorNd::Zero (model.qdot_size);
+  VectorNd qddot = VectorNd::Zero (model.qdot_size);
+  for (unsigned int i = 0; i < q.size(); i++) {
+    q[i] = 0.1 * i - 0.3;
+  }
+  model.SetQuaternion (base, Quaternion (Vector4d (0.1, 0.2, -0.3, 0.9).normalized()), q);
+  model.SetQuaternion (right_1, Quaternion (Vector4d (-0.2, 0.3, 0.1, 0.9).normalized()),
+                       q);
+  for (unsigned int i = 0; i < qdot.size(); i++) {
+    qdot[i] = 0.2 * i - 0.5;
+    tau[i] = 0.3 - 0.1 * i;
+  }
+
+  Vector3d point (0.1, 0.2, 0.3);
+  Vector3d left_2_point = CalcBodyToBaseCoordinates (model, q, left_2, point);
+  Vector3d fixed_point = CalcBodyToBaseCoordinates (model, q, left_fixed,
+                                                    point);
+  ForwardDynamics (model, q, qdot, tau, qddot);
+
+  unsigned int body_count = model.mBodies.size();
+  unsigned int q_size = model.q_size;
+  unsigned int root_id = model.free_flyer_root_id;
+  REQUIRE (root_id != 0);
+
+  ModelOrderingMap ordering = model.OptimizeOrdering();
+
+  REQUIRE (model.mBodies.size() == body_count);
+  REQUIRE (model.q_size == q_size);
+  CHECK (model.free_flyer_root_id == ordering.body[root_id]);
+
+  // every subtree occupies a contiguous range of ids
+  for (unsigned int i = 1; i < model.mBodies.size(); i++) {
+    CHECK (model.lambda[i] < i);
+    if (i + 1 < model.mBodies.size() && model.lambda[i + 1] != i) {
+      unsigned int j = i;
+      while (j != 0 && j != model.lambda[i + 1]) {
+        j = model.lambda[j];
+      }
+      CHECK (j == model.lambda[i + 1]);
+    }
+  }
+
+  CHECK (model.GetBodyId ("left_2") == ordering.body[left_2]);
+  CHECK (model.GetBodyId ("right_2") == ordering.body[right_2]);
+  CHECK (model.GetBodyId ("left_fixed") == left_fixed);
+  CHECK (model.GetParentBodyId (left_fixed) == ordering.body[left_2]);
+  CHECK (model.GetBodyId ("right_1") == ordering.body[left_2] + 1);
+
+  VectorNd q_new = VectorNd::Zero (model.q_size);
+  VectorNd qdot_new = VectorNd::Zero (model.qdot_size);
+  VectorNd tau_new = VectorNd::Zero (model.qdot_size);
+  VectorNd qddot_new = VectorNd::Zero (model.qdot_size);
+  VectorNd qddot_mapped = VectorNd::Zero (model.qdot_size);
+  for (unsigned int i = 0; i < q.size(); i++) {
+    q_new[ordering.q[i]] = q[i];
+  }
+  for (unsigned int i = 0; i < qdot.size(); i++) {
+    qdot_new[ordering.qdot[i]] = qdot[i];
+    tau_new[ordering.qdot[i]] = tau[i];
+    qddot_mapped[ordering.qdot[i]] = qddot[i];
+  }
+
+  CHECK_THAT (left_2_point,
+              AllCloseVector (CalcBodyToBaseCoordinates (
+                  model, q_new, ordering.body[left_2], point),
+                  TEST_PREC, TEST_PREC));
+  CHECK_THAT (fixed_point,
+              AllCloseVector (CalcBodyToBaseCoordinates (
+                  model, q_new, left_fixed, point),
+                  TEST_PREC, TEST_PREC));
+
+  ForwardDynamics (model, q_new, qdot_new, tau_new, qddot_new);
+  CHECK_THAT (qddot_mapped, AllCloseVector (qddot_new, 1.0e-12, 1.0e-12));
+}
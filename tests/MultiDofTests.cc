@@ -1362,3 +1362,253 @@ TEST_CASE_METHOD ( Human36, __FILE__"_SolveMInvTimesTauReuse", "") {
     );
   }
 }
+
+struct NativeMultiDofJoints {
+  NativeMultiDofJoints () {
+    ClearLogOutput();
+
+    native_model.emulate_multi_dof_joints = false;
+
+    Model *models[2] = { &emulated_model, &native_model };
+    Body body (1.3, Vector3d (0.1, 0.2, -0.3), Vector3d (0.4, 0.5, 0.6));
+
+    Joint joint_6dof (
+        SpatialVector (0., 0., 0., 1., 0., 0.),
+        SpatialVector (0., 0., 0., 0., 1., 0.),
+        SpatialVector (0., 0., 0., 0., 0., 1.),
+        SpatialVector (0., 0., 1., 0., 0., 0.),
+        SpatialVector (0., 1., 0., 0., 0., 0.),
+        SpatialVector (1., 0., 0., 0., 0., 0.)
+        );
+    Joint joint_rot_yxz (
+        SpatialVector (0., 1., 0., 0., 0., 0.),
+        SpatialVector (1., 0., 0., 0., 0., 0.),
+        SpatialVector (0., 0., 1., 0., 0., 0.)
+        );
+    Joint joint_2dof (
+        SpatialVector (0., 0., 0., 0., 0., 1.),
+        SpatialVector (0., 1., 0., 0., 0., 0.)
+        );
+    Joint joint_5dof (
+        SpatialVector (1., 0., 0., 0., 0., 0.),
+        SpatialVector (0., 0., 0., 0., 1., 0.),
+        SpatialVector (0., 0., 1., 0., 0., 0.),
+        SpatialVector (0., 0., 0., 1., 0., 0.),
+        SpatialVector (0., 1., 0., 0., 0., 0.)
+        );
+
+    for (unsigned int i = 0; i < 2; i++) {
+      Model &model = *models[i];
+      model.gravity = Vector3d (0., 0., -9.81);
+
+      root_id[i] = model.AddBody (0, Xtrans (Vector3d (0., 0., 1.)),
+                                  joint_6dof, body, "root");
+      model.AddBody (root_id[i], Xtrans (Vector3d (0.2, 0., 0.)),
+                     joint_rot_yxz, body, "arm");
+      leaf_id[i] = model.AppendBody (Xtrans (Vector3d (0., 0., -0.3)),
+                                     joint_2dof, body, "forearm");
+      model.AddBody (root_id[i], Xtrans (Vector3d (-0.2, 0., 0.)),
+                     joint_5dof, body, "leg");
+      model.AppendBody (Xtrans (Vector3d (0., 0., -0.4)),
+                        Joint (SpatialVector (0., 1., 0., 0., 0., 0.)), body,
+                        "foot");
+    }
+
+    q = VectorNd::Zero (native_model.q_size);
+    qdot = VectorNd::Zero (native_model.qdot_size);
+    qddot = VectorNd::Zero (native_model.qdot_size);
+    tau = VectorNd::Zero (native_model.qdot_size);
+
+    for (unsigned int i = 0; i < q.size(); i++) {
+      q[i] = 0.4 * M_PI * (rand() / static_cast<double>(RAND_MAX) - 0.5);
+      qdot[i] = 2. * (rand() / static_cast<double>(RAND_MAX) - 0.5);
+      qddot[i] = 2. * (rand() / static_cast<double>(RAND_MAX) - 0.5);
+      tau[i] = 2. * (rand() / static_cast<double>(RAND_MAX) - 0.5);
+    }
+  }
+
+  Model emulated_model;
+  Model native_model;
+  unsigned int root_id[2];
+  unsigned int leaf_id[2];
+
+  VectorNd q;
+  VectorNd qdot;
+  VectorNd qddot;
+  VectorNd tau;
+};
+
+TEST_CASE_METHOD (NativeMultiDofJoints, __FILE__"_TestNativeBodyCount", "") {
+  // 5 + 2 + 1 + 4 virtual bodies of the emulation
+  CHECK (emulated_model.mBodies.size() == 18);
+  CHECK (native_model.mBodies.size() == 6);
+  CHECK (native_model.mMultiDofJoints.size() == 4);
+  CHECK (native_model.dof_count == emulated_model.dof_count);
+  CHECK (native_model.q_size == emulated_model.q_size);
+
+  CHECK (root_id[1] == 1);
+  CHECK (native_model.GetBodyId ("forearm") == leaf_id[1]);
+  CHECK (native_model.GetParentBodyId (leaf_id[1])
+         == native_model.GetBodyId ("arm"));
+
+  Joint mixed_axis (SpatialVector (0., 0., 1., 1., 0., 0.),
+                    SpatialVector (0., 1., 0., 0., 0., 0.));
+  CHECK_THROWS_AS (native_model.AddBody (0, Xtrans (Vector3d (0., 0., 0.)),
+                   mixed_axis, Body()), Errors::RBDLError);
+}
+
+TEST_CASE_METHOD (NativeMultiDofJoints, __FILE__"_TestNativeKinematics", "") {
+  UpdateKinematics (emulated_model, q, qdot, qddot);
+  UpdateKinematics (native_model, q, qdot, qddot);
+
+  const char *body_names[5] = { "root", "arm", "forearm", "leg", "foot" };
+  Vector3d point (0.1, -0.2, 0.3);
+
+  for (unsigned int i = 0; i < 5; i++) {
+    unsigned int emulated_id = emulated_model.GetBodyId (body_names[i]);
+    unsigned int native_id = native_model.GetBodyId (body_names[i]);
+
+    SpatialVector emulated_v = emulated_model.v[emulated_id];
+    SpatialVector native_v = native_model.v[native_id];
+    CHECK_THAT (emulated_v, AllCloseVector (native_v, TEST_PREC, TEST_PREC));
+
+    SpatialVector emulated_a = emulated_model.a[emulated_id];
+    SpatialVector native_a = native_model.a[native_id];
+    CHECK_THAT (emulated_a, AllCloseVector (native_a, TEST_PREC, TEST_PREC));
+
+    Vector3d emulated_pos = CalcBodyToBaseCoordinates (emulated_model, q,
+        emulated_id, point, false);
+    Vector3d native_pos = CalcBodyToBaseCoordinates (native_model, q,
+        native_id, point, false);
+    CHECK_THAT (emulated_pos, AllCloseVector (native_pos, TEST_PREC,
+                                              TEST_PREC));
+
+    MatrixNd emulated_G = MatrixNd::Zero (6, emulated_model.qdot_size);
+    MatrixNd native_G = MatrixNd::Zero (6, native_model.qdot_size);
+    CalcPointJacobian6D (emulated_model, q, emulated_id, point, emulated_G,
+                         false);
+    CalcPointJacobian6D (native_model, q, native_id, point, native_G, false);
+    CHECK_THAT (emulated_G, AllCloseMatrix (native_G, TEST_PREC, TEST_PREC));
+  }
+}
+
+TEST_CASE_METHOD (NativeMultiDofJoints, __FILE__"_TestNativeDynamics", "") {
+  VectorNd emulated_result = VectorNd::Zero (qdot.size());
+  VectorNd native_result = VectorNd::Zero (qdot.size());
+
+  InverseDynamics (emulated_model, q, qdot, qddot, emulated_result);
+  InverseDynamics (native_model, q, qdot, qddot, native_result);
+  CHECK_THAT (emulated_result, AllCloseVector (native_result, TEST_PREC,
+                                               TEST_PREC));
+
+  NonlinearEffects (emulated_model, q, qdot, emulated_result);
+  NonlinearEffects (native_model, q, qdot, native_result);
+  CHECK_THAT (emulated_result, AllCloseVector (native_result, TEST_PREC,
+                                               TEST_PREC));
+
+  ForwardDynamics (emulated_model, q, qdot, tau, emulated_result);
+  ForwardDynamics (native_model, q, qdot, tau, native_result);
+  CHECK_THAT (emulated_result, AllCloseVector (native_result, TEST_LAX,
+                                               TEST_LAX));
+
+  ForwardDynamicsLagrangian (native_model, q, qdot, tau, emulated_result);
+  CHECK_THAT (emulated_result, AllCloseVector (native_result, TEST_LAX,
+                                               TEST_LAX));
+
+  MatrixNd emulated_H = MatrixNd::Zero (qdot.size(), qdot.size());
+  MatrixNd native_H = MatrixNd::Zero (qdot.size(), qdot.size());
+  CompositeRigidBodyAlgorithm (emulated_model, q, emulated_H);
+  CompositeRigidBodyAlgorithm (native_model, q, native_H);
+  CHECK_THAT (emulated_H, AllCloseMatrix (native_H, TEST_PREC, TEST_PREC));
+
+  CalcMInvTimesTau (emulated_model, q, tau, emulated_result);
+  CalcMInvTimesTau (native_model, q, tau, native_result);
+  CHECK_THAT (emulated_result, AllCloseVector (native_result, TEST_LAX,
+                                               TEST_LAX));
+}
+
+TEST_CASE_METHOD (NativeMultiDofJoints, __FILE__"_TestNativeNoHeapAllocations", "") {
+  if (!HeapAllocationCountAvailable()) {
+    WARN ("heap allocation counting not available, skipping test");
+    return;
+  }
+
+  ForwardDynamics (native_model, q, qdot, tau, qddot);
+  CalcMInvTimesTau (native_model, q, tau, qddot);
+
+  size_t allocations = HeapAllocationCount();
+  ForwardDynamics (native_model, q, qdot, tau, qddot);
+  CHECK (HeapAllocationCount() - allocations == 0);
+
+  allocations = HeapAllocationCount();
+  CalcMInvTimesTau (native_model, q, tau, qddot);
+  CHECK (HeapAllocationCount() - allocations == 0);
+}
+
+TEST_CASE (__FILE__"_TestNativeCRBANestedJoints", "") {
+  // A 2-DoF joint below another 2-DoF joint, followed by a revolute joint
+  // whose rows must not be overwritten by the coupling of the two joints.
+  Model emulated_model;
+  Model native_model;
+  native_model.emulate_multi_dof_joints = false;
+
+  Model *models[2] = { &emulated_model, &native_model };
+  Body body (1.1, Vector3d (0.1, -0.2, 0.3), Vector3d (0.3, 0.4, 0.5));
+  Joint joint_2dof (
+      SpatialVector (0., 0., 1., 0., 0., 0.),
+      SpatialVector (0., 0., 0., 1., 0., 0.)
+      );
+
+  for (unsigned int i = 0; i < 2; i++) {
+    Model &model = *models[i];
+    model.AddBody (0, Xtrans (Vector3d (0., 0., 0.)), joint_2dof, body);
+    model.AppendBody (Xtrans (Vector3d (0.5, 0., 0.)), joint_2dof, body);
+    model.AppendBody (Xtrans (Vector3d (0., 0.4, 0.)),
+                      Joint (SpatialVector (1., 0., 0., 0., 0., 0.)), body);
+  }
+
+  REQUIRE (native_model.mMultiDofJoints.size() == 2);
+
+  VectorNd q (native_model.q_size);
+  q << 0.3, -0.2, 0.7, 0.1, -0.5;
+
+  MatrixNd emulated_H = MatrixNd::Zero (q.size(), q.size());
+  MatrixNd native_H = MatrixNd::Zero (q.size(), q.size());
+  CompositeRigidBodyAlgorithm (emulated_model, q, emulated_H);
+  CompositeRigidBodyAlgorithm (native_model, q, native_H);
+
+  CHECK_THAT (emulated_H, AllCloseMatrix (native_H, TEST_PREC, TEST_PREC));
+}
+
+TEST_CASE (__FILE__"_TestNonlinearEffectsBaseJointBias", "") {
+  // Joints attached to the base whose bias acceleration c_J is not zero
+  Model euler_model;
+  Model native_model;
+  native_model.emulate_multi_dof_joints = false;
+
+  Body body (1.2, Vector3d (0.3, -0.1, 0.2), Vector3d (0.3, 0.4, 0.5));
+  euler_model.AddBody (0, Xtrans (Vector3d (0., 0., 0.)),
+                       Joint (JointTypeEulerZYX), body);
+  native_model.AddBody (0, Xtrans (Vector3d (0., 0., 0.)),
+                        Joint (SpatialVector (0., 0., 1., 0., 0., 0.),
+                               SpatialVector (0., 1., 0., 0., 0., 0.)),
+                        body);
+
+  REQUIRE (native_model.mMultiDofJoints.size() == 1);
+
+  Model *models[2] = { &euler_model, &native_model };
+  for (unsigned int i = 0; i < 2; i++) {
+    Model &model = *models[i];
+
+    VectorNd q = VectorNd::Constant (model.q_size, 0.4);
+    VectorNd qdot = VectorNd::LinSpaced (model.qdot_size, 0.7, -1.1);
+    VectorNd qddot = VectorNd::Zero (model.qdot_size);
+    VectorNd tau = VectorNd::Zero (model.qdot_size);
+    VectorNd nle = VectorNd::Zero (model.qdot_size);
+
+    InverseDynamics (model, q, qdot, qddot, tau);
+    NonlinearEffects (model, q, qdot, nle);
+
+    CHECK_THAT (tau, AllCloseVector (nle, TEST_PREC, TEST_PREC));
+  }
+}
@@ -0,0 +1,177 @@
+#include <iostream>
+
+#include "rbdl/Logging.h"
+
+#include "rbdl/Model.h"
+#include "rbdl/Dynamics.h"
+#include "rbdl/Kinematics.h"
+#include "rbdl/FrictionalContacts.h"
+#include "rbdl/Simulator.h"
+#include "rbdl/Rollout.h"
+
+#include "rbdl_tests.h"
+
+using namespace std;
+using namespace RigidBodyDynamics;
+using namespace RigidBodyDynamics::Math;
+
+struct RolloutFixture {
+  RolloutFixture () :
+    num_rollouts (13),
+    num_steps (25) {
+    ClearLogOutput();
+    model.gravity = Vector3d (0., 0., -9.81);
+
+    base_id = model.AddBody (0, SpatialTransform(),
+        Joint (JointTypeFloatingBase),
+        Body (2., Vector3d (0.1, 0.05, -0.1), Vector3d (0.3, 0.5, 0.7)));
+    unsigned int arm_id = model.AddBody (base_id,
+        Xtrans (Vector3d (0.3, 0., 0.1)), Joint (JointTypeSpherical),
+        Body (1., Vector3d (0.2, 0.1, 0.), Vector3d (0.1, 0.2, 0.15)));
+    model.AddBody (arm_id, Xtrans (Vector3d (0.4, 0., 0.)),
+        Joint (SpatialVector (0., 1., 0., 0., 0., 0.)),
+        Body (0.5, Vector3d (0.15, 0., 0.), Vector3d (0.05, 0.06, 0.04)));
+
+    Simulator simulator;
+    simulator.Bind (model);
+
+    Q0 = MatrixNd::Zero (model.q_size, num_rollouts);
+    QDot0 = MatrixNd::Zero (model.qdot_size, num_rollouts);
+    controls = MatrixNd::Zero (model.qdot_size, num_rollouts * num_steps);
+
+    for (unsigned int r = 0; r < num_rollouts; r++) {
+      Q0.col (r) = simulator.q;
+      Q0 (2, r) = 0.1 * r;
+      for (unsigned int i = 0; i < model.qdot_size; i++) {
+        QDot0 (i, r) = 0.1 * r - 0.05 * i;
+      }
+    }
+
+    for (unsigned int c = 0; c < controls.cols(); c++) {
+      for (unsigned int i = 0; i < model.qdot_size; i++) {
+        controls (i, c) = sin (0.1 * c + i);
+      }
+    }
+
+    buffer.Resize (model, num_rollouts, num_steps);
+  }
+
+  Model model;
+  unsigned int base_id;
+  unsigned int num_rollouts;
+  unsigned int num_steps;
+
+  MatrixNd Q0;
+  MatrixNd QDot0;
+  MatrixNd controls;
+  RolloutBuffer buffer;
+};
+
+TEST_CASE_METHOD (RolloutFixture, __FILE__"_RolloutMatchesSimulator", "") {
+  RolloutEngine engine;
+  engine.integrator = SimulatorIntegratorRungeKutta4;
+  engine.dt = 2.0e-3;
+  engine.Bind (model, 4);
+  REQUIRE (engine.workers.size() == 4);
+
+  engine.Run (Q0, QDot0, &controls, buffer);
+
+  for (unsigned int r = 0; r < num_rollouts; r++) {
+    Simulator simulator;
+    simulator.Bind (model);
+    simulator.integrator = SimulatorIntegratorRungeKutta4;
+    simulator.dt = 2.0e-3;
+    simulator.q = Q0.col (r);
+    simulator.qdot = QDot0.col (r);
+
+    for (unsigned int k = 0; k < num_steps; k++) {
+      simulator.tau = controls.col (r * num_steps + k);
+      simulator.Step();
+    }
+
+    unsigned int last_col = r * (num_steps + 1) + num_steps;
+    VectorNd q_initial = buffer.q.col (r * (num_steps + 1));
+    VectorNd q_last = buffer.q.col (last_col);
+    VectorNd qdot_last = buffer.qdot.col (last_col);
+    CHECK_THAT (simulator.q, AllCloseVector (q_last, 0., 0.));
+    CHECK_THAT (simulator.qdot, AllCloseVector (qdot_last, 0., 0.));
+    CHECK_THAT (VectorNd (Q0.col (r)), AllCloseVector (q_initial, 0., 0.));
+  }
+
+  CHECK_THAT (controls, AllCloseMatrix (buffer.tau, 0., 0.));
+}
+
+TEST_CASE_METHOD (RolloutFixture, __FILE__"_RolloutControlCallback", "") {
+  RolloutEngine engine;
+  engine.cpu_affinity.push_back (0);
+  engine.Bind (model, 3);
+
+  RolloutBuffer reference;
+  reference.Resize (model, num_rollouts, num_steps);
+  engine.Run (Q0, QDot0, &controls, reference);
+
+  engine.control_callback = [this] (unsigned int rollout, unsigned int step,
+      const Simulator &, VectorNd &tau) {
+    tau = controls.col (rollout * num_steps + step);
+  };
+  engine.Run (Q0, QDot0, NULL, buffer);
+
+  CHECK_THAT (reference.q, AllCloseMatrix (buffer.q, 0., 0.));
+  CHECK_THAT (reference.qdot, AllCloseMatrix (buffer.qdot, 0., 0.));
+
+  // zero torques without controls and callback
+  engine.control_callback = nullptr;
+  engine.Run (Q0, QDot0, NULL, buffer);
+  CHECK (buffer.tau.isZero());
+
+  RolloutBuffer too_small;
+  too_small.Resize (model, num_rollouts - 1, num_steps);
+  CHECK_THROWS_AS (engine.Run (Q0, QDot0, NULL, too_small),
+      Errors::RBDLError);
+
+  RolloutBuffer wrong_qdot;
+  wrong_qdot.Resize (model, num_rollouts, num_steps);
+  wrong_qdot.qdot.resize (model.qdot_size, num_rollouts * num_steps);
+  CHECK_THROWS_AS (engine.Run (Q0, QDot0, NULL, wrong_qdot),
+      Errors::RBDLError);
+
+  RolloutBuffer wrong_tau;
+  wrong_tau.Resize (model, num_rollouts, num_steps);
+  wrong_tau.tau.resize (model.qdot_size - 1, num_rollouts * num_steps);
+  CHECK_THROWS_AS (engine.Run (Q0, QDot0, NULL, wrong_tau),
+      Errors::RBDLError);
+}
+
+TEST_CASE_METHOD (RolloutFixture, __FILE__"_RolloutSetupWorker", "") {
+  // every worker has its own contact set bound to its model
+  std::vector<FrictionalContactSet> contacts (2);
+
+  RolloutEngine engine;
+  engine.setup_worker = [this, &contacts] (unsigned int thread,
+      RolloutWorker &worker) {
+    contacts[thread].AddContact (base_id, Vector3d (0., 0., -0.1),
+        Vector3d (0., 0., 1.), 0.8);
+    contacts[thread].Bind (worker.model);
+    worker.simulator.contacts = &contacts[thread];
+  };
+  engine.Bind (model, 2);
+
+  CHECK (&engine.workers[0]->model != &engine.workers[1]->model);
+  CHECK (engine.workers[0]->simulator.model == &engine.workers[0]->model);
+
+  engine.Run (Q0, QDot0, NULL, buffer);
+
+  // the active contacts prevent the contact point from moving downwards
+  Vector3d contact_point (0., 0., -0.1);
+  for (unsigned int r = 0; r < num_rollouts; r++) {
+    VectorNd q = Q0.col (r);
+    double height = CalcBodyToBaseCoordinates (model, q, base_id,
+        contact_point)[2];
+
+    for (unsigned int k = 1; k <= num_steps; k++) {
+      q = buffer.q.col (r * (num_steps + 1) + k);
+      CHECK (CalcBodyToBaseCoordinates (model, q, base_id,
+            contact_point)[2] > height - 1.0e-4);
+    }
+  }
+}
@@ -0,0 +1,254 @@
+#include <iostream>
+
+#include "rbdl/Logging.h"
+
+#include "rbdl/Model.h"
+#include "rbdl/Dynamics.h"
+#include "rbdl/Kinematics.h"
+#include "rbdl/Constraints.h"
+#include "rbdl/FrictionalContacts.h"
+#include "rbdl/Simulator.h"
+
+#include "rbdl_tests.h"
+
+using namespace std;
+using namespace RigidBodyDynamics;
+using namespace RigidBodyDynamics::Math;
+
+const double TEST_PREC = 1.0e-10;
+
+struct FloatingChainFixture {
+  FloatingChainFixture () {
+    ClearLogOutput();
+    model.gravity = Vector3d (0., 0., 0.);
+
+    base_id = model.AddBody (0, SpatialTransform(),
+        Joint (JointTypeFloatingBase),
+        Body (2., Vector3d (0.1, 0.05, -0.1), Vector3d (0.3, 0.5, 0.7)));
+    arm_id = model.AddBody (base_id, Xtrans (Vector3d (0.3, 0., 0.1)),
+        Joint (JointTypeSpherical),
+        Body (1., Vector3d (0.2, 0.1, 0.), Vector3d (0.1, 0.2, 0.15)));
+    model.AddBody (arm_id, Xtrans (Vector3d (0.4, 0., 0.)),
+        Joint (SpatialVector (0., 1., 0., 0., 0., 0.)),
+        Body (0.5, Vector3d (0.15, 0., 0.), Vector3d (0.05, 0.06, 0.04)));
+
+    simulator.Bind (model);
+    simulator.q.segment<3>(0) = Vector3d (0.1, -0.2, 0.3);
+    model.SetQuaternion (base_id,
+        Quaternion (Vector4d (0.1, -0.2, 0.3, 0.9).normalized()),
+        simulator.q);
+    model.SetQuaternion (arm_id,
+        Quaternion (Vector4d (-0.3, 0.1, 0.2, 0.9).normalized()),
+        simulator.q);
+    simulator.q[model.mJoints[arm_id + 1].q_index] = 0.4;
+
+    for (unsigned int i = 0; i < model.qdot_size; i++) {
+      simulator.qdot[i] = 0.7 - 0.3 * i;
+    }
+  }
+
+  // Integrates the initial state of the fixture up to time t_end and
+  // returns the difference to the reference state.
+  double CalcStateError (SimulatorIntegrator integrator, unsigned int steps,
+      double t_end, const VectorNd &q_ref, const VectorNd &qdot_ref) {
+    Simulator sim = simulator;
+    sim.integrator = integrator;
+    sim.dt = t_end / steps;
+    sim.Advance (steps);
+
+    VectorNd q_diff = VectorNd::Zero (model.qdot_size);
+    CalcConfigurationDifference (model, q_ref, sim.q, q_diff);
+
+    return q_diff.norm() + (sim.qdot - qdot_ref).norm();
+  }
+
+  Model model;
+  unsigned int base_id;
+  unsigned int arm_id;
+  Simulator simulator;
+};
+
+TEST_CASE_METHOD (FloatingChainFixture, __FILE__"_SimulatorConvergenceOrder",
+    "") {
+  REQUIRE (model.free_flyer_root_id == base_id);
+
+  const double t_end = 0.5;
+  Simulator reference = simulator;
+  reference.integrator = SimulatorIntegratorRungeKutta4;
+  reference.dt = t_end / 1280;
+  reference.Advance (1280);
+
+  double error_rk4_coarse = CalcStateError (SimulatorIntegratorRungeKutta4,
+      20, t_end, reference.q, reference.qdot);
+  double error_rk4_fine = CalcStateError (SimulatorIntegratorRungeKutta4,
+      40, t_end, reference.q, reference.qdot);
+  CHECK (error_rk4_coarse / error_rk4_fine > 12.);
+
+  double error_euler_coarse = CalcStateError (
+      SimulatorIntegratorSymplecticEuler, 200, t_end,
+      reference.q, reference.qdot);
+  double error_euler_fine = CalcStateError (
+      SimulatorIntegratorSymplecticEuler, 400, t_end,
+      reference.q, reference.qdot);
+  CHECK (error_euler_coarse / error_euler_fine > 1.6);
+  CHECK (error_euler_coarse / error_euler_fine < 2.5);
+
+  // quaternions stay normalized
+  CHECK (fabs (model.GetQuaternion (base_id, reference.q).norm() - 1.)
+      < TEST_PREC);
+  CHECK (fabs (model.GetQuaternion (arm_id, reference.q).norm() - 1.)
+      < TEST_PREC);
+
+  CHECK (fabs (reference.time - t_end) < TEST_PREC);
+}
+
+TEST_CASE_METHOD (FloatingChainFixture,
+    __FILE__"_SimulatorNoHeapAllocations", "") {
+  if (!HeapAllocationCountAvailable()) {
+    WARN ("heap allocation counting not available, skipping test");
+    return;
+  }
+
+  SimulatorIntegrator integrators[3] = {
+    SimulatorIntegratorSymplecticEuler,
+    SimulatorIntegratorSemiImplicit,
+    SimulatorIntegratorRungeKutta4
+  };
+
+  for (unsigned int i = 0; i < 3; i++) {
+    simulator.integrator = integrators[i];
+    simulator.Step();
+
+    size_t allocations = HeapAllocationCount();
+    simulator.Advance (10);
+    CHECK (HeapAllocationCount() - allocations == 0);
+  }
+}
+
+TEST_CASE (__FILE__"_SimulatorConstraintSolvers", "") {
+  Model model;
+  model.gravity = Vector3d (0., 0., -9.81);
+
+  Joint joint_rot_y (SpatialVector (0., 1., 0., 0., 0., 0.));
+  Body link (1., Vector3d (0., 0., -0.5), Vector3d (0.1, 0.1, 0.01));
+
+  unsigned int link_1 = model.AddBody (0, SpatialTransform(), joint_rot_y,
+      link);
+  unsigned int link_2 = model.AddBody (link_1,
+      Xtrans (Vector3d (0., 0., -1.)), joint_rot_y, link);
+  model.AddBody (link_2, Xtrans (Vector3d (0., 0., -1.)), joint_rot_y,
+      link);
+
+  Vector3d tip (0., 0., -1.);
+
+  ConstraintSolver solvers[3] = {
+    ConstraintSolverDirect,
+    ConstraintSolverRangeSpaceSparse,
+    ConstraintSolverNullSpace
+  };
+
+  VectorNd q_direct;
+
+  for (unsigned int i = 0; i < 3; i++) {
+    // the tip of the chain may only move vertically
+    ConstraintSet constraint_set;
+    constraint_set.AddContactConstraint (link_2 + 1, tip,
+        Vector3d (1., 0., 0.));
+    constraint_set.Bind (model);
+
+    Simulator simulator;
+    simulator.Bind (model);
+    simulator.SetConstraintSet (&constraint_set, solvers[i]);
+    simulator.q << 0.3, -0.6, 0.3;
+    simulator.qdot << 0.5, -1., 0.5;
+    simulator.Advance (500);
+    VectorNd q_prev = simulator.q;
+    simulator.Step();
+
+    // the velocities are consistent with the constraint at the positions
+    // at which the impulses were computed
+    double tip_velocity = CalcPointVelocity (model, q_prev,
+        simulator.qdot, link_2 + 1, tip)[0];
+    CHECK (fabs (tip_velocity) < TEST_PREC);
+    if (i == 0) {
+      q_direct = simulator.q;
+
+      // without the impulses the velocity error of the constraint drifts
+      Simulator euler;
+      euler.Bind (model);
+      euler.integrator = SimulatorIntegratorSymplecticEuler;
+      euler.SetConstraintSet (&constraint_set, solvers[i]);
+      euler.q << 0.3, -0.6, 0.3;
+      euler.qdot << 0.5, -1., 0.5;
+      euler.Advance (501);
+
+      double euler_tip_velocity = CalcPointVelocity (model, euler.q,
+          euler.qdot, link_2 + 1, tip)[0];
+      tip_velocity = CalcPointVelocity (model, simulator.q, simulator.qdot,
+          link_2 + 1, tip)[0];
+      CHECK (fabs (tip_velocity) * 10. < fabs (euler_tip_velocity));
+    } else {
+      CHECK_THAT (q_direct, AllCloseVector (simulator.q, 1.0e-8, 1.0e-8));
+    }
+  }
+}
+
+TEST_CASE (__FILE__"_SimulatorFrictionalContacts", "") {
+  Model model;
+  model.gravity = Vector3d (0., 0., -9.81);
+
+  const double radius = 0.1;
+  const double mass = 1.;
+  unsigned int body_id = model.AddBody (0, SpatialTransform(),
+      Joint (JointTypeFloatingBase),
+      Body (mass, Vector3d (0., 0., 0.),
+        Vector3d (0.4 * mass * radius * radius, 0.4 * mass * radius * radius,
+          0.4 * mass * radius * radius)));
+
+  FrictionalContactSet contacts;
+  contacts.AddContact (body_id, Vector3d (0., 0., -radius),
+      Vector3d (0., 0., 1.), 0.5, 0.5);
+  contacts.Bind (model);
+
+  Simulator simulator;
+  simulator.Bind (model);
+  simulator.contacts = &contacts;
+  simulator.q[2] = 0.3;
+  simulator.qdot[0] = 0.5;
+
+  // moves the contact point to the lowest point of the ball and corrects
+  // the penetration
+  simulator.pre_step = [&] (Simulator &sim) {
+    Vector3d center = CalcBodyToBaseCoordinates (model, sim.q, body_id,
+        Vector3d::Zero());
+    Matrix3d E = CalcBodyWorldOrientation (model, sim.q, body_id, false);
+    double depth = radius - center[2];
+
+    contacts.body_points[0] = E * Vector3d (0., 0., -radius);
+    contacts.active[0] = depth >= -0.01;
+    contacts.normal_velocity_bias[0] = depth >= 0. ?
+      0.2 * depth / sim.dt : depth / sim.dt;
+  };
+
+  simulator.integrator = SimulatorIntegratorRungeKutta4;
+  CHECK_THROWS_AS (simulator.Step(), Errors::RBDLError);
+
+  simulator.integrator = SimulatorIntegratorSemiImplicit;
+  simulator.Advance (3000);
+
+  // the ball rests on the ground and rolls without sliding
+  CHECK (fabs (simulator.q[2] - radius) < 1.0e-3);
+  CHECK (fabs (simulator.qdot[2]) < 2. * 9.81 * simulator.dt);
+
+  Matrix3d E = CalcBodyWorldOrientation (model, simulator.q, body_id);
+  Vector3d contact_velocity = CalcPointVelocity (model, simulator.q,
+      simulator.qdot, body_id, E * Vector3d (0., 0., -radius));
+  CHECK (contact_velocity.head<2>().norm() < 1.0e-6);
+  CHECK (fabs (simulator.qdot[0]) > 0.1);
+
+  if (HeapAllocationCountAvailable()) {
+    size_t allocations = HeapAllocationCount();
+    simulator.Advance (10);
+    CHECK (HeapAllocationCount() - allocations == 0);
+  }
+}
@@ -381,3 +381,160 @@ TEST_CASE_METHOD(LinearInvertedPendulumModel,
 {
   TestZMPComputationAgainstTableCartModel (*this, 1e-8);
 }
+
+void TestCentroidalMomentumMatrix (Model &model, const double TOL = 1e-8) {
+  const double EPS = 1e-7;
+
+  VectorNd q = VectorNd::Random (model.q_size);
+  VectorNd qdot = VectorNd::Random (model.qdot_size);
+  VectorNd qddot = VectorNd::Zero (model.qdot_size);
+
+  MatrixNd A_G (MatrixNd::Zero (6, model.qdot_size));
+  MatrixNd A_G_dot (MatrixNd::Zero (6, model.qdot_size));
+  MatrixNd A_G_plus (MatrixNd::Zero (6, model.qdot_size));
+  MatrixNd A_G_minus (MatrixNd::Zero (6, model.qdot_size));
+
+  double mass = 0.;
+  Vector3d com, com_velocity, com_acceleration;
+  Vector3d ang_mom, change_of_ang_mom;
+
+  Utils::CalcCenterOfMass (model, q, qdot, &qddot, mass, com, &com_velocity,
+                           &com_acceleration, &ang_mom, &change_of_ang_mom);
+
+  Utils::CalcCentroidalMomentumMatrix (model, q, A_G);
+  Utils::CalcCentroidalMomentumMatrixDot (model, q, qdot, A_G_dot);
+
+  // momentum at the COM
+  VectorNd h_G = A_G * qdot;
+  CHECK_THAT (ang_mom,
+              AllCloseVector(Vector3d (h_G[0], h_G[1], h_G[2]), TOL, TOL));
+  CHECK_THAT (mass * com_velocity,
+              AllCloseVector(Vector3d (h_G[3], h_G[4], h_G[5]), TOL, TOL));
+
+  // rate of change of the momentum for zero accelerations
+  VectorNd h_G_dot = A_G_dot * qdot;
+  CHECK_THAT (change_of_ang_mom,
+              AllCloseVector(Vector3d (h_G_dot[0], h_G_dot[1], h_G_dot[2]),
+                             TOL, TOL));
+  CHECK_THAT (mass * com_acceleration,
+              AllCloseVector(Vector3d (h_G_dot[3], h_G_dot[4], h_G_dot[5]),
+                             TOL, TOL));
+
+  // central differences of A_G along qdot
+  Utils::CalcCentroidalMomentumMatrix (model, q + EPS * qdot, A_G_plus);
+  Utils::CalcCentroidalMomentumMatrix (model, q - EPS * qdot, A_G_minus);
+
+  CHECK_THAT ((A_G_plus - A_G_minus) / (2. * EPS),
+              AllCloseMatrix(A_G_dot, 1e-6, 1e-6));
+}
+
+TEST_CASE_METHOD(Human36,
+                 __FILE__"_TestCentroidalMomentumMatrixHuman36", "")
+{
+  TestCentroidalMomentumMatrix (*model_emulated);
+  TestCentroidalMomentumMatrix (*model_3dof);
+}
+
+TEST_CASE_METHOD(FloatingBase12DoF,
+                 __FILE__"_TestCentroidalMomentumMatrixFloatingBase12DoF", "")
+{
+  TestCentroidalMomentumMatrix (*model);
+}
+
+void TestWholeBodyQuantities (Model &model, const double TOL = 1e-10) {
+  VectorNd q = VectorNd::Random (model.q_size);
+  VectorNd qdot = VectorNd::Random (model.qdot_size);
+  VectorNd qddot = VectorNd::Random (model.qdot_size);
+  Vector3d normal (0., 0., 1.);
+
+  double mass = 0.;
+  Vector3d com, com_velocity, com_acceleration;
+  Vector3d ang_mom, change_of_ang_mom;
+  Vector3d zmp;
+
+  Utils::CalcCenterOfMass (model, q, qdot, &qddot, mass, com, &com_velocity,
+                           &com_acceleration, &ang_mom, &change_of_ang_mom);
+  double kinetic_energy = Utils::CalcKineticEnergy (model, q, qdot);
+  double potential_energy = Utils::CalcPotentialEnergy (model, q);
+  Utils::CalcZeroMomentPoint (model, q, qdot, qddot, &zmp, normal);
+
+  Utils::WholeBodyQuantities quantities;
+  Utils::CalcWholeBodyQuantities (model, q, qdot, qddot, quantities, normal);
+
+  CHECK_THAT (mass, IsClose(quantities.mass, TOL, TOL));
+  CHECK_THAT (com, AllCloseVector(quantities.com, TOL, TOL));
+  CHECK_THAT (com_velocity, AllCloseVector(quantities.com_velocity, TOL, TOL));
+  CHECK_THAT (com_acceleration,
+              AllCloseVector(quantities.com_acceleration, TOL, TOL));
+  CHECK_THAT (ang_mom, AllCloseVector(quantities.angular_momentum, TOL, TOL));
+  CHECK_THAT (change_of_ang_mom,
+              AllCloseVector(quantities.change_of_angular_momentum, TOL, TOL));
+  CHECK_THAT (kinetic_energy,
+              IsClose(quantities.kinetic_energy, TOL, TOL));
+  CHECK_THAT (potential_energy,
+              IsClose(quantities.potential_energy, TOL, TOL));
+  CHECK_THAT (zmp, AllCloseVector(quantities.zmp, TOL, TOL));
+
+  // batch evaluation of a trajectory
+  const size_t num_states = 5;
+  std::vector<VectorNd> Q (num_states), QDot (num_states),
+      QDDot (num_states);
+  for (size_t k = 0; k < num_states; k++) {
+    Q[k] = VectorNd::Random (model.q_size);
+    QDot[k] = VectorNd::Random (model.qdot_size);
+    QDDot[k] = VectorNd::Random (model.qdot_size);
+  }
+
+  std::vector<Utils::WholeBodyQuantities> trajectory;
+  Utils::CalcWholeBodyQuantities (model, Q, QDot, QDDot, trajectory, normal);
+  REQUIRE (trajectory.size() == num_states);
+
+  for (size_t k = 0; k < num_states; k++) {
+    Utils::CalcWholeBodyQuantities (model, Q[k], QDot[k], QDDot[k],
+                                    quantities, normal);
+    CHECK_THAT (quantities.com, AllCloseVector(trajectory[k].com, TOL, TOL));
+    CHECK_THAT (quantities.angular_momentum,
+                AllCloseVector(trajectory[k].angular_momentum, TOL, TOL));
+    CHECK_THAT (quantities.kinetic_energy,
+                IsClose(trajectory[k].kinetic_energy, TOL, TOL));
+    CHECK_THAT (quantities.zmp, AllCloseVector(trajectory[k].zmp, TOL, TOL));
+  }
+
+  std::vector<VectorNd> QShort (num_states - 1, q);
+  CHECK_THROWS_AS (Utils::CalcWholeBodyQuantities (model, QShort, QDot, QDDot,
+                   trajectory, normal), Errors::RBDLSizeMismatchError);
+}
+
+TEST_CASE_METHOD(Human36,
+                 __FILE__"_TestWholeBodyQuantitiesHuman36", "")
+{
+  TestWholeBodyQuantities (*model_emulated);
+  TestWholeBodyQuantities (*model_3dof);
+}
+
+TEST_CASE_METHOD(FloatingBase12DoF,
+                 __FILE__"_TestWholeBodyQuantitiesFloatingBase12DoF", "")
+{
+  TestWholeBodyQuantities (*model);
+}
+
+TEST_CASE_METHOD(Human36,
+                 __FILE__"_TestWholeBodyQuantitiesNoHeapAllocations", "")
+{
+  if (!HeapAllocationCountAvailable()) {
+    WARN ("heap allocation counting not available, skipping test");
+    return;
+  }
+
+  randomizeStates();
+
+  std::vector<VectorNd> Q (10, q), QDot (10, qdot), QDDot (10, qddot);
+  std::vector<Utils::WholeBodyQuantities> trajectory;
+
+  // first call sizes the output
+  Utils::CalcWholeBodyQuantities (*model, Q, QDot, QDDot, trajectory);
+
+  size_t allocations = HeapAllocationCount();
+  Utils::CalcWholeBodyQuantities (*model, Q, QDot, QDDot, trajectory);
+  CHECK (HeapAllocationCount() - allocations == 0);
+}
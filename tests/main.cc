@@ -3,9 +3,57 @@
 
 #include <iostream>
 #include <string>
+#include <cstdlib>
 
 #include <rbdl/rbdl.h>
 
+#include "rbdl_tests.h"
+
+#if defined(__GLIBC__)
+#include <atomic>
+
+// Counts the heap allocations of the test executable (including the ones
+// done by the library) by wrapping the allocation functions of glibc.
+extern "C" {
+void *__libc_malloc (size_t size);
+void *__libc_calloc (size_t count, size_t size);
+void *__libc_realloc (void *ptr, size_t size);
+}
+
+static std::atomic<size_t> heap_allocation_count (0);
+
+extern "C" void *malloc (size_t size) {
+  heap_allocation_count++;
+  return __libc_malloc (size);
+}
+
+extern "C" void *calloc (size_t count, size_t size) {
+  heap_allocation_count++;
+  return __libc_calloc (count, size);
+}
+
+extern "C" void *realloc (void *ptr, size_t size) {
+  heap_allocation_count++;
+  return __libc_realloc (ptr, size);
+}
+
+bool HeapAllocationCountAvailable () {
+  return true;
+}
+
+size_t HeapAllocationCount () {
+  return heap_allocation_count;
+}
+#else
+bool HeapAllocationCountAvailable () {
+  return false;
+}
+
+size_t HeapAllocationCount () {
+  return 0;
+}
+#endif
+
 int main (int argc, char *argv[])
 {
   rbdl_check_api_version (RBDL_API_VERSION);
@@ -6,6 +6,12 @@
 #include "catch2/catch.hpp"
 #include "rbdl/rbdl_math.h"
 
+/// Whether HeapAllocationCount() is supported on this platform (glibc).
+bool HeapAllocationCountAvailable ();
+/// Number of heap allocations (malloc, calloc, realloc) of the test
+/// executable since its start.
+size_t HeapAllocationCount ();
+
 template <typename T>
 struct IsCloseMatcher : Catch::MatcherBase<T> {
   IsCloseMatcher(